@@ -0,0 +1,43 @@
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+#include <chrono>
+
+namespace bt::bench {
+class stopwatch {
+  public:
+    stopwatch() :
+        start { std::chrono::steady_clock::now() }
+    {
+    }
+
+    double elapsed_ms() const
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void reset() { start = std::chrono::steady_clock::now(); }
+
+  private:
+    std::chrono::steady_clock::time_point start;
+};
+
+void culling();
+void dynamic_resolution();
+void frame_arena();
+void host_allocator();
+void lod();
+void logging();
+void mip_generation();
+void particles();
+void pipeline_permutations();
+void render_graph();
+void render_queue();
+void render_thread();
+void resource_pool();
+void simulation();
+void swapchain_recreation();
+void texture_compression();
+} // namespace bt::bench
+
+#endif // BENCH_HPP
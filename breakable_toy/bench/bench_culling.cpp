@@ -0,0 +1,89 @@
+#include "bench.hpp"
+
+#include "bt_bvh.hpp"
+#include "bt_culling.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <fmt/core.h>
+
+#include <random>
+#include <vector>
+
+namespace bt::bench {
+void culling()
+{
+    constexpr int FRAMES = 20;
+
+    auto projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+    auto view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    auto frustum = bt_frustum::from_matrix(projection * view);
+
+    fmt::print("simd width: {}\n", bt_culler::SIMD_WIDTH);
+
+    for (size_t count : { 100'000u, 1'000'000u }) {
+        std::mt19937 rng { 42 };
+        std::uniform_real_distribution<float> position { -500.0f, 500.0f };
+        std::uniform_real_distribution<float> size { 0.25f, 1.0f };
+        std::uniform_real_distribution<float> jitter { -0.05f, 0.05f };
+
+        std::vector<bt_aabb> boxes(count);
+        bt_bounds_soa bounds;
+        bounds.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            glm::vec3 center { position(rng), position(rng), position(rng) };
+            glm::vec3 extents { size(rng), size(rng), size(rng) };
+            boxes[i] = { center - extents, center + extents };
+            bounds.set(i, boxes[i]);
+        }
+
+        bt_bvh bvh;
+        std::vector<int32_t> proxies(count);
+        stopwatch build;
+        for (size_t i = 0; i < count; i++) {
+            proxies[i] = bvh.create_proxy(boxes[i], static_cast<uint32_t>(i));
+        }
+        double build_ms = build.elapsed_ms();
+
+        bt_culler culler;
+        std::vector<uint32_t> visible;
+
+        double flat_ms = 0.0;
+        for (int frame = 0; frame < FRAMES; frame++) {
+            culler.cull(frustum, bounds, visible);
+            flat_ms += culler.stats().cull_ms;
+        }
+        auto flat_stats = culler.stats();
+
+        double refit_ms = 0.0;
+        double bvh_ms = 0.0;
+        for (int frame = 0; frame < FRAMES; frame++) {
+            // Move every tenth object a little, as a mostly static scene with some animated objects would.
+            stopwatch refit;
+            for (size_t i = frame % 10; i < count; i += 10) {
+                glm::vec3 offset { jitter(rng), jitter(rng), jitter(rng) };
+                boxes[i] = boxes[i].translated(offset);
+                bounds.set(i, boxes[i]);
+                bvh.move_proxy(proxies[i], boxes[i]);
+            }
+            bvh.refit();
+            refit_ms += refit.elapsed_ms();
+
+            culler.cull(frustum, bvh, bounds, visible);
+            bvh_ms += culler.stats().cull_ms;
+        }
+        auto bvh_stats = culler.stats();
+
+        fmt::print("{} objects: bvh build {:.1f} ms, height {}\n", count, build_ms, bvh.height());
+        fmt::print("  flat simd: {} visible, {} culled, {:.3f} ms/frame\n",
+            flat_stats.visible,
+            flat_stats.culled,
+            flat_ms / FRAMES);
+        fmt::print("  bvh + simd: {} visible, {} culled, {:.3f} ms/frame (+{:.3f} ms/frame refit)\n",
+            bvh_stats.visible,
+            bvh_stats.culled,
+            bvh_ms / FRAMES,
+            refit_ms / FRAMES);
+    }
+}
+} // namespace bt::bench
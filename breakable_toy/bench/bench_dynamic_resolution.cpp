@@ -0,0 +1,96 @@
+#include "bench.hpp"
+
+#include "bt_dynamic_resolution.hpp"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace bt::bench {
+namespace {
+constexpr int FRAMES = 1200;
+// Frames of GPU latency between rendering at a scale and measuring it, as with two frames in flight.
+constexpr int LATENCY = 2;
+
+// GPU cost of a frame: a fixed part plus a part proportional to the pixels drawn, scaled by how heavy the scene is.
+// Heavy stretches push full resolution to about 1.6x the budget.
+double frame_cost_ms(int frame, float scale, std::mt19937& rng)
+{
+    std::normal_distribution<double> noise { 0.0, 0.4 };
+    double load = 1.0;
+    if (frame >= 300 && frame < 600) {
+        load = 1.8;
+    } else if (frame >= 800 && frame < 900) {
+        load = 1.4;
+    }
+    return 2.0 + 12.0 * load * scale * scale + noise(rng);
+}
+
+struct run_result {
+    int over_budget = 0;
+    double worst_ms = 0.0;
+    float min_scale = 1.0f;
+    double mean_scale = 0.0;
+    int scale_changes = 0;
+};
+
+run_result simulate(const bt_dynamic_resolution_config& config, bool dynamic)
+{
+    std::mt19937 rng { 7 };
+    run_result result;
+
+    float scale = config.max_scale;
+    float in_flight[LATENCY];
+    std::fill(std::begin(in_flight), std::end(in_flight), scale);
+    double smoothed = 0.0;
+
+    for (int frame = 0; frame < FRAMES; frame++) {
+        // The frame measured now was rendered LATENCY frames ago.
+        float rendered = in_flight[frame % LATENCY];
+        double ms = frame_cost_ms(frame, rendered, rng);
+        smoothed = frame == 0 ? ms : smoothed + (ms - smoothed) * config.smoothing;
+
+        result.over_budget += ms > config.target_ms ? 1 : 0;
+        result.worst_ms = std::max(result.worst_ms, ms);
+        result.min_scale = std::min(result.min_scale, rendered);
+        result.mean_scale += rendered / FRAMES;
+
+        if (dynamic) {
+            float next = bt_next_resolution_scale(scale, smoothed, config);
+            result.scale_changes += next != scale ? 1 : 0;
+            scale = next;
+        }
+        in_flight[frame % LATENCY] = scale;
+    }
+    return result;
+}
+} // namespace
+
+void dynamic_resolution()
+{
+    bt_dynamic_resolution_config config;
+    fmt::print("{} frames against a {:.1f} ms budget, scene load steps 1.0 -> 1.8 -> 1.0 -> 1.4 -> 1.0\n",
+        FRAMES,
+        config.target_ms);
+    fmt::print("  {:<8} {:>12} {:>10} {:>10} {:>11} {:>8}\n",
+        "",
+        "over budget",
+        "worst",
+        "min scale",
+        "mean scale",
+        "changes");
+
+    for (bool dynamic : { false, true }) {
+        run_result result = simulate(config, dynamic);
+        fmt::print("  {:<8} {:>12} {:>7.2f} ms {:>10.3f} {:>11.3f} {:>8}\n",
+            dynamic ? "dynamic" : "fixed",
+            result.over_budget,
+            result.worst_ms,
+            result.min_scale,
+            result.mean_scale,
+            result.scale_changes);
+    }
+}
+} // namespace bt::bench
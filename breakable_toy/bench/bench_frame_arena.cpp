@@ -0,0 +1,78 @@
+#include "bench.hpp"
+
+#include "bt_frame_arena.hpp"
+
+#include <fmt/core.h>
+
+#include <memory_resource>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace bt::bench {
+namespace {
+constexpr uint32_t FRAMES_IN_FLIGHT = 2;
+constexpr int FRAMES = 500;
+
+struct transient_item {
+    uint64_t key;
+    float values[2];
+};
+
+// A frame's worth of short-lived containers, similar to what descriptor writes, barrier lists and per-system scratch
+// vectors look like: many small vectors grown by push_back plus a few strings. Returns a checksum so nothing is
+// optimised away.
+uint64_t frame_workload(std::pmr::memory_resource* resource, std::mt19937& rng)
+{
+    std::uniform_int_distribution<int> length { 1, 64 };
+
+    uint64_t checksum = 0;
+    for (int container = 0; container < 2000; container++) {
+        std::pmr::vector<transient_item> items { resource };
+        int count = length(rng);
+        for (int i = 0; i < count; i++) {
+            items.push_back({ static_cast<uint64_t>(i), { 0.0f, 1.0f } });
+        }
+        checksum += items.size();
+
+        if (container % 16 == 0) {
+            std::pmr::string name { "transient container with a name too long for the small string buffer", resource };
+            checksum += name.size();
+        }
+    }
+    return checksum;
+}
+} // namespace
+
+void frame_arena()
+{
+    std::mt19937 heap_rng { 42 };
+    uint64_t heap_checksum = 0;
+    stopwatch heap;
+    for (int frame = 0; frame < FRAMES; frame++) {
+        heap_checksum += frame_workload(std::pmr::new_delete_resource(), heap_rng);
+    }
+    double heap_ms = heap.elapsed_ms();
+
+    bt_frame_arena arena { FRAMES_IN_FLIGHT };
+    std::mt19937 arena_rng { 42 };
+    uint64_t arena_checksum = 0;
+    stopwatch arena_time;
+    for (int frame = 0; frame < FRAMES; frame++) {
+        arena.begin_frame(static_cast<uint32_t>(frame) % FRAMES_IN_FLIGHT);
+        arena_checksum += frame_workload(arena.resource(), arena_rng);
+    }
+    double arena_ms = arena_time.elapsed_ms();
+
+    fmt::print("{} frames, checksums {} / {}\n", FRAMES, heap_checksum, arena_checksum);
+    fmt::print("  {:<6} {:8.3f} ms/frame\n", "heap", heap_ms / FRAMES);
+    fmt::print("  {:<6} {:8.3f} ms/frame ({:.1f}x)\n", "arena", arena_ms / FRAMES, heap_ms / arena_ms);
+
+    auto stats = arena.stats();
+    fmt::print("  arena peak {} KiB, reserved {} KiB over {} thread(s) and {} frames in flight\n",
+        stats.peak_bytes / 1024,
+        stats.reserved_bytes / 1024,
+        stats.threads,
+        FRAMES_IN_FLIGHT);
+}
+} // namespace bt::bench
@@ -0,0 +1,106 @@
+#include "bench.hpp"
+
+#include "bt_host_allocator.hpp"
+
+#include <fmt/core.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace bt::bench {
+namespace {
+constexpr int FRAMES = 500;
+constexpr int ALLOCATIONS_PER_FRAME = 5000;
+constexpr int RECORDING_THREADS = 4;
+
+// What a driver does while recording a command buffer: many small command-scope allocations of a few sizes, all freed
+// together when the pool is reset. Frees go through the callbacks in the order allocated, as most drivers release
+// command buffer chunks. Returns a checksum so nothing is optimised away.
+uint64_t record_frames(const VkAllocationCallbacks& callbacks, uint32_t seed)
+{
+    std::mt19937 rng { seed };
+    std::uniform_int_distribution<size_t> size { 16, 1024 };
+    std::vector<void*> live;
+    live.reserve(ALLOCATIONS_PER_FRAME);
+
+    uint64_t checksum = 0;
+    for (int frame = 0; frame < FRAMES; frame++) {
+        for (int i = 0; i < ALLOCATIONS_PER_FRAME; i++) {
+            auto* memory = static_cast<uint8_t*>(
+                callbacks.pfnAllocation(callbacks.pUserData, size(rng), 16, VK_SYSTEM_ALLOCATION_SCOPE_COMMAND));
+            memory[0] = static_cast<uint8_t>(i);
+            checksum += memory[0];
+            live.push_back(memory);
+        }
+        for (auto* memory : live) {
+            callbacks.pfnFree(callbacks.pUserData, memory);
+        }
+        live.clear();
+    }
+    return checksum;
+}
+
+void* VKAPI_PTR heap_allocate(void*, size_t size, size_t alignment, VkSystemAllocationScope)
+{
+    return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+void VKAPI_PTR heap_free(void*, void* memory) { std::free(memory); }
+
+// Records on several threads at once, as when command buffers are recorded in parallel.
+double run(const VkAllocationCallbacks& callbacks, uint64_t& checksum)
+{
+    std::vector<uint64_t> checksums(RECORDING_THREADS);
+    std::vector<std::thread> threads;
+    stopwatch time;
+    for (int t = 0; t < RECORDING_THREADS; t++) {
+        threads.emplace_back([&, t] { checksums[t] = record_frames(callbacks, 42 + static_cast<uint32_t>(t)); });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    double ms = time.elapsed_ms();
+
+    checksum = 0;
+    for (auto value : checksums) {
+        checksum += value;
+    }
+    return ms;
+}
+} // namespace
+
+void host_allocator()
+{
+    VkAllocationCallbacks heap {};
+    heap.pfnAllocation = heap_allocate;
+    heap.pfnFree = heap_free;
+    uint64_t heap_checksum = 0;
+    double heap_ms = run(heap, heap_checksum);
+
+    bt_host_allocator tracked;
+    uint64_t tracked_checksum = 0;
+    double tracked_ms = run(*tracked.callbacks(), tracked_checksum);
+    tracked.end_frame();
+
+    fmt::print("{} frames of {} command-scope allocations on {} threads, checksums {} / {}\n",
+        FRAMES,
+        ALLOCATIONS_PER_FRAME,
+        RECORDING_THREADS,
+        heap_checksum,
+        tracked_checksum);
+    fmt::print("  {:<8} {:8.3f} ms/frame\n", "heap", heap_ms / FRAMES);
+    fmt::print("  {:<8} {:8.3f} ms/frame ({:.1f}x)\n", "tracked", tracked_ms / FRAMES, heap_ms / tracked_ms);
+
+    auto stats = tracked.stats();
+    const auto& command = stats.scopes[VK_SYSTEM_ALLOCATION_SCOPE_COMMAND];
+    fmt::print("  {} allocations, {} freed, peak {} KiB; pool {} hits, {} misses\n",
+        command.allocations,
+        command.frees,
+        command.peak_bytes / 1024,
+        stats.pool_hits,
+        stats.pool_misses);
+}
+} // namespace bt::bench
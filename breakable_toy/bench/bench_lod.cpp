@@ -0,0 +1,85 @@
+#include "bench.hpp"
+
+#include "bt_lod.hpp"
+#include "bt_simplify.hpp"
+
+#include <fmt/core.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace bt::bench {
+void lod()
+{
+    constexpr uint32_t RINGS = 128;
+    constexpr uint32_t SEGMENTS = 256;
+    constexpr size_t OBJECTS = 100'000;
+    constexpr int FRAMES = 60;
+
+    // A unit UV sphere: closed and curved, so every collapse has a real cost.
+    std::vector<glm::vec3> positions;
+    for (uint32_t ring = 0; ring <= RINGS; ring++) {
+        float phi = glm::radians(180.0f) * static_cast<float>(ring) / RINGS;
+        for (uint32_t segment = 0; segment <= SEGMENTS; segment++) {
+            float theta = glm::radians(360.0f) * static_cast<float>(segment) / SEGMENTS;
+            positions.emplace_back(std::sin(phi) * std::cos(theta), std::cos(phi), std::sin(phi) * std::sin(theta));
+        }
+    }
+
+    std::vector<uint32_t> indices;
+    for (uint32_t ring = 0; ring < RINGS; ring++) {
+        for (uint32_t segment = 0; segment < SEGMENTS; segment++) {
+            uint32_t a = ring * (SEGMENTS + 1) + segment;
+            uint32_t b = a + SEGMENTS + 1;
+            indices.insert(indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+        }
+    }
+
+    stopwatch simplify;
+    auto lods = bt_mesh_simplifier::generate_lods(positions, indices, 6);
+    fmt::print("simplified {} triangles into {} levels in {:.1f} ms\n",
+        lods[0].index_count / 3,
+        lods.size(),
+        simplify.elapsed_ms());
+    for (size_t i = 0; i < lods.size(); i++) {
+        fmt::print("  lod {}: {} triangles, error {:.5f}\n", i, lods[i].index_count / 3, lods[i].error);
+    }
+
+    // 1080p, 60 degree vertical field of view, objects scattered between 2 and 400 units from a camera that drifts
+    // slowly backwards so the hysteresis gets exercised.
+    float pixels_per_unit = 1080.0f / (2.0f * std::tan(glm::radians(30.0f)));
+    std::mt19937 rng { 42 };
+    std::uniform_real_distribution<float> distance { 2.0f, 400.0f };
+    std::vector<float> distances(OBJECTS);
+    for (auto& d : distances) {
+        d = distance(rng);
+    }
+
+    bt_lod_settings off { false };
+    bt_lod_settings no_hysteresis { true, 1.0f, 0.0f };
+    for (const auto& settings : { off, no_hysteresis, bt_lod_settings {} }) {
+        std::vector<uint32_t> current(OBJECTS, 0);
+        uint64_t triangles = 0;
+        uint64_t switches = 0;
+        stopwatch select;
+        for (int frame = 0; frame < FRAMES; frame++) {
+            float drift = 0.01f * static_cast<float>(frame % 2);
+            for (size_t i = 0; i < OBJECTS; i++) {
+                uint32_t level
+                    = bt_lod_selector::select(lods, current[i], distances[i] + drift, pixels_per_unit, settings);
+                switches += level != current[i] && frame > 0;
+                current[i] = level;
+                triangles += lods[level].index_count / 3;
+            }
+        }
+
+        fmt::print("lods {} (hysteresis {:.2f}): {:.1f}M triangles/frame, {} lod switches, select {:.3f} ms/frame\n",
+            settings.enabled ? "on" : "off",
+            settings.hysteresis,
+            static_cast<double>(triangles) / FRAMES / 1e6,
+            switches,
+            select.elapsed_ms() / FRAMES);
+    }
+}
+} // namespace bt::bench
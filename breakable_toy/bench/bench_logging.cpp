@@ -0,0 +1,88 @@
+#include "bench.hpp"
+
+#include "bt_async_log.hpp"
+
+#include <fmt/core.h>
+#include <spdlog/sinks/basic_file_sink.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace bt::bench {
+namespace {
+constexpr int BURSTS = 50;
+constexpr int CALLS_PER_BURST = 500;
+
+// Log calls arrive in bursts, like per-frame stats, with idle time in between for the background thread to catch up.
+template <typename Log>
+std::vector<double> measure(Log&& log)
+{
+    std::vector<double> latencies;
+    latencies.reserve(BURSTS * CALLS_PER_BURST);
+
+    for (int burst = 0; burst < BURSTS; burst++) {
+        for (int call = 0; call < CALLS_PER_BURST; call++) {
+            auto start = std::chrono::steady_clock::now();
+            log(call);
+            auto end = std::chrono::steady_clock::now();
+            latencies.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    return latencies;
+}
+
+void print(const char* name, const std::vector<double>& latencies)
+{
+    auto percentile = [&](double p) {
+        return latencies[static_cast<size_t>(p * static_cast<double>(latencies.size() - 1))];
+    };
+    fmt::print("  {:<7} p50 {:8.0f} ns, p99 {:8.0f} ns, max {:9.0f} ns\n",
+        name,
+        percentile(0.5),
+        percentile(0.99),
+        latencies.back());
+}
+} // namespace
+
+void logging()
+{
+    auto path = std::filesystem::temp_directory_path() / "bt_bench_logging.txt";
+    auto sink = std::make_shared<spdlog::sinks::basic_file_sink_mt>(path.string(), true);
+    auto logger = std::make_shared<spdlog::logger>("bench", sink);
+    logger->set_pattern("[%^%l%$] %v");
+    logger->set_level(spdlog::level::trace);
+
+    auto previous = spdlog::default_logger();
+    spdlog::set_default_logger(logger);
+
+    fmt::print("{} log calls in bursts of {}, producer-side latency\n", BURSTS * CALLS_PER_BURST, CALLS_PER_BURST);
+
+    print("timer", measure([](int) { }));
+
+    print("sync", measure([](int call) {
+        spdlog::default_logger_raw()->log(spdlog::source_loc { __FILE__, __LINE__, SPDLOG_FUNCTION },
+            spdlog::level::debug,
+            "{}: {} objects, {:.3f} ms",
+            "culling",
+            call,
+            0.125);
+    }));
+
+    {
+        bt_async_logger async_logger { logger };
+        print("async", measure([](int call) {
+            BT_LOG_ASYNC(spdlog::level::debug, "{}: {} objects, {:.3f} ms", "culling", call, 0.125);
+        }));
+    }
+
+    spdlog::set_default_logger(previous);
+    std::filesystem::remove(path);
+}
+} // namespace bt::bench
@@ -0,0 +1,43 @@
+#include "bench.hpp"
+
+#include "bt_texture_source.hpp"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace bt::bench {
+namespace {
+constexpr uint32_t SIZE = 4096;
+constexpr int RUNS = 5;
+} // namespace
+
+// CPU cost of building a 4K chain with the box filter, the baseline bt_mip_generator replaces. The GPU time of the
+// same work is logged by bt_mip_generator at debug level once a frame that generated mips has completed.
+void mip_generation()
+{
+    std::vector<std::byte> pixels(static_cast<size_t>(SIZE) * SIZE * 4);
+    for (size_t i = 0; i < pixels.size(); i++) {
+        pixels[i] = static_cast<std::byte>((i * 2654435761u) >> 24);
+    }
+
+    uint32_t mip_count = bt_mip_count(SIZE, SIZE);
+    double best_ms = 0.0;
+    size_t checksum = 0;
+    for (int run = 0; run < RUNS; run++) {
+        stopwatch timer;
+        std::vector<std::byte> level = pixels;
+        for (uint32_t i = 1; i < mip_count; i++) {
+            level = bt_downsample_rgba8(level, std::max(SIZE >> (i - 1), 1u), std::max(SIZE >> (i - 1), 1u));
+            checksum += static_cast<size_t>(level[0]);
+        }
+        double ms = timer.elapsed_ms();
+        best_ms = run == 0 ? ms : std::min(best_ms, ms);
+    }
+
+    fmt::print("{}x{} RGBA8, {} levels, checksum {}\n", SIZE, SIZE, mip_count, checksum);
+    fmt::print("  {:<10} {:8.2f} ms/texture (best of {})\n", "cpu box", best_ms, RUNS);
+    fmt::print("  gpu timings: run toy with debug logging, see \"mip generator\" lines\n");
+}
+} // namespace bt::bench
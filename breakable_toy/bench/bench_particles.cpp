@@ -0,0 +1,145 @@
+#include "bench.hpp"
+
+#include "bt_device.hpp"
+#include "bt_particles.hpp"
+#include "bt_resources.hpp"
+
+#include <fmt/core.h>
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <vector>
+
+namespace bt::bench {
+namespace {
+constexpr uint32_t SIZES[] = { 100'000, 1'000'000, 10'000'000 };
+constexpr int FRAMES = 60;
+constexpr float DT = 1.0f / 60.0f;
+
+// Particles that outlive the run and barely move, so every frame simulates all of them.
+bt_particle_config full_config(uint32_t capacity)
+{
+    bt_particle_config config;
+    config.capacity = capacity;
+    config.emit_rate = 0.0f;
+    config.lifetime = 1e6f;
+    config.velocity = { 0.0f, -0.01f };
+    config.spread = 6.28f;
+    config.gravity = { 0.0f, 0.0f };
+    return config;
+}
+
+// Same layout and per-particle work as shaders/particles.comp.glsl.
+struct cpu_particle {
+    glm::vec2 position;
+    uint32_t velocity;
+    float life;
+};
+
+// Returns the survivors appended to dst.
+uint32_t simulate_cpu(const std::vector<cpu_particle>& src, uint32_t alive, std::vector<cpu_particle>& dst)
+{
+    const glm::vec2 gravity { 0.0f, 0.0f };
+    uint32_t survivors = 0;
+    for (uint32_t i = 0; i < alive; i++) {
+        cpu_particle p = src[i];
+        p.life -= DT;
+        glm::vec2 velocity = glm::unpackHalf2x16(p.velocity) + gravity * DT;
+        p.position += velocity * DT;
+        p.velocity = glm::packHalf2x16(velocity);
+        if (p.life <= 0.0f || std::abs(p.position.x) > 2.0f || std::abs(p.position.y) > 2.0f) {
+            continue;
+        }
+        dst[survivors++] = p;
+    }
+    return survivors;
+}
+
+void run_cpu(uint32_t size)
+{
+    std::vector<cpu_particle> buffers[2];
+    buffers[0].resize(size);
+    buffers[1].resize(size);
+    for (uint32_t i = 0; i < size; i++) {
+        float angle = static_cast<float>(i) * 6.28f / static_cast<float>(size);
+        glm::vec2 velocity = glm::vec2(std::sin(angle), std::cos(angle)) * 0.01f;
+        buffers[0][i] = { { 0.0f, 0.6f }, glm::packHalf2x16(velocity), 1e6f };
+    }
+
+    uint32_t alive = size;
+    uint32_t src = 0;
+    double best_ms = 0.0;
+    for (int frame = 0; frame < FRAMES; frame++) {
+        stopwatch timer;
+        alive = simulate_cpu(buffers[src], alive, buffers[1 - src]);
+        double ms = timer.elapsed_ms();
+        best_ms = frame == 0 ? ms : std::min(best_ms, ms);
+        src = 1 - src;
+    }
+
+    fmt::print("  {:>10} particles  cpu, 1 thread {:8.3f} ms/frame {:10.0f} particles/ms ({} alive)\n",
+        size,
+        best_ms,
+        size / best_ms,
+        alive);
+}
+
+void run_gpu(bt_device& device, uint32_t size)
+{
+    bt_resources resources { device };
+    bt_particle_system particles { device, resources, 1, full_config(size) };
+    particles.burst(size);
+
+    double best_ms = 0.0;
+    uint32_t measured = 0;
+    for (int frame = 0; frame < FRAMES + 2; frame++) {
+        // Each frame is waited for, so its statistics are read back by the next begin_frame.
+        particles.begin_frame(0);
+        const auto& stats = particles.stats();
+        if (stats.simulated == size && stats.gpu_ms > 0.0) {
+            best_ms = measured++ == 0 ? stats.gpu_ms : std::min(best_ms, stats.gpu_ms);
+        }
+
+        VkCommandBuffer command_buffer = device.begin_single_time_commands();
+        particles.simulate(command_buffer, DT);
+        device.end_single_time_commands(command_buffer);
+    }
+
+    if (measured == 0) {
+        fmt::print("  {:>10} particles  gpu: no timings (timestamps unsupported?)\n", size);
+        return;
+    }
+    fmt::print("  {:>10} particles  gpu             {:8.3f} ms/frame {:10.0f} particles/ms ({} alive)\n",
+        size,
+        best_ms,
+        size / best_ms,
+        particles.stats().alive);
+}
+} // namespace
+
+// Particles simulated per millisecond by bt_particle_system from 100k to 10M particles, against the same integrate
+// and compact loop on one CPU core. GPU times are the system's own timestamps around emission, simulation and
+// compaction, best of the frames run; the GPU half is skipped when no Vulkan device can be created.
+void particles()
+{
+    for (auto size : SIZES) {
+        run_cpu(size);
+    }
+
+    try {
+        bt_device device;
+        for (auto size : SIZES) {
+            try {
+                run_gpu(device, size);
+            } catch (const std::exception& e) {
+                fmt::print("  {:>10} particles  gpu: {}\n", size, e.what());
+            }
+        }
+    } catch (const std::exception& e) {
+        fmt::print("  gpu: skipped, {}\n", e.what());
+    }
+}
+} // namespace bt::bench
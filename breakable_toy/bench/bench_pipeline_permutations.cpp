@@ -0,0 +1,217 @@
+#include "bench.hpp"
+
+#include "bt_device.hpp"
+#include "bt_pipeline_registry.hpp"
+#include "bt_resources.hpp"
+
+#include <fmt/core.h>
+
+#include <exception>
+#include <stdexcept>
+#include <unordered_set>
+#include <vector>
+
+namespace bt::bench {
+namespace {
+constexpr const char* VERT_SHADER = "shaders/simple_shader.vert.spv";
+constexpr const char* FRAG_SHADER = "shaders/simple_shader.frag.spv";
+
+// Surfaces a forward renderer draws, each single- and double-sided, with both windings for mirrored instances and as
+// triangle lists and restarting strips; shadow casters; and debug lines with and without depth testing.
+std::vector<bt_pipeline_desc> material_set(VkPipelineLayout pipeline_layout, VkRenderPass render_pass)
+{
+    struct surface {
+        bool blend;
+        bool depth_write;
+        VkCompareOp depth_compare;
+        bool depth_bias;
+    };
+    const surface surfaces[] = {
+        // Opaque, blended, decal, sky drawn at the far plane, and opaque after a depth prepass.
+        { false, true, VK_COMPARE_OP_LESS, false },
+        { true, false, VK_COMPARE_OP_LESS, false },
+        { true, false, VK_COMPARE_OP_LESS_OR_EQUAL, true },
+        { false, false, VK_COMPARE_OP_LESS_OR_EQUAL, false },
+        { false, false, VK_COMPARE_OP_EQUAL, false },
+    };
+
+    std::vector<bt_pipeline_desc> descs;
+    auto add = [&](bool blend, const bt_draw_state& state) {
+        bt_pipeline_desc desc {};
+        desc.vert_shader = VERT_SHADER;
+        desc.frag_shader = FRAG_SHADER;
+        desc.pipeline_layout = pipeline_layout;
+        desc.render_pass = render_pass;
+        desc.blend = blend;
+        desc.draw_state = state;
+        descs.push_back(desc);
+    };
+
+    for (auto front_face : { VK_FRONT_FACE_CLOCKWISE, VK_FRONT_FACE_COUNTER_CLOCKWISE }) {
+        for (bool strip : { false, true }) {
+            bt_draw_state state {};
+            state.front_face = front_face;
+            state.topology = strip ? VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP : VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+            state.primitive_restart = strip;
+
+            for (const auto& s : surfaces) {
+                for (auto cull_mode : { VK_CULL_MODE_BACK_BIT, VK_CULL_MODE_NONE }) {
+                    state.cull_mode = cull_mode;
+                    state.depth_write = s.depth_write;
+                    state.depth_compare = s.depth_compare;
+                    state.depth_bias = s.depth_bias;
+                    add(s.blend, state);
+                }
+            }
+
+            state.cull_mode = VK_CULL_MODE_FRONT_BIT;
+            state.depth_write = true;
+            state.depth_compare = VK_COMPARE_OP_LESS;
+            state.depth_bias = true;
+            add(false, state);
+        }
+    }
+
+    for (bool strip : { false, true }) {
+        for (bool depth_test : { true, false }) {
+            bt_draw_state state {};
+            state.topology = strip ? VK_PRIMITIVE_TOPOLOGY_LINE_STRIP : VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
+            state.primitive_restart = strip;
+            state.depth_test = depth_test;
+            state.depth_write = false;
+            add(true, state);
+        }
+    }
+    return descs;
+}
+
+size_t count_pipelines(const std::vector<bt_pipeline_desc>& descs, bool dynamic_draw_state, bool dynamic_draw_state2)
+{
+    std::unordered_set<bt_pipeline_desc, bt_pipeline_desc_hash> keys;
+    for (const auto& desc : descs) {
+        keys.insert(bt_pipeline_registry::static_part(desc, dynamic_draw_state, dynamic_draw_state2));
+    }
+    return keys.size();
+}
+
+VkRenderPass create_render_pass(bt_device& device)
+{
+    VkAttachmentDescription attachments[2] {};
+    attachments[0].format = VK_FORMAT_R8G8B8A8_UNORM;
+    attachments[0].samples = VK_SAMPLE_COUNT_1_BIT;
+    attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    attachments[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachments[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    attachments[0].finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    attachments[1] = attachments[0];
+    attachments[1].format = VK_FORMAT_D32_SFLOAT;
+    attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachments[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    VkAttachmentReference color_ref { 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+    VkAttachmentReference depth_ref { 1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+    VkSubpassDescription subpass {};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = 1;
+    subpass.pColorAttachments = &color_ref;
+    subpass.pDepthStencilAttachment = &depth_ref;
+
+    VkRenderPassCreateInfo render_pass_info { VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO };
+    render_pass_info.attachmentCount = 2;
+    render_pass_info.pAttachments = attachments;
+    render_pass_info.subpassCount = 1;
+    render_pass_info.pSubpasses = &subpass;
+
+    VkRenderPass render_pass;
+    if (vkCreateRenderPass(device.device(), &render_pass_info, device.allocator(), &render_pass) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create render pass");
+    }
+    return render_pass;
+}
+
+VkPipelineLayout create_pipeline_layout(bt_device& device)
+{
+    // The scene shaders' push constants: a vec3 offset and a vec3 colour, each 16-byte aligned.
+    VkPushConstantRange push_constant_range {};
+    push_constant_range.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+    push_constant_range.size = 32;
+
+    VkPipelineLayoutCreateInfo layout_info { VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+    layout_info.pushConstantRangeCount = 1;
+    layout_info.pPushConstantRanges = &push_constant_range;
+
+    VkPipelineLayout pipeline_layout;
+    if (vkCreatePipelineLayout(device.device(), &layout_info, device.allocator(), &pipeline_layout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create pipeline layout");
+    }
+    return pipeline_layout;
+}
+
+bt_pipeline_registry_stats build(bt_device& device,
+    bt_resources& resources,
+    const std::vector<bt_pipeline_desc>& descs,
+    bool dynamic_draw_state,
+    const char* label)
+{
+    bt_pipeline_registry registry { device, resources, dynamic_draw_state };
+    for (const auto& desc : descs) {
+        registry.get(desc);
+    }
+    const auto& stats = registry.stats();
+    fmt::print("  {:<24} {:3} pipelines {:9.2f} ms compiling {:7.3f} ms/pipeline\n",
+        label,
+        stats.pipelines,
+        stats.compile_ms,
+        stats.compile_ms / stats.pipelines);
+    return stats;
+}
+} // namespace
+
+// Pipelines a representative material set needs when all draw state is baked, with VK_EXT_extended_dynamic_state
+// and with VK_EXT_extended_dynamic_state2 as well, counted from bt_pipeline_registry's keys. On a Vulkan device the
+// set is then built through a registry each way, timing vkCreateGraphicsPipelines; the dynamic one goes first so a
+// driver's own shader cache, if any, favours the baked build and the time saved is not overstated.
+void pipeline_permutations()
+{
+    auto counted = material_set(VK_NULL_HANDLE, VK_NULL_HANDLE);
+    fmt::print("  {} materials: {} pipelines baked, {} with extended dynamic state, {} with extended dynamic state 2\n",
+        counted.size(),
+        count_pipelines(counted, false, false),
+        count_pipelines(counted, true, false),
+        count_pipelines(counted, true, true));
+
+    try {
+        bt_device device;
+        bt_resources resources { device };
+        auto render_pass = create_render_pass(device);
+        auto pipeline_layout = create_pipeline_layout(device);
+        auto descs = material_set(pipeline_layout, render_pass);
+
+        try {
+            if (!device.extended_dynamic_state_supported()) {
+                fmt::print("  dynamic: skipped, VK_EXT_extended_dynamic_state not supported\n");
+                build(device, resources, descs, false, "baked");
+            } else {
+                auto dynamic = build(device,
+                    resources,
+                    descs,
+                    true,
+                    device.extended_dynamic_state2_supported() ? "extended dynamic state 2" : "extended dynamic state");
+                auto baked = build(device, resources, descs, false, "baked");
+                fmt::print("  {} fewer pipelines, {:.2f} ms of compilation saved\n",
+                    baked.pipelines - dynamic.pipelines,
+                    baked.compile_ms - dynamic.compile_ms);
+            }
+        } catch (const std::exception& e) {
+            fmt::print("  gpu: {}\n", e.what());
+        }
+
+        device.destroy_later(pipeline_layout);
+        device.destroy_later(render_pass);
+    } catch (const std::exception& e) {
+        fmt::print("  gpu: skipped, {}\n", e.what());
+    }
+}
+} // namespace bt::bench
@@ -0,0 +1,229 @@
+#include "bench.hpp"
+
+#include "bt_render_graph.hpp"
+
+#include <fmt/core.h>
+
+#include <array>
+#include <unordered_map>
+
+namespace bt::bench {
+namespace {
+constexpr uint32_t FRAMES_IN_FLIGHT = 2;
+constexpr uint32_t SWAPCHAIN_IMAGES = 3;
+// Typical placement granularity of optimal-tiling images on desktop GPUs.
+constexpr VkDeviceSize IMAGE_ALIGNMENT = 64 * 1024;
+
+uint32_t bytes_per_texel(VkFormat format)
+{
+    switch (format) {
+    case VK_FORMAT_R8_UNORM:
+        return 1;
+    case VK_FORMAT_R16G16B16A16_SFLOAT:
+        return 8;
+    default:
+        return 4;
+    }
+}
+
+struct frame_graph {
+    bt_render_graph graph;
+    std::unordered_map<bt_rg_resource, bt_rg_image_desc> descs;
+
+    bt_rg_resource image(const char* name, VkFormat format, VkExtent2D extent)
+    {
+        bt_rg_image_desc desc { format, extent };
+        bt_rg_resource id = graph.create_image(name, desc);
+        descs[id] = desc;
+        return id;
+    }
+};
+
+// A deferred frame: G-buffer, SSAO, lighting, a bloom chain and tonemapping into the swapchain image, plus a debug
+// view nothing presents, which the graph culls.
+void build_frame(frame_graph& frame, VkExtent2D extent)
+{
+    auto& graph = frame.graph;
+    VkExtent2D half { extent.width / 2, extent.height / 2 };
+    VkExtent2D quarter { extent.width / 4, extent.height / 4 };
+    VkExtent2D eighth { extent.width / 8, extent.height / 8 };
+
+    auto backbuffer = graph.import_image("backbuffer",
+        { VK_FORMAT_B8G8R8A8_SRGB, extent },
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+    auto albedo = frame.image("albedo", VK_FORMAT_R8G8B8A8_UNORM, extent);
+    auto normal = frame.image("normal", VK_FORMAT_R16G16B16A16_SFLOAT, extent);
+    auto material = frame.image("material", VK_FORMAT_R8G8B8A8_UNORM, extent);
+    auto depth = frame.image("depth", VK_FORMAT_D32_SFLOAT, extent);
+    auto ao = frame.image("ao", VK_FORMAT_R8_UNORM, extent);
+    auto hdr = frame.image("hdr", VK_FORMAT_R16G16B16A16_SFLOAT, extent);
+    auto bloom_half = frame.image("bloom_half", VK_FORMAT_R16G16B16A16_SFLOAT, half);
+    auto bloom_quarter = frame.image("bloom_quarter", VK_FORMAT_R16G16B16A16_SFLOAT, quarter);
+    auto bloom_eighth = frame.image("bloom_eighth", VK_FORMAT_R16G16B16A16_SFLOAT, eighth);
+    auto bloom = frame.image("bloom", VK_FORMAT_R16G16B16A16_SFLOAT, half);
+    auto debug = frame.image("debug", VK_FORMAT_R8G8B8A8_UNORM, extent);
+
+    auto nothing = [](VkCommandBuffer) {};
+    graph.add_pass(
+        "gbuffer",
+        [&](bt_render_graph::pass_builder& pass) {
+            pass.color_attachment(albedo, VkClearColorValue {});
+            pass.color_attachment(normal, VkClearColorValue {});
+            pass.color_attachment(material, VkClearColorValue {});
+            pass.depth_attachment(depth, VkClearDepthStencilValue { 1.0f, 0 });
+        },
+        nothing);
+    graph.add_pass(
+        "ssao",
+        [&](bt_render_graph::pass_builder& pass) {
+            pass.read(depth, bt_rg_usage::sampled);
+            pass.read(normal, bt_rg_usage::sampled);
+            pass.write(ao, bt_rg_usage::storage);
+        },
+        nothing);
+    graph.add_pass(
+        "lighting",
+        [&](bt_render_graph::pass_builder& pass) {
+            pass.read(albedo, bt_rg_usage::sampled);
+            pass.read(normal, bt_rg_usage::sampled);
+            pass.read(material, bt_rg_usage::sampled);
+            pass.read(depth, bt_rg_usage::sampled);
+            pass.read(ao, bt_rg_usage::sampled);
+            pass.color_attachment(hdr, VkClearColorValue {});
+        },
+        nothing);
+    graph.add_pass(
+        "debug_view",
+        [&](bt_render_graph::pass_builder& pass) {
+            pass.read(normal, bt_rg_usage::sampled);
+            pass.color_attachment(debug);
+        },
+        nothing);
+
+    std::array<std::pair<bt_rg_resource, bt_rg_resource>, 3> downsamples {
+        { { hdr, bloom_half }, { bloom_half, bloom_quarter }, { bloom_quarter, bloom_eighth } }
+    };
+    for (auto [source, target] : downsamples) {
+        graph.add_pass(
+            "bloom_down",
+            [&](bt_render_graph::pass_builder& pass) {
+                pass.read(source, bt_rg_usage::sampled);
+                pass.write(target, bt_rg_usage::storage);
+            },
+            nothing);
+    }
+    graph.add_pass(
+        "bloom_up",
+        [&](bt_render_graph::pass_builder& pass) {
+            pass.read(bloom_eighth, bt_rg_usage::sampled);
+            pass.read(bloom_quarter, bt_rg_usage::sampled);
+            pass.write(bloom, bt_rg_usage::storage);
+        },
+        nothing);
+    graph.add_pass(
+        "tonemap",
+        [&](bt_render_graph::pass_builder& pass) {
+            pass.read(hdr, bt_rg_usage::sampled);
+            pass.read(bloom, bt_rg_usage::sampled);
+            pass.color_attachment(backbuffer);
+        },
+        nothing);
+}
+
+// The app's frame: one pass drawing into the swapchain image with a cleared depth buffer.
+void build_forward_frame(frame_graph& frame, VkExtent2D extent)
+{
+    auto backbuffer = frame.graph.import_image("backbuffer",
+        { VK_FORMAT_B8G8R8A8_SRGB, extent },
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+    auto depth = frame.image("depth", VK_FORMAT_D32_SFLOAT, extent);
+    frame.graph.add_pass(
+        "main",
+        [&](bt_render_graph::pass_builder& pass) {
+            pass.color_attachment(backbuffer, VkClearColorValue {});
+            pass.depth_attachment(depth, VkClearDepthStencilValue { 1.0f, 0 });
+        },
+        [](VkCommandBuffer) {});
+}
+
+VkDeviceSize estimated_size(const bt_rg_image_desc& desc)
+{
+    VkDeviceSize size =
+        static_cast<VkDeviceSize>(desc.extent.width) * desc.extent.height * bytes_per_texel(desc.format);
+    return (size + IMAGE_ALIGNMENT - 1) / IMAGE_ALIGNMENT * IMAGE_ALIGNMENT;
+}
+
+void plan(frame_graph& frame)
+{
+    frame.graph.plan([&](bt_rg_resource id) {
+        return VkMemoryRequirements { estimated_size(frame.descs.at(id)), IMAGE_ALIGNMENT, 1 };
+    });
+}
+
+void plan_frame(VkExtent2D extent)
+{
+    frame_graph frame;
+    build_frame(frame, extent);
+
+    stopwatch timer;
+    plan(frame);
+    double plan_ms = timer.elapsed_ms();
+
+    const auto& stats = frame.graph.stats();
+    double mib = 1024.0 * 1024.0;
+    fmt::print("{}x{}: {} passes ({} culled), {} barriers, {} transient images, planned in {:.3f} ms\n",
+        extent.width,
+        extent.height,
+        stats.passes,
+        stats.culled_passes,
+        stats.barriers,
+        stats.transient_images,
+        plan_ms);
+    fmt::print("  transient memory  {:7.1f} MiB aliased, {:7.1f} MiB unaliased per frame ({:.0f}% saved)\n",
+        static_cast<double>(stats.transient_bytes) / mib,
+        static_cast<double>(stats.unaliased_bytes) / mib,
+        100.0 * (1.0 - static_cast<double>(stats.transient_bytes) / static_cast<double>(stats.unaliased_bytes)));
+    fmt::print("  x {} frames       {:7.1f} MiB aliased, {:7.1f} MiB unaliased\n",
+        FRAMES_IN_FLIGHT,
+        static_cast<double>(stats.transient_bytes * FRAMES_IN_FLIGHT) / mib,
+        static_cast<double>(stats.unaliased_bytes * FRAMES_IN_FLIGHT) / mib);
+}
+
+// Depth used to be one image and allocation per swapchain image; now it is one per frame in flight, placed in a pool
+// that survives swapchain recreation, and lazily allocated since it is cleared on load and never stored.
+void attachment_memory(VkExtent2D extent)
+{
+    frame_graph frame;
+    build_forward_frame(frame, extent);
+    plan(frame);
+
+    const auto& stats = frame.graph.stats();
+    double mib = 1024.0 * 1024.0;
+    VkDeviceSize per_image = estimated_size({ VK_FORMAT_D32_SFLOAT, extent });
+    fmt::print("{}x{} depth, {} swapchain images, {} frames in flight:\n",
+        extent.width,
+        extent.height,
+        SWAPCHAIN_IMAGES,
+        FRAMES_IN_FLIGHT);
+    fmt::print("  per swapchain image  {:7.1f} MiB in {} allocations\n",
+        static_cast<double>(per_image * SWAPCHAIN_IMAGES) / mib,
+        SWAPCHAIN_IMAGES);
+    fmt::print("  per frame in flight  {:7.1f} MiB in {} allocations, {:.1f} MiB of it lazily allocated\n",
+        static_cast<double>(stats.transient_bytes * FRAMES_IN_FLIGHT) / mib,
+        FRAMES_IN_FLIGHT,
+        static_cast<double>(stats.lazy_bytes * FRAMES_IN_FLIGHT) / mib);
+    fmt::print("  tile-based GPUs commit no pages for lazily allocated memory; others use device-local memory\n");
+}
+} // namespace
+
+void render_graph()
+{
+    plan_frame({ 1920, 1080 });
+    plan_frame({ 3840, 2160 });
+    attachment_memory({ 3840, 2160 });
+}
+} // namespace bt::bench
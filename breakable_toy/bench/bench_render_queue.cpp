@@ -0,0 +1,91 @@
+#include "bench.hpp"
+
+#include "bt_render_queue.hpp"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace bt::bench {
+namespace {
+// Stands in for the Vulkan recorder: counts commands so only the queue's own CPU cost is measured.
+struct counting_recorder {
+    uint64_t commands = 0;
+
+    void bind_pipeline(uint32_t) { commands++; }
+    void bind_descriptor_set(uint32_t) { commands++; }
+    void bind_mesh(uint32_t) { commands++; }
+    void draw(const bt_draw&, const void*, uint32_t) { commands++; }
+};
+} // namespace
+
+void render_queue()
+{
+    constexpr uint32_t PIPELINES = 32;
+    constexpr uint32_t DESCRIPTOR_SETS = 128;
+    constexpr uint32_t MESHES = 1024;
+    constexpr uint32_t PUSH_SIZE = 32;
+
+    std::mt19937 rng { 42 };
+    std::uniform_int_distribution<uint32_t> pipeline { 0, PIPELINES - 1 };
+    std::uniform_int_distribution<uint32_t> descriptor_set { 0, DESCRIPTOR_SETS - 1 };
+    std::uniform_int_distribution<uint32_t> mesh { 0, MESHES - 1 };
+    std::uniform_real_distribution<float> depth { 0.0f, 1.0f };
+    std::byte push[PUSH_SIZE] {};
+
+    unsigned hardware_threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    for (size_t count : { 10'000u, 100'000u, 1'000'000u }) {
+        std::vector<bt_draw> draws(count);
+        for (auto& draw : draws) {
+            draw.pipeline = pipeline(rng);
+            draw.descriptor_set = descriptor_set(rng);
+            draw.mesh = mesh(rng);
+            draw.depth = depth(rng);
+        }
+
+        fmt::print("{} draws ({} pipelines, {} descriptor sets, {} meshes)\n",
+            count,
+            PIPELINES,
+            DESCRIPTOR_SETS,
+            MESHES);
+
+        for (unsigned threads : { 0u, 1u, hardware_threads }) {
+            bt_render_queue queue { std::max(threads, 1u) };
+
+            stopwatch build;
+            for (const auto& draw : draws) {
+                queue.push(draw, push, PUSH_SIZE);
+            }
+            double build_ms = build.elapsed_ms();
+
+            // Zero threads means submission order, i.e. what recording without the queue would do.
+            if (threads > 0) {
+                queue.sort();
+            }
+
+            counting_recorder recorder;
+            stopwatch replay;
+            queue.replay(recorder);
+            double replay_ms = replay.elapsed_ms();
+
+            const auto& stats = queue.stats();
+            fmt::print("  {:<14} build {:7.3f} ms, sort {:7.3f} ms, replay {:7.3f} ms | binds issued/elided: "
+                       "pipeline {}/{}, descriptor set {}/{}, mesh {}/{}\n",
+                threads == 0 ? "unsorted" : fmt::format("sorted, {} thr", threads),
+                build_ms,
+                stats.sort_ms,
+                replay_ms,
+                stats.pipeline_binds,
+                stats.pipeline_binds_elided,
+                stats.descriptor_set_binds,
+                stats.descriptor_set_binds_elided,
+                stats.mesh_binds,
+                stats.mesh_binds_elided);
+        }
+    }
+}
+} // namespace bt::bench
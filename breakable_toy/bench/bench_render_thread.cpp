@@ -0,0 +1,183 @@
+#include "bench.hpp"
+
+#include "bt_simulation.hpp"
+#include "bt_spsc_queue.hpp"
+
+#include <fmt/core.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace bt::bench {
+namespace {
+using clock = std::chrono::steady_clock;
+
+constexpr auto RUN_TIME = std::chrono::milliseconds { 1500 };
+constexpr auto FRAME_PERIOD = std::chrono::microseconds { 16667 };
+constexpr auto RENDER_COST = std::chrono::milliseconds { 4 };
+// Input arrives every millisecond. Every DRAG_PERIOD the event pump is stuck for DRAG_STALL, as in the modal loop
+// Windows runs while a window is dragged or resized.
+constexpr auto INPUT_PERIOD = std::chrono::milliseconds { 1 };
+constexpr auto DRAG_PERIOD = std::chrono::milliseconds { 300 };
+constexpr auto DRAG_STALL = std::chrono::milliseconds { 100 };
+
+struct input_event {
+    clock::time_point time;
+};
+
+class event_source {
+  public:
+    explicit event_source(clock::time_point start) :
+        start { start },
+        next_event { start }
+    {
+    }
+
+    // Like glfwPollEvents: delivers everything that arrived so far, but not before a stall is over.
+    template <typename Deliver>
+    int pump(Deliver&& deliver)
+    {
+        auto into_period = (clock::now() - start) % DRAG_PERIOD;
+        if (into_period < DRAG_STALL) {
+            std::this_thread::sleep_for(DRAG_STALL - into_period);
+        }
+
+        int events = 0;
+        for (auto now = clock::now(); next_event <= now; next_event += INPUT_PERIOD) {
+            deliver(input_event { next_event });
+            events++;
+        }
+        return events;
+    }
+
+  private:
+    clock::time_point start;
+    clock::time_point next_event;
+};
+
+// Presenting with vsync: render, then wait for the next vblank.
+void render_frame(clock::time_point& next_vblank)
+{
+    std::this_thread::sleep_for(RENDER_COST);
+    auto now = clock::now();
+    while (next_vblank <= now) {
+        next_vblank += FRAME_PERIOD;
+    }
+    std::this_thread::sleep_until(next_vblank);
+}
+
+void report(const char* name, const bt_jitter_stats& frames, int events, const bt_jitter_stats& latency)
+{
+    fmt::print("  {:<24} {:4} frames, {:6.2f} ms mean, {:6.2f} ms jitter, {:6.2f} ms worst; {:5} events, "
+               "{:6.2f} ms mean / {:6.2f} ms worst latency\n",
+        name,
+        frames.samples + 1,
+        frames.mean_ms,
+        frames.stddev_ms,
+        frames.max_ms,
+        events,
+        latency.mean_ms,
+        latency.max_ms);
+}
+
+double since_ms(clock::time_point time)
+{
+    return std::chrono::duration<double, std::milli>(clock::now() - time).count();
+}
+
+// Polls events, then draws; event stalls hold up the frame.
+void polling_render_thread()
+{
+    bt_jitter_tracker frames;
+    bt_jitter_tracker latency;
+    int events = 0;
+    auto start = clock::now();
+    event_source source { start };
+    auto next_vblank = start + FRAME_PERIOD;
+    while (clock::now() - start < RUN_TIME) {
+        frames.tick(clock::now());
+        events += source.pump([&](const input_event& event) { latency.add(since_ms(event.time)); });
+        render_frame(next_vblank);
+    }
+    report("polling on render thread", frames.stats(), events, latency.stats());
+}
+
+// Pumps events on this thread and draws on another, handing input over through a queue.
+void dedicated_render_thread()
+{
+    bt_spsc_queue<input_event, 1024> queue;
+    std::atomic<bool> stopping = false;
+    bt_jitter_tracker frames;
+    bt_jitter_tracker latency;
+    int events = 0;
+    auto start = clock::now();
+
+    std::thread renderer { [&] {
+        auto next_vblank = start + FRAME_PERIOD;
+        while (!stopping.load()) {
+            frames.tick(clock::now());
+            input_event event;
+            while (queue.pop(event)) {
+                latency.add(since_ms(event.time));
+                events++;
+            }
+            render_frame(next_vblank);
+        }
+    } };
+
+    // Stands in for glfwWaitEvents.
+    event_source source { start };
+    int dropped = 0;
+    while (clock::now() - start < RUN_TIME) {
+        source.pump([&](const input_event& event) { dropped += queue.push(event) ? 0 : 1; });
+        std::this_thread::sleep_for(INPUT_PERIOD);
+    }
+    stopping.store(true);
+    renderer.join();
+    report("dedicated render thread", frames.stats(), events, latency.stats());
+    if (dropped > 0) {
+        fmt::print("  {} events dropped\n", dropped);
+    }
+}
+
+void queue_throughput()
+{
+    constexpr int COUNT = 1'000'000;
+    bt_spsc_queue<int, 1024> queue;
+
+    stopwatch timer;
+    std::thread consumer { [&] {
+        int value = 0;
+        for (int received = 0; received < COUNT;) {
+            if (queue.pop(value)) {
+                received++;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    } };
+    for (int i = 0; i < COUNT;) {
+        if (queue.push(i)) {
+            i++;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    consumer.join();
+    double ms = timer.elapsed_ms();
+    fmt::print("  spsc queue: {} values in {:.1f} ms, {:.1f} ns per value\n", COUNT, ms, ms * 1e6 / COUNT);
+}
+} // namespace
+
+void render_thread()
+{
+    fmt::print("60 Hz vsync, {} ms of rendering, event pump stalled {} of every {} ms:\n",
+        RENDER_COST.count(),
+        DRAG_STALL.count(),
+        DRAG_PERIOD.count());
+    polling_render_thread();
+    dedicated_render_thread();
+    queue_throughput();
+}
+} // namespace bt::bench
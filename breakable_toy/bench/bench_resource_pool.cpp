@@ -0,0 +1,139 @@
+#include "bench.hpp"
+
+#include "bt_resource_pool.hpp"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace bt::bench {
+namespace {
+constexpr uint32_t RESOURCES = 100'000;
+constexpr int LOOKUP_ROUNDS = 20;
+constexpr int ITERATION_ROUNDS = 50;
+
+// Roughly what a draw reads from a mesh: bounds and index ranges.
+struct mesh_record {
+    float bounds[6];
+    uint32_t first_index;
+    uint32_t index_count;
+    uint32_t vertex_offset;
+    uint32_t lod_count;
+};
+
+mesh_record make_record(uint32_t i)
+{
+    auto f = static_cast<float>(i);
+    return { { f, f, f, f + 1.0f, f + 1.0f, f + 1.0f }, i * 6, 6, i * 4, 1 };
+}
+
+// Objects created over the life of a scene are interleaved with other allocations, so their heap addresses end up
+// scattered. Each mesh here is followed by a short-lived allocation of a random size that stays behind as a gap.
+std::vector<std::unique_ptr<mesh_record>> scattered_meshes(std::mt19937& rng)
+{
+    std::uniform_int_distribution<size_t> gap { 16, 512 };
+    std::vector<std::unique_ptr<mesh_record>> meshes;
+    std::vector<std::unique_ptr<std::byte[]>> other;
+    meshes.reserve(RESOURCES);
+    other.reserve(RESOURCES);
+    for (uint32_t i = 0; i < RESOURCES; i++) {
+        meshes.push_back(std::make_unique<mesh_record>(make_record(i)));
+        other.push_back(std::make_unique<std::byte[]>(gap(rng)));
+    }
+    return meshes;
+}
+
+uint64_t read(const mesh_record& mesh)
+{
+    return mesh.first_index + mesh.index_count + static_cast<uint64_t>(mesh.bounds[3]);
+}
+
+void report(const char* name, double ms, uint64_t operations, uint64_t checksum)
+{
+    fmt::print("  {:<34} {:8.2f} ms, {:6.2f} ns per resource (checksum {})\n",
+        name,
+        ms,
+        ms * 1e6 / static_cast<double>(operations),
+        checksum);
+}
+} // namespace
+
+void resource_pool()
+{
+    std::mt19937 rng { 42 };
+    auto pointers = scattered_meshes(rng);
+
+    bt_resource_pool<mesh_record> pool { RESOURCES };
+    std::vector<bt_handle<mesh_record>> handles;
+    handles.reserve(RESOURCES);
+    for (uint32_t i = 0; i < RESOURCES; i++) {
+        handles.push_back(pool.create(make_record(i)));
+    }
+
+    // Draws reference resources in an order unrelated to creation.
+    std::vector<uint32_t> order(RESOURCES);
+    std::iota(order.begin(), order.end(), 0u);
+    std::shuffle(order.begin(), order.end(), rng);
+
+    fmt::print("{} meshes, {} byte records:\n", RESOURCES, sizeof(mesh_record));
+
+    uint64_t checksum = 0;
+    stopwatch timer;
+    for (int round = 0; round < LOOKUP_ROUNDS; round++) {
+        for (auto i : order) {
+            checksum += read(*pointers[i]);
+        }
+    }
+    report("resolve unique_ptr, random order", timer.elapsed_ms(), uint64_t { RESOURCES } * LOOKUP_ROUNDS, checksum);
+
+    checksum = 0;
+    timer.reset();
+    for (int round = 0; round < LOOKUP_ROUNDS; round++) {
+        for (auto i : order) {
+            checksum += read(pool.get(handles[i]));
+        }
+    }
+    report("resolve handle, random order", timer.elapsed_ms(), uint64_t { RESOURCES } * LOOKUP_ROUNDS, checksum);
+
+    checksum = 0;
+    timer.reset();
+    for (int round = 0; round < ITERATION_ROUNDS; round++) {
+        for (const auto& mesh : pointers) {
+            checksum += read(*mesh);
+        }
+    }
+    report("iterate unique_ptr vector", timer.elapsed_ms(), uint64_t { RESOURCES } * ITERATION_ROUNDS, checksum);
+
+    checksum = 0;
+    timer.reset();
+    for (int round = 0; round < ITERATION_ROUNDS; round++) {
+        pool.for_each([&](bt_handle<mesh_record>, const mesh_record& mesh) { checksum += read(mesh); });
+    }
+    report("iterate pool", timer.elapsed_ms(), uint64_t { RESOURCES } * ITERATION_ROUNDS, checksum);
+
+    // Churn: replace a random tenth of the resources, as streaming does.
+    timer.reset();
+    for (uint32_t n = 0; n < RESOURCES / 10; n++) {
+        auto i = order[n];
+        pointers[i] = std::make_unique<mesh_record>(make_record(i));
+    }
+    report("replace 10% via make_unique", timer.elapsed_ms(), RESOURCES / 10, 0);
+
+    timer.reset();
+    for (uint32_t n = 0; n < RESOURCES / 10; n++) {
+        auto i = order[n];
+        pool.destroy(handles[i]);
+        handles[i] = pool.create(make_record(i));
+    }
+    report("replace 10% via pool", timer.elapsed_ms(), RESOURCES / 10, 0);
+
+    // Handles to replaced resources are now stale rather than dangling.
+    bt_handle<mesh_record> stale { handles[order[0]].index(), handles[order[0]].generation() - 1 };
+    fmt::print("  stale handle detected: {}\n", !pool.valid(stale));
+}
+} // namespace bt::bench
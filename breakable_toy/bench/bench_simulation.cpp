@@ -0,0 +1,112 @@
+#include "bench.hpp"
+
+#include "bt_simulation.hpp"
+#include "bt_triple_buffer.hpp"
+
+#include <fmt/core.h>
+
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+namespace bt::bench {
+namespace {
+constexpr double RUN_SECONDS = 1.5;
+
+struct snapshot {
+    uint64_t step = 0;
+    double time = 0.0;
+    // Moves at one unit per second, so it reads as simulated seconds.
+    double position = 0.0;
+};
+
+// Renders at `render_hz` against a 120 Hz simulation, every 30th frame taking three times as long. Displayed motion
+// is compared with the motion the frame interval calls for: drawing the latest snapshot moves objects in whole steps,
+// interpolating between the last two moves them by the time that actually passed.
+void run(double render_hz)
+{
+    bt_triple_buffer<snapshot> snapshots;
+    double position = 0.0;
+    bt_fixed_step_loop loop {
+        [&](uint64_t step, double time, double dt) {
+            position += dt;
+            snapshots.write_slot() = { step, time, position };
+            snapshots.publish();
+        },
+    };
+
+    snapshot previous;
+    snapshot current;
+    bt_jitter_tracker frames;
+    bt_jitter_tracker latest_error;
+    bt_jitter_tracker interpolated_error;
+    uint64_t fresh_frames = 0;
+    uint64_t frame_count = 0;
+    double last_time = 0.0;
+    double last_latest = 0.0;
+    double last_interpolated = 0.0;
+
+    auto period = std::chrono::duration<double>(1.0 / render_hz);
+    auto next = std::chrono::steady_clock::now();
+    while (loop.now() < RUN_SECONDS) {
+        frame_count++;
+        next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            period * (frame_count % 30 == 0 ? 3.0 : 1.0));
+        std::this_thread::sleep_until(next);
+        frames.tick(std::chrono::steady_clock::now());
+
+        if (snapshots.update()) {
+            previous = current;
+            current = snapshots.read();
+            fresh_frames++;
+        }
+
+        double time = loop.now() - loop.dt();
+        float alpha = bt_interpolation_alpha(previous.time, current.time, time);
+        double interpolated = previous.position + (current.position - previous.position) * alpha;
+
+        if (current.step > 1) {
+            double expected = time - last_time;
+            latest_error.add(1000.0 * std::abs(current.position - last_latest - expected));
+            interpolated_error.add(1000.0 * std::abs(interpolated - last_interpolated - expected));
+        }
+        last_time = time;
+        last_latest = current.position;
+        last_interpolated = interpolated;
+    }
+
+    auto sim = loop.stats();
+    auto frame = frames.stats();
+    fmt::print("render at {:.0f} Hz, simulate at {:.0f} Hz:\n", render_hz, 1.0 / loop.dt());
+    fmt::print("  simulation  {:6} steps  {:6.3f} ms mean, {:6.3f} ms jitter, {:6.3f}-{:6.3f} ms, worst {:.3f} ms "
+               "late, {} dropped\n",
+        sim.steps,
+        sim.interval.mean_ms,
+        sim.interval.stddev_ms,
+        sim.interval.min_ms,
+        sim.interval.max_ms,
+        sim.max_late_ms,
+        sim.dropped_steps);
+    fmt::print("  render      {:6} frames {:6.3f} ms mean, {:6.3f} ms jitter, {:6.3f}-{:6.3f} ms, {} with a new "
+               "snapshot\n",
+        frame.samples + 1,
+        frame.mean_ms,
+        frame.stddev_ms,
+        frame.min_ms,
+        frame.max_ms,
+        fresh_frames);
+    fmt::print("  motion error per frame, in ms of simulated time: latest snapshot {:.3f} mean / {:.3f} max, "
+               "interpolated {:.3f} mean / {:.3f} max\n",
+        latest_error.stats().mean_ms,
+        latest_error.stats().max_ms,
+        interpolated_error.stats().mean_ms,
+        interpolated_error.stats().max_ms);
+}
+} // namespace
+
+void simulation()
+{
+    run(60.0);
+    run(144.0);
+}
+} // namespace bt::bench
@@ -0,0 +1,139 @@
+#include "bench.hpp"
+
+#include "bt_simulation.hpp"
+
+#include <fmt/core.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace bt::bench {
+namespace {
+using namespace std::chrono_literals;
+
+constexpr int FRAMES = 120;
+constexpr uint64_t FRAMES_IN_FLIGHT = 2;
+// Costs of the app's frame and of rebuilding what a resize invalidates, in the order recreate_swapchain did them.
+constexpr auto GPU_FRAME = 8ms;
+constexpr auto CPU_FRAME = 2ms;
+constexpr auto SWAPCHAIN_CREATION = 1500us;
+constexpr auto RENDER_GRAPH_CREATION = 500us;
+constexpr auto PIPELINE_CREATION = 10ms;
+
+// Executes submitted frames one after another, like a queue, and signals their completion.
+class fake_queue {
+  public:
+    fake_queue() :
+        worker { [this] { run(); } }
+    {
+    }
+
+    ~fake_queue()
+    {
+        {
+            std::lock_guard lock { mutex };
+            stopping = true;
+        }
+        changed.notify_all();
+        worker.join();
+    }
+
+    uint64_t submit()
+    {
+        std::lock_guard lock { mutex };
+        pending.push_back(++submitted);
+        changed.notify_all();
+        return submitted;
+    }
+
+    void wait(uint64_t frame)
+    {
+        std::unique_lock lock { mutex };
+        changed.wait(lock, [&] { return completed >= frame; });
+    }
+
+    void wait_idle() { wait(submitted); }
+
+  private:
+    void run()
+    {
+        std::unique_lock lock { mutex };
+        while (true) {
+            changed.wait(lock, [&] { return stopping || !pending.empty(); });
+            if (stopping) {
+                return;
+            }
+
+            uint64_t frame = pending.front();
+            pending.pop_front();
+            lock.unlock();
+            std::this_thread::sleep_for(GPU_FRAME);
+            lock.lock();
+            completed = frame;
+            changed.notify_all();
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<uint64_t> pending;
+    uint64_t submitted = 0;
+    uint64_t completed = 0;
+    bool stopping = false;
+    std::thread worker;
+};
+
+// Renders FRAMES frames with the window resized before each one.
+bt_jitter_stats resize_continuously(bool stall_free)
+{
+    fake_queue queue;
+    bt_jitter_tracker frames;
+
+    for (int frame = 0; frame < FRAMES; frame++) {
+        frames.tick(std::chrono::steady_clock::now());
+
+        if (stall_free) {
+            // Frames in flight keep the old swapchain; formats don't change, so the pipeline is kept.
+            std::this_thread::sleep_for(SWAPCHAIN_CREATION + RENDER_GRAPH_CREATION);
+        } else {
+            queue.wait_idle();
+            std::this_thread::sleep_for(SWAPCHAIN_CREATION + RENDER_GRAPH_CREATION + PIPELINE_CREATION);
+        }
+
+        // Acquire waits for the frame that last used this frame index.
+        if (frame >= static_cast<int>(FRAMES_IN_FLIGHT)) {
+            queue.wait(static_cast<uint64_t>(frame) + 1 - FRAMES_IN_FLIGHT);
+        }
+        std::this_thread::sleep_for(CPU_FRAME);
+        queue.submit();
+    }
+    frames.tick(std::chrono::steady_clock::now());
+    queue.wait_idle();
+
+    return frames.stats();
+}
+
+void report(const char* name, const bt_jitter_stats& stats)
+{
+    fmt::print("  {:<38} {:6.2f} ms mean, {:6.2f} ms worst, {:5.2f} ms jitter\n",
+        name,
+        stats.mean_ms,
+        stats.max_ms,
+        stats.stddev_ms);
+}
+} // namespace
+
+void swapchain_recreation()
+{
+    fmt::print("resizing every frame; {} ms GPU and {} ms CPU per frame, {} frames in flight:\n",
+        GPU_FRAME.count(),
+        CPU_FRAME.count(),
+        FRAMES_IN_FLIGHT);
+    report("vkDeviceWaitIdle and rebuild all", resize_continuously(false));
+    report("retire old swapchain, rebuild by size", resize_continuously(true));
+}
+} // namespace bt::bench
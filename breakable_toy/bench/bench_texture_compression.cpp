@@ -0,0 +1,75 @@
+#include "bench.hpp"
+
+#include "bt_block_compression.hpp"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace bt::bench {
+namespace {
+constexpr uint32_t SIZE = 1024;
+
+// Smooth gradients, hard edges and noise, so every encoder sees both easy and difficult blocks.
+std::vector<std::byte> make_image()
+{
+    std::mt19937 rng { 42 };
+    std::uniform_int_distribution<int> noise { -12, 12 };
+
+    std::vector<std::byte> pixels(static_cast<size_t>(SIZE) * SIZE * 4);
+    for (uint32_t y = 0; y < SIZE; y++) {
+        for (uint32_t x = 0; x < SIZE; x++) {
+            bool tile = ((x / 32) + (y / 32)) % 2 == 0;
+            float wave = 0.5f + 0.5f * std::sin(static_cast<float>(x) * 0.02f + static_cast<float>(y) * 0.013f);
+            int values[4] = { static_cast<int>(x * 255 / SIZE),
+                static_cast<int>(wave * 255.0f),
+                tile ? 220 : 40,
+                static_cast<int>(y * 255 / SIZE) };
+            auto* texel = &pixels[(static_cast<size_t>(y) * SIZE + x) * 4];
+            for (int c = 0; c < 4; c++) {
+                texel[c] = static_cast<std::byte>(std::clamp(values[c] + noise(rng), 0, 255));
+            }
+        }
+    }
+    return pixels;
+}
+} // namespace
+
+void texture_compression()
+{
+    std::vector<std::byte> pixels = make_image();
+    unsigned threads = std::max(std::thread::hardware_concurrency(), 1u);
+    double megapixels = static_cast<double>(SIZE) * SIZE / 1e6;
+    size_t rgba8_size = pixels.size();
+
+    fmt::print("{}x{} RGBA8, {} KiB\n", SIZE, SIZE, rgba8_size / 1024);
+    fmt::print("  {:<4} {:>15} {:>15} {:>10} {:>9}\n", "", "1 thread", "threads", "PSNR", "size");
+
+    for (auto format : { bt_block_format::bc1, bt_block_format::bc3, bt_block_format::bc5, bt_block_format::bc7 }) {
+        const auto& info = bt_block_info(format);
+
+        stopwatch single;
+        std::vector<std::byte> blocks = bt_compress_blocks(format, pixels.data(), SIZE, SIZE, 1);
+        double single_ms = single.elapsed_ms();
+
+        stopwatch threaded;
+        blocks = bt_compress_blocks(format, pixels.data(), SIZE, SIZE, threads);
+        double threaded_ms = threaded.elapsed_ms();
+
+        std::vector<std::byte> decoded = bt_decompress_blocks(format, blocks.data(), SIZE, SIZE);
+        double psnr = bt_psnr(pixels.data(), decoded.data(), static_cast<size_t>(SIZE) * SIZE, info.channels);
+
+        fmt::print("  {:<4} {:8.1f} MPix/s {:8.1f} MPix/s {:7.2f} dB {:6.1f}x smaller\n",
+            info.name,
+            megapixels / (single_ms / 1000.0),
+            megapixels / (threaded_ms / 1000.0),
+            psnr,
+            static_cast<double>(rgba8_size) / static_cast<double>(blocks.size()));
+    }
+    fmt::print("  threaded runs use {} thread(s); PSNR is over the channels each format stores\n", threads);
+}
+} // namespace bt::bench
@@ -0,0 +1,54 @@
+#include "bench.hpp"
+
+#include "bt_filesystem.hpp"
+
+#include <fmt/core.h>
+
+#include <cstdlib>
+#include <string_view>
+
+namespace {
+struct benchmark {
+    std::string_view name;
+    void (*run)();
+};
+
+constexpr benchmark benchmarks[] = {
+    { "culling", bt::bench::culling },
+    { "dynamic_resolution", bt::bench::dynamic_resolution },
+    { "frame_arena", bt::bench::frame_arena },
+    { "host_allocator", bt::bench::host_allocator },
+    { "lod", bt::bench::lod },
+    { "logging", bt::bench::logging },
+    { "mip_generation", bt::bench::mip_generation },
+    { "particles", bt::bench::particles },
+    { "pipeline_permutations", bt::bench::pipeline_permutations },
+    { "render_graph", bt::bench::render_graph },
+    { "render_queue", bt::bench::render_queue },
+    { "render_thread", bt::bench::render_thread },
+    { "resource_pool", bt::bench::resource_pool },
+    { "simulation", bt::bench::simulation },
+    { "swapchain_recreation", bt::bench::swapchain_recreation },
+    { "texture_compression", bt::bench::texture_compression },
+};
+} // namespace
+
+// Runs every benchmark, or only those named on the command line.
+int main(int argc, char* argv[])
+{
+    bt::bt_filesystem::init(argv[0]);
+
+    for (const auto& benchmark : benchmarks) {
+        bool selected = argc == 1;
+        for (int i = 1; i < argc; i++) {
+            selected |= benchmark.name == argv[i];
+        }
+
+        if (selected) {
+            fmt::print("== {} ==\n", benchmark.name);
+            benchmark.run();
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
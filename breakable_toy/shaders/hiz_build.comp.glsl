@@ -0,0 +1,36 @@
+#version 450
+
+// Builds one level of the depth pyramid used for occlusion culling. Every texel holds the farthest depth of the part
+// of the source it covers, so whatever lies behind it lies behind everything drawn there. Level 0 is reduced from the
+// depth attachment, which need not be a power of two, so the part a texel covers is rounded outwards and may overlap
+// its neighbours'; every other level halves the one above exactly.
+
+layout (local_size_x = 8, local_size_y = 8) in;
+
+layout (set = 0, binding = 0) uniform sampler2D source;
+layout (set = 0, binding = 1, r32f) uniform writeonly image2D destination;
+
+layout (push_constant) uniform Push {
+    uvec2 source_size;
+    uvec2 destination_size;
+} push;
+
+void main()
+{
+    uvec2 texel = gl_GlobalInvocationID.xy;
+    if (any(greaterThanEqual(texel, push.destination_size))) {
+        return;
+    }
+
+    vec2 scale = vec2(push.source_size) / vec2(push.destination_size);
+    ivec2 first = ivec2(floor(vec2(texel) * scale));
+    ivec2 last = min(ivec2(ceil(vec2(texel + 1) * scale)) - 1, ivec2(push.source_size) - 1);
+
+    float depth = 0.0;
+    for (int y = first.y; y <= last.y; y++) {
+        for (int x = first.x; x <= last.x; x++) {
+            depth = max(depth, texelFetch(source, ivec2(x, y), 0).r);
+        }
+    }
+    imageStore(destination, ivec2(texel), vec4(depth));
+}
@@ -0,0 +1,161 @@
+#version 450
+
+// Single-pass mip generation: one dispatch writes up to 12 levels below level 0. Each workgroup reduces a 64x64 tile
+// of level 0 to levels 1-6 in shared memory; the last workgroup to finish then reduces level 6 to levels 7-12. Every
+// texel is the 2x2 box filter of the level above, with coordinates clamped at the edges.
+
+layout (local_size_x = 256) in;
+
+layout (set = 0, binding = 0, rgba8) uniform readonly image2D level_0;
+layout (set = 0, binding = 1, rgba8) uniform coherent image2D levels[12];
+layout (set = 0, binding = 2) coherent buffer Counter {
+    uint finished_groups;
+} counter;
+
+layout (push_constant) uniform Push {
+    uvec2 size;
+    uint mip_count;
+    // Views are UNORM aliases of sRGB images, so filtering happens in linear space only if converted here.
+    uint srgb;
+    uint group_count;
+} push;
+
+const uint TILE = 64;
+
+shared vec4 tile[TILE / 2][TILE / 2];
+shared bool last_group;
+
+uvec2 level_size(uint level)
+{
+    return max(push.size >> level, uvec2(1));
+}
+
+vec4 to_linear(vec4 c)
+{
+    if (push.srgb == 0) {
+        return c;
+    }
+    vec3 low = c.rgb / 12.92;
+    vec3 high = pow((c.rgb + 0.055) / 1.055, vec3(2.4));
+    return vec4(mix(high, low, lessThanEqual(c.rgb, vec3(0.04045))), c.a);
+}
+
+vec4 to_srgb(vec4 c)
+{
+    if (push.srgb == 0) {
+        return c;
+    }
+    vec3 low = c.rgb * 12.92;
+    vec3 high = 1.055 * pow(c.rgb, vec3(1.0 / 2.4)) - 0.055;
+    return vec4(mix(high, low, lessThanEqual(c.rgb, vec3(0.0031308))), c.a);
+}
+
+// Only level 0 and level 6 are ever read back from images; the levels in between stay in shared memory.
+vec4 load_texel(uint level, ivec2 p)
+{
+    return to_linear(level == 0 ? imageLoad(level_0, p) : imageLoad(levels[5], p));
+}
+
+void store_texel(uint level, ivec2 p, vec4 c)
+{
+    c = to_srgb(c);
+    switch (level) {
+    case 1: imageStore(levels[0], p, c); break;
+    case 2: imageStore(levels[1], p, c); break;
+    case 3: imageStore(levels[2], p, c); break;
+    case 4: imageStore(levels[3], p, c); break;
+    case 5: imageStore(levels[4], p, c); break;
+    case 6: imageStore(levels[5], p, c); break;
+    case 7: imageStore(levels[6], p, c); break;
+    case 8: imageStore(levels[7], p, c); break;
+    case 9: imageStore(levels[8], p, c); break;
+    case 10: imageStore(levels[9], p, c); break;
+    case 11: imageStore(levels[10], p, c); break;
+    case 12: imageStore(levels[11], p, c); break;
+    }
+}
+
+void store_if_inside(uint level, uvec2 p, vec4 c)
+{
+    if (all(lessThan(p, level_size(level)))) {
+        store_texel(level, ivec2(p), c);
+    }
+}
+
+// Reduces the TILE x TILE texels of source_level starting at origin through up to six levels.
+void downsample_tile(uint source_level, uvec2 origin)
+{
+    uint last_level = min(source_level + 6, push.mip_count - 1);
+
+    // First level straight from the image, four texels per thread.
+    ivec2 source_max = ivec2(level_size(source_level)) - 1;
+    for (uint i = gl_LocalInvocationIndex; i < (TILE / 2) * (TILE / 2); i += gl_WorkGroupSize.x) {
+        uvec2 local = uvec2(i % (TILE / 2), i / (TILE / 2));
+        ivec2 base = ivec2(origin + local * 2);
+        vec4 sum = load_texel(source_level, min(base, source_max))
+            + load_texel(source_level, min(base + ivec2(1, 0), source_max))
+            + load_texel(source_level, min(base + ivec2(0, 1), source_max))
+            + load_texel(source_level, min(base + ivec2(1, 1), source_max));
+        vec4 average = sum * 0.25;
+        tile[local.y][local.x] = average;
+        store_if_inside(source_level + 1, origin / 2 + local, average);
+    }
+    memoryBarrierShared();
+    barrier();
+
+    // Remaining levels from shared memory, reduced in place. Clamping is relative to the tile, which holds every
+    // texel a reduction inside it can reach.
+    for (uint level = source_level + 2; level <= last_level; level++) {
+        uint shift = level - source_level;
+        uint side = TILE >> shift;
+        uvec2 previous_origin = origin >> (shift - 1);
+        ivec2 previous_max = max(ivec2(level_size(level - 1)) - 1 - ivec2(previous_origin), ivec2(0));
+
+        bool active = gl_LocalInvocationIndex < side * side;
+        uvec2 local = uvec2(gl_LocalInvocationIndex % side, gl_LocalInvocationIndex / side);
+        vec4 average = vec4(0.0);
+        if (active) {
+            ivec2 base = ivec2(local * 2);
+            ivec2 p00 = min(base, previous_max);
+            ivec2 p10 = min(base + ivec2(1, 0), previous_max);
+            ivec2 p01 = min(base + ivec2(0, 1), previous_max);
+            ivec2 p11 = min(base + ivec2(1, 1), previous_max);
+            average = 0.25 * (tile[p00.y][p00.x] + tile[p10.y][p10.x] + tile[p01.y][p01.x] + tile[p11.y][p11.x]);
+        }
+        barrier();
+
+        if (active) {
+            tile[local.y][local.x] = average;
+            store_if_inside(level, (origin >> shift) + local, average);
+        }
+        memoryBarrierShared();
+        barrier();
+    }
+}
+
+void main()
+{
+    downsample_tile(0, gl_WorkGroupID.xy * TILE);
+    if (push.mip_count <= 7) {
+        return;
+    }
+
+    // Publish this group's level 6 texel, then count finished groups. The last one sees every other group's level 6.
+    memoryBarrierImage();
+    barrier();
+    if (gl_LocalInvocationIndex == 0) {
+        last_group = atomicAdd(counter.finished_groups, 1) == push.group_count - 1;
+    }
+    memoryBarrierShared();
+    barrier();
+    if (!last_group) {
+        return;
+    }
+
+    if (gl_LocalInvocationIndex == 0) {
+        // Ready for the next dispatch that uses this counter.
+        counter.finished_groups = 0;
+    }
+    memoryBarrierImage();
+    downsample_tile(6, uvec2(0));
+}
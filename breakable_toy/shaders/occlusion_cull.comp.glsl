@@ -0,0 +1,129 @@
+#version 450
+
+// Two-phase occlusion culling. Two pipelines are built from this file, one per STAGE. Every candidate has a command
+// for each phase, whose instance count of 0 or 1 is written here; the rest of the commands is written by the CPU.
+//
+//   prepare: turns on the first-phase draw of every candidate whose object was visible last frame.
+//   cull:    tests every candidate's bounds against the depth pyramid built from the first phase, turns on the
+//            second-phase draw of those visible but not drawn yet, and records each object's visibility for the next
+//            frame. Reference frames draw everything not drawn yet, so what culling saves can be measured.
+
+layout (local_size_x = 64) in;
+
+layout (constant_id = 0) const uint STAGE = 0;
+
+const uint STAGE_PREPARE = 0;
+const uint STAGE_CULL = 1;
+
+struct Candidate {
+    vec4 box_min;
+    vec4 box_max;
+    uint object;
+};
+
+// VkDrawIndexedIndirectCommand; a VkDrawIndirectCommand for meshes without indices, whose instance count is also the
+// second member.
+struct Command {
+    uint index_count;
+    uint instance_count;
+    uint first_index;
+    int vertex_offset;
+    uint first_instance;
+};
+
+layout (set = 0, binding = 0) readonly buffer Candidates {
+    Candidate candidates[];
+};
+
+// The first phase's commands, then the second's.
+layout (set = 0, binding = 1) buffer Commands {
+    Command commands[];
+};
+
+layout (set = 0, binding = 2) buffer Visibility {
+    uint visible[];
+};
+
+layout (set = 0, binding = 3) buffer Counters {
+    uint candidate_count;
+    uint first_phase;
+    uint occluded;
+    uint second_phase;
+} counters;
+
+layout (set = 0, binding = 4) uniform sampler2D pyramid;
+
+layout (push_constant) uniform Push {
+    mat4 view_projection;
+    // Size of level 0 in use, which may be less than the image's.
+    uvec2 pyramid_size;
+    uint level_count;
+    uint count;
+    uint capacity;
+    uint reference;
+} push;
+
+bool is_occluded(Candidate candidate)
+{
+    vec2 lo = vec2(1.0);
+    vec2 hi = vec2(0.0);
+    float nearest = 1.0;
+    for (uint corner = 0; corner < 8; corner++) {
+        vec3 pick = vec3(corner & 1, (corner >> 1) & 1, (corner >> 2) & 1);
+        vec4 clip = push.view_projection * vec4(mix(candidate.box_min.xyz, candidate.box_max.xyz, pick), 1.0);
+        // Boxes reaching behind the eye are never culled.
+        if (clip.w <= 0.0) {
+            return false;
+        }
+        vec3 ndc = clip.xyz / clip.w;
+        vec2 uv = ndc.xy * 0.5 + 0.5;
+        lo = min(lo, uv);
+        hi = max(hi, uv);
+        nearest = min(nearest, ndc.z);
+    }
+    lo = clamp(lo, 0.0, 1.0);
+    hi = clamp(hi, 0.0, 1.0);
+
+    // The level at which the box's screen rectangle is at most one texel across, so it touches at most 2x2 texels.
+    vec2 size = (hi - lo) * vec2(push.pyramid_size);
+    int level = int(clamp(ceil(log2(max(max(size.x, size.y), 1.0))), 0.0, float(push.level_count - 1)));
+    ivec2 level_size = max(ivec2(push.pyramid_size) >> level, ivec2(1));
+    ivec2 a = clamp(ivec2(lo * vec2(level_size)), ivec2(0), level_size - 1);
+    ivec2 b = clamp(ivec2(hi * vec2(level_size)), ivec2(0), level_size - 1);
+
+    float farthest = max(max(texelFetch(pyramid, a, level).r, texelFetch(pyramid, ivec2(b.x, a.y), level).r),
+        max(texelFetch(pyramid, ivec2(a.x, b.y), level).r, texelFetch(pyramid, b, level).r));
+    return nearest > farthest;
+}
+
+void main()
+{
+    uint i = gl_GlobalInvocationID.x;
+    if (i == 0 && STAGE == STAGE_PREPARE) {
+        counters.candidate_count = push.count;
+    }
+    if (i >= push.count) {
+        return;
+    }
+
+    uint object = candidates[i].object;
+    bool was_visible = visible[object] != 0;
+
+    if (STAGE == STAGE_PREPARE) {
+        commands[i].instance_count = was_visible ? 1 : 0;
+        if (was_visible) {
+            atomicAdd(counters.first_phase, 1);
+        }
+    } else if (STAGE == STAGE_CULL) {
+        bool occluded = is_occluded(candidates[i]);
+        bool draw = !was_visible && (!occluded || push.reference != 0);
+        commands[push.capacity + i].instance_count = draw ? 1 : 0;
+        visible[object] = occluded ? 0 : 1;
+        if (occluded) {
+            atomicAdd(counters.occluded, 1);
+        }
+        if (draw) {
+            atomicAdd(counters.second_phase, 1);
+        }
+    }
+}
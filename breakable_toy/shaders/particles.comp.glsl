@@ -0,0 +1,152 @@
+#version 450
+
+// GPU particle simulation. Three pipelines are built from this file, one per STAGE. Particles live in two buffers
+// that swap roles every frame: each frame reads the particles alive in src and appends the survivors, then the newly
+// emitted ones, to dst. Dead particles are compacted away by that append, with no free list or separate pass.
+//
+//   simulate: ages and integrates src, appending survivors to dst. It is dispatched indirectly, with the group count
+//             written by the previous frame's finalize.
+//   emit:     appends up to push.emit_count new particles to dst. It runs alongside simulate, since both only append,
+//             and it only takes the room that src's survivors cannot need.
+//   finalize: one invocation writes the draw of dst and the dispatch of next frame's simulate, then empties src.
+
+layout (local_size_x = 256) in;
+
+layout (constant_id = 0) const uint STAGE = 0;
+
+const uint STAGE_SIMULATE = 0;
+const uint STAGE_EMIT = 1;
+const uint STAGE_FINALIZE = 2;
+
+struct Particle {
+    vec2 position;
+    // Half-precision x and y.
+    uint velocity;
+    // Seconds left to live.
+    float life;
+};
+
+layout (set = 0, binding = 0) readonly buffer Src {
+    Particle particles[];
+} src;
+
+layout (set = 0, binding = 1) writeonly buffer Dst {
+    Particle particles[];
+} dst;
+
+// Matches bt_particle_state.
+layout (set = 0, binding = 2) buffer State {
+    uint alive[2];
+    uint simulated;
+    uint dropped;
+    uint draw_vertex_count;
+    uint draw_instance_count;
+    uint draw_first_vertex;
+    uint draw_first_instance;
+    uint dispatch_x;
+    uint dispatch_y;
+    uint dispatch_z;
+} state;
+
+layout (push_constant) uniform Push {
+    vec2 emitter;
+    vec2 velocity;
+    vec2 gravity;
+    float spread;
+    float lifetime;
+    float dt;
+    float size;
+    uint src;
+    uint emit_count;
+    uint capacity;
+    uint seed;
+} push;
+
+uint hash(uint x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+float random(inout uint rng)
+{
+    rng = hash(rng);
+    return float(rng >> 8) / 16777216.0;
+}
+
+void simulate(uint i)
+{
+    if (i >= state.alive[push.src]) {
+        return;
+    }
+
+    Particle p = src.particles[i];
+    p.life -= push.dt;
+    vec2 velocity = unpackHalf2x16(p.velocity) + push.gravity * push.dt;
+    p.position += velocity * push.dt;
+    p.velocity = packHalf2x16(velocity);
+
+    // Particles that leave the view die too.
+    if (p.life <= 0.0 || any(greaterThan(abs(p.position), vec2(2.0)))) {
+        return;
+    }
+
+    dst.particles[atomicAdd(state.alive[1 - push.src], 1)] = p;
+}
+
+void emit(uint i)
+{
+    if (i >= min(push.emit_count, push.capacity - state.alive[push.src])) {
+        return;
+    }
+
+    uint rng = hash(push.seed ^ hash(i));
+    float angle = (random(rng) - 0.5) * push.spread;
+    float speed = 0.75 + 0.5 * random(rng);
+    vec2 velocity = mat2(cos(angle), sin(angle), -sin(angle), cos(angle)) * push.velocity * speed;
+
+    Particle p;
+    p.position = push.emitter;
+    p.velocity = packHalf2x16(velocity);
+    p.life = push.lifetime * (0.5 + 0.5 * random(rng));
+
+    dst.particles[atomicAdd(state.alive[1 - push.src], 1)] = p;
+}
+
+void finalize()
+{
+    if (gl_GlobalInvocationID.x != 0) {
+        return;
+    }
+
+    uint alive = state.alive[1 - push.src];
+    state.simulated = state.alive[push.src];
+    state.dropped = push.emit_count - min(push.emit_count, push.capacity - state.alive[push.src]);
+    // src is next frame's dst.
+    state.alive[push.src] = 0;
+
+    // One quad per particle.
+    state.draw_vertex_count = 6;
+    state.draw_instance_count = alive;
+    state.draw_first_vertex = 0;
+    state.draw_first_instance = 0;
+
+    state.dispatch_x = (alive + gl_WorkGroupSize.x - 1) / gl_WorkGroupSize.x;
+    state.dispatch_y = 1;
+    state.dispatch_z = 1;
+}
+
+void main()
+{
+    if (STAGE == STAGE_SIMULATE) {
+        simulate(gl_GlobalInvocationID.x);
+    } else if (STAGE == STAGE_EMIT) {
+        emit(gl_GlobalInvocationID.x);
+    } else {
+        finalize();
+    }
+}
@@ -0,0 +1,44 @@
+#version 450
+
+// Draws the particles alive after this frame's simulation as quads, one instance each, fetched from the buffer the
+// simulation wrote them to.
+
+struct Particle {
+    vec2 position;
+    uint velocity;
+    float life;
+};
+
+layout (set = 0, binding = 1) readonly buffer Particles {
+    Particle particles[];
+};
+
+layout (push_constant) uniform Push {
+    vec2 emitter;
+    vec2 velocity;
+    vec2 gravity;
+    float spread;
+    float lifetime;
+    float dt;
+    float size;
+    uint src;
+    uint emit_count;
+    uint capacity;
+    uint seed;
+} push;
+
+layout (location = 0) out vec4 color;
+
+const vec2 corners[6] = vec2[](vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(1.0, 1.0),
+                               vec2(-1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, 1.0));
+
+void main()
+{
+    Particle p = particles[gl_InstanceIndex];
+
+    // Fades from yellow to red as the particle ages.
+    float t = clamp(p.life / push.lifetime, 0.0, 1.0);
+    color = vec4(mix(vec3(0.8, 0.15, 0.05), vec3(1.0, 0.85, 0.4), t), t);
+
+    gl_Position = vec4(p.position + corners[gl_VertexIndex] * push.size, 0.0, 1.0);
+}
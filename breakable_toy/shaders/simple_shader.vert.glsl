@@ -4,11 +4,12 @@ layout (location = 0) in vec2 position;
 layout (location = 1) in vec3 color;
 
 layout (push_constant) uniform Push {
-    vec2 offset;
+    // Clip-space offset and depth.
+    vec3 offset;
     vec3 color;
 } push;
 
 void main()
 {
-    gl_Position = vec4(position + push.offset, 0.0, 1.0);
+    gl_Position = vec4(position + push.offset.xy, push.offset.z, 1.0);
 }
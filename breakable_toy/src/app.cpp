@@ -1,49 +1,755 @@
 #include "app.hpp"
 
+#include "bt_filesystem.hpp"
 #include "bt_logger.hpp"
 #include "bt_maths.hpp"
 
+#include <fmt/core.h>
+
+#include <algorithm>
 #include <array>
 #include <cassert>
+#include <chrono>
+#include <exception>
 #include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
 
 namespace bt {
 struct push_constant_data {
-    alignas(8) glm::vec2 offset;
+    alignas(16) glm::vec3 offset;
     alignas(16) glm::vec3 color;
 };
 
-app::app()
+// Matches the uniform block at set 0, binding 0.
+struct frame_data {
+    glm::vec2 extent;
+    float time;
+    uint32_t frame;
+};
+
+namespace {
+// Translates the render queue's replay into Vulkan commands. Pipeline and mesh ids are resource handles.
+// Descriptors come from the bindless table, which is bound once per command buffer. A draw's slot indexes the
+// viewport's occlusion culling slots; draws that got one are issued as the phase's indirect draw, the rest are drawn
+// in the first phase.
+struct command_recorder {
+    VkCommandBuffer command_buffer;
+    VkPipelineLayout pipeline_layout;
+    bt_resources& resources;
+    bt_occlusion_culler& occlusion;
+    const std::vector<uint32_t>& occlusion_slots;
+    uint32_t phase;
+    bt_model* mesh = nullptr;
+
+    void bind_pipeline(uint32_t pipeline) { resources.pipeline(bt_pipeline_handle { pipeline }).bind(command_buffer); }
+    void bind_descriptor_set(uint32_t) { }
+    void bind_mesh(uint32_t mesh_handle)
+    {
+        mesh = &resources.mesh(bt_mesh_handle { mesh_handle });
+        mesh->bind(command_buffer);
+    }
+
+    void draw(const bt_draw& draw, const void* push_data, uint32_t push_size)
+    {
+        vkCmdPushConstants(command_buffer,
+            pipeline_layout,
+            VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+            0,
+            push_size,
+            push_data);
+
+        uint32_t slot = occlusion_slots[draw.slot];
+        if (slot != bt_occlusion_culler::NO_SLOT) {
+            occlusion.draw(command_buffer, *mesh, slot, phase);
+        } else if (phase == 0) {
+            mesh->draw(command_buffer, draw.lod);
+        }
+    }
+};
+} // namespace
+
+app::viewport_state::viewport_state(bt_device& device, bt_resources& resources, bt_window& window) :
+    device { device },
+    window { window },
+    surface { device.create_surface(window) },
+    render_graph_memory { device },
+    occlusion { device, resources, bt_swapchain::MAX_FRAMES_IN_FLIGHT }
+{
+}
+
+app::viewport_state::~viewport_state()
 {
-    load_models();
-    create_pipeline_layout();
-    recreate_swapchain();
+    render_graph.reset();
+    swapchain.reset();
+    device.destroy_later(surface);
+}
+
+app::app(const app_options& options) :
+    startup_profile { options.startup_profile },
+    device { options.track_host_allocations },
+    pipeline_registry { device, resources, options.dynamic_draw_state }
+{
+    // Windows are created on the thread that pumps their events.
+    for (uint32_t i = 0; i < options.viewports; i++) {
+        auto title = i == 0 ? std::string { "Breakable Toy" } : fmt::format("Breakable Toy (view {})", i + 1);
+        windows.push_back(std::make_unique<bt_window>(WIDTH, HEIGHT, title));
+        viewports.push_back(std::make_unique<viewport_state>(device, resources, *windows.back()));
+    }
+
+    initialise(options.serial_startup, options.startup_profile);
     create_command_buffers();
+    start_simulation();
 }
 
-app::~app() { vkDestroyPipelineLayout(device.device(), pipeline_layout, device.allocator()); }
+app::~app() { device.destroy_later(pipeline_layout); }
 
 void app::run()
 {
-    while (!window.should_close()) {
-        glfwPollEvents();
+    std::exception_ptr render_error;
+    std::thread render_thread { [&] {
+        try {
+            render_loop();
+        } catch (...) {
+            render_error = std::current_exception();
+        }
+
+        // Wake the main thread if it is waiting for events, in case the render thread stopped first.
+        render_stopping.store(true);
+        glfwPostEmptyEvent();
+    } };
+
+    // The OS can block event processing, e.g. while a window is dragged or resized on Windows; only this thread
+    // stalls then, the render thread keeps presenting.
+    auto any_closed = [&] {
+        return std::any_of(windows.begin(), windows.end(), [](const auto& window) { return window->should_close(); });
+    };
+    while (!any_closed() && !render_stopping.load()) {
+        glfwWaitEvents();
+    }
+
+    render_stopping.store(true);
+    render_thread.join();
+
+    if (render_error) {
+        std::rethrow_exception(render_error);
+    }
+}
+
+void app::render_loop()
+{
+    while (!render_stopping.load()) {
+        process_window_events();
+        track_frame_time();
         draw_frame();
-        // vkDeviceWaitIdle(device.device());
     }
 
     vkDeviceWaitIdle(device.device());
 }
 
+void app::process_window_events()
+{
+    auto now = std::chrono::steady_clock::now();
+    bt_window_event event;
+    for (auto& window : windows) {
+        while (window->poll_event(event)) {
+            // Resizes are picked up from the window's flag when the frame is presented; input has no consumers yet.
+            if (event.type == bt_window_event_type::resize) {
+                resize_events++;
+                last_resize = now;
+            } else {
+                input_events++;
+                last_input = now;
+            }
+        }
+    }
+}
+
+void app::track_frame_time()
+{
+    auto now = std::chrono::steady_clock::now();
+    if (last_frame_start != std::chrono::steady_clock::time_point {}) {
+        double interval_ms = std::chrono::duration<double, std::milli>(now - last_frame_start).count();
+        frame_intervals.add(interval_ms);
+        frame_dt = static_cast<float>(std::min(interval_ms, MAX_FRAME_DT_MS) / 1000.0);
+        if (now - last_input < WINDOW_ACTIVITY_SPAN) {
+            input_frame_intervals.add(interval_ms);
+        }
+        if (now - last_resize < WINDOW_ACTIVITY_SPAN) {
+            resize_frame_intervals.add(interval_ms);
+        }
+    }
+    last_frame_start = now;
+}
+
+void app::initialise(bool serial, bool profile)
+{
+    double before_ms
+        = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startup_start).count();
+
+    // Steps that run concurrently touch separate state: meshes, graphics pipelines and compute pipelines are separate
+    // pools of resources, which is not synchronised, and the scene and particle pipelines, sharing one, are created one
+    // after the other. Each swapchain step touches only its own viewport, and none records into the device's command
+    // pool.
+    bt_startup_graph graph;
+    auto bindless_table = graph.add("bindless table", {}, [this] { create_bindless_table(); });
+    auto shaders = graph.add("read shaders", {}, [this] { read_shaders(); });
+    auto meshes = graph.add("meshes", {}, [this] { load_models(); });
+    auto textures = graph.add("textures", { bindless_table }, [this] { load_textures(); });
+    auto layout = graph.add("pipeline layout", { bindless_table }, [this] { create_pipeline_layout(); });
+    std::vector<bt_startup_graph::step_id> swapchains;
+    for (size_t i = 0; i < viewports.size(); i++) {
+        swapchains.push_back(graph.add(fmt::format("swapchain {}", i), {}, [this, i] {
+            recreate_swapchain(*viewports[i], false);
+        }));
+    }
+
+    // A minimised window's viewport has no swapchain yet; pipelines are then created once it is restored.
+    auto first_with_swapchain = [this]() -> viewport_state* {
+        auto found = std::find_if(
+            viewports.begin(), viewports.end(), [](const auto& view) { return view->swapchain != nullptr; });
+        return found != viewports.end() ? found->get() : nullptr;
+    };
+    auto scene_pipeline_dependencies = swapchains;
+    scene_pipeline_dependencies.insert(scene_pipeline_dependencies.end(), { shaders, layout });
+    auto scene_pipeline = graph.add("scene pipeline", scene_pipeline_dependencies, [this, first_with_swapchain] {
+        if (auto* view = first_with_swapchain()) {
+            check_pipeline_formats(*view);
+            create_scene_pipeline(*view);
+        }
+    });
+    graph.add("particle pipeline", { scene_pipeline }, [this, first_with_swapchain] {
+        if (auto* view = first_with_swapchain()) {
+            create_particle_pipeline(*view);
+        }
+    });
+    graph.add("scene", { meshes, textures }, [this] { create_scene(); });
+
+    graph.run(serial ? 1 : std::thread::hardware_concurrency());
+
+    if (profile) {
+        SPDLOG_INFO("startup: {:.2f} ms creating the device, windows and surfaces first", before_ms);
+        graph.log_trace();
+    } else {
+        SPDLOG_DEBUG("startup: {:.2f} ms, then {:.2f} ms of steps in {:.2f} ms on {} threads",
+            before_ms,
+            graph.serial_ms(),
+            graph.wall_ms(),
+            graph.threads_used());
+    }
+}
+
+void app::create_bindless_table()
+{
+    if (!device.bindless_supported()) {
+        SPDLOG_WARN("descriptor indexing not supported, bindless resources disabled");
+        return;
+    }
+
+    bindless = std::make_unique<bt_bindless_table>(device);
+}
+
+void app::read_shaders()
+{
+    for (const char* path : { "shaders/simple_shader.vert.spv", "shaders/simple_shader.frag.spv" }) {
+        pipeline_registry.add_shader(path, bt_filesystem::read_file(path));
+    }
+}
+
 void app::load_models()
 {
-    std::vector<bt_model::vertex> vertices {
+    std::array<bt_model::vertex, 3> corners { {
         // clang-format off
         {{ 0.0f, -0.5f }, { 1.0f, 0.0f, 0.0f }},
         {{ 0.5f, 0.5f },  { 0.0f, 1.0f, 0.0f }},
         {{ -0.5f, 0.5f }, { 0.0f, 0.0f, 1.0f }}
         // clang-format on
+    } };
+
+    // Tessellate the triangle so there is geometry for the simplifier to remove.
+    auto triangle = [&](float scale) {
+        constexpr uint32_t subdivisions = 16;
+        bt_model::builder builder {};
+        for (uint32_t row = 0; row <= subdivisions; row++) {
+            for (uint32_t column = 0; column <= row; column++) {
+                float b = static_cast<float>(row - column) / subdivisions;
+                float c = static_cast<float>(column) / subdivisions;
+                float a = 1.0f - b - c;
+                builder.vertices.push_back(
+                    { scale * (a * corners[0].position + b * corners[1].position + c * corners[2].position),
+                        a * corners[0].color + b * corners[1].color + c * corners[2].color });
+            }
+        }
+
+        auto index_of = [](uint32_t row, uint32_t column) { return row * (row + 1) / 2 + column; };
+        for (uint32_t row = 0; row < subdivisions; row++) {
+            for (uint32_t column = 0; column <= row; column++) {
+                builder.indices.insert(builder.indices.end(),
+                    { index_of(row, column), index_of(row + 1, column), index_of(row + 1, column + 1) });
+                if (column < row) {
+                    builder.indices.insert(builder.indices.end(),
+                        { index_of(row, column), index_of(row + 1, column + 1), index_of(row, column + 1) });
+                }
+            }
+        }
+
+        builder.generate_lods(MAX_LODS);
+        return resources.create_mesh(builder);
     };
-    model = std::make_unique<bt_model>(device, vertices);
+
+    quad = triangle(1.0f);
+    pebble = triangle(0.12f);
+
+    // An occluder for the pebbles behind it.
+    bt_model::builder wall_builder {};
+    wall_builder.vertices = {
+        // clang-format off
+        {{ -0.6f, -0.6f }, { 0.5f, 0.5f, 0.5f }},
+        {{ 0.6f, -0.6f },  { 0.5f, 0.5f, 0.5f }},
+        {{ 0.6f, 0.6f },   { 0.5f, 0.5f, 0.5f }},
+        {{ -0.6f, 0.6f },  { 0.5f, 0.5f, 0.5f }}
+        // clang-format on
+    };
+    wall_builder.indices = { 0, 1, 2, 0, 2, 3 };
+    wall = resources.create_mesh(wall_builder);
+
+    const auto& model = resources.mesh(quad);
+    for (uint32_t i = 0; i < model.lods().size(); i++) {
+        SPDLOG_DEBUG("lod {}: {} triangles, error {}", i, model.triangle_count(i), model.lods()[i].error);
+    }
+}
+
+bt_aabb app::object_bounds(const scene_object& object)
+{
+    return resources.mesh(object.mesh).bounding_box().translated(glm::vec3(object.offset, object.depth));
+}
+
+void app::load_textures()
+{
+    texture_streamer = std::make_unique<bt_texture_streamer>(device, resources, bindless.get());
+
+    // Textures cooked by texture_cooker into textures/ next to the executable; none are checked in, so missing ones
+    // are replaced by uncompressed checkerboards rather than encoded at startup.
+    constexpr uint32_t size = 1024;
+    constexpr uint32_t squares = 16;
+    for (uint32_t i = 0; i < 4; i++) {
+        auto cooked = bt_filesystem::absolute_path_to(fmt::format("textures/checker_{}.bttx", i));
+        if (fs::exists(cooked)) {
+            textures.push_back(texture_streamer->add(bt_load_texture(device, cooked)));
+            continue;
+        }
+
+        std::vector<std::byte> pixels(static_cast<size_t>(size) * size * 4);
+        for (uint32_t y = 0; y < size; y++) {
+            for (uint32_t x = 0; x < size; x++) {
+                bool light = ((x * squares / size) + (y * squares / size)) % 2 == 0;
+                auto* texel = &pixels[(static_cast<size_t>(y) * size + x) * 4];
+                texel[0] = static_cast<std::byte>(light ? 255 : 64 * i);
+                texel[1] = static_cast<std::byte>(light ? 255 : 32);
+                texel[2] = static_cast<std::byte>(light ? 255 : 255 - 64 * i);
+                texel[3] = std::byte { 255 };
+            }
+        }
+        // Half get CPU-built mips, half upload level 0 and generate mips on the GPU.
+        if (i % 2 == 0) {
+            textures.push_back(
+                texture_streamer->add(bt_memory_texture_source::from_rgba8(size, size, std::move(pixels))));
+        } else {
+            textures.push_back(
+                texture_streamer->add(bt_memory_texture_source::with_generated_mips(size, size, std::move(pixels))));
+        }
+    }
+}
+
+void app::create_scene()
+{
+    auto add = [&](scene_object object) {
+        object.proxy = scene_bvh.create_proxy(object_bounds(object), static_cast<uint32_t>(scene_objects.size()));
+        scene_objects.push_back(object);
+    };
+
+    // Objects sweeping across the view in front of a field of pebbles, part of which is hidden behind a wall. Smaller
+    // depths are nearer.
+    for (auto j = 0; j < 4; j++) {
+        scene_object object {};
+        object.offset = { -0.5f, -0.4f + static_cast<float>(j) * 0.25f };
+        object.depth = 0.5f;
+        object.velocity = { 1.2f, 0.0f };
+        object.color = { 0.0f, 0.0f, 0.2f + 0.2f * static_cast<float>(j) };
+        object.mesh = quad;
+        object.texture = textures[j % textures.size()];
+        add(object);
+    }
+
+    scene_object wall_object {};
+    wall_object.depth = 0.25f;
+    wall_object.color = { 0.35f, 0.35f, 0.4f };
+    wall_object.mesh = wall;
+    wall_object.texture = textures[0];
+    add(wall_object);
+
+    constexpr int pebbles_per_side = 12;
+    for (auto y = 0; y < pebbles_per_side; y++) {
+        for (auto x = 0; x < pebbles_per_side; x++) {
+            scene_object object {};
+            object.offset = glm::vec2 { x, y } * (1.8f / (pebbles_per_side - 1)) - 0.9f;
+            object.depth = 0.75f;
+            object.color = { 0.6f, 0.3f + 0.4f * static_cast<float>(x) / pebbles_per_side, 0.2f };
+            object.mesh = pebble;
+            object.texture = textures[(x + y) % textures.size()];
+            add(object);
+        }
+    }
+
+    scene_bounds.resize(scene_objects.size());
+}
+
+void app::start_simulation()
+{
+    for (const auto& object : scene_objects) {
+        simulated.offsets.push_back(object.offset);
+        simulated.velocities.push_back(object.velocity);
+    }
+
+    scene_snapshot initial { 0, 0.0, simulated.offsets };
+    previous_snapshot = initial;
+    current_snapshot = initial;
+    snapshots.write_slot() = initial;
+
+    bt_fixed_step_config config;
+    config.rate_hz = SIMULATION_HZ;
+    simulation = std::make_unique<bt_fixed_step_loop>(
+        [this](uint64_t step, double time, double dt) { step_simulation(step, time, dt); },
+        config);
+}
+
+void app::step_simulation(uint64_t step, double time, double dt)
+{
+    constexpr float min_x = -0.5f;
+    constexpr float max_x = 1.5f;
+
+    for (size_t i = 0; i < simulated.offsets.size(); i++) {
+        auto& offset = simulated.offsets[i];
+        auto& velocity = simulated.velocities[i];
+        // Static objects may lie outside the range moving ones bounce within.
+        if (velocity == glm::vec2 { 0.0f }) {
+            continue;
+        }
+        offset += velocity * static_cast<float>(dt);
+        if (offset.x > max_x || offset.x < min_x) {
+            offset.x = offset.x > max_x ? 2.0f * max_x - offset.x : 2.0f * min_x - offset.x;
+            velocity.x = -velocity.x;
+        }
+    }
+
+    // Assigning reuses the slot's storage, so publishing does not allocate once every slot has been written.
+    auto& snapshot = snapshots.write_slot();
+    snapshot.step = step;
+    snapshot.time = time;
+    snapshot.offsets = simulated.offsets;
+    snapshots.publish();
+}
+
+void app::update_scene()
+{
+    frame = (frame + 1) % 100;
+
+    if (snapshots.update()) {
+        std::swap(previous_snapshot, current_snapshot);
+        current_snapshot = snapshots.read();
+    }
+
+    float alpha =
+        bt_interpolation_alpha(previous_snapshot.time, current_snapshot.time, simulation->now() - simulation->dt());
+
+    for (size_t i = 0; i < scene_objects.size(); i++) {
+        auto& object = scene_objects[i];
+        object.offset = glm::mix(previous_snapshot.offsets[i], current_snapshot.offsets[i], alpha);
+
+        auto box = object_bounds(object);
+        scene_bounds.set(i, box);
+        scene_bvh.move_proxy(object.proxy, box);
+    }
+
+    scene_bvh.refit();
+}
+
+void app::cull_scene()
+{
+    // There is no camera yet, so positions are already in clip space and the frustum is the canonical view volume.
+    auto frustum = bt_frustum::from_matrix(glm::mat4 { 1.0f });
+    culler.cull(frustum, scene_bvh, scene_bounds, visible_objects);
+
+    // With an orthographic view the projected error does not depend on distance; clip space spans two units.
+    // Detail follows the primary viewport.
+    float pixels_per_unit = static_cast<float>(primary_viewport().swapchain->height()) * 0.5f;
+    triangles_submitted = 0;
+    for (auto index : visible_objects) {
+        auto& object = scene_objects[index];
+        const auto& model = resources.mesh(object.mesh);
+        object.lod = bt_lod_selector::select(model.lods(), object.lod, 1.0f, pixels_per_unit, lod_settings);
+        triangles_submitted += model.triangle_count(object.lod);
+
+        auto extents = model.bounding_box().extents() * 2.0f;
+        texture_streamer->request(object.texture, std::max(extents.x, extents.y) * pixels_per_unit);
+    }
+}
+
+void app::build_render_queue()
+{
+    render_queue.clear();
+    for (uint32_t index = 0; index < visible_objects.size(); index++) {
+        const auto& object = scene_objects[visible_objects[index]];
+
+        push_constant_data push {};
+        push.offset = glm::vec3(object.offset, object.depth);
+        push.color = object.color;
+
+        bt_draw draw {};
+        draw.pipeline = pipeline.value();
+        draw.mesh = object.mesh.value();
+        draw.lod = object.lod;
+        draw.depth = object.depth;
+        // Each viewport maps the visible object to the slot its occlusion culler gave it, if any.
+        draw.slot = index;
+        render_queue.push(draw, &push, sizeof(push));
+    }
+    render_queue.sort();
+}
+
+void app::stream_frame_data()
+{
+    frame_allocator.begin_frame(presenter.current_frame_index());
+
+    auto extent = primary_viewport().swapchain->swapchain_extent();
+    frame_data data {};
+    data.extent = { static_cast<float>(extent.width), static_cast<float>(extent.height) };
+    data.time = static_cast<float>(glfwGetTime());
+    data.frame = frame;
+
+    // On overflow keep binding offset 0; the buffer is grown before this frame index comes round again.
+    auto allocation = frame_allocator.push(data);
+    frame_data_offset = allocation.is_valid() ? allocation.offset : 0;
+}
+
+void app::log_frame_stats(double record_ms)
+{
+    stats_frames++;
+    if (frame != 0) {
+        return;
+    }
+
+    const auto& cull_stats = culler.stats();
+    SPDLOG_DEBUG("culling: {} objects, {} visible, {} culled in {:.3f} ms",
+        cull_stats.tested,
+        cull_stats.visible,
+        cull_stats.culled,
+        cull_stats.cull_ms);
+    SPDLOG_DEBUG("lod: {} triangles submitted", triangles_submitted);
+
+    const auto& queue_stats = render_queue.stats();
+    SPDLOG_DEBUG("render queue: {} draws replayed {} times, pipeline binds {}/{} elided, mesh binds {}/{} elided, "
+                 "sort {:.3f} ms, record {:.3f} ms",
+        queue_stats.draws,
+        queue_stats.replays,
+        queue_stats.pipeline_binds_elided,
+        queue_stats.pipeline_binds + queue_stats.pipeline_binds_elided,
+        queue_stats.mesh_binds_elided,
+        queue_stats.mesh_binds + queue_stats.mesh_binds_elided,
+        queue_stats.sort_ms,
+        record_ms);
+
+    const auto& allocator_stats = frame_allocator.stats();
+    SPDLOG_DEBUG("frame allocator: {} allocations, {}/{} bytes streamed, {} failed",
+        allocator_stats.allocations,
+        allocator_stats.bytes_allocated,
+        allocator_stats.capacity,
+        allocator_stats.failed_allocations);
+
+    auto arena_stats = frame_arena.stats();
+    SPDLOG_DEBUG("frame arena: {} bytes this frame, peak {} bytes, {} bytes reserved over {} threads",
+        arena_stats.bytes_used,
+        arena_stats.peak_bytes,
+        arena_stats.reserved_bytes,
+        arena_stats.threads);
+
+    const auto& texture_stats = texture_streamer->stats();
+    SPDLOG_DEBUG("textures: {} textures, {}/{} KiB resident, {} KiB uploaded ({:.1f} MiB/s), {} mips in, {} evicted, "
+                 "{} draws sampling non-resident mips",
+        texture_stats.textures,
+        texture_stats.resident_bytes / 1024,
+        texture_stats.budget / 1024,
+        texture_stats.uploaded_bytes / 1024,
+        texture_stats.upload_mb_per_second,
+        texture_stats.mips_streamed_in,
+        texture_stats.mips_evicted,
+        texture_stats.non_resident_draws);
+
+    const auto& resolution_stats = dynamic_resolution.stats();
+    const auto& primary = primary_viewport();
+    if (primary.dynamic_resolution_active) {
+        SPDLOG_DEBUG("dynamic resolution: scale {:.3f} ({}x{}), gpu {:.2f} ms (smoothed {:.2f} ms, target {:.2f} ms), "
+                     "{}/{} frames over budget",
+            resolution_stats.scale,
+            primary.render_extent.width,
+            primary.render_extent.height,
+            resolution_stats.gpu_ms,
+            resolution_stats.smoothed_ms,
+            dynamic_resolution.config().target_ms,
+            resolution_stats.frames_over_budget,
+            resolution_stats.measured_frames);
+    } else {
+        SPDLOG_DEBUG("gpu frame: {:.2f} ms (smoothed {:.2f} ms)",
+            resolution_stats.gpu_ms,
+            resolution_stats.smoothed_ms);
+    }
+
+    const auto& particle_stats = particles.stats();
+    SPDLOG_DEBUG("particles: {}/{} alive, {} simulated, {} emitted ({} dropped), gpu {:.3f} ms ({:.0f} particles/ms)",
+        particle_stats.alive,
+        particle_stats.capacity,
+        particle_stats.simulated,
+        particle_stats.emitted,
+        particle_stats.dropped,
+        particle_stats.gpu_ms,
+        particle_stats.particles_per_ms);
+
+    const auto& occlusion_stats = primary.occlusion.stats();
+    SPDLOG_DEBUG("occlusion: {} candidates, {} occluded, {} drawn early, {} drawn late; {:.0f} fragment invocations "
+                 "({:.0f} saved, {} reference frames), cull {:.3f} ms, scene {:.3f} ms vs {:.3f} ms unculled, "
+                 "net {:.3f} ms saved",
+        occlusion_stats.candidates,
+        occlusion_stats.occluded,
+        occlusion_stats.first_phase_draws,
+        occlusion_stats.second_phase_draws,
+        occlusion_stats.fragment_invocations,
+        occlusion_stats.fragment_invocations_saved(),
+        occlusion_stats.reference_frames,
+        occlusion_stats.cull_ms,
+        occlusion_stats.scene_ms,
+        occlusion_stats.reference_scene_ms - occlusion_stats.cull_ms,
+        occlusion_stats.net_ms_saved());
+
+    const auto& telemetry_stats = telemetry.stats();
+    if (telemetry_stats.pipeline_statistics_valid) {
+        const auto& pipeline_stats = telemetry_stats.pipeline;
+        SPDLOG_DEBUG("gpu work: {} vertices, {} primitives ({} after clipping), {} vertex, {} fragment and {} compute "
+                     "invocations",
+            pipeline_stats.input_assembly_vertices,
+            pipeline_stats.input_assembly_primitives,
+            pipeline_stats.clipping_primitives,
+            pipeline_stats.vertex_shader_invocations,
+            pipeline_stats.fragment_shader_invocations,
+            pipeline_stats.compute_shader_invocations);
+    }
+    if (telemetry_stats.memory_budget_valid) {
+        std::string heaps;
+        for (const auto& heap : telemetry_stats.heaps) {
+            heaps += fmt::format("{}{}/{} MiB{}",
+                heaps.empty() ? "" : ", ",
+                heap.usage / (1024 * 1024),
+                heap.budget / (1024 * 1024),
+                heap.device_local ? " (device local)" : "");
+        }
+        SPDLOG_DEBUG("gpu memory: {}; {} heaps past {:.0f}% of budget, {} warnings",
+            heaps,
+            telemetry_stats.heaps_over_budget_warning,
+            100.0f * telemetry.config().budget_warning_fraction,
+            telemetry_stats.budget_warnings);
+    }
+
+    if (auto* host_allocator = device.host_allocator()) {
+        auto host_stats = host_allocator->stats();
+        std::string scopes;
+        for (size_t i = 0; i < host_stats.scopes.size(); i++) {
+            const auto& scope = host_stats.scopes[i];
+            scopes += fmt::format("{}{} {} last frame, {} live ({} KiB, peak {} KiB, internal {} KiB)",
+                scopes.empty() ? "" : "; ",
+                bt_host_allocator::scope_name(static_cast<VkSystemAllocationScope>(i)),
+                scope.frame_allocations,
+                scope.allocations - scope.frees,
+                scope.bytes / 1024,
+                scope.peak_bytes / 1024,
+                scope.internal_bytes / 1024);
+        }
+        SPDLOG_DEBUG("host allocations: {}; command scope pool {} hits, {} misses",
+            scopes,
+            host_stats.pool_hits,
+            host_stats.pool_misses);
+    }
+
+    auto deletion_stats = device.deletion_stats();
+    SPDLOG_DEBUG("deletion queue: {} queued and {} destroyed last frame, {} pending (peak {}), {}/{} destroyed",
+        deletion_stats.queued,
+        deletion_stats.destroyed,
+        deletion_stats.pending,
+        deletion_stats.peak_pending,
+        deletion_stats.total_destroyed,
+        deletion_stats.total_queued);
+
+    // CPU time of every thread in the process, so N single-window processes can be compared with one process drawing
+    // N viewports by summing theirs.
+    auto cpu_now = std::clock();
+    auto wall_now = std::chrono::steady_clock::now();
+    double cpu_ms = 1000.0 * static_cast<double>(cpu_now - stats_cpu_start) / CLOCKS_PER_SEC;
+    double wall_ms = std::chrono::duration<double, std::milli>(wall_now - stats_wall_start).count();
+    const auto& presenter_stats = presenter.stats();
+    SPDLOG_DEBUG("viewports: {} windows, {} presented with {} submit and {} present; process cpu {:.2f} ms per frame "
+                 "({:.0f}% of a core), gpu {:.2f} ms per frame",
+        viewports.size(),
+        presenter_stats.swapchains,
+        presenter_stats.submits,
+        presenter_stats.presents,
+        cpu_ms / std::max(stats_frames, 1u),
+        wall_ms > 0.0 ? 100.0 * cpu_ms / wall_ms : 0.0,
+        resolution_stats.gpu_ms);
+    stats_frames = 0;
+    stats_cpu_start = cpu_now;
+    stats_wall_start = wall_now;
+
+    uint64_t dropped_events = 0;
+    for (const auto& window : windows) {
+        dropped_events += window->dropped_events();
+    }
+    auto input_stats = input_frame_intervals.stats();
+    auto resize_stats = resize_frame_intervals.stats();
+    SPDLOG_DEBUG("window: {} input events ({} dropped), {} resizes; frame jitter {:.3f} ms (max {:.2f} ms) over {} "
+                 "frames with input, {:.3f} ms (max {:.2f} ms) over {} frames while resizing",
+        input_events,
+        dropped_events,
+        resize_events,
+        input_stats.stddev_ms,
+        input_stats.max_ms,
+        input_stats.samples,
+        resize_stats.stddev_ms,
+        resize_stats.max_ms,
+        resize_stats.samples);
+    input_frame_intervals.reset();
+    resize_frame_intervals.reset();
+
+    if (swapchain_recreations > 0) {
+        SPDLOG_DEBUG("swapchain: {} recreations, worst {:.2f} ms", swapchain_recreations, worst_recreate_ms);
+        swapchain_recreations = 0;
+        worst_recreate_ms = 0.0;
+    }
+
+    auto simulation_stats = simulation->stats();
+    auto frame_stats = frame_intervals.stats();
+    SPDLOG_DEBUG("simulation: step {:.2f} ms (jitter {:.3f} ms, {:.2f}-{:.2f} ms, worst {:.3f} ms late), "
+                 "{} steps dropped; frame {:.2f} ms (jitter {:.3f} ms, {:.2f}-{:.2f} ms)",
+        simulation_stats.interval.mean_ms,
+        simulation_stats.interval.stddev_ms,
+        simulation_stats.interval.min_ms,
+        simulation_stats.interval.max_ms,
+        simulation_stats.max_late_ms,
+        simulation_stats.dropped_steps,
+        frame_stats.mean_ms,
+        frame_stats.stddev_ms,
+        frame_stats.min_ms,
+        frame_stats.max_ms);
+    simulation->reset_stats();
+    frame_intervals.reset();
 }
 
 void app::create_pipeline_layout()
@@ -53,9 +759,16 @@ void app::create_pipeline_layout()
     push_constant_range.offset = 0;
     push_constant_range.size = sizeof(push_constant_data);
 
+    // Per-draw data stays in push constants, per-frame data is streamed through the frame allocator and everything
+    // else is reached through the bindless table's sets.
+    std::vector<VkDescriptorSetLayout> set_layouts { frame_allocator.set_layout() };
+    if (bindless != nullptr) {
+        set_layouts.insert(set_layouts.end(), bindless->set_layouts().begin(), bindless->set_layouts().end());
+    }
+
     VkPipelineLayoutCreateInfo pipeline_layout_info { VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
-    pipeline_layout_info.setLayoutCount = 0;
-    pipeline_layout_info.pSetLayouts = nullptr;
+    pipeline_layout_info.setLayoutCount = static_cast<uint32_t>(set_layouts.size());
+    pipeline_layout_info.pSetLayouts = set_layouts.data();
     pipeline_layout_info.pushConstantRangeCount = 1;
     pipeline_layout_info.pPushConstantRanges = &push_constant_range;
 
@@ -65,25 +778,54 @@ void app::create_pipeline_layout()
     }
 }
 
-void app::create_pipeline()
+void app::create_pipeline(viewport_state& view)
+{
+    check_pipeline_formats(view);
+    create_scene_pipeline(view);
+    create_particle_pipeline(view);
+}
+
+void app::check_pipeline_formats(const viewport_state& view)
+{
+    std::pair formats { view.swapchain->swapchain_image_format(), view.swapchain->find_depth_format() };
+    for (const auto& other : viewports) {
+        if (other.get() == &view || other->swapchain == nullptr) {
+            continue;
+        }
+        if (std::pair { other->swapchain->swapchain_image_format(), other->swapchain->find_depth_format() }
+            != formats) {
+            throw std::runtime_error("failed to create viewport: attachment formats differ from the other viewports'");
+        }
+    }
+}
+
+void app::create_scene_pipeline(viewport_state& view)
 {
-    assert(swapchain != nullptr && "cannot create pipeline before swapchain");
+    assert(view.render_graph != nullptr && "cannot create pipeline before render graph");
     assert(pipeline_layout != nullptr && "cannot create pipeline before pipeline layout");
 
-    bt_pipeline_config_info pipeline_config {};
-    bt_pipeline::default_pipeline_config_info(pipeline_config);
-    pipeline_config.render_pass = swapchain->render_pass();
-    pipeline_config.pipeline_layout = pipeline_layout;
+    // Every pipeline in the registry was created for the old render passes.
+    pipeline_registry.clear();
 
-    pipeline = std::make_unique<bt_pipeline>(device,
-        "shaders/simple_shader.vert.spv",
-        "shaders/simple_shader.frag.spv",
-        pipeline_config);
+    bt_pipeline_desc desc {};
+    desc.vert_shader = "shaders/simple_shader.vert.spv";
+    desc.frag_shader = "shaders/simple_shader.frag.spv";
+    desc.pipeline_layout = pipeline_layout;
+    desc.render_pass = view.render_graph->render_pass(view.main_pass);
+    desc.draw_state = scene_draw_state;
+    pipeline = pipeline_registry.get(desc);
+    pipeline_formats = { view.swapchain->swapchain_image_format(), view.swapchain->find_depth_format() };
+}
+
+void app::create_particle_pipeline(viewport_state& view)
+{
+    // Particles are drawn over everything else, in the late pass.
+    particles.create_draw_pipeline(view.render_graph->render_pass(view.late_pass));
 }
 
 void app::create_command_buffers()
 {
-    command_buffers.resize(swapchain->image_count());
+    command_buffers.resize(bt_swapchain::MAX_FRAMES_IN_FLIGHT);
 
     VkCommandBufferAllocateInfo alloc_info { VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
     alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
@@ -95,124 +837,312 @@ void app::create_command_buffers()
     }
 }
 
-void app::free_command_buffers()
+void app::draw_frame()
 {
-    vkFreeCommandBuffers(device.device(),
-        device.command_pool(),
-        static_cast<uint32_t>(command_buffers.size()),
-        command_buffers.data());
-    command_buffers.clear();
+    uint32_t frame_index = presenter.begin_frame();
+
+    bool any_acquired = false;
+    for (auto& view : viewports) {
+        view->acquired = acquire_image(*view);
+        any_acquired |= view->acquired;
+    }
+
+    if (!any_acquired) {
+        // While every window is minimised the main thread keeps pumping events until one is restored or closed.
+        bool all_minimised = std::all_of(viewports.begin(), viewports.end(), [](const auto& view) {
+            auto extent = view->window.extent();
+            return extent.width == 0 || extent.height == 0;
+        });
+        if (all_minimised) {
+            std::this_thread::sleep_for(std::chrono::milliseconds { 10 });
+        }
+        return;
+    }
+
+    // begin_frame waited for this frame's fence, so its transient CPU memory and command buffer are free again.
+    frame_arena.begin_frame(frame_index);
+    particles.begin_frame(frame_index);
+    auto command_buffer = command_buffers[frame_index];
+
+    update_scene();
+    cull_scene();
+    build_render_queue();
+    stream_frame_data();
+    auto record_start = std::chrono::steady_clock::now();
+    record_command_buffer(frame_index, command_buffer);
+    log_frame_stats(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - record_start).count());
+
+    presenter.submit_and_present(&command_buffer, 1, present_results);
+    // Every frame, so the counts log_frame_stats reports cover one frame, from the previous present to this one.
+    if (auto* host_allocator = device.host_allocator()) {
+        host_allocator->end_frame();
+    }
+
+    size_t presented = 0;
+    for (auto& view : viewports) {
+        if (!view->acquired) {
+            continue;
+        }
+
+        auto result = present_results[presented++];
+        if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || view->window.was_resized()) {
+            view->window.reset_resized_flag();
+            recreate_swapchain(*view);
+        } else if (result != VK_SUCCESS) {
+            throw std::runtime_error("failed to present swapchain image");
+        }
+    }
+
+    if (startup_profile && !first_frame_presented) {
+        first_frame_presented = true;
+        SPDLOG_INFO("startup: first frame presented {:.2f} ms after the app began creating the device",
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startup_start).count());
+    }
 }
 
-void app::draw_frame()
+bool app::acquire_image(viewport_state& view)
 {
-    uint32_t image_index;
-    auto result = swapchain->acquire_next_image(&image_index);
+    if (view.swapchain == nullptr && !recreate_swapchain(view)) {
+        return false;
+    }
 
+    auto result = presenter.acquire(*view.swapchain, &view.image_index);
     if (result == VK_ERROR_OUT_OF_DATE_KHR) {
-        recreate_swapchain();
-        return;
+        recreate_swapchain(view);
+        return false;
     }
 
     if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
         throw std::runtime_error("failed to acquire swapchain image");
     }
 
-    record_command_buffer(image_index);
-    result = swapchain->submit_command_buffers(&command_buffers[image_index], &image_index);
-    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || window.was_resized()) {
-        window.reset_resized_flag();
-        recreate_swapchain();
-        return;
-    }
+    return true;
+}
 
-    if (result != VK_SUCCESS) {
-        throw std::runtime_error("failed to present swapchain image");
-    }
+app::viewport_state& app::primary_viewport()
+{
+    // draw_frame only records frames with at least one image acquired.
+    auto primary = std::find_if(viewports.begin(), viewports.end(), [](const auto& view) { return view->acquired; });
+    assert(primary != viewports.end() && "no viewport is being drawn");
+    return **primary;
 }
 
-void app::recreate_swapchain()
+bool app::recreate_swapchain(viewport_state& view, bool create_pipelines)
 {
-    auto extent = window.extent();
-    while (extent.width == 0 || extent.height == 0) {
-        extent = window.extent();
-        glfwWaitEvents();
+    auto extent = view.window.extent();
+    if (extent.width == 0 || extent.height == 0) {
+        return false;
     }
 
-    vkDeviceWaitIdle(device.device());
-
-    if (swapchain == nullptr) {
-        swapchain = std::make_unique<bt_swapchain>(device, extent);
+    // Frames in flight keep rendering with the objects replaced here; destroying those only queues their Vulkan
+    // objects until the frames complete. Command buffers, synchronisation and everything else that does not depend on
+    // the size carry over, as do the other viewports.
+    auto recreate_start = std::chrono::steady_clock::now();
+    bool recreating = view.swapchain != nullptr;
+    if (view.swapchain == nullptr) {
+        view.swapchain = std::make_unique<bt_swapchain>(device, view.surface, extent);
     } else {
-        swapchain = std::make_unique<bt_swapchain>(device, extent, std::move(swapchain));
-        if (swapchain->image_count() != command_buffers.size()) {
-            free_command_buffers();
-            create_command_buffers();
-        }
+        std::shared_ptr<bt_swapchain> old_swapchain = std::move(view.swapchain);
+        view.swapchain = std::make_unique<bt_swapchain>(device, view.surface, extent, old_swapchain);
+    }
+
+    // The new graph's images for a frame index share pool memory with the old graph's for the same index, which is
+    // only reused once that frame index's fence has been waited for.
+    view.render_graph.reset();
+    create_render_graph(view);
+
+    std::pair formats { view.swapchain->swapchain_image_format(), view.swapchain->find_depth_format() };
+    if (create_pipelines && (pipeline.is_null() || formats != pipeline_formats)) {
+        create_pipeline(view);
     }
 
-    // TODO: check if render pass is compatible and only create pipeline if it is not.
-    create_pipeline();
+    if (recreating) {
+        swapchain_recreations++;
+        worst_recreate_ms = std::max(worst_recreate_ms,
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - recreate_start).count());
+    }
+    return true;
 }
 
-void app::record_command_buffer(uint32_t image_index)
+void app::create_render_graph(viewport_state& view)
 {
-    static int frame = 0;
-    frame = (frame + 1) % 100;
+    auto& swapchain = *view.swapchain;
+    VkExtent2D extent = swapchain.swapchain_extent();
+    view.render_graph =
+        std::make_unique<bt_render_graph>(device, view.render_graph_memory, bt_swapchain::MAX_FRAMES_IN_FLIGHT);
+    auto& render_graph = *view.render_graph;
+
+    view.backbuffer = render_graph.import_image("backbuffer",
+        { swapchain.swapchain_image_format(), extent },
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+
+    // With dynamic resolution the scene is drawn into the top-left part of a full-size offscreen target and blitted up
+    // to the swapchain image, which needs the swapchain format to support filtered blits; otherwise straight into it.
+    constexpr VkFormatFeatureFlags blit_features = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT
+        | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    view.dynamic_resolution_active = DYNAMIC_RESOLUTION
+        && (swapchain.image_usage() & VK_IMAGE_USAGE_TRANSFER_DST_BIT) != 0
+        && device.has_format_features(swapchain.swapchain_image_format(), VK_IMAGE_TILING_OPTIMAL, blit_features);
+    view.scene_color = view.dynamic_resolution_active
+        ? render_graph.create_image("scene_color", { swapchain.swapchain_image_format(), extent })
+        : view.backbuffer;
+    bt_rg_resource depth = render_graph.create_image("depth", { swapchain.find_depth_format(), extent });
+    view.occlusion.resize(extent);
 
+    // Occlusion culling: the main pass draws what was visible last frame, its depth is reduced into a pyramid that
+    // every draw is tested against, and the late pass draws on top whatever turned out visible but was not drawn.
+    render_graph.add_pass(
+        "occlusion_prepare",
+        [](bt_render_graph::pass_builder& pass) { pass.side_effect(); },
+        [&view](VkCommandBuffer command_buffer) { view.occlusion.prepare(command_buffer); });
+
+    view.main_pass = render_graph.add_pass(
+        "main",
+        [&](bt_render_graph::pass_builder& pass) {
+            pass.color_attachment(view.scene_color, VkClearColorValue { { 0.1f, 0.1f, 0.1f, 1.0f } });
+            pass.depth_attachment(depth, VkClearDepthStencilValue { 1.0f, 0 });
+        },
+        [this, &view](VkCommandBuffer command_buffer) { draw_scene(command_buffer, view, 0); });
+
+    render_graph.add_pass(
+        "occlusion_cull",
+        [&](bt_render_graph::pass_builder& pass) {
+            pass.read(depth, bt_rg_usage::sampled);
+            pass.side_effect();
+        },
+        [&view, depth](VkCommandBuffer command_buffer) {
+            // No camera yet, as in cull_scene().
+            view.occlusion.build_and_cull(command_buffer,
+                glm::mat4 { 1.0f },
+                view.render_graph->view(depth),
+                view.render_extent);
+        });
+
+    view.late_pass = render_graph.add_pass(
+        "main_late",
+        [&](bt_render_graph::pass_builder& pass) {
+            pass.color_attachment(view.scene_color);
+            pass.depth_attachment(depth);
+        },
+        [this, &view](VkCommandBuffer command_buffer) { draw_scene(command_buffer, view, 1); });
+
+    if (view.dynamic_resolution_active) {
+        render_graph.add_pass(
+            "upscale",
+            [&](bt_render_graph::pass_builder& pass) {
+                pass.read(view.scene_color, bt_rg_usage::transfer_src);
+                pass.write(view.backbuffer, bt_rg_usage::transfer_dst);
+            },
+            [this, &view](VkCommandBuffer command_buffer) { upscale_scene(command_buffer, view); });
+    }
+
+    render_graph.compile();
+}
+
+void app::record_command_buffer(uint32_t frame_index, VkCommandBuffer command_buffer)
+{
     VkCommandBufferBeginInfo begin_info { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
 
-    if (vkBeginCommandBuffer(command_buffers[image_index], &begin_info) != VK_SUCCESS) {
+    if (vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS) {
         throw std::runtime_error("failed to begin recording command buffer");
     }
 
-    VkRenderPassBeginInfo render_pass_info { VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
-    render_pass_info.renderPass = swapchain->render_pass();
-    render_pass_info.framebuffer = swapchain->framebuffer(image_index);
-    render_pass_info.renderArea.offset = { 0, 0 };
-    render_pass_info.renderArea.extent = swapchain->swapchain_extent();
+    dynamic_resolution.begin_frame(command_buffer, frame_index);
+    telemetry.begin_frame(command_buffer, frame_index);
+    // Fragment work is only counted for whole frames, so every viewport's culler is given the same count.
+    const auto& telemetry_stats = telemetry.stats();
+    uint64_t fragment_invocations
+        = telemetry_stats.pipeline_statistics_valid ? telemetry_stats.pipeline.fragment_shader_invocations : 0;
+    for (auto& view : viewports) {
+        view->occlusion.begin_frame(frame_index, fragment_invocations);
+    }
+    texture_streamer->update(command_buffer, frame_index, frame_arena.resource());
+    // Once for all viewports, before their render passes.
+    particles.simulate(command_buffer, frame_dt);
+
+    // Every viewport goes into the same command buffer, so the GPU time measured covers all of them and one scale
+    // applies to all.
+    for (auto& view : viewports) {
+        if (!view->acquired) {
+            continue;
+        }
+
+        auto& swapchain = *view->swapchain;
+        view->render_extent = view->dynamic_resolution_active
+            ? dynamic_resolution.scaled_extent(swapchain.swapchain_extent())
+            : swapchain.swapchain_extent();
+        view->render_graph->set_render_area(view->main_pass, view->render_extent);
+        view->render_graph->set_render_area(view->late_pass, view->render_extent);
+        view->occlusion_slots.resize(visible_objects.size());
+        for (uint32_t index = 0; index < visible_objects.size(); index++) {
+            const auto& object = scene_objects[visible_objects[index]];
+            view->occlusion_slots[index] = view->occlusion.add(
+                visible_objects[index], object_bounds(object), resources.mesh(object.mesh), object.lod);
+        }
+        view->render_graph->set_imported(
+            view->backbuffer, swapchain.image(view->image_index), swapchain.image_view(view->image_index));
+        view->render_graph->execute(command_buffer, frame_index);
+    }
 
-    std::array<VkClearValue, 2> clear_values {};
-    clear_values[0].color = { 0.1f, 0.1f, 0.1f, 1.0f };
-    clear_values[1].depthStencil = { 1.0f, 0 };
-    render_pass_info.clearValueCount = static_cast<uint32_t>(clear_values.size());
-    render_pass_info.pClearValues = clear_values.data();
+    telemetry.end_frame(command_buffer);
+    dynamic_resolution.end_frame(command_buffer);
 
-    vkCmdBeginRenderPass(command_buffers[image_index], &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
+    if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to record command buffer");
+    }
+}
 
+void app::draw_scene(VkCommandBuffer command_buffer, viewport_state& view, uint32_t phase)
+{
     VkViewport viewport {};
     viewport.x = 0;
     viewport.y = 0;
-    viewport.width = static_cast<float>(swapchain->swapchain_extent().width);
-    viewport.height = static_cast<float>(swapchain->swapchain_extent().height);
+    viewport.width = static_cast<float>(view.render_extent.width);
+    viewport.height = static_cast<float>(view.render_extent.height);
     viewport.minDepth = 0.0f;
     viewport.maxDepth = 1.0f;
-    VkRect2D scissor { { 0, 0 }, swapchain->swapchain_extent() };
-    vkCmdSetViewport(command_buffers[image_index], 0, 1, &viewport);
-    vkCmdSetScissor(command_buffers[image_index], 0, 1, &scissor);
-
-    pipeline->bind(command_buffers[image_index]);
-    model->bind(command_buffers[image_index]);
+    VkRect2D scissor { { 0, 0 }, view.render_extent };
+    vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+    vkCmdSetScissor(command_buffer, 0, 1, &scissor);
 
-    for (auto j = 0; j < 4; j++) {
-        push_constant_data push {};
-        push.offset = { -0.5f + static_cast<float>(frame) * 0.02f, -0.4f + static_cast<float>(j) * 0.25f };
-        push.color = { 0.0f, 0.0f, 0.2f + 0.2f * static_cast<float>(j) };
+    frame_allocator.bind(command_buffer, pipeline_layout, FRAME_SET, frame_data_offset, 0);
+    if (bindless != nullptr) {
+        bindless->bind(command_buffer, pipeline_layout, BINDLESS_FIRST_SET);
+    }
 
-        vkCmdPushConstants(command_buffers[image_index],
-            pipeline_layout,
-            VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-            0,
-            sizeof(push_constant_data),
-            &push);
+    pipeline_registry.set_draw_state(command_buffer, scene_draw_state);
+    command_recorder recorder {
+        command_buffer, pipeline_layout, resources, view.occlusion, view.occlusion_slots, phase
+    };
+    render_queue.replay(recorder);
+    view.occlusion.end_phase(command_buffer, phase);
 
-        model->draw(command_buffers[image_index]);
+    // Binds its own pipeline layout, so it comes after everything drawn with the scene's, over the whole scene.
+    if (phase == 1) {
+        particles.draw(command_buffer);
     }
+}
 
-    vkCmdEndRenderPass(command_buffers[image_index]);
+void app::upscale_scene(VkCommandBuffer command_buffer, viewport_state& view)
+{
+    VkExtent2D extent = view.swapchain->swapchain_extent();
+    VkExtent2D render_extent = view.render_extent;
 
-    if (vkEndCommandBuffer(command_buffers[image_index]) != VK_SUCCESS) {
-        throw std::runtime_error("failed to record command buffer");
-    }
+    VkImageBlit blit {};
+    blit.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+    blit.srcOffsets[1] = { static_cast<int32_t>(render_extent.width), static_cast<int32_t>(render_extent.height), 1 };
+    blit.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+    blit.dstOffsets[1] = { static_cast<int32_t>(extent.width), static_cast<int32_t>(extent.height), 1 };
+
+    vkCmdBlitImage(command_buffer,
+        view.render_graph->image(view.scene_color),
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        view.render_graph->image(view.backbuffer),
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        1,
+        &blit,
+        VK_FILTER_LINEAR);
 }
 } // namespace bt
@@ -1,46 +1,245 @@
 #ifndef APP_HPP
 #define APP_HPP
 
+#include "bt_bindless.hpp"
+#include "bt_bvh.hpp"
+#include "bt_culling.hpp"
 #include "bt_device.hpp"
+#include "bt_dynamic_resolution.hpp"
+#include "bt_frame_allocator.hpp"
+#include "bt_frame_arena.hpp"
+#include "bt_gpu_telemetry.hpp"
+#include "bt_lod.hpp"
 #include "bt_model.hpp"
+#include "bt_occlusion.hpp"
+#include "bt_particles.hpp"
 #include "bt_pipeline.hpp"
+#include "bt_pipeline_registry.hpp"
+#include "bt_presenter.hpp"
+#include "bt_render_graph.hpp"
+#include "bt_render_queue.hpp"
+#include "bt_resources.hpp"
+#include "bt_simulation.hpp"
+#include "bt_startup_graph.hpp"
 #include "bt_swapchain.hpp"
+#include "bt_texture_file.hpp"
+#include "bt_texture_streamer.hpp"
+#include "bt_triple_buffer.hpp"
 #include "bt_window.hpp"
 
+#include <atomic>
+#include <chrono>
+#include <ctime>
 #include <memory>
+#include <utility>
 #include <vector>
 
 namespace bt {
+struct app_options {
+    // Windows rendered and presented together by one device.
+    uint32_t viewports = 1;
+    // Counts the driver's host allocations and logs them per frame.
+    bool track_host_allocations = false;
+    // Logs how long each startup step took and when the first frame was presented.
+    bool startup_profile = false;
+    // Runs the startup steps one after another on the calling thread, to compare with running them concurrently.
+    bool serial_startup = false;
+    // Leaves cull mode, depth state and topology dynamic when the device supports it, so materials differing only in
+    // those share pipelines.
+    bool dynamic_draw_state = true;
+};
+
 class app {
   public:
     static constexpr uint32_t WIDTH = 1280;
     static constexpr uint32_t HEIGHT = 720;
+    static constexpr size_t MAX_LODS = 4;
+    // The frame allocator's set comes first so its set number does not depend on bindless support.
+    static constexpr uint32_t FRAME_SET = 0;
+    static constexpr uint32_t BINDLESS_FIRST_SET = 1;
+    // Render the scene at a resolution that keeps GPU frame time within budget, upscaled to the swapchain.
+    static constexpr bool DYNAMIC_RESOLUTION = true;
+    // The scene is simulated on its own thread at this rate, independent of the display's.
+    static constexpr double SIMULATION_HZ = 120.0;
+    // Frames within this long of a window event count as rendered during resizing or input.
+    static constexpr std::chrono::milliseconds WINDOW_ACTIVITY_SPAN { 250 };
+    // Longest frame time GPU particles are stepped by.
+    static constexpr double MAX_FRAME_DT_MS = 100.0;
 
-    app();
+    // Opens one window per viewport, all showing the scene and presented together.
+    explicit app(const app_options& options = {});
     app(const app&) = delete;
     ~app();
 
     app& operator=(const app&) = delete;
 
+    // Pumps window events on the calling thread, which must be the one that created the app, while a render thread
+    // draws frames, until any window is closed. Rethrows anything the render thread threw.
     void run();
 
   private:
+    struct scene_object {
+        glm::vec2 offset;
+        // Clip-space depth the object is drawn at.
+        float depth;
+        glm::vec2 velocity;
+        glm::vec3 color;
+        int32_t proxy;
+        uint32_t lod;
+        bt_mesh_handle mesh;
+        bt_texture_id texture;
+    };
+
+    // Scene state published by the simulation thread; immutable once published.
+    struct scene_snapshot {
+        uint64_t step = 0;
+        double time = 0.0;
+        std::vector<glm::vec2> offsets;
+    };
+
+    // A window and what is rendered to it. Its render graph draws into the swapchain image acquired for the frame.
+    struct viewport_state {
+        viewport_state(bt_device& device, bt_resources& resources, bt_window& window);
+        viewport_state(const viewport_state&) = delete;
+        ~viewport_state();
+
+        viewport_state& operator=(const viewport_state&) = delete;
+
+        bt_device& device;
+        bt_window& window;
+        VkSurfaceKHR surface;
+        std::unique_ptr<bt_swapchain> swapchain;
+        // Keeps transient attachment memory across swapchain recreation.
+        bt_rg_memory_pool render_graph_memory;
+        std::unique_ptr<bt_render_graph> render_graph;
+        bt_rg_resource backbuffer = 0;
+        bt_rg_resource scene_color = 0;
+        // Draws what was visible last frame; late_pass draws what occlusion culling then found visible too.
+        bt_rg_pass main_pass = 0;
+        bt_rg_pass late_pass = 0;
+        bt_occlusion_culler occlusion;
+        // Slot the culler gave each of the frame's visible objects, or NO_SLOT for those drawn directly.
+        std::vector<uint32_t> occlusion_slots;
+        bool dynamic_resolution_active = false;
+        // Part of the scene target drawn this frame.
+        VkExtent2D render_extent {};
+        // Whether an image was acquired for the frame being recorded, and which.
+        bool acquired = false;
+        uint32_t image_index = 0;
+    };
+
+    // Owned by the simulation thread.
+    struct simulation_state {
+        std::vector<glm::vec2> offsets;
+        std::vector<glm::vec2> velocities;
+    };
+
+    // Once the device and windows exist, everything else is created by a startup graph.
+    void initialise(bool serial, bool profile);
+    void create_bindless_table();
+    void read_shaders();
     void load_models();
+    bt_aabb object_bounds(const scene_object& object);
+    void load_textures();
+    void create_scene();
+    void start_simulation();
+    void step_simulation(uint64_t step, double time, double dt);
+    void update_scene();
+    void cull_scene();
+    void build_render_queue();
+    void stream_frame_data();
+    void log_frame_stats(double record_ms);
     void create_pipeline_layout();
-    void create_pipeline();
     void create_command_buffers();
-    void free_command_buffers();
+    void render_loop();
+    void process_window_events();
+    void track_frame_time();
     void draw_frame();
-    void recreate_swapchain();
-    void record_command_buffer(uint32_t image_index);
+    bool acquire_image(viewport_state& view);
+    viewport_state& primary_viewport();
+    // Returns false, leaving the swapchain as it is, while the window is minimised. Pipelines are recreated for new
+    // attachment formats unless create_pipelines is false, as at startup where they are created concurrently.
+    bool recreate_swapchain(viewport_state& view, bool create_pipelines = true);
+    void create_render_graph(viewport_state& view);
+    void create_pipeline(viewport_state& view);
+    // Throws if another viewport's attachment formats differ from view's, as one pipeline draws all of them.
+    void check_pipeline_formats(const viewport_state& view);
+    void create_scene_pipeline(viewport_state& view);
+    void create_particle_pipeline(viewport_state& view);
+    void record_command_buffer(uint32_t frame_index, VkCommandBuffer command_buffer);
+    void draw_scene(VkCommandBuffer command_buffer, viewport_state& view, uint32_t phase);
+    void upscale_scene(VkCommandBuffer command_buffer, viewport_state& view);
 
-    bt_window window { WIDTH, HEIGHT, "Breakable Toy" };
-    bt_device device { window };
-    std::unique_ptr<bt_swapchain> swapchain;
-    std::unique_ptr<bt_pipeline> pipeline;
+    // Startup is timed from before the device is created.
+    std::chrono::steady_clock::time_point startup_start = std::chrono::steady_clock::now();
+    bool startup_profile = false;
+    bool first_frame_presented = false;
+    // Declared before the device, whose destruction destroys their surfaces.
+    std::vector<std::unique_ptr<bt_window>> windows;
+    bt_device device;
+    // Meshes, pipelines, buffers and images, referred to by handle everywhere else.
+    bt_resources resources { device };
+    bt_pipeline_registry pipeline_registry;
+    std::unique_ptr<bt_bindless_table> bindless;
+    bt_frame_allocator frame_allocator { device, bt_swapchain::MAX_FRAMES_IN_FLIGHT };
+    // Scratch lists built while recording a frame, such as the texture streamer's uploads and barriers.
+    bt_frame_arena frame_arena { bt_swapchain::MAX_FRAMES_IN_FLIGHT };
+    bt_presenter presenter { device };
+    std::vector<std::unique_ptr<viewport_state>> viewports;
+    std::vector<VkResult> present_results;
+    bt_dynamic_resolution dynamic_resolution { device, bt_swapchain::MAX_FRAMES_IN_FLIGHT };
+    // Pipeline statistics of whole frames and memory budgets; nothing else may begin pipeline statistics queries.
+    bt_gpu_telemetry telemetry { device, bt_swapchain::MAX_FRAMES_IN_FLIGHT };
+    // Simulated and drawn entirely on the GPU, over the scene.
+    bt_particle_system particles { device, resources, bt_swapchain::MAX_FRAMES_IN_FLIGHT };
+    bt_pipeline_handle pipeline;
+    bt_draw_state scene_draw_state;
+    // Attachment formats the pipeline was created for; it stays compatible with render passes using the same ones, so
+    // one pipeline draws every viewport.
+    std::pair<VkFormat, VkFormat> pipeline_formats {};
     VkPipelineLayout pipeline_layout;
+    uint32_t swapchain_recreations = 0;
+    double worst_recreate_ms = 0.0;
+    // Process CPU time across all threads, for comparing one process with N viewports against N processes.
+    uint32_t stats_frames = 0;
+    std::clock_t stats_cpu_start = std::clock();
+    std::chrono::steady_clock::time_point stats_wall_start = std::chrono::steady_clock::now();
+    // One per frame in flight.
     std::vector<VkCommandBuffer> command_buffers;
-    std::unique_ptr<bt_model> model;
+    bt_mesh_handle quad;
+    bt_mesh_handle pebble;
+    bt_mesh_handle wall;
+    std::unique_ptr<bt_texture_streamer> texture_streamer;
+    std::vector<bt_texture_id> textures;
+    std::vector<scene_object> scene_objects;
+    bt_bounds_soa scene_bounds;
+    bt_bvh scene_bvh;
+    bt_culler culler;
+    std::vector<uint32_t> visible_objects;
+    bt_lod_settings lod_settings;
+    uint32_t triangles_submitted = 0;
+    bt_render_queue render_queue;
+    uint32_t frame = 0;
+    uint32_t frame_data_offset = 0;
+    simulation_state simulated;
+    bt_triple_buffer<scene_snapshot> snapshots;
+    // The last two snapshots taken from the simulation, drawn interpolated one step behind its clock.
+    scene_snapshot previous_snapshot;
+    scene_snapshot current_snapshot;
+    std::atomic<bool> render_stopping = false;
+    // Window events and frame times, owned by the render thread.
+    uint64_t input_events = 0;
+    uint64_t resize_events = 0;
+    std::chrono::steady_clock::time_point last_frame_start {};
+    // Seconds since the previous frame began, bounded so a stall does not become one huge step.
+    float frame_dt = 0.0f;
+    std::chrono::steady_clock::time_point last_input {};
+    std::chrono::steady_clock::time_point last_resize {};
+    bt_jitter_tracker frame_intervals;
+    bt_jitter_tracker input_frame_intervals;
+    bt_jitter_tracker resize_frame_intervals;
+    // Declared last so the thread stops before the state it steps is destroyed.
+    std::unique_ptr<bt_fixed_step_loop> simulation;
 };
 } // namespace bt
 
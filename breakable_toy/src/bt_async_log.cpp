@@ -0,0 +1,191 @@
+#include "bt_async_log.hpp"
+
+#include <spdlog/details/os.h>
+#include <spdlog/sinks/sink.h>
+
+#include <bit>
+#include <cassert>
+#include <chrono>
+#include <mutex>
+
+namespace bt {
+namespace {
+// The active logger is only touched under the registry mutex, so a thread registering its ring cannot race with the
+// logger's destruction. Log calls check the id instead, which never dangles.
+std::mutex registry_mutex;
+bt_async_logger* active_logger = nullptr;
+std::atomic<uint64_t> active_logger_id = 0;
+std::atomic<uint64_t> next_logger_id = 1;
+
+// The calling thread's ring in the logger it last logged through. Keyed by id so a ring from a destroyed logger is
+// never reused by a new one at the same address. Abandoned when the thread exits, so the logger can free it.
+struct thread_ring {
+    uint64_t logger_id = 0;
+    std::shared_ptr<bt_log_ring> ring;
+
+    thread_ring() = default;
+    thread_ring(const thread_ring&) = delete;
+    ~thread_ring() { release(); }
+
+    thread_ring& operator=(const thread_ring&) = delete;
+
+    void release()
+    {
+        if (ring != nullptr) {
+            ring->abandon();
+            ring.reset();
+        }
+        logger_id = 0;
+    }
+};
+thread_local thread_ring cache;
+} // namespace
+
+bt_log_ring::bt_log_ring(size_t capacity) :
+    buffer { std::make_unique<std::byte[]>(std::bit_ceil(capacity)) },
+    capacity { std::bit_ceil(capacity) },
+    mask { std::bit_ceil(capacity) - 1 },
+    thread_id_ { spdlog::details::os::thread_id() }
+{
+}
+
+bt_async_logger::bt_async_logger(std::shared_ptr<spdlog::logger> target, size_t ring_capacity) :
+    target { std::move(target) },
+    ring_capacity { ring_capacity },
+    id { next_logger_id++ }
+{
+    worker = std::thread { &bt_async_logger::run, this };
+
+    std::lock_guard lock { registry_mutex };
+    assert(active_logger == nullptr && "only one async logger can be active at a time");
+    active_logger = this;
+    active_logger_id.store(id, std::memory_order_release);
+}
+
+bt_async_logger::~bt_async_logger()
+{
+    // New calls go back to synchronous logging; the worker drains what is already queued before it exits.
+    {
+        std::lock_guard lock { registry_mutex };
+        active_logger = nullptr;
+        active_logger_id.store(0, std::memory_order_release);
+    }
+    stopping.store(true);
+    worker.join();
+    target->flush();
+}
+
+bt_log_ring* bt_async_logger::current_ring()
+{
+    uint64_t id = active_logger_id.load(std::memory_order_acquire);
+    if (id == 0) {
+        return nullptr;
+    }
+
+    if (cache.logger_id == id) {
+        return cache.ring.get();
+    }
+
+    // First log call of this thread: the only time a producer allocates or takes a lock.
+    std::lock_guard registry_lock { registry_mutex };
+    auto* logger = active_logger;
+    if (logger == nullptr) {
+        return nullptr;
+    }
+
+    cache.release();
+    auto ring = std::make_shared<bt_log_ring>(logger->ring_capacity);
+    {
+        std::lock_guard lock { logger->rings_mutex };
+        logger->rings.push_back(ring);
+    }
+    cache.logger_id = logger->id;
+    cache.ring = std::move(ring);
+    return cache.ring.get();
+}
+
+void bt_async_logger::run()
+{
+    using namespace std::chrono_literals;
+
+    while (true) {
+        bool stop = stopping.load();
+        if (drain() == 0) {
+            if (stop) {
+                break;
+            }
+            std::this_thread::sleep_for(1ms);
+        }
+    }
+}
+
+size_t bt_async_logger::drain()
+{
+    std::lock_guard lock { rings_mutex };
+
+    size_t count = 0;
+    for (auto& ring : rings) {
+        // Checked first: once abandoned, everything the thread wrote is visible to the consume below.
+        bool abandoned = ring->abandoned();
+        size_t thread_id = ring->thread_id();
+        count += ring->consume(
+            [&](const bt_log_record_header& header, const std::byte* args) { write(header, args, thread_id); });
+
+        if (auto dropped = ring->take_dropped(); dropped > 0) {
+            write_dropped(dropped, thread_id);
+        }
+        if (abandoned) {
+            ring.reset();
+        }
+    }
+    std::erase(rings, nullptr);
+    return count;
+}
+
+void bt_async_logger::write(const bt_log_record_header& header, const std::byte* args, size_t thread_id)
+{
+    const auto& site = *header.site;
+
+    buffer.clear();
+    try {
+        header.format(site, args, buffer);
+    } catch (const fmt::format_error& e) {
+        buffer.clear();
+        fmt::format_to(fmt::appender(buffer), "failed to format log message '{}': {}", site.format, e.what());
+    }
+
+    spdlog::details::log_msg message { spdlog::source_loc { site.file, site.line, site.function },
+        target->name(),
+        site.level,
+        spdlog::string_view_t { buffer.data(), buffer.size() } };
+    message.time = header.time;
+    message.thread_id = thread_id;
+
+    for (auto& sink : target->sinks()) {
+        if (sink->should_log(site.level)) {
+            sink->log(message);
+        }
+    }
+
+    if (site.level >= target->flush_level()) {
+        target->flush();
+    }
+}
+
+void bt_async_logger::write_dropped(uint64_t dropped, size_t thread_id)
+{
+    buffer.clear();
+    fmt::format_to(fmt::appender(buffer), "async log ring full, dropped {} messages", dropped);
+
+    spdlog::details::log_msg message { target->name(),
+        spdlog::level::warn,
+        spdlog::string_view_t { buffer.data(), buffer.size() } };
+    message.thread_id = thread_id;
+
+    for (auto& sink : target->sinks()) {
+        if (sink->should_log(spdlog::level::warn)) {
+            sink->log(message);
+        }
+    }
+}
+} // namespace bt
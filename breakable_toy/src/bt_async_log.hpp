@@ -0,0 +1,291 @@
+#ifndef BT_ASYNC_LOG_HPP
+#define BT_ASYNC_LOG_HPP
+
+#include <spdlog/spdlog.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace bt {
+// Everything about a log call that is known at compile time. One static instance exists per call site, so records
+// only carry a pointer to it.
+struct bt_log_site {
+    spdlog::level::level_enum level;
+    const char* format;
+    const char* file;
+    int line;
+    const char* function;
+};
+
+using bt_log_format_fn = void (*)(const bt_log_site& site, const std::byte* args, fmt::memory_buffer& out);
+
+struct bt_log_record_header {
+    // Total record size including this header, a multiple of 8. A padding record only has size and padding set.
+    uint32_t size;
+    uint32_t padding;
+    bt_log_format_fn format;
+    const bt_log_site* site;
+    spdlog::log_clock::time_point time;
+};
+
+// Single producer, single consumer byte ring. The producer is the thread that owns it, the consumer is the async
+// logger's background thread. Records never wrap; the tail of the buffer is skipped with a padding record instead.
+class bt_log_ring {
+  public:
+    explicit bt_log_ring(size_t capacity);
+    bt_log_ring(const bt_log_ring&) = delete;
+    ~bt_log_ring() = default;
+
+    bt_log_ring& operator=(const bt_log_ring&) = delete;
+
+    // Returns nullptr, and counts the record as dropped, if there is no room.
+    std::byte* reserve(size_t size)
+    {
+        uint64_t write = write_pos.load(std::memory_order_relaxed);
+        size_t to_end = capacity - (write & mask);
+        size_t skip = to_end < size ? to_end : 0;
+
+        if (capacity - (write - cached_read_pos) < skip + size) {
+            cached_read_pos = read_pos.load(std::memory_order_acquire);
+            if (capacity - (write - cached_read_pos) < skip + size) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+        }
+
+        if (skip > 0) {
+            uint32_t padding_record[2] = { static_cast<uint32_t>(skip), 1 };
+            memcpy(buffer.get() + (write & mask), padding_record, sizeof(padding_record));
+        }
+
+        pending_skip = skip;
+        return buffer.get() + ((write + skip) & mask);
+    }
+
+    void commit(size_t size)
+    {
+        uint64_t write = write_pos.load(std::memory_order_relaxed);
+        write_pos.store(write + pending_skip + size, std::memory_order_release);
+    }
+
+    // Calls consumer(header, args) for every committed record. Returns the number of records consumed.
+    template <typename Consumer>
+    size_t consume(Consumer&& consumer);
+
+    uint64_t take_dropped() { return dropped.exchange(0, std::memory_order_relaxed); }
+    size_t thread_id() const { return thread_id_; }
+
+    // Called by the producer when it stops using the ring, after its last commit.
+    void abandon() { abandoned_.store(true, std::memory_order_release); }
+    bool abandoned() const { return abandoned_.load(std::memory_order_acquire); }
+
+  private:
+    std::unique_ptr<std::byte[]> buffer;
+    size_t capacity;
+    size_t mask;
+    size_t thread_id_;
+
+    alignas(64) std::atomic<uint64_t> write_pos = 0;
+    uint64_t cached_read_pos = 0;
+    size_t pending_skip = 0;
+    std::atomic<uint64_t> dropped = 0;
+    std::atomic<bool> abandoned_ = false;
+
+    alignas(64) std::atomic<uint64_t> read_pos = 0;
+};
+
+template <typename Consumer>
+size_t bt_log_ring::consume(Consumer&& consumer)
+{
+    uint64_t read = read_pos.load(std::memory_order_relaxed);
+    uint64_t write = write_pos.load(std::memory_order_acquire);
+
+    size_t count = 0;
+    while (read != write) {
+        const std::byte* record = buffer.get() + (read & mask);
+
+        uint32_t size_and_padding[2];
+        memcpy(size_and_padding, record, sizeof(size_and_padding));
+        if (size_and_padding[1] == 0) {
+            bt_log_record_header header;
+            memcpy(&header, record, sizeof(header));
+            consumer(header, record + sizeof(header));
+            count++;
+        }
+
+        read += size_and_padding[0];
+        read_pos.store(read, std::memory_order_release);
+    }
+    return count;
+}
+
+namespace detail {
+template <typename T>
+constexpr bool is_log_string_v = std::is_same_v<T, const char*> || std::is_same_v<T, char*>
+    || std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>;
+
+// Strings are copied into the record and read back as views into the ring; everything else is copied bitwise.
+template <typename T>
+using log_stored_t = std::conditional_t<is_log_string_v<T>, std::string_view, T>;
+
+template <typename T>
+std::string_view as_log_string(const T& value)
+{
+    if constexpr (std::is_pointer_v<T>) {
+        return value != nullptr ? std::string_view { value } : std::string_view { "(null)" };
+    } else {
+        return value;
+    }
+}
+
+template <typename T>
+size_t log_arg_size(const T& value)
+{
+    static_assert(is_log_string_v<T> || std::is_trivially_copyable_v<T>,
+        "async log arguments must be strings or trivially copyable - format other types before logging them");
+
+    if constexpr (is_log_string_v<T>) {
+        return sizeof(uint32_t) + as_log_string(value).size();
+    } else {
+        return sizeof(T);
+    }
+}
+
+template <typename T>
+void write_log_arg(std::byte*& cursor, const T& value)
+{
+    if constexpr (is_log_string_v<T>) {
+        auto string = as_log_string(value);
+        auto length = static_cast<uint32_t>(string.size());
+        memcpy(cursor, &length, sizeof(length));
+        memcpy(cursor + sizeof(length), string.data(), length);
+        cursor += sizeof(length) + length;
+    } else {
+        memcpy(cursor, &value, sizeof(T));
+        cursor += sizeof(T);
+    }
+}
+
+template <typename T>
+T read_log_arg(const std::byte*& cursor)
+{
+    if constexpr (std::is_same_v<T, std::string_view>) {
+        uint32_t length;
+        memcpy(&length, cursor, sizeof(length));
+        std::string_view string { reinterpret_cast<const char*>(cursor + sizeof(length)), length };
+        cursor += sizeof(length) + length;
+        return string;
+    } else {
+        T value;
+        memcpy(&value, cursor, sizeof(T));
+        cursor += sizeof(T);
+        return value;
+    }
+}
+
+template <typename... Stored>
+void format_log_record(const bt_log_site& site, [[maybe_unused]] const std::byte* args, fmt::memory_buffer& out)
+{
+    // Braced initialisation evaluates the reads left to right.
+    std::tuple<Stored...> values { read_log_arg<Stored>(args)... };
+    std::apply([&](const auto&... v) { fmt::format_to(fmt::appender(out), fmt::runtime(site.format), v...); }, values);
+}
+} // namespace detail
+
+// Moves formatting and sink writes off the calling thread. Log calls copy their arguments into a compact binary record
+// in a per-thread ring buffer, without locking or allocating, and a background thread formats the records and hands
+// them to the sinks of the target logger. When a ring is full the record is dropped and a warning is written later.
+//
+// Only one async logger can be active at a time. Without one, BT_LOG_ASYNC falls back to logging synchronously.
+//
+// Rings are shared by the logger and the thread that writes to them, so neither outliving the other leaves a dangling
+// ring. A thread's ring is freed once the thread has exited and the ring is drained; a record a thread commits while
+// the logger is being destroyed may be lost, but never written to freed memory.
+class bt_async_logger {
+  public:
+    static constexpr size_t DEFAULT_RING_CAPACITY = 256 * 1024;
+
+    explicit bt_async_logger(std::shared_ptr<spdlog::logger> target, size_t ring_capacity = DEFAULT_RING_CAPACITY);
+    bt_async_logger(const bt_async_logger&) = delete;
+    ~bt_async_logger();
+
+    bt_async_logger& operator=(const bt_async_logger&) = delete;
+
+    template <typename... Args>
+    static void log(const bt_log_site& site, fmt::format_string<Args...> format, Args&&... args);
+
+  private:
+    static bt_log_ring* current_ring();
+
+    void run();
+    size_t drain();
+    void write(const bt_log_record_header& header, const std::byte* args, size_t thread_id);
+    void write_dropped(uint64_t dropped, size_t thread_id);
+
+    std::shared_ptr<spdlog::logger> target;
+    size_t ring_capacity;
+    uint64_t id;
+    std::mutex rings_mutex;
+    std::vector<std::shared_ptr<bt_log_ring>> rings;
+    fmt::memory_buffer buffer;
+    std::atomic<bool> stopping = false;
+    std::thread worker;
+};
+
+template <typename... Args>
+void bt_async_logger::log(const bt_log_site& site, fmt::format_string<Args...> format, Args&&... args)
+{
+    auto* logger = spdlog::default_logger_raw();
+    if (!logger->should_log(site.level)) {
+        return;
+    }
+
+    auto* ring = current_ring();
+    if (ring == nullptr) {
+        logger->log(spdlog::source_loc { site.file, site.line, site.function },
+            site.level,
+            format,
+            std::forward<Args>(args)...);
+        return;
+    }
+
+    size_t size = sizeof(bt_log_record_header) + (detail::log_arg_size<std::decay_t<Args>>(args) + ... + 0);
+    size = (size + 7) & ~size_t { 7 };
+
+    auto* record = ring->reserve(size);
+    if (record == nullptr) {
+        return;
+    }
+
+    bt_log_record_header header {};
+    header.size = static_cast<uint32_t>(size);
+    header.format = &detail::format_log_record<detail::log_stored_t<std::decay_t<Args>>...>;
+    header.site = &site;
+    header.time = spdlog::log_clock::now();
+    memcpy(record, &header, sizeof(header));
+
+    [[maybe_unused]] auto* cursor = record + sizeof(header);
+    (detail::write_log_arg<std::decay_t<Args>>(cursor, args), ...);
+
+    ring->commit(size);
+}
+} // namespace bt
+
+// The format string must be a literal; it is validated at compile time and formatted on the background thread.
+#define BT_LOG_ASYNC(level, format, ...)                                                                              \
+    do {                                                                                                               \
+        static const ::bt::bt_log_site bt_log_site_ { level, format, __FILE__, __LINE__, SPDLOG_FUNCTION };           \
+        ::bt::bt_async_logger::log(bt_log_site_, format __VA_OPT__(, ) __VA_ARGS__);                                   \
+    } while (0)
+
+#endif // BT_ASYNC_LOG_HPP
@@ -0,0 +1,252 @@
+#include "bt_bindless.hpp"
+
+#include "bt_logger.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace bt {
+namespace {
+constexpr std::array<VkDescriptorType, bt_bindless_table::SET_COUNT> descriptor_types {
+    VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+    VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+    VK_DESCRIPTOR_TYPE_SAMPLER,
+};
+} // namespace
+
+uint32_t bt_index_allocator::allocate()
+{
+    if (!free_list.empty()) {
+        uint32_t index = free_list.back();
+        free_list.pop_back();
+        return index;
+    }
+
+    if (next == capacity_) {
+        return INVALID_INDEX;
+    }
+
+    return next++;
+}
+
+void bt_index_allocator::free(uint32_t index)
+{
+    assert(index < next && "freeing an index that was never allocated");
+    free_list.push_back(index);
+}
+
+bt_bindless_table::bt_bindless_table(bt_device& device, const bt_bindless_capacity& requested) :
+    device { device },
+    allocators { bt_index_allocator { clamp_to_device_limits(device, requested).storage_buffers },
+        bt_index_allocator { clamp_to_device_limits(device, requested).sampled_images },
+        bt_index_allocator { clamp_to_device_limits(device, requested).samplers } }
+{
+    assert(device.bindless_supported() && "cannot create bindless table - descriptor indexing is not supported");
+
+    create_set_layouts();
+    create_descriptor_pool();
+    allocate_descriptor_sets();
+
+    SPDLOG_DEBUG("bindless table: {} storage buffers, {} sampled images, {} samplers",
+        allocators[0].capacity(),
+        allocators[1].capacity(),
+        allocators[2].capacity());
+}
+
+bt_bindless_table::~bt_bindless_table()
+{
+    // Destroying the pool frees the sets allocated from it; frames in flight may still have them bound.
+    device.destroy_later(descriptor_pool);
+    for (auto set_layout : set_layouts_) {
+        device.destroy_later(set_layout);
+    }
+}
+
+uint32_t bt_bindless_table::add_storage_buffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+{
+    uint32_t index = allocators[static_cast<size_t>(bt_bindless_type::storage_buffer)].allocate();
+    if (index == bt_index_allocator::INVALID_INDEX) {
+        throw std::runtime_error("bindless table is out of storage buffer slots");
+    }
+
+    update_storage_buffer(index, buffer, offset, range);
+    return index;
+}
+
+uint32_t bt_bindless_table::add_sampled_image(VkImageView image_view, VkImageLayout layout)
+{
+    uint32_t index = allocators[static_cast<size_t>(bt_bindless_type::sampled_image)].allocate();
+    if (index == bt_index_allocator::INVALID_INDEX) {
+        throw std::runtime_error("bindless table is out of sampled image slots");
+    }
+
+    update_sampled_image(index, image_view, layout);
+    return index;
+}
+
+uint32_t bt_bindless_table::add_sampler(VkSampler sampler)
+{
+    uint32_t index = allocators[static_cast<size_t>(bt_bindless_type::sampler)].allocate();
+    if (index == bt_index_allocator::INVALID_INDEX) {
+        throw std::runtime_error("bindless table is out of sampler slots");
+    }
+
+    VkDescriptorImageInfo image_info {};
+    image_info.sampler = sampler;
+    write(bt_bindless_type::sampler, index, nullptr, &image_info);
+    return index;
+}
+
+void bt_bindless_table::update_storage_buffer(
+    uint32_t index, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+{
+    VkDescriptorBufferInfo buffer_info {};
+    buffer_info.buffer = buffer;
+    buffer_info.offset = offset;
+    buffer_info.range = range;
+    write(bt_bindless_type::storage_buffer, index, &buffer_info, nullptr);
+}
+
+void bt_bindless_table::update_sampled_image(uint32_t index, VkImageView image_view, VkImageLayout layout)
+{
+    VkDescriptorImageInfo image_info {};
+    image_info.imageView = image_view;
+    image_info.imageLayout = layout;
+    write(bt_bindless_type::sampled_image, index, nullptr, &image_info);
+}
+
+void bt_bindless_table::remove(bt_bindless_type type, uint32_t index)
+{
+    // Partially bound arrays allow the stale descriptor to stay in place until the slot is reused.
+    allocators[static_cast<size_t>(type)].free(index);
+}
+
+void bt_bindless_table::bind(VkCommandBuffer command_buffer,
+    VkPipelineLayout pipeline_layout,
+    uint32_t first_set,
+    VkPipelineBindPoint bind_point)
+{
+    vkCmdBindDescriptorSets(command_buffer,
+        bind_point,
+        pipeline_layout,
+        first_set,
+        static_cast<uint32_t>(descriptor_sets.size()),
+        descriptor_sets.data(),
+        0,
+        nullptr);
+}
+
+bt_bindless_capacity bt_bindless_table::clamp_to_device_limits(
+    bt_device& device, const bt_bindless_capacity& requested)
+{
+    const auto& limits = device.descriptor_indexing_properties;
+
+    bt_bindless_capacity capacity;
+    capacity.storage_buffers = std::min({ requested.storage_buffers,
+        limits.maxDescriptorSetUpdateAfterBindStorageBuffers,
+        limits.maxPerStageDescriptorUpdateAfterBindStorageBuffers });
+    capacity.sampled_images = std::min({ requested.sampled_images,
+        limits.maxDescriptorSetUpdateAfterBindSampledImages,
+        limits.maxPerStageDescriptorUpdateAfterBindSampledImages });
+    capacity.samplers = std::min({ requested.samplers,
+        limits.maxDescriptorSetUpdateAfterBindSamplers,
+        limits.maxPerStageDescriptorUpdateAfterBindSamplers });
+    return capacity;
+}
+
+void bt_bindless_table::create_set_layouts()
+{
+    // Unused-while-pending lets slots be written while earlier frames that do not read them are still executing.
+    VkDescriptorBindingFlags binding_flags = VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT
+        | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT
+        | VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT;
+
+    for (uint32_t set = 0; set < SET_COUNT; set++) {
+        VkDescriptorSetLayoutBinding binding {};
+        binding.binding = 0;
+        binding.descriptorType = descriptor_types[set];
+        binding.descriptorCount = allocators[set].capacity();
+        binding.stageFlags = VK_SHADER_STAGE_ALL;
+
+        VkDescriptorSetLayoutBindingFlagsCreateInfo flags_info {
+            VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO
+        };
+        flags_info.bindingCount = 1;
+        flags_info.pBindingFlags = &binding_flags;
+
+        VkDescriptorSetLayoutCreateInfo layout_info { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+        layout_info.pNext = &flags_info;
+        layout_info.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+        layout_info.bindingCount = 1;
+        layout_info.pBindings = &binding;
+
+        if (vkCreateDescriptorSetLayout(device.device(), &layout_info, device.allocator(), &set_layouts_[set])
+            != VK_SUCCESS) {
+            throw std::runtime_error("failed to create bindless descriptor set layout");
+        }
+    }
+}
+
+void bt_bindless_table::create_descriptor_pool()
+{
+    std::array<VkDescriptorPoolSize, SET_COUNT> pool_sizes {};
+    for (uint32_t set = 0; set < SET_COUNT; set++) {
+        pool_sizes[set].type = descriptor_types[set];
+        pool_sizes[set].descriptorCount = allocators[set].capacity();
+    }
+
+    VkDescriptorPoolCreateInfo pool_info { VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+    pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+    pool_info.maxSets = SET_COUNT;
+    pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+    pool_info.pPoolSizes = pool_sizes.data();
+
+    if (vkCreateDescriptorPool(device.device(), &pool_info, device.allocator(), &descriptor_pool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create bindless descriptor pool");
+    }
+}
+
+void bt_bindless_table::allocate_descriptor_sets()
+{
+    std::array<uint32_t, SET_COUNT> counts {};
+    for (uint32_t set = 0; set < SET_COUNT; set++) {
+        counts[set] = allocators[set].capacity();
+    }
+
+    VkDescriptorSetVariableDescriptorCountAllocateInfo count_info {
+        VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO
+    };
+    count_info.descriptorSetCount = SET_COUNT;
+    count_info.pDescriptorCounts = counts.data();
+
+    VkDescriptorSetAllocateInfo alloc_info { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+    alloc_info.pNext = &count_info;
+    alloc_info.descriptorPool = descriptor_pool;
+    alloc_info.descriptorSetCount = SET_COUNT;
+    alloc_info.pSetLayouts = set_layouts_.data();
+
+    if (vkAllocateDescriptorSets(device.device(), &alloc_info, descriptor_sets.data()) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate bindless descriptor sets");
+    }
+}
+
+void bt_bindless_table::write(bt_bindless_type type,
+    uint32_t index,
+    const VkDescriptorBufferInfo* buffer_info,
+    const VkDescriptorImageInfo* image_info)
+{
+    auto set = static_cast<size_t>(type);
+
+    VkWriteDescriptorSet write { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+    write.dstSet = descriptor_sets[set];
+    write.dstBinding = 0;
+    write.dstArrayElement = index;
+    write.descriptorCount = 1;
+    write.descriptorType = descriptor_types[set];
+    write.pBufferInfo = buffer_info;
+    write.pImageInfo = image_info;
+
+    vkUpdateDescriptorSets(device.device(), 1, &write, 0, nullptr);
+}
+} // namespace bt
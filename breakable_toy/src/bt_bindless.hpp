@@ -0,0 +1,111 @@
+#ifndef BT_BINDLESS_HPP
+#define BT_BINDLESS_HPP
+
+#include "bt_device.hpp"
+
+#include <glad/vulkan.h>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace bt {
+// Hands out indices in [0, capacity). An index stays valid until it is freed, after which it may be reused.
+class bt_index_allocator {
+  public:
+    static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+    explicit bt_index_allocator(uint32_t capacity) :
+        capacity_ { capacity }
+    {
+    }
+
+    uint32_t allocate();
+    void free(uint32_t index);
+
+    uint32_t capacity() const { return capacity_; }
+    uint32_t in_use() const { return next - static_cast<uint32_t>(free_list.size()); }
+
+  private:
+    uint32_t capacity_;
+    uint32_t next = 0;
+    std::vector<uint32_t> free_list;
+};
+
+enum class bt_bindless_type : uint32_t {
+    storage_buffer = 0,
+    sampled_image,
+    sampler,
+    count
+};
+
+struct bt_bindless_capacity {
+    uint32_t storage_buffers = 8192;
+    uint32_t sampled_images = 16384;
+    uint32_t samplers = 256;
+};
+
+// Global resource table built on Vulkan 1.2 descriptor indexing. Each resource type lives in its own descriptor set
+// holding a single update-after-bind, partially bound, variable count array, so shaders index resources directly
+// (set numbers shown for first_set = 0):
+//
+//     layout (set = 0, binding = 0) buffer storage_buffers { uint data[]; } buffers[];
+//     layout (set = 1, binding = 0) uniform texture2D textures[];
+//     layout (set = 2, binding = 0) uniform sampler samplers[];
+//
+// The sets are bound once per command buffer; draws pass the indices returned by the add_* functions (e.g. through
+// push constants) instead of binding per draw descriptors.
+class bt_bindless_table {
+  public:
+    static constexpr uint32_t SET_COUNT = static_cast<uint32_t>(bt_bindless_type::count);
+
+    bt_bindless_table(bt_device& device, const bt_bindless_capacity& requested = {});
+    bt_bindless_table(const bt_bindless_table&) = delete;
+    ~bt_bindless_table();
+
+    bt_bindless_table& operator=(const bt_bindless_table&) = delete;
+
+    uint32_t add_storage_buffer(VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+    uint32_t add_sampled_image(VkImageView image_view,
+        VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    uint32_t add_sampler(VkSampler sampler);
+
+    void update_storage_buffer(uint32_t index,
+        VkBuffer buffer,
+        VkDeviceSize offset = 0,
+        VkDeviceSize range = VK_WHOLE_SIZE);
+    void update_sampled_image(uint32_t index,
+        VkImageView image_view,
+        VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+    // The caller must make sure no in-flight work still reads the slot before it is removed and reused.
+    void remove(bt_bindless_type type, uint32_t index);
+
+    void bind(VkCommandBuffer command_buffer,
+        VkPipelineLayout pipeline_layout,
+        uint32_t first_set = 0,
+        VkPipelineBindPoint bind_point = VK_PIPELINE_BIND_POINT_GRAPHICS);
+
+    const std::array<VkDescriptorSetLayout, SET_COUNT>& set_layouts() const { return set_layouts_; }
+    const bt_index_allocator& allocator(bt_bindless_type type) const { return allocators[static_cast<size_t>(type)]; }
+
+  private:
+    static bt_bindless_capacity clamp_to_device_limits(bt_device& device, const bt_bindless_capacity& requested);
+
+    void create_set_layouts();
+    void create_descriptor_pool();
+    void allocate_descriptor_sets();
+    void write(bt_bindless_type type,
+        uint32_t index,
+        const VkDescriptorBufferInfo* buffer_info,
+        const VkDescriptorImageInfo* image_info);
+
+    bt_device& device;
+    std::array<bt_index_allocator, SET_COUNT> allocators;
+    std::array<VkDescriptorSetLayout, SET_COUNT> set_layouts_ {};
+    std::array<VkDescriptorSet, SET_COUNT> descriptor_sets {};
+    VkDescriptorPool descriptor_pool = VK_NULL_HANDLE;
+};
+} // namespace bt
+
+#endif // BT_BINDLESS_HPP
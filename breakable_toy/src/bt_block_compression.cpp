@@ -0,0 +1,722 @@
+#include "bt_block_compression.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BT_BC_SSE 1
+#endif
+
+namespace bt {
+namespace {
+constexpr uint32_t BLOCK_TEXELS = 16;
+
+const std::array<bt_block_format_info, 4> format_infos = { {
+    { "BC1", 8, 3, VK_FORMAT_BC1_RGB_UNORM_BLOCK, VK_FORMAT_BC1_RGB_SRGB_BLOCK },
+    { "BC3", 16, 4, VK_FORMAT_BC3_UNORM_BLOCK, VK_FORMAT_BC3_SRGB_BLOCK },
+    { "BC5", 16, 2, VK_FORMAT_BC5_UNORM_BLOCK, VK_FORMAT_BC5_UNORM_BLOCK },
+    { "BC7", 16, 4, VK_FORMAT_BC7_UNORM_BLOCK, VK_FORMAT_BC7_SRGB_BLOCK },
+} };
+
+// Texels of one block, one array per channel so four texels can be compared against a palette entry at once.
+struct block_texels {
+    alignas(16) float channels[4][BLOCK_TEXELS];
+};
+
+using color = std::array<float, 4>;
+
+block_texels load_block(const std::byte* pixels, uint32_t width, uint32_t height, uint32_t block_x, uint32_t block_y)
+{
+    block_texels block;
+    for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+        uint32_t x = std::min(block_x * 4 + i % 4, width - 1);
+        uint32_t y = std::min(block_y * 4 + i / 4, height - 1);
+        const std::byte* texel = pixels + (static_cast<size_t>(y) * width + x) * 4;
+        for (uint32_t c = 0; c < 4; c++) {
+            block.channels[c][i] = static_cast<float>(texel[c]);
+        }
+    }
+    return block;
+}
+
+// Writes, for each texel, the index of the nearest palette entry over the first channel_count channels, and returns
+// the summed squared error.
+float select_indices(const block_texels& block,
+    uint32_t channel_count,
+    const color* palette,
+    uint32_t palette_size,
+    uint8_t* indices)
+{
+#if defined(BT_BC_SSE)
+    float error = 0.0f;
+    for (uint32_t group = 0; group < BLOCK_TEXELS; group += 4) {
+        __m128 best = _mm_set1_ps(std::numeric_limits<float>::max());
+        __m128i best_index = _mm_setzero_si128();
+        for (uint32_t p = 0; p < palette_size; p++) {
+            __m128 distance = _mm_setzero_ps();
+            for (uint32_t c = 0; c < channel_count; c++) {
+                __m128 d = _mm_sub_ps(_mm_load_ps(&block.channels[c][group]), _mm_set1_ps(palette[p][c]));
+                distance = _mm_add_ps(distance, _mm_mul_ps(d, d));
+            }
+            __m128i closer = _mm_castps_si128(_mm_cmplt_ps(distance, best));
+            best = _mm_min_ps(distance, best);
+            best_index = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(static_cast<int>(p))),
+                _mm_andnot_si128(closer, best_index));
+        }
+        alignas(16) int32_t lane_indices[4];
+        alignas(16) float lane_errors[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lane_indices), best_index);
+        _mm_store_ps(lane_errors, best);
+        for (uint32_t lane = 0; lane < 4; lane++) {
+            indices[group + lane] = static_cast<uint8_t>(lane_indices[lane]);
+            error += lane_errors[lane];
+        }
+    }
+    return error;
+#else
+    float error = 0.0f;
+    for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+        float best = std::numeric_limits<float>::max();
+        for (uint32_t p = 0; p < palette_size; p++) {
+            float distance = 0.0f;
+            for (uint32_t c = 0; c < channel_count; c++) {
+                float d = block.channels[c][i] - palette[p][c];
+                distance += d * d;
+            }
+            if (distance < best) {
+                best = distance;
+                indices[i] = static_cast<uint8_t>(p);
+            }
+        }
+        error += best;
+    }
+    return error;
+#endif
+}
+
+// Endpoints spanning the block's texels along their principal axis, found by power iteration on the covariance.
+void principal_endpoints(const block_texels& block, uint32_t channel_count, color& start, color& end)
+{
+    color mean {};
+    for (uint32_t c = 0; c < channel_count; c++) {
+        for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+            mean[c] += block.channels[c][i];
+        }
+        mean[c] /= BLOCK_TEXELS;
+    }
+
+    float covariance[4][4] = {};
+    for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+        for (uint32_t a = 0; a < channel_count; a++) {
+            for (uint32_t b = a; b < channel_count; b++) {
+                covariance[a][b] += (block.channels[a][i] - mean[a]) * (block.channels[b][i] - mean[b]);
+            }
+        }
+    }
+    for (uint32_t a = 0; a < channel_count; a++) {
+        for (uint32_t b = 0; b < a; b++) {
+            covariance[a][b] = covariance[b][a];
+        }
+    }
+
+    color axis { 1.0f, 1.0f, 1.0f, 1.0f };
+    for (int iteration = 0; iteration < 8; iteration++) {
+        color next {};
+        float length = 0.0f;
+        for (uint32_t a = 0; a < channel_count; a++) {
+            for (uint32_t b = 0; b < channel_count; b++) {
+                next[a] += covariance[a][b] * axis[b];
+            }
+            length = std::max(length, std::abs(next[a]));
+        }
+        if (length == 0.0f) {
+            break;
+        }
+        for (uint32_t a = 0; a < channel_count; a++) {
+            axis[a] = next[a] / length;
+        }
+    }
+
+    float min_t = std::numeric_limits<float>::max();
+    float max_t = std::numeric_limits<float>::lowest();
+    float axis_length_squared = 0.0f;
+    for (uint32_t c = 0; c < channel_count; c++) {
+        axis_length_squared += axis[c] * axis[c];
+    }
+    for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+        float t = 0.0f;
+        for (uint32_t c = 0; c < channel_count; c++) {
+            t += (block.channels[c][i] - mean[c]) * axis[c];
+        }
+        min_t = std::min(min_t, t);
+        max_t = std::max(max_t, t);
+    }
+    min_t /= axis_length_squared;
+    max_t /= axis_length_squared;
+
+    for (uint32_t c = 0; c < 4; c++) {
+        start[c] = c < channel_count ? std::clamp(mean[c] + axis[c] * min_t, 0.0f, 255.0f) : 255.0f;
+        end[c] = c < channel_count ? std::clamp(mean[c] + axis[c] * max_t, 0.0f, 255.0f) : 255.0f;
+    }
+}
+
+// Least-squares endpoints for fixed indices, where index i interpolates weights[i] of the way from start to end.
+// Returns false when the system is degenerate (all texels share one weight).
+bool refine_endpoints(const block_texels& block,
+    uint32_t channel_count,
+    const uint8_t* indices,
+    const float* weights,
+    color& start,
+    color& end)
+{
+    float aa = 0.0f;
+    float ab = 0.0f;
+    float bb = 0.0f;
+    color ax {};
+    color bx {};
+    for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+        float b = weights[indices[i]];
+        float a = 1.0f - b;
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+        for (uint32_t c = 0; c < channel_count; c++) {
+            ax[c] += a * block.channels[c][i];
+            bx[c] += b * block.channels[c][i];
+        }
+    }
+
+    float determinant = aa * bb - ab * ab;
+    if (std::abs(determinant) < 1e-6f) {
+        return false;
+    }
+    for (uint32_t c = 0; c < channel_count; c++) {
+        start[c] = std::clamp((bb * ax[c] - ab * bx[c]) / determinant, 0.0f, 255.0f);
+        end[c] = std::clamp((aa * bx[c] - ab * ax[c]) / determinant, 0.0f, 255.0f);
+    }
+    return true;
+}
+
+void store_le(std::byte* destination, uint64_t value, uint32_t bytes)
+{
+    for (uint32_t i = 0; i < bytes; i++) {
+        destination[i] = static_cast<std::byte>(value >> (8 * i));
+    }
+}
+
+uint64_t load_le(const std::byte* source, uint32_t bytes)
+{
+    uint64_t value = 0;
+    for (uint32_t i = 0; i < bytes; i++) {
+        value |= static_cast<uint64_t>(source[i]) << (8 * i);
+    }
+    return value;
+}
+
+// BC1 colour block: two RGB565 endpoints and a 2-bit index per texel.
+
+uint16_t pack_565(const color& c)
+{
+    auto r = static_cast<uint32_t>(c[0] * 31.0f / 255.0f + 0.5f);
+    auto g = static_cast<uint32_t>(c[1] * 63.0f / 255.0f + 0.5f);
+    auto b = static_cast<uint32_t>(c[2] * 31.0f / 255.0f + 0.5f);
+    return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+color unpack_565(uint16_t packed)
+{
+    uint32_t r = (packed >> 11) & 31;
+    uint32_t g = (packed >> 5) & 63;
+    uint32_t b = packed & 31;
+    return { static_cast<float>((r << 3) | (r >> 2)),
+        static_cast<float>((g << 2) | (g >> 4)),
+        static_cast<float>((b << 3) | (b >> 2)),
+        255.0f };
+}
+
+// Palette of a block decoded in four-colour mode (endpoint 0 > endpoint 1, which BC3 always assumes).
+std::array<color, 4> bc1_palette(uint16_t c0, uint16_t c1)
+{
+    std::array<color, 4> palette { unpack_565(c0), unpack_565(c1) };
+    for (uint32_t c = 0; c < 4; c++) {
+        palette[2][c] = std::floor((2.0f * palette[0][c] + palette[1][c]) / 3.0f);
+        palette[3][c] = std::floor((palette[0][c] + 2.0f * palette[1][c]) / 3.0f);
+    }
+    return palette;
+}
+
+void encode_bc1_color(const block_texels& block, std::byte* out)
+{
+    // Weight of the second endpoint for each index in four-colour mode.
+    static constexpr float weights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+    color start;
+    color end;
+    principal_endpoints(block, 3, start, end);
+
+    uint16_t best_c0 = 0;
+    uint16_t best_c1 = 0;
+    uint8_t best_indices[BLOCK_TEXELS] = {};
+    float best_error = std::numeric_limits<float>::max();
+
+    for (int iteration = 0; iteration < 2; iteration++) {
+        uint16_t c0 = pack_565(end);
+        uint16_t c1 = pack_565(start);
+        if (c0 == c1) {
+            // A solid block; four-colour mode needs c0 > c1, so every texel takes c0 exactly.
+            if (best_error == std::numeric_limits<float>::max()) {
+                best_c0 = c0;
+                best_c1 = c1;
+                std::fill(std::begin(best_indices), std::end(best_indices), uint8_t { 0 });
+            }
+            break;
+        }
+        if (c0 < c1) {
+            std::swap(c0, c1);
+            std::swap(start, end);
+        }
+
+        std::array<color, 4> palette = bc1_palette(c0, c1);
+        uint8_t indices[BLOCK_TEXELS];
+        float error = select_indices(block, 3, palette.data(), 4, indices);
+        if (error < best_error) {
+            best_error = error;
+            best_c0 = c0;
+            best_c1 = c1;
+            std::copy(std::begin(indices), std::end(indices), best_indices);
+        }
+        if (error == 0.0f || !refine_endpoints(block, 3, indices, weights, end, start)) {
+            break;
+        }
+    }
+
+    uint32_t packed_indices = 0;
+    for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+        packed_indices |= static_cast<uint32_t>(best_indices[i]) << (2 * i);
+    }
+    store_le(out, best_c0, 2);
+    store_le(out + 2, best_c1, 2);
+    store_le(out + 4, packed_indices, 4);
+}
+
+void decode_bc1_color(const std::byte* in, bool allow_three_color, std::byte* texels)
+{
+    auto c0 = static_cast<uint16_t>(load_le(in, 2));
+    auto c1 = static_cast<uint16_t>(load_le(in + 2, 2));
+    auto indices = static_cast<uint32_t>(load_le(in + 4, 4));
+
+    std::array<color, 4> palette = bc1_palette(c0, c1);
+    if (allow_three_color && c0 <= c1) {
+        for (uint32_t c = 0; c < 3; c++) {
+            palette[2][c] = std::floor((palette[0][c] + palette[1][c]) / 2.0f);
+        }
+        palette[3] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    }
+
+    for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+        const color& value = palette[(indices >> (2 * i)) & 3];
+        for (uint32_t c = 0; c < 4; c++) {
+            texels[i * 4 + c] = static_cast<std::byte>(value[c]);
+        }
+    }
+}
+
+// BC4 single channel block, as used for BC3 alpha and both BC5 channels: two 8-bit endpoints and a 3-bit index per
+// texel. Always encoded in the eight-value mode (endpoint 0 > endpoint 1).
+
+std::array<float, 8> bc4_palette(uint32_t a0, uint32_t a1)
+{
+    std::array<float, 8> palette { static_cast<float>(a0), static_cast<float>(a1) };
+    if (a0 > a1) {
+        for (uint32_t i = 1; i < 7; i++) {
+            palette[i + 1] = static_cast<float>(((7 - i) * a0 + i * a1) / 7);
+        }
+    } else {
+        for (uint32_t i = 1; i < 5; i++) {
+            palette[i + 1] = static_cast<float>(((5 - i) * a0 + i * a1) / 5);
+        }
+        palette[6] = 0.0f;
+        palette[7] = 255.0f;
+    }
+    return palette;
+}
+
+void encode_bc4(const float* values, std::byte* out)
+{
+    float low = *std::min_element(values, values + BLOCK_TEXELS);
+    float high = *std::max_element(values, values + BLOCK_TEXELS);
+    auto a0 = static_cast<uint32_t>(high + 0.5f);
+    auto a1 = static_cast<uint32_t>(low + 0.5f);
+
+    uint64_t packed_indices = 0;
+    if (a0 != a1) {
+        std::array<float, 8> palette = bc4_palette(a0, a1);
+        for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+            uint64_t best_index = 0;
+            float best = std::numeric_limits<float>::max();
+            for (uint32_t p = 0; p < 8; p++) {
+                float distance = std::abs(values[i] - palette[p]);
+                if (distance < best) {
+                    best = distance;
+                    best_index = p;
+                }
+            }
+            packed_indices |= best_index << (3 * i);
+        }
+    }
+    out[0] = static_cast<std::byte>(a0);
+    out[1] = static_cast<std::byte>(a1);
+    store_le(out + 2, packed_indices, 6);
+}
+
+void decode_bc4(const std::byte* in, uint32_t channel, std::byte* texels)
+{
+    std::array<float, 8> palette = bc4_palette(static_cast<uint32_t>(in[0]), static_cast<uint32_t>(in[1]));
+    uint64_t indices = load_le(in + 2, 6);
+    for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+        texels[i * 4 + channel] = static_cast<std::byte>(palette[(indices >> (3 * i)) & 7]);
+    }
+}
+
+// BC7 mode 6: one subset, RGBA endpoints of 7 bits plus a shared-per-endpoint p-bit, and 4-bit indices.
+
+constexpr uint32_t bc7_weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+class bit_writer {
+  public:
+    explicit bit_writer(std::byte* out) :
+        out { out }
+    {
+        std::memset(out, 0, 16);
+    }
+
+    void write(uint32_t value, uint32_t bits)
+    {
+        for (uint32_t i = 0; i < bits; i++, position++) {
+            if ((value >> i) & 1) {
+                out[position / 8] |= static_cast<std::byte>(1u << (position % 8));
+            }
+        }
+    }
+
+  private:
+    std::byte* out;
+    uint32_t position = 0;
+};
+
+class bit_reader {
+  public:
+    explicit bit_reader(const std::byte* in) :
+        in { in }
+    {
+    }
+
+    uint32_t read(uint32_t bits)
+    {
+        uint32_t value = 0;
+        for (uint32_t i = 0; i < bits; i++, position++) {
+            value |= ((static_cast<uint32_t>(in[position / 8]) >> (position % 8)) & 1) << i;
+        }
+        return value;
+    }
+
+  private:
+    const std::byte* in;
+    uint32_t position = 0;
+};
+
+// Quantises an endpoint to 7 bits per channel, choosing the p-bit that lands closest.
+void quantize_bc7_endpoint(const color& value, std::array<uint32_t, 4>& quantized, uint32_t& p_bit)
+{
+    float best_error = std::numeric_limits<float>::max();
+    for (uint32_t p = 0; p < 2; p++) {
+        std::array<uint32_t, 4> candidate;
+        float error = 0.0f;
+        for (uint32_t c = 0; c < 4; c++) {
+            int q = static_cast<int>(std::lround((value[c] - static_cast<float>(p)) / 2.0f));
+            candidate[c] = static_cast<uint32_t>(std::clamp(q, 0, 127));
+            float d = static_cast<float>((candidate[c] << 1) | p) - value[c];
+            error += d * d;
+        }
+        if (error < best_error) {
+            best_error = error;
+            quantized = candidate;
+            p_bit = p;
+        }
+    }
+}
+
+std::array<color, 16> bc7_palette(const std::array<uint32_t, 4>& e0, const std::array<uint32_t, 4>& e1)
+{
+    std::array<color, 16> palette;
+    for (uint32_t i = 0; i < 16; i++) {
+        for (uint32_t c = 0; c < 4; c++) {
+            palette[i][c] = static_cast<float>(((64 - bc7_weights[i]) * e0[c] + bc7_weights[i] * e1[c] + 32) >> 6);
+        }
+    }
+    return palette;
+}
+
+void encode_bc7(const block_texels& block, std::byte* out)
+{
+    static constexpr auto weights = [] {
+        std::array<float, 16> w {};
+        for (uint32_t i = 0; i < 16; i++) {
+            w[i] = static_cast<float>(bc7_weights[i]) / 64.0f;
+        }
+        return w;
+    }();
+
+    color start;
+    color end;
+    principal_endpoints(block, 4, start, end);
+
+    std::array<uint32_t, 4> best_q0 {};
+    std::array<uint32_t, 4> best_q1 {};
+    uint32_t best_p0 = 0;
+    uint32_t best_p1 = 0;
+    uint8_t best_indices[BLOCK_TEXELS] = {};
+    float best_error = std::numeric_limits<float>::max();
+
+    for (int iteration = 0; iteration < 2; iteration++) {
+        std::array<uint32_t, 4> q0;
+        std::array<uint32_t, 4> q1;
+        uint32_t p0;
+        uint32_t p1;
+        quantize_bc7_endpoint(start, q0, p0);
+        quantize_bc7_endpoint(end, q1, p1);
+
+        std::array<uint32_t, 4> e0;
+        std::array<uint32_t, 4> e1;
+        for (uint32_t c = 0; c < 4; c++) {
+            e0[c] = (q0[c] << 1) | p0;
+            e1[c] = (q1[c] << 1) | p1;
+        }
+        std::array<color, 16> palette = bc7_palette(e0, e1);
+        uint8_t indices[BLOCK_TEXELS];
+        float error = select_indices(block, 4, palette.data(), 16, indices);
+        if (error < best_error) {
+            best_error = error;
+            best_q0 = q0;
+            best_q1 = q1;
+            best_p0 = p0;
+            best_p1 = p1;
+            std::copy(std::begin(indices), std::end(indices), best_indices);
+        }
+        if (error == 0.0f || !refine_endpoints(block, 4, indices, weights.data(), start, end)) {
+            break;
+        }
+    }
+
+    // The first texel's index is stored with its top bit implied zero; mirror the block if it is set.
+    if (best_indices[0] & 8) {
+        std::swap(best_q0, best_q1);
+        std::swap(best_p0, best_p1);
+        for (uint8_t& index : best_indices) {
+            index = static_cast<uint8_t>(15 - index);
+        }
+    }
+
+    bit_writer writer { out };
+    writer.write(1u << 6, 7);
+    for (uint32_t c = 0; c < 4; c++) {
+        writer.write(best_q0[c], 7);
+        writer.write(best_q1[c], 7);
+    }
+    writer.write(best_p0, 1);
+    writer.write(best_p1, 1);
+    writer.write(best_indices[0], 3);
+    for (uint32_t i = 1; i < BLOCK_TEXELS; i++) {
+        writer.write(best_indices[i], 4);
+    }
+}
+
+void decode_bc7(const std::byte* in, std::byte* texels)
+{
+    bit_reader reader { in };
+    if (reader.read(7) != 1u << 6) {
+        for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+            texels[i * 4 + 0] = std::byte { 255 };
+            texels[i * 4 + 1] = std::byte { 0 };
+            texels[i * 4 + 2] = std::byte { 255 };
+            texels[i * 4 + 3] = std::byte { 255 };
+        }
+        return;
+    }
+
+    std::array<uint32_t, 4> e0;
+    std::array<uint32_t, 4> e1;
+    for (uint32_t c = 0; c < 4; c++) {
+        e0[c] = reader.read(7) << 1;
+        e1[c] = reader.read(7) << 1;
+    }
+    uint32_t p0 = reader.read(1);
+    uint32_t p1 = reader.read(1);
+    for (uint32_t c = 0; c < 4; c++) {
+        e0[c] |= p0;
+        e1[c] |= p1;
+    }
+
+    std::array<color, 16> palette = bc7_palette(e0, e1);
+    for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+        const color& value = palette[reader.read(i == 0 ? 3 : 4)];
+        for (uint32_t c = 0; c < 4; c++) {
+            texels[i * 4 + c] = static_cast<std::byte>(value[c]);
+        }
+    }
+}
+
+void encode_block(bt_block_format format, const block_texels& block, std::byte* out)
+{
+    switch (format) {
+    case bt_block_format::bc1:
+        encode_bc1_color(block, out);
+        break;
+    case bt_block_format::bc3:
+        encode_bc4(block.channels[3], out);
+        encode_bc1_color(block, out + 8);
+        break;
+    case bt_block_format::bc5:
+        encode_bc4(block.channels[0], out);
+        encode_bc4(block.channels[1], out + 8);
+        break;
+    case bt_block_format::bc7:
+        encode_bc7(block, out);
+        break;
+    }
+}
+
+void decode_block(bt_block_format format, const std::byte* in, std::byte* texels)
+{
+    switch (format) {
+    case bt_block_format::bc1:
+        decode_bc1_color(in, true, texels);
+        break;
+    case bt_block_format::bc3:
+        decode_bc1_color(in + 8, false, texels);
+        decode_bc4(in, 3, texels);
+        break;
+    case bt_block_format::bc5:
+        for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+            texels[i * 4 + 2] = std::byte { 0 };
+            texels[i * 4 + 3] = std::byte { 255 };
+        }
+        decode_bc4(in, 0, texels);
+        decode_bc4(in + 8, 1, texels);
+        break;
+    case bt_block_format::bc7:
+        decode_bc7(in, texels);
+        break;
+    }
+}
+
+uint32_t blocks_across(uint32_t size)
+{
+    return (size + 3) / 4;
+}
+} // namespace
+
+const bt_block_format_info& bt_block_info(bt_block_format format)
+{
+    return format_infos[static_cast<size_t>(format)];
+}
+
+std::optional<bt_block_format> bt_block_format_from_vk(VkFormat format)
+{
+    for (size_t i = 0; i < format_infos.size(); i++) {
+        if (format_infos[i].unorm == format || format_infos[i].srgb == format) {
+            return static_cast<bt_block_format>(i);
+        }
+    }
+    return std::nullopt;
+}
+
+size_t bt_compressed_size(bt_block_format format, uint32_t width, uint32_t height)
+{
+    return static_cast<size_t>(blocks_across(width)) * blocks_across(height) * bt_block_info(format).block_bytes;
+}
+
+std::vector<std::byte> bt_compress_blocks(bt_block_format format,
+    const std::byte* pixels,
+    uint32_t width,
+    uint32_t height,
+    unsigned thread_count)
+{
+    uint32_t block_columns = blocks_across(width);
+    uint32_t block_rows = blocks_across(height);
+    uint32_t block_bytes = bt_block_info(format).block_bytes;
+    std::vector<std::byte> blocks(bt_compressed_size(format, width, height));
+
+    auto encode_rows = [&](uint32_t first_row, uint32_t last_row) {
+        for (uint32_t by = first_row; by < last_row; by++) {
+            for (uint32_t bx = 0; bx < block_columns; bx++) {
+                std::byte* out = blocks.data() + (static_cast<size_t>(by) * block_columns + bx) * block_bytes;
+                encode_block(format, load_block(pixels, width, height, bx, by), out);
+            }
+        }
+    };
+
+    thread_count = std::clamp(thread_count, 1u, block_rows);
+    if (thread_count == 1) {
+        encode_rows(0, block_rows);
+        return blocks;
+    }
+
+    std::vector<std::jthread> workers;
+    workers.reserve(thread_count);
+    for (uint32_t t = 0; t < thread_count; t++) {
+        workers.emplace_back(encode_rows, block_rows * t / thread_count, block_rows * (t + 1) / thread_count);
+    }
+    workers.clear();
+    return blocks;
+}
+
+std::vector<std::byte> bt_decompress_blocks(bt_block_format format,
+    const std::byte* blocks,
+    uint32_t width,
+    uint32_t height)
+{
+    uint32_t block_columns = blocks_across(width);
+    uint32_t block_rows = blocks_across(height);
+    uint32_t block_bytes = bt_block_info(format).block_bytes;
+    std::vector<std::byte> pixels(static_cast<size_t>(width) * height * 4);
+
+    std::byte texels[BLOCK_TEXELS * 4];
+    for (uint32_t by = 0; by < block_rows; by++) {
+        for (uint32_t bx = 0; bx < block_columns; bx++) {
+            decode_block(format, blocks + (static_cast<size_t>(by) * block_columns + bx) * block_bytes, texels);
+            for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+                uint32_t x = bx * 4 + i % 4;
+                uint32_t y = by * 4 + i / 4;
+                if (x < width && y < height) {
+                    std::memcpy(&pixels[(static_cast<size_t>(y) * width + x) * 4], &texels[i * 4], 4);
+                }
+            }
+        }
+    }
+    return pixels;
+}
+
+double bt_psnr(const std::byte* a, const std::byte* b, size_t pixel_count, uint32_t channel_count)
+{
+    assert(channel_count >= 1 && channel_count <= 4);
+
+    double squared_error = 0.0;
+    for (size_t i = 0; i < pixel_count; i++) {
+        for (uint32_t c = 0; c < channel_count; c++) {
+            double d = static_cast<double>(a[i * 4 + c]) - static_cast<double>(b[i * 4 + c]);
+            squared_error += d * d;
+        }
+    }
+    if (squared_error == 0.0) {
+        return std::numeric_limits<double>::infinity();
+    }
+    double mean_squared_error = squared_error / (static_cast<double>(pixel_count) * channel_count);
+    return 10.0 * std::log10(255.0 * 255.0 / mean_squared_error);
+}
+} // namespace bt
@@ -0,0 +1,55 @@
+#ifndef BT_BLOCK_COMPRESSION_HPP
+#define BT_BLOCK_COMPRESSION_HPP
+
+#include <glad/vulkan.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace bt {
+enum class bt_block_format : uint32_t {
+    bc1, // RGB, 4 bpp
+    bc3, // RGBA, 8 bpp
+    bc5, // two channel (e.g. normal map XY), 8 bpp
+    bc7, // RGBA, 8 bpp, highest quality
+};
+
+struct bt_block_format_info {
+    const char* name;
+    uint32_t block_bytes;
+    // Channels the format stores, counted from red; used when measuring error.
+    uint32_t channels;
+    VkFormat unorm;
+    VkFormat srgb;
+};
+
+const bt_block_format_info& bt_block_info(bt_block_format format);
+std::optional<bt_block_format> bt_block_format_from_vk(VkFormat format);
+
+size_t bt_compressed_size(bt_block_format format, uint32_t width, uint32_t height);
+
+// Encodes RGBA8 pixels into 4x4 blocks, rows of blocks split across threads. Partial blocks at the right and bottom
+// edges repeat the edge texels. The encoders fit endpoints along each block's principal axis, refine them once by
+// least squares and pick indices with SSE2 where available. BC7 uses mode 6 (one subset, RGBA endpoints, 4-bit
+// indices) for every block.
+std::vector<std::byte> bt_compress_blocks(bt_block_format format,
+    const std::byte* pixels,
+    uint32_t width,
+    uint32_t height,
+    unsigned thread_count = std::thread::hardware_concurrency());
+
+// Decodes blocks back to RGBA8. BC5 decodes to (r, g, 0, 255). Only BC7 mode 6 blocks, which is what
+// bt_compress_blocks produces, are decoded; blocks using other modes decode to magenta.
+std::vector<std::byte> bt_decompress_blocks(bt_block_format format,
+    const std::byte* blocks,
+    uint32_t width,
+    uint32_t height);
+
+// Peak signal-to-noise ratio in dB over the first channel_count channels of two RGBA8 images.
+double bt_psnr(const std::byte* a, const std::byte* b, size_t pixel_count, uint32_t channel_count = 3);
+} // namespace bt
+
+#endif // BT_BLOCK_COMPRESSION_HPP
@@ -0,0 +1,111 @@
+#ifndef BT_BOUNDS_HPP
+#define BT_BOUNDS_HPP
+
+#include "bt_maths.hpp"
+
+#include <array>
+#include <limits>
+
+namespace bt {
+struct bt_aabb {
+    glm::vec3 min { std::numeric_limits<float>::max() };
+    glm::vec3 max { std::numeric_limits<float>::lowest() };
+
+    bool is_valid() const { return min.x <= max.x && min.y <= max.y && min.z <= max.z; }
+    glm::vec3 center() const { return (min + max) * 0.5f; }
+    glm::vec3 extents() const { return (max - min) * 0.5f; }
+
+    float surface_area() const
+    {
+        glm::vec3 d = max - min;
+        return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+
+    bool contains(const bt_aabb& other) const
+    {
+        return min.x <= other.min.x && min.y <= other.min.y && min.z <= other.min.z && max.x >= other.max.x
+            && max.y >= other.max.y && max.z >= other.max.z;
+    }
+
+    void expand(const glm::vec3& point)
+    {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+
+    static bt_aabb merge(const bt_aabb& a, const bt_aabb& b)
+    {
+        return { glm::min(a.min, b.min), glm::max(a.max, b.max) };
+    }
+
+    bt_aabb translated(const glm::vec3& offset) const { return { min + offset, max + offset }; }
+    bt_aabb inflated(float margin) const { return { min - glm::vec3(margin), max + glm::vec3(margin) }; }
+};
+
+struct bt_sphere {
+    glm::vec3 center { 0.0f };
+    float radius = 0.0f;
+};
+
+// Planes are stored as (normal, distance) with normals pointing into the frustum, so a point p is inside a plane when
+// dot(normal, p) + distance >= 0.
+struct bt_frustum {
+    enum plane { left = 0, right, bottom, top, front, back, count };
+
+    std::array<glm::vec4, plane::count> planes;
+
+    // Extracts the planes from a Vulkan style (depth zero to one) view-projection matrix.
+    static bt_frustum from_matrix(const glm::mat4& view_projection)
+    {
+        auto row = [&](int i) {
+            return glm::vec4(view_projection[0][i],
+                view_projection[1][i],
+                view_projection[2][i],
+                view_projection[3][i]);
+        };
+
+        bt_frustum frustum;
+        frustum.planes[left] = row(3) + row(0);
+        frustum.planes[right] = row(3) - row(0);
+        frustum.planes[bottom] = row(3) + row(1);
+        frustum.planes[top] = row(3) - row(1);
+        frustum.planes[front] = row(2);
+        frustum.planes[back] = row(3) - row(2);
+
+        for (auto& p : frustum.planes) {
+            float length = glm::length(glm::vec3(p.x, p.y, p.z));
+            p = p / length;
+        }
+
+        return frustum;
+    }
+
+    bool intersects(const bt_aabb& box) const
+    {
+        for (const auto& p : planes) {
+            glm::vec3 positive { p.x > 0.0f ? box.max.x : box.min.x,
+                p.y > 0.0f ? box.max.y : box.min.y,
+                p.z > 0.0f ? box.max.z : box.min.z };
+            if (p.x * positive.x + p.y * positive.y + p.z * positive.z + p.w < 0.0f) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool contains(const bt_aabb& box) const
+    {
+        for (const auto& p : planes) {
+            glm::vec3 negative { p.x > 0.0f ? box.min.x : box.max.x,
+                p.y > 0.0f ? box.min.y : box.max.y,
+                p.z > 0.0f ? box.min.z : box.max.z };
+            if (p.x * negative.x + p.y * negative.y + p.z * negative.z + p.w < 0.0f) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+} // namespace bt
+
+#endif // BT_BOUNDS_HPP
@@ -0,0 +1,311 @@
+#include "bt_bvh.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace bt {
+namespace {
+bool overlaps(const bt_aabb& a, const bt_aabb& b)
+{
+    return a.min.x <= b.max.x && a.max.x >= b.min.x && a.min.y <= b.max.y && a.max.y >= b.min.y
+        && a.min.z <= b.max.z && a.max.z >= b.min.z;
+}
+} // namespace
+
+int32_t bt_bvh::create_proxy(const bt_aabb& box, uint32_t user_data)
+{
+    int32_t proxy = allocate_node();
+    nodes[proxy].box = box.inflated(FAT_MARGIN);
+    nodes[proxy].user_data = user_data;
+    nodes[proxy].height = 0;
+
+    insert_leaf(proxy);
+    proxy_count_++;
+
+    return proxy;
+}
+
+void bt_bvh::destroy_proxy(int32_t proxy)
+{
+    assert(proxy >= 0 && proxy < static_cast<int32_t>(nodes.size()) && nodes[proxy].is_leaf());
+
+    remove_leaf(proxy);
+    free_node(proxy);
+    proxy_count_--;
+}
+
+bool bt_bvh::move_proxy(int32_t proxy, const bt_aabb& box)
+{
+    assert(proxy >= 0 && proxy < static_cast<int32_t>(nodes.size()) && nodes[proxy].is_leaf());
+
+    node& leaf = nodes[proxy];
+    if (leaf.box.contains(box)) {
+        return false;
+    }
+
+    // Objects that jump away from their old position are reinserted so the tree stays tight; everything else is
+    // updated in place and refit lazily.
+    if (!overlaps(leaf.box, box)) {
+        remove_leaf(proxy);
+        leaf.box = box.inflated(FAT_MARGIN);
+        insert_leaf(proxy);
+        return true;
+    }
+
+    leaf.box = box.inflated(FAT_MARGIN);
+    if (!leaf.dirty) {
+        leaf.dirty = true;
+        dirty_leaves.push_back(proxy);
+    }
+
+    return true;
+}
+
+void bt_bvh::refit()
+{
+    for (int32_t leaf : dirty_leaves) {
+        nodes[leaf].dirty = false;
+
+        int32_t index = nodes[leaf].parent;
+        while (index != NULL_NODE) {
+            node& n = nodes[index];
+            bt_aabb refit_box = bt_aabb::merge(nodes[n.left].box, nodes[n.right].box);
+            if (n.box.contains(refit_box) && refit_box.contains(n.box)) {
+                break;
+            }
+            n.box = refit_box;
+            rotate(index);
+            index = n.parent;
+        }
+    }
+
+    dirty_leaves.clear();
+}
+
+void bt_bvh::clear()
+{
+    nodes.clear();
+    free_list.clear();
+    dirty_leaves.clear();
+    root = NULL_NODE;
+    proxy_count_ = 0;
+}
+
+void bt_bvh::query(const bt_frustum& frustum, std::vector<uint32_t>& visible, std::vector<uint32_t>& candidates) const
+{
+    if (root == NULL_NODE) {
+        return;
+    }
+
+    auto& stack = query_stack;
+    stack.clear();
+    stack.push_back(root);
+
+    while (!stack.empty()) {
+        int32_t index = stack.back();
+        stack.pop_back();
+
+        const node& n = nodes[index];
+        if (!frustum.intersects(n.box)) {
+            continue;
+        }
+
+        if (n.is_leaf()) {
+            candidates.push_back(n.user_data);
+        } else if (frustum.contains(n.box)) {
+            collect_leaves(index, visible);
+        } else {
+            stack.push_back(n.left);
+            stack.push_back(n.right);
+        }
+    }
+}
+
+int32_t bt_bvh::allocate_node()
+{
+    if (!free_list.empty()) {
+        int32_t index = free_list.back();
+        free_list.pop_back();
+        nodes[index] = node {};
+        return index;
+    }
+
+    nodes.emplace_back();
+    return static_cast<int32_t>(nodes.size() - 1);
+}
+
+void bt_bvh::free_node(int32_t index)
+{
+    nodes[index].height = -1;
+    free_list.push_back(index);
+}
+
+void bt_bvh::insert_leaf(int32_t leaf)
+{
+    if (root == NULL_NODE) {
+        root = leaf;
+        nodes[root].parent = NULL_NODE;
+        return;
+    }
+
+    // Descend towards the sibling that minimises the increase in surface area.
+    bt_aabb leaf_box = nodes[leaf].box;
+    int32_t index = root;
+    while (!nodes[index].is_leaf()) {
+        const node& n = nodes[index];
+
+        float area = n.box.surface_area();
+        float combined_area = bt_aabb::merge(n.box, leaf_box).surface_area();
+        float cost = 2.0f * combined_area;
+        float inheritance_cost = 2.0f * (combined_area - area);
+
+        auto child_cost = [&](int32_t child) {
+            const node& c = nodes[child];
+            float merged = bt_aabb::merge(leaf_box, c.box).surface_area();
+            return c.is_leaf() ? merged + inheritance_cost : merged - c.box.surface_area() + inheritance_cost;
+        };
+
+        float left_cost = child_cost(n.left);
+        float right_cost = child_cost(n.right);
+
+        if (cost < left_cost && cost < right_cost) {
+            break;
+        }
+
+        index = left_cost < right_cost ? n.left : n.right;
+    }
+
+    int32_t sibling = index;
+    int32_t old_parent = nodes[sibling].parent;
+    int32_t new_parent = allocate_node();
+
+    nodes[new_parent].parent = old_parent;
+    nodes[new_parent].box = bt_aabb::merge(leaf_box, nodes[sibling].box);
+    nodes[new_parent].height = nodes[sibling].height + 1;
+    nodes[new_parent].left = sibling;
+    nodes[new_parent].right = leaf;
+    nodes[sibling].parent = new_parent;
+    nodes[leaf].parent = new_parent;
+
+    if (old_parent == NULL_NODE) {
+        root = new_parent;
+    } else if (nodes[old_parent].left == sibling) {
+        nodes[old_parent].left = new_parent;
+    } else {
+        nodes[old_parent].right = new_parent;
+    }
+
+    for (index = nodes[leaf].parent; index != NULL_NODE; index = nodes[index].parent) {
+        node& n = nodes[index];
+        n.height = 1 + std::max(nodes[n.left].height, nodes[n.right].height);
+        n.box = bt_aabb::merge(nodes[n.left].box, nodes[n.right].box);
+        rotate(index);
+    }
+}
+
+void bt_bvh::remove_leaf(int32_t leaf)
+{
+    if (nodes[leaf].dirty) {
+        nodes[leaf].dirty = false;
+        std::erase(dirty_leaves, leaf);
+    }
+
+    if (leaf == root) {
+        root = NULL_NODE;
+        return;
+    }
+
+    int32_t parent = nodes[leaf].parent;
+    int32_t grand_parent = nodes[parent].parent;
+    int32_t sibling = nodes[parent].left == leaf ? nodes[parent].right : nodes[parent].left;
+
+    if (grand_parent == NULL_NODE) {
+        root = sibling;
+        nodes[sibling].parent = NULL_NODE;
+        free_node(parent);
+        return;
+    }
+
+    if (nodes[grand_parent].left == parent) {
+        nodes[grand_parent].left = sibling;
+    } else {
+        nodes[grand_parent].right = sibling;
+    }
+    nodes[sibling].parent = grand_parent;
+    free_node(parent);
+
+    for (int32_t index = grand_parent; index != NULL_NODE; index = nodes[index].parent) {
+        node& n = nodes[index];
+        n.height = 1 + std::max(nodes[n.left].height, nodes[n.right].height);
+        n.box = bt_aabb::merge(nodes[n.left].box, nodes[n.right].box);
+        rotate(index);
+    }
+}
+
+void bt_bvh::collect_leaves(int32_t subtree, std::vector<uint32_t>& out) const
+{
+    // Walks the subtree through parent links instead of a stack: down to the leftmost leaf, then up until a right
+    // sibling is left to visit.
+    int32_t index = subtree;
+    while (true) {
+        while (!nodes[index].is_leaf()) {
+            index = nodes[index].left;
+        }
+        out.push_back(nodes[index].user_data);
+
+        while (index != subtree && nodes[nodes[index].parent].right == index) {
+            index = nodes[index].parent;
+        }
+        if (index == subtree) {
+            return;
+        }
+        index = nodes[nodes[index].parent].right;
+    }
+}
+
+void bt_bvh::rotate(int32_t index)
+{
+    // Swaps one child with a grandchild under the other child when that shrinks the other child's box, the only
+    // one that changes. Applied on every node whose box changes, this keeps the tree tight as objects move, without
+    // rebuilding it.
+    const node& n = nodes[index];
+    int32_t best_uncle = NULL_NODE;
+    int32_t best_grandchild = NULL_NODE;
+    float best_gain = 0.0f;
+
+    auto consider = [&](int32_t uncle, int32_t child) {
+        const node& c = nodes[child];
+        if (c.is_leaf()) {
+            return;
+        }
+        float area = c.box.surface_area();
+        for (int32_t grandchild : { c.left, c.right }) {
+            int32_t kept = grandchild == c.left ? c.right : c.left;
+            float gain = area - bt_aabb::merge(nodes[uncle].box, nodes[kept].box).surface_area();
+            if (gain > best_gain) {
+                best_gain = gain;
+                best_uncle = uncle;
+                best_grandchild = grandchild;
+            }
+        }
+    };
+    consider(n.left, n.right);
+    consider(n.right, n.left);
+
+    if (best_uncle == NULL_NODE) {
+        return;
+    }
+
+    int32_t child = nodes[best_grandchild].parent;
+    node& c = nodes[child];
+    (c.left == best_grandchild ? c.left : c.right) = best_uncle;
+    nodes[best_uncle].parent = child;
+    c.box = bt_aabb::merge(nodes[c.left].box, nodes[c.right].box);
+    c.height = 1 + std::max(nodes[c.left].height, nodes[c.right].height);
+
+    node& parent = nodes[index];
+    (parent.left == best_uncle ? parent.left : parent.right) = best_grandchild;
+    nodes[best_grandchild].parent = index;
+    parent.height = 1 + std::max(nodes[parent.left].height, nodes[parent.right].height);
+}
+} // namespace bt
@@ -0,0 +1,69 @@
+#ifndef BT_BVH_HPP
+#define BT_BVH_HPP
+
+#include "bt_bounds.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace bt {
+// Dynamic AABB tree over scene objects. Leaves store a fattened box so that small movements do not touch the tree;
+// larger movements update the leaf in place and the affected ancestors are refit in bulk by refit(). Nodes whose box
+// changes are rotated when that lowers the tree's surface area, so it does not degrade as objects move.
+class bt_bvh {
+  public:
+    static constexpr int32_t NULL_NODE = -1;
+    static constexpr float FAT_MARGIN = 0.1f;
+
+    bt_bvh() = default;
+    bt_bvh(const bt_bvh&) = delete;
+    ~bt_bvh() = default;
+
+    bt_bvh& operator=(const bt_bvh&) = delete;
+
+    int32_t create_proxy(const bt_aabb& box, uint32_t user_data);
+    void destroy_proxy(int32_t proxy);
+    bool move_proxy(int32_t proxy, const bt_aabb& box);
+    void refit();
+    void clear();
+
+    // Walks the tree against the frustum. Objects in subtrees entirely inside the frustum are appended to `visible`;
+    // objects in leaves that only intersect it are appended to `candidates` for an exact test by the caller. Reuses
+    // the tree's traversal stack, so queries on one tree must not run concurrently.
+    void query(const bt_frustum& frustum, std::vector<uint32_t>& visible, std::vector<uint32_t>& candidates) const;
+
+    const bt_aabb& fat_bounds(int32_t proxy) const { return nodes[proxy].box; }
+    uint32_t user_data(int32_t proxy) const { return nodes[proxy].user_data; }
+    size_t proxy_count() const { return proxy_count_; }
+    int32_t height() const { return root == NULL_NODE ? 0 : nodes[root].height; }
+
+  private:
+    struct node {
+        bt_aabb box;
+        int32_t parent = NULL_NODE;
+        int32_t left = NULL_NODE;
+        int32_t right = NULL_NODE;
+        int32_t height = 0;
+        uint32_t user_data = 0;
+        bool dirty = false;
+
+        bool is_leaf() const { return left == NULL_NODE; }
+    };
+
+    int32_t allocate_node();
+    void free_node(int32_t index);
+    void insert_leaf(int32_t leaf);
+    void remove_leaf(int32_t leaf);
+    void collect_leaves(int32_t subtree, std::vector<uint32_t>& out) const;
+    void rotate(int32_t index);
+
+    std::vector<node> nodes;
+    std::vector<int32_t> free_list;
+    std::vector<int32_t> dirty_leaves;
+    mutable std::vector<int32_t> query_stack;
+    int32_t root = NULL_NODE;
+    size_t proxy_count_ = 0;
+};
+} // namespace bt
+
+#endif // BT_BVH_HPP
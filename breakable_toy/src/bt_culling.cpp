@@ -0,0 +1,216 @@
+#include "bt_culling.hpp"
+
+#include <array>
+#include <bit>
+#include <chrono>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define BT_CULL_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BT_CULL_SSE 1
+#endif
+
+namespace bt {
+namespace {
+// For each plane, the box corner furthest along the plane normal (the "positive vertex") is picked per component.
+// The choice depends only on the sign of the normal, so it can be made once per plane rather than once per box.
+struct plane_selection {
+    float nx, ny, nz, d;
+    const float* px;
+    const float* py;
+    const float* pz;
+};
+
+std::array<plane_selection, bt_frustum::count> select_planes(const bt_frustum& frustum,
+    const float* min_x,
+    const float* min_y,
+    const float* min_z,
+    const float* max_x,
+    const float* max_y,
+    const float* max_z)
+{
+    std::array<plane_selection, bt_frustum::count> selected;
+    for (size_t i = 0; i < frustum.planes.size(); i++) {
+        const auto& p = frustum.planes[i];
+        selected[i] = { p.x,
+            p.y,
+            p.z,
+            p.w,
+            p.x > 0.0f ? max_x : min_x,
+            p.y > 0.0f ? max_y : min_y,
+            p.z > 0.0f ? max_z : min_z };
+    }
+    return selected;
+}
+
+size_t cull_scalar(const std::array<plane_selection, bt_frustum::count>& planes,
+    size_t begin,
+    size_t end,
+    const uint32_t* ids,
+    uint32_t* out)
+{
+    size_t written = 0;
+    for (size_t i = begin; i < end; i++) {
+        bool inside = true;
+        for (const auto& p : planes) {
+            if (p.nx * p.px[i] + p.ny * p.py[i] + p.nz * p.pz[i] + p.d < 0.0f) {
+                inside = false;
+                break;
+            }
+        }
+
+        if (inside) {
+            out[written++] = ids ? ids[i] : static_cast<uint32_t>(i);
+        }
+    }
+    return written;
+}
+} // namespace
+
+#if defined(BT_CULL_AVX)
+const int bt_culler::SIMD_WIDTH = 8;
+#elif defined(BT_CULL_SSE)
+const int bt_culler::SIMD_WIDTH = 4;
+#else
+const int bt_culler::SIMD_WIDTH = 1;
+#endif
+
+void bt_bounds_soa::resize(size_t count)
+{
+    min_x.resize(count);
+    min_y.resize(count);
+    min_z.resize(count);
+    max_x.resize(count);
+    max_y.resize(count);
+    max_z.resize(count);
+}
+
+void bt_bounds_soa::set(size_t index, const bt_aabb& box)
+{
+    min_x[index] = box.min.x;
+    min_y[index] = box.min.y;
+    min_z[index] = box.min.z;
+    max_x[index] = box.max.x;
+    max_y[index] = box.max.y;
+    max_z[index] = box.max.z;
+}
+
+size_t cull_aabbs(const bt_frustum& frustum,
+    const float* min_x,
+    const float* min_y,
+    const float* min_z,
+    const float* max_x,
+    const float* max_y,
+    const float* max_z,
+    size_t count,
+    const uint32_t* ids,
+    uint32_t* out)
+{
+    auto planes = select_planes(frustum, min_x, min_y, min_z, max_x, max_y, max_z);
+    size_t written = 0;
+    size_t i = 0;
+
+#if defined(BT_CULL_AVX)
+    for (; i + 8 <= count; i += 8) {
+        __m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (const auto& p : planes) {
+            __m256 distance = _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(p.nx), _mm256_loadu_ps(p.px + i)),
+                    _mm256_mul_ps(_mm256_set1_ps(p.ny), _mm256_loadu_ps(p.py + i))),
+                _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(p.nz), _mm256_loadu_ps(p.pz + i)), _mm256_set1_ps(p.d)));
+            visible = _mm256_and_ps(visible, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_GE_OQ));
+        }
+
+        for (int mask = _mm256_movemask_ps(visible); mask != 0; mask &= mask - 1) {
+            size_t index = i + static_cast<size_t>(std::countr_zero(static_cast<unsigned>(mask)));
+            out[written++] = ids ? ids[index] : static_cast<uint32_t>(index);
+        }
+    }
+#elif defined(BT_CULL_SSE)
+    for (; i + 4 <= count; i += 4) {
+        __m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (const auto& p : planes) {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(p.nx), _mm_loadu_ps(p.px + i)),
+                                             _mm_mul_ps(_mm_set1_ps(p.ny), _mm_loadu_ps(p.py + i))),
+                _mm_add_ps(_mm_mul_ps(_mm_set1_ps(p.nz), _mm_loadu_ps(p.pz + i)), _mm_set1_ps(p.d)));
+            visible = _mm_and_ps(visible, _mm_cmpge_ps(distance, _mm_setzero_ps()));
+        }
+
+        for (int mask = _mm_movemask_ps(visible); mask != 0; mask &= mask - 1) {
+            size_t index = i + static_cast<size_t>(std::countr_zero(static_cast<unsigned>(mask)));
+            out[written++] = ids ? ids[index] : static_cast<uint32_t>(index);
+        }
+    }
+#endif
+
+    written += cull_scalar(planes, i, count, ids, out + written);
+    return written;
+}
+
+void bt_culler::cull(const bt_frustum& frustum, const bt_bounds_soa& bounds, std::vector<uint32_t>& visible)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    visible.resize(bounds.size());
+    size_t count = cull_aabbs(frustum,
+        bounds.min_x.data(),
+        bounds.min_y.data(),
+        bounds.min_z.data(),
+        bounds.max_x.data(),
+        bounds.max_y.data(),
+        bounds.max_z.data(),
+        bounds.size(),
+        nullptr,
+        visible.data());
+    visible.resize(count);
+
+    stats_.tested = static_cast<uint32_t>(bounds.size());
+    stats_.visible = static_cast<uint32_t>(count);
+    stats_.culled = stats_.tested - stats_.visible;
+    stats_.cull_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void bt_culler::cull(const bt_frustum& frustum,
+    const bt_bvh& bvh,
+    const bt_bounds_soa& bounds,
+    std::vector<uint32_t>& visible)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    visible.clear();
+    candidates.clear();
+    bvh.query(frustum, visible, candidates);
+
+    size_t accepted = visible.size();
+    gathered.resize(candidates.size());
+    for (size_t i = 0; i < candidates.size(); i++) {
+        uint32_t id = candidates[i];
+        gathered.min_x[i] = bounds.min_x[id];
+        gathered.min_y[i] = bounds.min_y[id];
+        gathered.min_z[i] = bounds.min_z[id];
+        gathered.max_x[i] = bounds.max_x[id];
+        gathered.max_y[i] = bounds.max_y[id];
+        gathered.max_z[i] = bounds.max_z[id];
+    }
+
+    visible.resize(accepted + candidates.size());
+    size_t count = cull_aabbs(frustum,
+        gathered.min_x.data(),
+        gathered.min_y.data(),
+        gathered.min_z.data(),
+        gathered.max_x.data(),
+        gathered.max_y.data(),
+        gathered.max_z.data(),
+        candidates.size(),
+        candidates.data(),
+        visible.data() + accepted);
+    visible.resize(accepted + count);
+
+    stats_.tested = static_cast<uint32_t>(bvh.proxy_count());
+    stats_.visible = static_cast<uint32_t>(visible.size());
+    stats_.culled = stats_.tested - stats_.visible;
+    stats_.cull_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+} // namespace bt
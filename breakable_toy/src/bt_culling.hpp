@@ -0,0 +1,71 @@
+#ifndef BT_CULLING_HPP
+#define BT_CULLING_HPP
+
+#include "bt_bounds.hpp"
+#include "bt_bvh.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace bt {
+// Structure-of-arrays copy of world space bounds so the culling kernel can load several boxes per instruction.
+struct bt_bounds_soa {
+    std::vector<float> min_x;
+    std::vector<float> min_y;
+    std::vector<float> min_z;
+    std::vector<float> max_x;
+    std::vector<float> max_y;
+    std::vector<float> max_z;
+
+    size_t size() const { return min_x.size(); }
+    void resize(size_t count);
+    void set(size_t index, const bt_aabb& box);
+};
+
+struct bt_cull_stats {
+    uint32_t tested = 0;
+    uint32_t visible = 0;
+    uint32_t culled = 0;
+    double cull_ms = 0.0;
+};
+
+class bt_culler {
+  public:
+    // Number of boxes tested per iteration by the kernel selected at compile time.
+    static const int SIMD_WIDTH;
+
+    // Brute force: tests every box in `bounds` and writes the indices of the visible ones to `visible`.
+    void cull(const bt_frustum& frustum, const bt_bounds_soa& bounds, std::vector<uint32_t>& visible);
+
+    // Hierarchical: the BVH rejects or accepts whole subtrees, then the leaves straddling the frustum are gathered and
+    // tested exactly against `bounds` (indexed by the proxies' user data).
+    void cull(const bt_frustum& frustum,
+        const bt_bvh& bvh,
+        const bt_bounds_soa& bounds,
+        std::vector<uint32_t>& visible);
+
+    const bt_cull_stats& stats() const { return stats_; }
+
+  private:
+    std::vector<uint32_t> candidates;
+    bt_bounds_soa gathered;
+    bt_cull_stats stats_;
+};
+
+// Tests `count` boxes against the frustum and appends the visible ones to `out`, which must have room for `count`
+// entries. When `ids` is non-null the id of each visible box is written instead of its index. Returns the number of
+// entries written.
+size_t cull_aabbs(const bt_frustum& frustum,
+    const float* min_x,
+    const float* min_y,
+    const float* min_z,
+    const float* max_x,
+    const float* max_y,
+    const float* max_z,
+    size_t count,
+    const uint32_t* ids,
+    uint32_t* out);
+} // namespace bt
+
+#endif // BT_CULLING_HPP
@@ -0,0 +1,102 @@
+#include "bt_deletion_queue.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace bt {
+namespace {
+template <typename Handle>
+Handle handle_cast(uint64_t handle)
+{
+    return reinterpret_cast<Handle>(handle);
+}
+} // namespace
+
+void bt_deletion_queue::push(VkObjectType type, uint64_t handle, uint64_t frame)
+{
+    entries.push_back({ type, handle, frame });
+    frame_queued++;
+    stats_.total_queued++;
+    stats_.pending = entries.size();
+    stats_.peak_pending = std::max(stats_.peak_pending, stats_.pending);
+}
+
+void bt_deletion_queue::collect(
+    VkInstance instance, VkDevice device, const VkAllocationCallbacks* allocator, uint64_t completed)
+{
+    while (!entries.empty() && entries.front().frame <= completed) {
+        destroy(instance, device, allocator, entries.front());
+        entries.pop_front();
+        frame_destroyed++;
+        stats_.total_destroyed++;
+    }
+    stats_.pending = entries.size();
+}
+
+void bt_deletion_queue::end_frame()
+{
+    stats_.queued = std::exchange(frame_queued, 0);
+    stats_.destroyed = std::exchange(frame_destroyed, 0);
+}
+
+void bt_deletion_queue::destroy(
+    VkInstance instance, VkDevice device, const VkAllocationCallbacks* allocator, const entry& e)
+{
+    switch (e.type) {
+    case VK_OBJECT_TYPE_BUFFER:
+        vkDestroyBuffer(device, handle_cast<VkBuffer>(e.handle), allocator);
+        break;
+    case VK_OBJECT_TYPE_IMAGE:
+        vkDestroyImage(device, handle_cast<VkImage>(e.handle), allocator);
+        break;
+    case VK_OBJECT_TYPE_IMAGE_VIEW:
+        vkDestroyImageView(device, handle_cast<VkImageView>(e.handle), allocator);
+        break;
+    case VK_OBJECT_TYPE_DEVICE_MEMORY:
+        vkFreeMemory(device, handle_cast<VkDeviceMemory>(e.handle), allocator);
+        break;
+    case VK_OBJECT_TYPE_SAMPLER:
+        vkDestroySampler(device, handle_cast<VkSampler>(e.handle), allocator);
+        break;
+    case VK_OBJECT_TYPE_PIPELINE:
+        vkDestroyPipeline(device, handle_cast<VkPipeline>(e.handle), allocator);
+        break;
+    case VK_OBJECT_TYPE_PIPELINE_LAYOUT:
+        vkDestroyPipelineLayout(device, handle_cast<VkPipelineLayout>(e.handle), allocator);
+        break;
+    case VK_OBJECT_TYPE_SHADER_MODULE:
+        vkDestroyShaderModule(device, handle_cast<VkShaderModule>(e.handle), allocator);
+        break;
+    case VK_OBJECT_TYPE_RENDER_PASS:
+        vkDestroyRenderPass(device, handle_cast<VkRenderPass>(e.handle), allocator);
+        break;
+    case VK_OBJECT_TYPE_FRAMEBUFFER:
+        vkDestroyFramebuffer(device, handle_cast<VkFramebuffer>(e.handle), allocator);
+        break;
+    case VK_OBJECT_TYPE_DESCRIPTOR_POOL:
+        vkDestroyDescriptorPool(device, handle_cast<VkDescriptorPool>(e.handle), allocator);
+        break;
+    case VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT:
+        vkDestroyDescriptorSetLayout(device, handle_cast<VkDescriptorSetLayout>(e.handle), allocator);
+        break;
+    case VK_OBJECT_TYPE_QUERY_POOL:
+        vkDestroyQueryPool(device, handle_cast<VkQueryPool>(e.handle), allocator);
+        break;
+    case VK_OBJECT_TYPE_SEMAPHORE:
+        vkDestroySemaphore(device, handle_cast<VkSemaphore>(e.handle), allocator);
+        break;
+    case VK_OBJECT_TYPE_FENCE:
+        vkDestroyFence(device, handle_cast<VkFence>(e.handle), allocator);
+        break;
+    case VK_OBJECT_TYPE_SWAPCHAIN_KHR:
+        vkDestroySwapchainKHR(device, handle_cast<VkSwapchainKHR>(e.handle), allocator);
+        break;
+    case VK_OBJECT_TYPE_SURFACE_KHR:
+        vkDestroySurfaceKHR(instance, handle_cast<VkSurfaceKHR>(e.handle), allocator);
+        break;
+    default:
+        throw std::runtime_error("failed to destroy deferred object of unsupported type");
+    }
+}
+} // namespace bt
@@ -0,0 +1,83 @@
+#ifndef BT_DELETION_QUEUE_HPP
+#define BT_DELETION_QUEUE_HPP
+
+#include <glad/vulkan.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+namespace bt {
+template <typename Handle>
+constexpr VkObjectType bt_object_type();
+
+#define BT_OBJECT_TYPE(handle_type, object_type)                                                                      \
+    template <>                                                                                                        \
+    constexpr VkObjectType bt_object_type<handle_type>()                                                               \
+    {                                                                                                                  \
+        return object_type;                                                                                            \
+    }
+
+BT_OBJECT_TYPE(VkBuffer, VK_OBJECT_TYPE_BUFFER)
+BT_OBJECT_TYPE(VkImage, VK_OBJECT_TYPE_IMAGE)
+BT_OBJECT_TYPE(VkImageView, VK_OBJECT_TYPE_IMAGE_VIEW)
+BT_OBJECT_TYPE(VkDeviceMemory, VK_OBJECT_TYPE_DEVICE_MEMORY)
+BT_OBJECT_TYPE(VkSampler, VK_OBJECT_TYPE_SAMPLER)
+BT_OBJECT_TYPE(VkPipeline, VK_OBJECT_TYPE_PIPELINE)
+BT_OBJECT_TYPE(VkPipelineLayout, VK_OBJECT_TYPE_PIPELINE_LAYOUT)
+BT_OBJECT_TYPE(VkShaderModule, VK_OBJECT_TYPE_SHADER_MODULE)
+BT_OBJECT_TYPE(VkRenderPass, VK_OBJECT_TYPE_RENDER_PASS)
+BT_OBJECT_TYPE(VkFramebuffer, VK_OBJECT_TYPE_FRAMEBUFFER)
+BT_OBJECT_TYPE(VkDescriptorPool, VK_OBJECT_TYPE_DESCRIPTOR_POOL)
+BT_OBJECT_TYPE(VkDescriptorSetLayout, VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT)
+BT_OBJECT_TYPE(VkQueryPool, VK_OBJECT_TYPE_QUERY_POOL)
+BT_OBJECT_TYPE(VkSemaphore, VK_OBJECT_TYPE_SEMAPHORE)
+BT_OBJECT_TYPE(VkFence, VK_OBJECT_TYPE_FENCE)
+BT_OBJECT_TYPE(VkSwapchainKHR, VK_OBJECT_TYPE_SWAPCHAIN_KHR)
+BT_OBJECT_TYPE(VkSurfaceKHR, VK_OBJECT_TYPE_SURFACE_KHR)
+
+#undef BT_OBJECT_TYPE
+
+struct bt_deletion_stats {
+    // During the last frame, i.e. between its submission and the one before.
+    uint32_t queued = 0;
+    uint32_t destroyed = 0;
+    size_t pending = 0;
+    size_t peak_pending = 0;
+    uint64_t total_queued = 0;
+    uint64_t total_destroyed = 0;
+};
+
+// Vulkan objects waiting for the last frame that may use them to complete. Objects are kept as type-tagged handles in
+// queueing order, which is also frame order, so collecting is a walk from the front.
+class bt_deletion_queue {
+  public:
+    bt_deletion_queue() = default;
+    bt_deletion_queue(const bt_deletion_queue&) = delete;
+    bt_deletion_queue& operator=(const bt_deletion_queue&) = delete;
+
+    void push(VkObjectType type, uint64_t handle, uint64_t frame);
+    // Destroys everything queued for frames up to and including `completed`. Surfaces belong to the instance.
+    void collect(VkInstance instance, VkDevice device, const VkAllocationCallbacks* allocator, uint64_t completed);
+    // Closes the per-frame counters; call when a frame is submitted.
+    void end_frame();
+
+    const bt_deletion_stats& stats() const { return stats_; }
+
+  private:
+    struct entry {
+        VkObjectType type;
+        uint64_t handle;
+        uint64_t frame;
+    };
+
+    static void destroy(VkInstance instance, VkDevice device, const VkAllocationCallbacks* allocator, const entry& e);
+
+    std::deque<entry> entries;
+    uint32_t frame_queued = 0;
+    uint32_t frame_destroyed = 0;
+    bt_deletion_stats stats_;
+};
+} // namespace bt
+
+#endif // BT_DELETION_QUEUE_HPP
@@ -2,8 +2,11 @@
 
 #include "bt_logger.hpp"
 
+#include <algorithm>
+#include <cassert>
 #include <cstring>
 #include <iostream>
+#include <limits>
 #include <set>
 #include <unordered_set>
 
@@ -43,16 +46,20 @@ void destroy_debug_utils_messenger_ext(
     }
 }
 
-bt_device::bt_device(bt_window& window)
-    : window { window }
+bt_device::bt_device(bool track_host_allocations)
 {
+    if (track_host_allocations) {
+        host_allocator_ = std::make_unique<bt_host_allocator>();
+        allocator_ = host_allocator_->callbacks();
+    }
+
     load_vulkan_function_pointers(nullptr, nullptr, nullptr);
     create_instance();
     load_vulkan_function_pointers(instance, nullptr, nullptr);
     setup_debug_messenger();
-    create_surface();
     pick_physical_device();
     load_vulkan_function_pointers(instance, physical_device, nullptr);
+    query_descriptor_indexing_support();
     create_logical_device();
     load_vulkan_function_pointers(instance, physical_device, device_);
     create_command_pool();
@@ -60,6 +67,9 @@ bt_device::bt_device(bt_window& window)
 
 bt_device::~bt_device()
 {
+    vkDeviceWaitIdle(device_);
+    deletion_queue.collect(instance, device_, allocator_, std::numeric_limits<uint64_t>::max());
+
     vkDestroyCommandPool(device_, command_pool_, allocator_);
     vkDestroyDevice(device_, allocator_);
 
@@ -67,8 +77,35 @@ bt_device::~bt_device()
         destroy_debug_utils_messenger_ext(instance, debug_messenger, allocator_);
     }
 
-    vkDestroySurfaceKHR(instance, surface_, allocator_);
     vkDestroyInstance(instance, allocator_);
+    gladLoaderUnloadVulkan();
+}
+
+uint64_t bt_device::submit_frame()
+{
+    std::lock_guard lock { deletion_mutex };
+    deletion_queue.end_frame();
+    return ++submitted_frames_;
+}
+
+void bt_device::complete_frames(uint64_t completed)
+{
+    std::lock_guard lock { deletion_mutex };
+    completed_frames_ = std::max(completed_frames_, completed);
+    deletion_queue.collect(instance, device_, allocator_, completed_frames_);
+}
+
+double bt_device::timestamp_ms(uint64_t begin, uint64_t end) const
+{
+    assert(timestamp_valid_bits_ > 0 && "the graphics queue does not write timestamps");
+    uint64_t mask = timestamp_valid_bits_ >= 64 ? ~uint64_t { 0 } : (uint64_t { 1 } << timestamp_valid_bits_) - 1;
+    return static_cast<double>((end - begin) & mask) * properties.limits.timestampPeriod / 1e6;
+}
+
+bt_deletion_stats bt_device::deletion_stats()
+{
+    std::lock_guard lock { deletion_mutex };
+    return deletion_queue.stats();
 }
 
 void bt_device::load_vulkan_function_pointers(VkInstance instance, VkPhysicalDevice physical_device, VkDevice device)
@@ -94,7 +131,7 @@ void bt_device::create_instance()
     app_info.applicationVersion = VK_MAKE_VERSION(0, 1, 0);
     app_info.pEngineName = "Breakable Toy";
     app_info.engineVersion = VK_MAKE_VERSION(0, 1, 0);
-    app_info.apiVersion = VK_API_VERSION_1_0;
+    app_info.apiVersion = VK_API_VERSION_1_2;
 
     VkInstanceCreateInfo create_info = { VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO };
     create_info.pApplicationInfo = &app_info;
@@ -149,6 +186,36 @@ void bt_device::pick_physical_device()
     SPDLOG_DEBUG("physical device: {}", properties.deviceName);
 }
 
+void bt_device::query_descriptor_indexing_support()
+{
+    if (properties.apiVersion < VK_API_VERSION_1_2) {
+        SPDLOG_DEBUG("descriptor indexing unavailable: device only supports Vulkan {}.{}",
+            VK_API_VERSION_MAJOR(properties.apiVersion),
+            VK_API_VERSION_MINOR(properties.apiVersion));
+        return;
+    }
+
+    VkPhysicalDeviceVulkan12Features supported_12 { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+    VkPhysicalDeviceFeatures2 supported { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2 };
+    supported.pNext = &supported_12;
+    vkGetPhysicalDeviceFeatures2(physical_device, &supported);
+
+    bindless_supported_ = supported_12.descriptorIndexing && supported_12.runtimeDescriptorArray
+        && supported_12.descriptorBindingPartiallyBound && supported_12.descriptorBindingVariableDescriptorCount
+        && supported_12.descriptorBindingStorageBufferUpdateAfterBind
+        && supported_12.descriptorBindingSampledImageUpdateAfterBind
+        && supported_12.descriptorBindingUpdateUnusedWhilePending
+        && supported_12.shaderStorageBufferArrayNonUniformIndexing
+        && supported_12.shaderSampledImageArrayNonUniformIndexing;
+
+    descriptor_indexing_properties = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES };
+    VkPhysicalDeviceProperties2 properties_2 { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2 };
+    properties_2.pNext = &descriptor_indexing_properties;
+    vkGetPhysicalDeviceProperties2(physical_device, &properties_2);
+
+    SPDLOG_DEBUG("descriptor indexing (bindless) supported: {}", bindless_supported_);
+}
+
 void bt_device::create_logical_device()
 {
     queue_family_indices indices = find_queue_families(physical_device);
@@ -165,15 +232,98 @@ void bt_device::create_logical_device()
         queue_create_infos.push_back(queue_create_info);
     }
 
-    VkPhysicalDeviceFeatures device_features = {};
-    device_features.samplerAnisotropy = VK_TRUE;
+    VkPhysicalDeviceVulkan12Features device_features_12 = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+    if (bindless_supported_) {
+        device_features_12.descriptorIndexing = VK_TRUE;
+        device_features_12.runtimeDescriptorArray = VK_TRUE;
+        device_features_12.descriptorBindingPartiallyBound = VK_TRUE;
+        device_features_12.descriptorBindingVariableDescriptorCount = VK_TRUE;
+        device_features_12.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+        device_features_12.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+        device_features_12.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+        device_features_12.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
+        device_features_12.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+    }
+
+    VkPhysicalDeviceFeatures supported_features;
+    vkGetPhysicalDeviceFeatures(physical_device, &supported_features);
+    pipeline_statistics_supported_ = supported_features.pipelineStatisticsQuery == VK_TRUE;
+
+    // VkPhysicalDeviceFeatures2 is core from Vulkan 1.1; older devices need VK_KHR_get_physical_device_properties2,
+    // and without either only the Vulkan 1.0 features can be enabled, through pEnabledFeatures.
+    bool features2_core = properties.apiVersion >= VK_API_VERSION_1_1;
+    auto instance_extensions = get_required_instance_extensions();
+    bool features2_supported = features2_core
+        || std::any_of(instance_extensions.begin(), instance_extensions.end(), [](const char* name) {
+               return strcmp(name, VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME) == 0;
+           });
+    properties2_core_ = features2_core;
+    properties2_supported_ = features2_supported;
+    auto get_features2 = [&](VkPhysicalDeviceFeatures2& features) {
+        if (features2_core) {
+            vkGetPhysicalDeviceFeatures2(physical_device, &features);
+        } else {
+            vkGetPhysicalDeviceFeatures2KHR(physical_device, &features);
+        }
+    };
+
+    VkPhysicalDeviceFeatures2 device_features = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2 };
+    device_features.features.samplerAnisotropy = VK_TRUE;
+    device_features.features.pipelineStatisticsQuery = supported_features.pipelineStatisticsQuery;
+    device_features.pNext = properties.apiVersion >= VK_API_VERSION_1_2 ? &device_features_12 : nullptr;
 
     std::vector<const char*> required_device_extensions = get_required_device_extensions(physical_device);
+    auto enabled = [&](const char* extension) {
+        return std::any_of(required_device_extensions.begin(),
+            required_device_extensions.end(),
+            [extension](const char* name) { return strcmp(name, extension) == 0; });
+    };
+    // Budgets are only reported through vkGetPhysicalDeviceMemoryProperties2.
+    memory_budget_supported_ = features2_supported && enabled(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+    // Extended dynamic state lets pipelines leave cull mode, depth state, topology and more to be set per draw.
+    VkPhysicalDeviceExtendedDynamicStateFeaturesEXT extended_dynamic_state {
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT
+    };
+    VkPhysicalDeviceExtendedDynamicState2FeaturesEXT extended_dynamic_state2 {
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_2_FEATURES_EXT
+    };
+    if (features2_supported && enabled(VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME)) {
+        VkPhysicalDeviceFeatures2 supported { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2 };
+        supported.pNext = &extended_dynamic_state;
+        if (enabled(VK_EXT_EXTENDED_DYNAMIC_STATE_2_EXTENSION_NAME)) {
+            extended_dynamic_state.pNext = &extended_dynamic_state2;
+        }
+        get_features2(supported);
+
+        extended_dynamic_state_supported_ = extended_dynamic_state.extendedDynamicState == VK_TRUE;
+        extended_dynamic_state2_supported_
+            = extended_dynamic_state_supported_ && extended_dynamic_state2.extendedDynamicState2 == VK_TRUE;
+        // Only the base features are used.
+        extended_dynamic_state2.extendedDynamicState2LogicOp = VK_FALSE;
+        extended_dynamic_state2.extendedDynamicState2PatchControlPoints = VK_FALSE;
+    }
+    if (extended_dynamic_state2_supported_) {
+        extended_dynamic_state2.pNext = device_features.pNext;
+        device_features.pNext = &extended_dynamic_state2;
+    }
+    if (extended_dynamic_state_supported_) {
+        extended_dynamic_state.pNext = device_features.pNext;
+        device_features.pNext = &extended_dynamic_state;
+    }
+    SPDLOG_DEBUG("extended dynamic state supported: {}, extended dynamic state 2: {}",
+        extended_dynamic_state_supported_,
+        extended_dynamic_state2_supported_);
 
     VkDeviceCreateInfo create_info = { VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO };
     create_info.queueCreateInfoCount = static_cast<uint32_t>(queue_create_infos.size());
     create_info.pQueueCreateInfos = queue_create_infos.data();
-    create_info.pEnabledFeatures = &device_features;
+    if (features2_supported) {
+        create_info.pNext = &device_features;
+        create_info.pEnabledFeatures = nullptr;
+    } else {
+        create_info.pEnabledFeatures = &device_features.features;
+    }
     create_info.enabledExtensionCount = static_cast<uint32_t>(required_device_extensions.size());
     create_info.ppEnabledExtensionNames = required_device_extensions.data();
 
@@ -190,6 +340,12 @@ void bt_device::create_logical_device()
 
     vkGetDeviceQueue(device_, indices.graphics, 0, &graphics_queue_);
     vkGetDeviceQueue(device_, indices.present, 0, &present_queue_);
+
+    uint32_t queue_family_count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, nullptr);
+    std::vector<VkQueueFamilyProperties> queue_families(queue_family_count);
+    vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, queue_families.data());
+    timestamp_valid_bits_ = queue_families[indices.graphics].timestampValidBits;
 }
 
 void bt_device::create_command_pool()
@@ -205,7 +361,22 @@ void bt_device::create_command_pool()
     }
 }
 
-void bt_device::create_surface() { window.create_window_surface(instance, &surface_, allocator_); }
+VkSurfaceKHR bt_device::create_surface(bt_window& window)
+{
+    VkSurfaceKHR surface;
+    window.create_window_surface(instance, &surface, allocator_);
+
+    // The present queue was picked for the GPU's presentation support in general; check it covers this surface.
+    VkBool32 present_support = VK_FALSE;
+    vkGetPhysicalDeviceSurfaceSupportKHR(
+        physical_device, find_queue_families(physical_device).present, surface, &present_support);
+    if (!present_support) {
+        vkDestroySurfaceKHR(instance, surface, allocator_);
+        throw std::runtime_error("failed to create window surface: present queue cannot present to it");
+    }
+
+    return surface;
+}
 
 bool bt_device::is_device_suitable(VkPhysicalDevice device)
 {
@@ -213,16 +384,11 @@ bool bt_device::is_device_suitable(VkPhysicalDevice device)
 
     bool extensions_supported = check_device_extension_support(device);
 
-    bool swapchain_adequate = false;
-    if (extensions_supported) {
-        swapchain_support_details swapchain_support = query_swapchain_support(device);
-        swapchain_adequate = !swapchain_support.formats.empty() && !swapchain_support.present_modes.empty();
-    }
-
     VkPhysicalDeviceFeatures supported_features;
     vkGetPhysicalDeviceFeatures(device, &supported_features);
 
-    return indices.isComplete() && extensions_supported && swapchain_adequate && supported_features.samplerAnisotropy;
+    // Surface formats and present modes are per surface; bt_swapchain picks from whatever a window's surface offers.
+    return indices.isComplete() && extensions_supported && supported_features.samplerAnisotropy;
 }
 
 void bt_device::populate_debug_messenger_create_info(VkDebugUtilsMessengerCreateInfoEXT& create_info)
@@ -319,6 +485,18 @@ std::vector<const char*> bt_device::get_required_device_extensions(VkPhysicalDev
         required_extensions.push_back("VK_KHR_portability_subset");
     }
 
+    // Optional: enabled whenever available.
+    for (const char* optional : { VK_EXT_MEMORY_BUDGET_EXTENSION_NAME,
+             VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME,
+             VK_EXT_EXTENDED_DYNAMIC_STATE_2_EXTENSION_NAME }) {
+        bool available = std::any_of(available_extensions.begin(),
+            available_extensions.end(),
+            [optional](const auto& extension) { return strcmp(extension.extensionName, optional) == 0; });
+        if (available) {
+            required_extensions.push_back(optional);
+        }
+    }
+
     return required_extensions;
 }
 
@@ -381,8 +559,8 @@ queue_family_indices bt_device::find_queue_families(VkPhysicalDevice device)
             indices.graphics_has_value = true;
         }
 
-        VkBool32 present_support = false;
-        vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &present_support);
+        // Asks whether the family can present on this platform at all, which needs no surface.
+        bool present_support = glfwGetPhysicalDevicePresentationSupport(instance, device, i) == GLFW_TRUE;
         if (queue_family.queueCount > 0 && present_support) {
             indices.present = i;
             indices.present_has_value = true;
@@ -398,25 +576,25 @@ queue_family_indices bt_device::find_queue_families(VkPhysicalDevice device)
     return indices;
 }
 
-swapchain_support_details bt_device::query_swapchain_support(VkPhysicalDevice device)
+swapchain_support_details bt_device::query_swapchain_support(VkPhysicalDevice device, VkSurfaceKHR surface)
 {
     swapchain_support_details details;
-    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, surface_, &details.capabilities);
+    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, surface, &details.capabilities);
 
     uint32_t format_count;
-    vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface_, &format_count, nullptr);
+    vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &format_count, nullptr);
 
     if (format_count != 0) {
         details.formats.resize(format_count);
-        vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface_, &format_count, details.formats.data());
+        vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &format_count, details.formats.data());
     }
 
     uint32_t present_mode_count;
-    vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface_, &present_mode_count, nullptr);
+    vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &present_mode_count, nullptr);
 
     if (present_mode_count != 0) {
         details.present_modes.resize(present_mode_count);
-        vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface_, &present_mode_count, details.present_modes.data());
+        vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &present_mode_count, details.present_modes.data());
     }
 
     return details;
@@ -426,12 +604,7 @@ VkFormat bt_device::find_supported_format(
     const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features)
 {
     for (VkFormat format : candidates) {
-        VkFormatProperties props;
-        vkGetPhysicalDeviceFormatProperties(physical_device, format, &props);
-
-        if (tiling == VK_IMAGE_TILING_LINEAR && (props.linearTilingFeatures & features) == features) {
-            return format;
-        } else if (tiling == VK_IMAGE_TILING_OPTIMAL && (props.optimalTilingFeatures & features) == features) {
+        if (has_format_features(format, tiling, features)) {
             return format;
         }
     }
@@ -439,6 +612,42 @@ VkFormat bt_device::find_supported_format(
     throw std::runtime_error("failed to find supported format");
 }
 
+bool bt_device::has_format_features(VkFormat format, VkImageTiling tiling, VkFormatFeatureFlags features)
+{
+    VkFormatProperties props;
+    vkGetPhysicalDeviceFormatProperties(physical_device, format, &props);
+
+    if (tiling == VK_IMAGE_TILING_LINEAR) {
+        return (props.linearTilingFeatures & features) == features;
+    } else if (tiling == VK_IMAGE_TILING_OPTIMAL) {
+        return (props.optimalTilingFeatures & features) == features;
+    }
+    return false;
+}
+
+void bt_device::memory_heaps(std::vector<bt_memory_heap>& heaps)
+{
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budget { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT };
+    VkPhysicalDeviceMemoryProperties2 properties2 { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2 };
+    properties2.pNext = memory_budget_supported_ ? &budget : nullptr;
+    if (properties2_core_) {
+        vkGetPhysicalDeviceMemoryProperties2(physical_device, &properties2);
+    } else if (properties2_supported_) {
+        vkGetPhysicalDeviceMemoryProperties2KHR(physical_device, &properties2);
+    } else {
+        vkGetPhysicalDeviceMemoryProperties(physical_device, &properties2.memoryProperties);
+    }
+
+    const auto& memory = properties2.memoryProperties;
+    heaps.resize(memory.memoryHeapCount);
+    for (uint32_t i = 0; i < memory.memoryHeapCount; i++) {
+        heaps[i].size = memory.memoryHeaps[i].size;
+        heaps[i].device_local = (memory.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+        heaps[i].budget = memory_budget_supported_ ? budget.heapBudget[i] : heaps[i].size;
+        heaps[i].usage = memory_budget_supported_ ? budget.heapUsage[i] : 0;
+    }
+}
+
 uint32_t bt_device::find_memory_type(uint32_t type_filter, VkMemoryPropertyFlags properties)
 {
     VkPhysicalDeviceMemoryProperties mem_properties;
@@ -452,6 +661,18 @@ uint32_t bt_device::find_memory_type(uint32_t type_filter, VkMemoryPropertyFlags
     throw std::runtime_error("failed to find suitable memory type");
 }
 
+bool bt_device::has_memory_type(uint32_t type_filter, VkMemoryPropertyFlags properties)
+{
+    VkPhysicalDeviceMemoryProperties mem_properties;
+    vkGetPhysicalDeviceMemoryProperties(physical_device, &mem_properties);
+    for (uint32_t i = 0; i < mem_properties.memoryTypeCount; i++) {
+        if ((type_filter & (1 << i)) && (mem_properties.memoryTypes[i].propertyFlags & properties) == properties) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void bt_device::create_buffer(VkDeviceSize size,
     VkBufferUsageFlags usage,
     VkMemoryPropertyFlags properties,
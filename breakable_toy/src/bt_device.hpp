@@ -1,10 +1,15 @@
 #ifndef BT_DEVICE_HPP
 #define BT_DEVICE_HPP
 
+#include "bt_deletion_queue.hpp"
+#include "bt_host_allocator.hpp"
 #include "bt_window.hpp"
 
 #include <glad/vulkan.h>
 
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -23,6 +28,15 @@ struct queue_family_indices {
     bool isComplete() { return graphics_has_value && present_has_value; }
 };
 
+struct bt_memory_heap {
+    VkDeviceSize size = 0;
+    // What the process can use of the heap before risking eviction or failed allocations, and how much it uses. Without
+    // VK_EXT_memory_budget the budget is the heap's size and usage is unknown, reported as 0.
+    VkDeviceSize budget = 0;
+    VkDeviceSize usage = 0;
+    bool device_local = false;
+};
+
 class bt_device {
   public:
 #ifdef NDEBUG
@@ -31,7 +45,9 @@ class bt_device {
     const bool enable_validation_layers = true;
 #endif
 
-    bt_device(bt_window& window);
+    // Picks a GPU that can present to windows, without needing one: surfaces are created per window afterwards. With
+    // track_host_allocations every Vulkan object is created with a bt_host_allocator, otherwise with the driver's own.
+    explicit bt_device(bool track_host_allocations = false);
     bt_device(const bt_device&) = delete;
     bt_device(bt_device&&) = delete;
     ~bt_device();
@@ -40,20 +56,31 @@ class bt_device {
     bt_device& operator=(bt_device&&) = delete;
 
     VkAllocationCallbacks* allocator() { return allocator_; }
+    // Null unless host allocations are tracked.
+    bt_host_allocator* host_allocator() { return host_allocator_.get(); }
     VkCommandPool command_pool() { return command_pool_; }
     VkDevice device() { return device_; }
-    VkSurfaceKHR surface() { return surface_; }
     VkQueue graphics_queue() { return graphics_queue_; }
     VkQueue present_queue() { return present_queue_; }
 
-    swapchain_support_details swapchain_support() { return query_swapchain_support(physical_device); }
+    // The surface is destroyed through the deletion queue, so destroy_later() it after the swapchains using it.
+    VkSurfaceKHR create_surface(bt_window& window);
+    swapchain_support_details swapchain_support(VkSurfaceKHR surface)
+    {
+        return query_swapchain_support(physical_device, surface);
+    }
+
+    // Current budget and usage of every memory heap. Cheap enough to call every frame; never waits for the GPU.
+    void memory_heaps(std::vector<bt_memory_heap>& heaps);
 
     uint32_t find_memory_type(uint32_t type_filter, VkMemoryPropertyFlags properties);
+    bool has_memory_type(uint32_t type_filter, VkMemoryPropertyFlags properties);
 
     queue_family_indices find_physical_queue_families() { return find_queue_families(physical_device); }
 
     VkFormat find_supported_format(
         const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
+    bool has_format_features(VkFormat format, VkImageTiling tiling, VkFormatFeatureFlags features);
 
     void create_buffer(VkDeviceSize size,
         VkBufferUsageFlags usage,
@@ -71,14 +98,50 @@ class bt_device {
         VkImage& image,
         VkDeviceMemory& image_memory);
 
+    // Frames are numbered from 1 in submission order and complete in order. The presenting code reports both, so
+    // objects handed to destroy_later() can be destroyed once no frame that might use them is still executing.
+    uint64_t submit_frame();
+    void complete_frames(uint64_t completed);
+    uint64_t submitted_frames() const { return submitted_frames_; }
+    uint64_t completed_frames() const { return completed_frames_; }
+
+    // Destroys handle once the frame being recorded, and all before it, have completed; safe for objects that
+    // recorded or in-flight command buffers still use. Any thread may queue objects.
+    template <typename Handle>
+    void destroy_later(Handle handle)
+    {
+        if (handle != VK_NULL_HANDLE) {
+            std::lock_guard lock { deletion_mutex };
+            deletion_queue.push(bt_object_type<Handle>(), reinterpret_cast<uint64_t>(handle), submitted_frames_ + 1);
+        }
+    }
+    bt_deletion_stats deletion_stats();
+
+    // True when the Vulkan 1.2 descriptor indexing features needed by bt_bindless_table are enabled.
+    bool bindless_supported() const { return bindless_supported_; }
+    // True when pipeline statistics queries are enabled.
+    bool pipeline_statistics_supported() const { return pipeline_statistics_supported_; }
+    // True when VK_EXT_memory_budget is enabled and memory properties can be queried through
+    // vkGetPhysicalDeviceMemoryProperties2, so memory_heaps() reports real budgets and usage.
+    bool memory_budget_supported() const { return memory_budget_supported_; }
+    // True when VK_EXT_extended_dynamic_state, and VK_EXT_extended_dynamic_state2, are enabled with their base
+    // features.
+    bool extended_dynamic_state_supported() const { return extended_dynamic_state_supported_; }
+    bool extended_dynamic_state2_supported() const { return extended_dynamic_state2_supported_; }
+    // Bits of the graphics queue's timestamps that count; 0 when the queue does not write timestamps.
+    uint32_t timestamp_valid_bits() const { return timestamp_valid_bits_; }
+    // Milliseconds between two timestamps written on the graphics queue, which wrap at timestamp_valid_bits().
+    double timestamp_ms(uint64_t begin, uint64_t end) const;
+
     VkPhysicalDeviceProperties properties;
+    VkPhysicalDeviceDescriptorIndexingProperties descriptor_indexing_properties {};
 
   private:
     void load_vulkan_function_pointers(VkInstance instance, VkPhysicalDevice physical_device, VkDevice device);
     void create_instance();
     void setup_debug_messenger();
-    void create_surface();
     void pick_physical_device();
+    void query_descriptor_indexing_support();
     void create_logical_device();
     void create_command_pool();
 
@@ -90,18 +153,33 @@ class bt_device {
     void populate_debug_messenger_create_info(VkDebugUtilsMessengerCreateInfoEXT& create_info);
     void check_instance_extension_support();
     bool check_device_extension_support(VkPhysicalDevice device);
-    swapchain_support_details query_swapchain_support(VkPhysicalDevice device);
+    swapchain_support_details query_swapchain_support(VkPhysicalDevice device, VkSurfaceKHR surface);
 
+    // Instance extensions and presentation support are queried through GLFW.
+    bt_glfw_context glfw;
+    // Outlives the instance, which is destroyed in the destructor's body.
+    std::unique_ptr<bt_host_allocator> host_allocator_;
     VkAllocationCallbacks* allocator_ = nullptr;
     VkInstance instance;
     VkDebugUtilsMessengerEXT debug_messenger;
     VkPhysicalDevice physical_device = VK_NULL_HANDLE;
-    bt_window& window;
     VkCommandPool command_pool_;
     VkDevice device_;
-    VkSurfaceKHR surface_;
     VkQueue graphics_queue_;
     VkQueue present_queue_;
+    bool bindless_supported_ = false;
+    bool pipeline_statistics_supported_ = false;
+    // Whether vkGetPhysicalDevice*2 are core, or else available through VK_KHR_get_physical_device_properties2.
+    bool properties2_core_ = false;
+    bool properties2_supported_ = false;
+    bool memory_budget_supported_ = false;
+    bool extended_dynamic_state_supported_ = false;
+    bool extended_dynamic_state2_supported_ = false;
+    uint32_t timestamp_valid_bits_ = 0;
+    uint64_t submitted_frames_ = 0;
+    uint64_t completed_frames_ = 0;
+    std::mutex deletion_mutex;
+    bt_deletion_queue deletion_queue;
 
     const std::vector<const char*> required_validation_layers = { "VK_LAYER_KHRONOS_validation" };
 };
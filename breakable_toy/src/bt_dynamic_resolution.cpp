@@ -0,0 +1,121 @@
+#include "bt_dynamic_resolution.hpp"
+
+#include "bt_logger.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace bt {
+float bt_next_resolution_scale(float scale, double gpu_ms, const bt_dynamic_resolution_config& config)
+{
+    if (gpu_ms <= 0.0) {
+        return scale;
+    }
+
+    auto ideal = static_cast<float>(scale * std::sqrt(config.target_ms / gpu_ms));
+    ideal = std::clamp(ideal, config.min_scale, config.max_scale);
+    if (std::abs(ideal - scale) < config.dead_band) {
+        return scale;
+    }
+
+    float rate = ideal < scale ? config.decrease_rate : config.increase_rate;
+    return std::clamp(scale + (ideal - scale) * rate, config.min_scale, config.max_scale);
+}
+
+bt_dynamic_resolution::bt_dynamic_resolution(bt_device& device,
+    uint32_t frame_count,
+    const bt_dynamic_resolution_config& config) :
+    device { device },
+    config_ { config },
+    pending(frame_count, false)
+{
+    stats_.scale = config.max_scale;
+
+    if (device.timestamp_valid_bits() == 0) {
+        SPDLOG_WARN("timestamps not supported on the graphics queue, dynamic resolution stays at scale {}",
+            config.max_scale);
+        return;
+    }
+
+    VkQueryPoolCreateInfo query_info { VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO };
+    query_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    query_info.queryCount = 2 * frame_count;
+
+    if (vkCreateQueryPool(device.device(), &query_info, device.allocator(), &timestamp_pool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create dynamic resolution query pool");
+    }
+}
+
+bt_dynamic_resolution::~bt_dynamic_resolution() { device.destroy_later(timestamp_pool); }
+
+void bt_dynamic_resolution::begin_frame(VkCommandBuffer command_buffer, uint32_t frame_index)
+{
+    current = frame_index;
+    if (timestamp_pool == VK_NULL_HANDLE) {
+        return;
+    }
+
+    read_timestamps();
+    vkCmdResetQueryPool(command_buffer, timestamp_pool, current * 2, 2);
+    vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestamp_pool, current * 2);
+}
+
+void bt_dynamic_resolution::end_frame(VkCommandBuffer command_buffer)
+{
+    if (timestamp_pool == VK_NULL_HANDLE) {
+        return;
+    }
+
+    vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestamp_pool, current * 2 + 1);
+    pending[current] = true;
+}
+
+VkExtent2D bt_dynamic_resolution::scaled_extent(VkExtent2D full) const
+{
+    auto scale_axis = [this](uint32_t size) {
+        return std::max(static_cast<uint32_t>(std::lround(static_cast<float>(size) * stats_.scale)), 1u);
+    };
+    return { scale_axis(full.width), scale_axis(full.height) };
+}
+
+void bt_dynamic_resolution::read_timestamps()
+{
+    if (!pending[current]) {
+        return;
+    }
+    pending[current] = false;
+
+    uint64_t timestamps[2];
+    VkResult result = vkGetQueryPoolResults(device.device(),
+        timestamp_pool,
+        current * 2,
+        2,
+        sizeof(timestamps),
+        timestamps,
+        sizeof(uint64_t),
+        VK_QUERY_RESULT_64_BIT);
+    if (result != VK_SUCCESS) {
+        return;
+    }
+
+    stats_.gpu_ms = device.timestamp_ms(timestamps[0], timestamps[1]);
+    stats_.smoothed_ms = stats_.measured_frames == 0
+        ? stats_.gpu_ms
+        : stats_.smoothed_ms + (stats_.gpu_ms - stats_.smoothed_ms) * config_.smoothing;
+    stats_.measured_frames++;
+    if (stats_.gpu_ms > config_.target_ms) {
+        stats_.frames_over_budget++;
+    }
+
+    float previous = stats_.scale;
+    stats_.scale = bt_next_resolution_scale(stats_.scale, stats_.smoothed_ms, config_);
+    if (stats_.scale != previous) {
+        SPDLOG_TRACE("dynamic resolution: scale {:.3f} -> {:.3f} at {:.2f} ms (target {:.2f} ms)",
+            previous,
+            stats_.scale,
+            stats_.smoothed_ms,
+            config_.target_ms);
+    }
+}
+} // namespace bt
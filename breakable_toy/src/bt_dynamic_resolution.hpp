@@ -0,0 +1,80 @@
+#ifndef BT_DYNAMIC_RESOLUTION_HPP
+#define BT_DYNAMIC_RESOLUTION_HPP
+
+#include "bt_device.hpp"
+
+#include <glad/vulkan.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace bt {
+struct bt_dynamic_resolution_config {
+    // GPU time per frame the controller aims for; a little under the 60 Hz frame period so spikes still fit.
+    double target_ms = 15.0;
+    // Per-axis scale of the render target relative to the swapchain.
+    float min_scale = 0.5f;
+    float max_scale = 1.0f;
+    // Fraction of the way to the ideal scale taken per frame. Dropping fast avoids missing deadlines, rising slowly
+    // avoids oscillating around the budget.
+    float decrease_rate = 0.5f;
+    float increase_rate = 0.05f;
+    // Ideal scales closer than this to the current one are ignored, so a steady scene keeps a steady resolution.
+    float dead_band = 0.02f;
+    // Weight of the newest measurement in the smoothed GPU time.
+    float smoothing = 0.3f;
+};
+
+struct bt_dynamic_resolution_stats {
+    float scale = 1.0f;
+    // Last measured and smoothed GPU time of a whole frame.
+    double gpu_ms = 0.0;
+    double smoothed_ms = 0.0;
+    uint32_t measured_frames = 0;
+    uint32_t frames_over_budget = 0;
+};
+
+// The scale to render the next frame at, given the current one and the smoothed GPU time it took. GPU time is
+// modelled as proportional to the pixel count, i.e. to scale squared.
+float bt_next_resolution_scale(float scale, double gpu_ms, const bt_dynamic_resolution_config& config);
+
+// Times each frame on the GPU with a pair of timestamps around its command buffer and adjusts the resolution the
+// scene is rendered at to keep that time within budget. Measurements are read back when a frame index is begun again,
+// so the scale lags the frame it reacts to by the number of frames in flight.
+//
+// Without timestamp support on the graphics queue the scale stays at max_scale.
+class bt_dynamic_resolution {
+  public:
+    bt_dynamic_resolution(bt_device& device,
+        uint32_t frame_count,
+        const bt_dynamic_resolution_config& config = bt_dynamic_resolution_config {});
+    bt_dynamic_resolution(const bt_dynamic_resolution&) = delete;
+    ~bt_dynamic_resolution();
+
+    bt_dynamic_resolution& operator=(const bt_dynamic_resolution&) = delete;
+
+    // Call first in a frame's command buffer, once the previous use of frame_index has completed.
+    void begin_frame(VkCommandBuffer command_buffer, uint32_t frame_index);
+    // Call last in the frame's command buffer.
+    void end_frame(VkCommandBuffer command_buffer);
+
+    float scale() const { return stats_.scale; }
+    // full scaled by scale(), at least one pixel.
+    VkExtent2D scaled_extent(VkExtent2D full) const;
+    const bt_dynamic_resolution_config& config() const { return config_; }
+    const bt_dynamic_resolution_stats& stats() const { return stats_; }
+
+  private:
+    void read_timestamps();
+
+    bt_device& device;
+    bt_dynamic_resolution_config config_;
+    VkQueryPool timestamp_pool = VK_NULL_HANDLE;
+    // Whether the queries of each frame index were written and not yet read.
+    std::vector<bool> pending;
+    uint32_t current = 0;
+    bt_dynamic_resolution_stats stats_;
+};
+} // namespace bt
+
+#endif // BT_DYNAMIC_RESOLUTION_HPP
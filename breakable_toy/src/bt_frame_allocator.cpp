@@ -0,0 +1,226 @@
+#include "bt_frame_allocator.hpp"
+
+#include "bt_logger.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <stdexcept>
+
+namespace bt {
+namespace {
+VkDeviceSize align_up(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+} // namespace
+
+bt_frame_allocator::bt_frame_allocator(bt_device& device,
+    uint32_t frame_count,
+    const bt_frame_allocator_config& config) :
+    device { device },
+    config { config },
+    alignment { std::max(device.properties.limits.minUniformBufferOffsetAlignment,
+        device.properties.limits.minStorageBufferOffsetAlignment) },
+    frames(frame_count)
+{
+    assert(frame_count > 0 && "frame allocator needs at least one frame");
+
+    this->config.uniform_range = std::min<VkDeviceSize>(config.uniform_range,
+        device.properties.limits.maxUniformBufferRange);
+    this->config.storage_range = std::min<VkDeviceSize>(config.storage_range,
+        device.properties.limits.maxStorageBufferRange);
+
+    create_set_layout();
+    create_descriptor_pool(frame_count);
+
+    std::vector<VkDescriptorSetLayout> set_layouts(frame_count, set_layout_);
+    std::vector<VkDescriptorSet> descriptor_sets(frame_count);
+
+    VkDescriptorSetAllocateInfo alloc_info { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+    alloc_info.descriptorPool = descriptor_pool;
+    alloc_info.descriptorSetCount = frame_count;
+    alloc_info.pSetLayouts = set_layouts.data();
+
+    if (vkAllocateDescriptorSets(device.device(), &alloc_info, descriptor_sets.data()) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate frame allocator descriptor sets");
+    }
+
+    for (uint32_t i = 0; i < frame_count; i++) {
+        frames[i].descriptor_set = descriptor_sets[i];
+        create_frame_buffer(frames[i], align_up(this->config.capacity, alignment));
+        write_descriptor_set(frames[i]);
+    }
+
+    SPDLOG_DEBUG("frame allocator: {} frames of {} bytes, alignment {}", frame_count, frames[0].capacity, alignment);
+}
+
+bt_frame_allocator::~bt_frame_allocator()
+{
+    for (auto& f : frames) {
+        destroy_frame_buffer(f);
+    }
+    device.destroy_later(descriptor_pool);
+    device.destroy_later(set_layout_);
+}
+
+void bt_frame_allocator::begin_frame(uint32_t frame_index)
+{
+    assert(frame_index < frames.size() && "frame index out of range");
+
+    current = frame_index;
+    auto& f = frames[current];
+
+    // The frame's fence has signalled, so nothing on the GPU reads this buffer any more and it can be replaced.
+    if (f.stats.bytes_requested > f.capacity) {
+        VkDeviceSize capacity = std::max(f.capacity * 2, std::bit_ceil(f.stats.bytes_requested));
+        SPDLOG_INFO("frame allocator: growing frame {} from {} to {} bytes", frame_index, f.capacity, capacity);
+
+        destroy_frame_buffer(f);
+        create_frame_buffer(f, capacity);
+        write_descriptor_set(f);
+    }
+
+    f.head = 0;
+    f.stats = {};
+    f.stats.capacity = f.capacity;
+}
+
+bt_frame_allocation bt_frame_allocator::allocate(VkDeviceSize size)
+{
+    auto& f = frames[current];
+
+    VkDeviceSize offset = align_up(f.head, alignment);
+    // Tracks what the frame would have needed had nothing failed, which is what the next growth is sized by.
+    f.stats.bytes_requested = align_up(f.stats.bytes_requested, alignment) + size;
+
+    if (offset + size > f.capacity) {
+        if (f.stats.failed_allocations++ == 0) {
+            SPDLOG_WARN("frame allocator: frame {} is out of space ({} bytes), growing next frame",
+                current,
+                f.capacity);
+        }
+        return {};
+    }
+
+    f.head = offset + size;
+    f.stats.allocations++;
+    f.stats.bytes_allocated = f.head;
+
+    bt_frame_allocation allocation;
+    allocation.data = f.mapped + offset;
+    allocation.buffer = f.buffer;
+    allocation.offset = static_cast<uint32_t>(offset);
+    return allocation;
+}
+
+void bt_frame_allocator::bind(VkCommandBuffer command_buffer,
+    VkPipelineLayout pipeline_layout,
+    uint32_t set,
+    uint32_t uniform_offset,
+    uint32_t storage_offset,
+    VkPipelineBindPoint bind_point)
+{
+    std::array<uint32_t, 2> dynamic_offsets { uniform_offset, storage_offset };
+    vkCmdBindDescriptorSets(command_buffer,
+        bind_point,
+        pipeline_layout,
+        set,
+        1,
+        &frames[current].descriptor_set,
+        static_cast<uint32_t>(dynamic_offsets.size()),
+        dynamic_offsets.data());
+}
+
+void bt_frame_allocator::create_set_layout()
+{
+    std::array<VkDescriptorSetLayoutBinding, 2> bindings {};
+    bindings[0].binding = 0;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    bindings[0].descriptorCount = 1;
+    bindings[0].stageFlags = VK_SHADER_STAGE_ALL;
+    bindings[1].binding = 1;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+    bindings[1].descriptorCount = 1;
+    bindings[1].stageFlags = VK_SHADER_STAGE_ALL;
+
+    VkDescriptorSetLayoutCreateInfo layout_info { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+    layout_info.bindingCount = static_cast<uint32_t>(bindings.size());
+    layout_info.pBindings = bindings.data();
+
+    if (vkCreateDescriptorSetLayout(device.device(), &layout_info, device.allocator(), &set_layout_) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create frame allocator descriptor set layout");
+    }
+}
+
+void bt_frame_allocator::create_descriptor_pool(uint32_t frame_count)
+{
+    std::array<VkDescriptorPoolSize, 2> pool_sizes {};
+    pool_sizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    pool_sizes[0].descriptorCount = frame_count;
+    pool_sizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+    pool_sizes[1].descriptorCount = frame_count;
+
+    VkDescriptorPoolCreateInfo pool_info { VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+    pool_info.maxSets = frame_count;
+    pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+    pool_info.pPoolSizes = pool_sizes.data();
+
+    if (vkCreateDescriptorPool(device.device(), &pool_info, device.allocator(), &descriptor_pool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create frame allocator descriptor pool");
+    }
+}
+
+void bt_frame_allocator::create_frame_buffer(frame& f, VkDeviceSize capacity)
+{
+    // Pad past the capacity so that a binding range starting at any allocation offset stays inside the buffer.
+    VkDeviceSize size = capacity + std::max(config.uniform_range, config.storage_range);
+
+    device.create_buffer(size,
+        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        f.buffer,
+        f.memory);
+
+    void* mapped;
+    if (vkMapMemory(device.device(), f.memory, 0, size, 0, &mapped) != VK_SUCCESS) {
+        throw std::runtime_error("failed to map frame allocator buffer");
+    }
+
+    f.mapped = static_cast<std::byte*>(mapped);
+    f.capacity = capacity;
+}
+
+void bt_frame_allocator::destroy_frame_buffer(frame& f)
+{
+    // Frames in flight may still read the buffer; freeing the memory later also unmaps it.
+    device.destroy_later(f.buffer);
+    device.destroy_later(f.memory);
+    f.buffer = VK_NULL_HANDLE;
+    f.memory = VK_NULL_HANDLE;
+    f.mapped = nullptr;
+}
+
+void bt_frame_allocator::write_descriptor_set(frame& f)
+{
+    std::array<VkDescriptorBufferInfo, 2> buffer_infos {};
+    buffer_infos[0].buffer = f.buffer;
+    buffer_infos[0].range = config.uniform_range;
+    buffer_infos[1].buffer = f.buffer;
+    buffer_infos[1].range = config.storage_range;
+
+    std::array<VkWriteDescriptorSet, 2> writes {};
+    for (uint32_t binding = 0; binding < writes.size(); binding++) {
+        writes[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[binding].dstSet = f.descriptor_set;
+        writes[binding].dstBinding = binding;
+        writes[binding].descriptorCount = 1;
+        writes[binding].pBufferInfo = &buffer_infos[binding];
+    }
+    writes[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+
+    vkUpdateDescriptorSets(device.device(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+}
+} // namespace bt
@@ -0,0 +1,103 @@
+#ifndef BT_FRAME_ALLOCATOR_HPP
+#define BT_FRAME_ALLOCATOR_HPP
+
+#include "bt_device.hpp"
+
+#include <glad/vulkan.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace bt {
+struct bt_frame_allocator_config {
+    VkDeviceSize capacity = 1024 * 1024;
+    // Ranges bound through the dynamic uniform (binding 0) and storage (binding 1) buffer descriptors; a single
+    // allocation read through that binding must fit in its range.
+    VkDeviceSize uniform_range = 16 * 1024;
+    VkDeviceSize storage_range = 64 * 1024;
+};
+
+struct bt_frame_allocation {
+    void* data = nullptr;
+    VkBuffer buffer = VK_NULL_HANDLE;
+    uint32_t offset = 0;
+
+    bool is_valid() const { return data != nullptr; }
+};
+
+struct bt_frame_allocator_stats {
+    uint32_t allocations = 0;
+    VkDeviceSize bytes_allocated = 0;
+    VkDeviceSize bytes_requested = 0;
+    VkDeviceSize capacity = 0;
+    uint32_t failed_allocations = 0;
+};
+
+// Streams per-frame shader constants. Each frame in flight owns one persistently mapped host-visible buffer which is
+// bump allocated during the frame and reset wholesale when the frame comes round again (its fence has signalled by
+// then). Shaders reach the data through a per-frame descriptor set with a dynamic uniform buffer and a dynamic storage
+// buffer, so only the dynamic offsets change between draws and no descriptors are written per frame.
+//
+// If a frame runs out of space the allocation fails, the shortfall is recorded and that frame's buffer is grown the
+// next time it is begun.
+class bt_frame_allocator {
+  public:
+    bt_frame_allocator(bt_device& device, uint32_t frame_count, const bt_frame_allocator_config& config = {});
+    bt_frame_allocator(const bt_frame_allocator&) = delete;
+    ~bt_frame_allocator();
+
+    bt_frame_allocator& operator=(const bt_frame_allocator&) = delete;
+
+    void begin_frame(uint32_t frame_index);
+    bt_frame_allocation allocate(VkDeviceSize size);
+
+    template <typename T>
+    bt_frame_allocation push(const T& value)
+    {
+        auto allocation = allocate(sizeof(T));
+        if (allocation.is_valid()) {
+            *static_cast<T*>(allocation.data) = value;
+        }
+        return allocation;
+    }
+
+    void bind(VkCommandBuffer command_buffer,
+        VkPipelineLayout pipeline_layout,
+        uint32_t set,
+        uint32_t uniform_offset,
+        uint32_t storage_offset,
+        VkPipelineBindPoint bind_point = VK_PIPELINE_BIND_POINT_GRAPHICS);
+
+    VkDescriptorSetLayout set_layout() const { return set_layout_; }
+    // Stats of the frame most recently begun, up to the point of the call.
+    const bt_frame_allocator_stats& stats() const { return frames[current].stats; }
+
+  private:
+    struct frame {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDescriptorSet descriptor_set = VK_NULL_HANDLE;
+        std::byte* mapped = nullptr;
+        VkDeviceSize capacity = 0;
+        VkDeviceSize head = 0;
+        bt_frame_allocator_stats stats;
+    };
+
+    void create_set_layout();
+    void create_descriptor_pool(uint32_t frame_count);
+    void create_frame_buffer(frame& f, VkDeviceSize capacity);
+    void destroy_frame_buffer(frame& f);
+    void write_descriptor_set(frame& f);
+
+    bt_device& device;
+    bt_frame_allocator_config config;
+    VkDeviceSize alignment;
+    VkDescriptorSetLayout set_layout_ = VK_NULL_HANDLE;
+    VkDescriptorPool descriptor_pool = VK_NULL_HANDLE;
+    std::vector<frame> frames;
+    uint32_t current = 0;
+};
+} // namespace bt
+
+#endif // BT_FRAME_ALLOCATOR_HPP
@@ -0,0 +1,148 @@
+#include "bt_frame_arena.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace bt {
+namespace {
+std::atomic<uint64_t> next_arena_id = 1;
+
+// Remembers which thread_arenas entry this thread uses in the arena it last touched, so resource() only takes the
+// lock on a thread's first allocation. Keyed by a unique id rather than the address, which may be reused.
+struct thread_cache {
+    uint64_t arena_id = 0;
+    void* arenas = nullptr;
+};
+thread_local thread_cache cache;
+} // namespace
+
+bt_linear_arena::bt_linear_arena(size_t block_size, std::pmr::memory_resource* upstream) :
+    upstream { upstream },
+    block_size { block_size }
+{
+}
+
+bt_linear_arena::~bt_linear_arena() { release_blocks(); }
+
+void bt_linear_arena::reset()
+{
+    if (blocks.size() > 1) {
+        size_t total = reserved;
+        release_blocks();
+        add_block(total);
+    }
+
+    current_block = 0;
+    head = 0;
+    used = 0;
+}
+
+void* bt_linear_arena::do_allocate(size_t bytes, size_t alignment)
+{
+    while (true) {
+        if (current_block < blocks.size()) {
+            auto& b = blocks[current_block];
+            auto address = reinterpret_cast<uintptr_t>(b.data) + head;
+            size_t padding = (alignment - address % alignment) % alignment;
+
+            if (head + padding + bytes <= b.size) {
+                head += padding + bytes;
+                used += padding + bytes;
+                peak = std::max(peak, used);
+                return b.data + head - bytes;
+            }
+
+            if (current_block + 1 < blocks.size()) {
+                current_block++;
+                head = 0;
+                continue;
+            }
+        }
+
+        add_block(bytes + alignment);
+        current_block = blocks.size() - 1;
+        head = 0;
+    }
+}
+
+void bt_linear_arena::add_block(size_t min_size)
+{
+    size_t size = std::max({ min_size, block_size, blocks.empty() ? size_t { 0 } : blocks.back().size * 2 });
+    blocks.push_back({ static_cast<std::byte*>(upstream->allocate(size, alignof(std::max_align_t))), size });
+    reserved += size;
+}
+
+void bt_linear_arena::release_blocks()
+{
+    for (const auto& b : blocks) {
+        upstream->deallocate(b.data, b.size, alignof(std::max_align_t));
+    }
+    blocks.clear();
+    reserved = 0;
+}
+
+bt_frame_arena::bt_frame_arena(uint32_t frame_count, size_t block_size) :
+    frame_count { frame_count },
+    block_size { block_size },
+    id { next_arena_id++ }
+{
+    assert(frame_count > 0 && "frame arena needs at least one frame");
+}
+
+void bt_frame_arena::begin_frame(uint32_t frame_index)
+{
+    assert(frame_index < frame_count && "frame index out of range");
+
+    std::lock_guard lock { threads_mutex };
+    for (auto& t : threads) {
+        t->frames[frame_index]->reset();
+    }
+    current_frame.store(frame_index, std::memory_order_release);
+}
+
+std::pmr::memory_resource* bt_frame_arena::resource()
+{
+    return arenas_for_this_thread().frames[current_frame.load(std::memory_order_acquire)].get();
+}
+
+bt_frame_arena_stats bt_frame_arena::stats() const
+{
+    std::lock_guard lock { threads_mutex };
+
+    bt_frame_arena_stats stats;
+    stats.threads = threads.size();
+    uint32_t frame = current_frame.load(std::memory_order_acquire);
+    for (const auto& t : threads) {
+        stats.bytes_used += t->frames[frame]->bytes_used();
+        for (const auto& arena : t->frames) {
+            stats.peak_bytes += arena->peak_bytes();
+            stats.reserved_bytes += arena->reserved_bytes();
+        }
+    }
+    return stats;
+}
+
+bt_frame_arena::thread_arenas& bt_frame_arena::arenas_for_this_thread()
+{
+    if (cache.arena_id == id) {
+        return *static_cast<thread_arenas*>(cache.arenas);
+    }
+
+    std::lock_guard lock { threads_mutex };
+
+    auto this_thread = std::this_thread::get_id();
+    auto it = std::find_if(threads.begin(), threads.end(), [&](const auto& t) { return t->thread == this_thread; });
+    if (it == threads.end()) {
+        auto arenas = std::make_unique<thread_arenas>();
+        arenas->thread = this_thread;
+        for (uint32_t i = 0; i < frame_count; i++) {
+            arenas->frames.push_back(std::make_unique<bt_linear_arena>(block_size));
+        }
+        threads.push_back(std::move(arenas));
+        it = threads.end() - 1;
+    }
+
+    cache = { id, it->get() };
+    return **it;
+}
+} // namespace bt
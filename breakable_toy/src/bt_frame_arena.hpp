@@ -0,0 +1,107 @@
+#ifndef BT_FRAME_ARENA_HPP
+#define BT_FRAME_ARENA_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace bt {
+// Bump allocator over a list of blocks. Deallocation is a no-op; everything is released at once by reset(), which
+// keeps the memory for the next use. If a reset finds more than one block they are replaced by a single block big
+// enough for all of them, so a steady workload settles into one block and never touches the upstream resource again.
+class bt_linear_arena : public std::pmr::memory_resource {
+  public:
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+    explicit bt_linear_arena(size_t block_size = DEFAULT_BLOCK_SIZE,
+        std::pmr::memory_resource* upstream = std::pmr::get_default_resource());
+    bt_linear_arena(const bt_linear_arena&) = delete;
+    ~bt_linear_arena() override;
+
+    bt_linear_arena& operator=(const bt_linear_arena&) = delete;
+
+    void reset();
+
+    size_t bytes_used() const { return used; }
+    size_t peak_bytes() const { return peak; }
+    size_t reserved_bytes() const { return reserved; }
+    size_t block_count() const { return blocks.size(); }
+
+  private:
+    struct block {
+        std::byte* data;
+        size_t size;
+    };
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void*, size_t, size_t) override { }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    void add_block(size_t min_size);
+    void release_blocks();
+
+    std::pmr::memory_resource* upstream;
+    size_t block_size;
+    std::vector<block> blocks;
+    size_t current_block = 0;
+    size_t head = 0;
+    size_t used = 0;
+    size_t peak = 0;
+    size_t reserved = 0;
+};
+
+struct bt_frame_arena_stats {
+    size_t threads = 0;
+    // Summed over threads for the current frame.
+    size_t bytes_used = 0;
+    // Summed over threads and frames in flight.
+    size_t peak_bytes = 0;
+    size_t reserved_bytes = 0;
+};
+
+// Transient CPU memory for data that only lives until its frame's fence signals. Every thread that allocates gets its
+// own arena per frame in flight, so allocation needs no locking; begin_frame() resets the arenas of the frame index it
+// is given. Containers opt in through the std::pmr memory resource:
+//
+//     std::pmr::vector<VkWriteDescriptorSet> writes { arena.resource() };
+//
+// begin_frame() must not run concurrently with allocations, and memory from a frame must not be used after that frame
+// index is begun again.
+class bt_frame_arena {
+  public:
+    bt_frame_arena(uint32_t frame_count, size_t block_size = bt_linear_arena::DEFAULT_BLOCK_SIZE);
+    bt_frame_arena(const bt_frame_arena&) = delete;
+    ~bt_frame_arena() = default;
+
+    bt_frame_arena& operator=(const bt_frame_arena&) = delete;
+
+    void begin_frame(uint32_t frame_index);
+
+    // The calling thread's arena for the current frame.
+    std::pmr::memory_resource* resource();
+
+    bt_frame_arena_stats stats() const;
+
+  private:
+    struct thread_arenas {
+        std::thread::id thread;
+        std::vector<std::unique_ptr<bt_linear_arena>> frames;
+    };
+
+    thread_arenas& arenas_for_this_thread();
+
+    uint32_t frame_count;
+    size_t block_size;
+    uint64_t id;
+    std::atomic<uint32_t> current_frame = 0;
+    mutable std::mutex threads_mutex;
+    std::vector<std::unique_ptr<thread_arenas>> threads;
+};
+} // namespace bt
+
+#endif // BT_FRAME_ARENA_HPP
@@ -0,0 +1,121 @@
+#include "bt_gpu_telemetry.hpp"
+
+#include "bt_logger.hpp"
+
+#include <stdexcept>
+
+namespace bt {
+namespace {
+// Written in this order, which bt_pipeline_statistics follows.
+constexpr VkQueryPipelineStatisticFlags STATISTICS = VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT
+    | VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT
+    | VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT
+    | VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT
+    | VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT
+    | VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT
+    | VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+} // namespace
+
+bt_gpu_telemetry::bt_gpu_telemetry(bt_device& device, uint32_t frame_count, const bt_gpu_telemetry_config& config) :
+    device { device },
+    config_ { config },
+    pending(frame_count, false)
+{
+    stats_.memory_budget_valid = device.memory_budget_supported();
+    if (!stats_.memory_budget_valid) {
+        SPDLOG_WARN("VK_EXT_memory_budget not supported, video memory usage unknown");
+    }
+
+    if (!device.pipeline_statistics_supported()) {
+        SPDLOG_WARN("pipeline statistics queries not supported, GPU work per frame unknown");
+        return;
+    }
+
+    VkQueryPoolCreateInfo query_info { VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO };
+    query_info.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+    query_info.queryCount = frame_count;
+    query_info.pipelineStatistics = STATISTICS;
+
+    if (vkCreateQueryPool(device.device(), &query_info, device.allocator(), &statistics_pool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create pipeline statistics query pool");
+    }
+}
+
+bt_gpu_telemetry::~bt_gpu_telemetry() { device.destroy_later(statistics_pool); }
+
+void bt_gpu_telemetry::begin_frame(VkCommandBuffer command_buffer, uint32_t frame_index)
+{
+    current = frame_index;
+    sample_memory_budget();
+    if (statistics_pool == VK_NULL_HANDLE) {
+        return;
+    }
+
+    read_statistics();
+    vkCmdResetQueryPool(command_buffer, statistics_pool, current, 1);
+    vkCmdBeginQuery(command_buffer, statistics_pool, current, 0);
+}
+
+void bt_gpu_telemetry::end_frame(VkCommandBuffer command_buffer)
+{
+    if (statistics_pool == VK_NULL_HANDLE) {
+        return;
+    }
+
+    vkCmdEndQuery(command_buffer, statistics_pool, current);
+    pending[current] = true;
+}
+
+void bt_gpu_telemetry::read_statistics()
+{
+    if (!pending[current]) {
+        return;
+    }
+    pending[current] = false;
+
+    bt_pipeline_statistics results;
+    VkResult result = vkGetQueryPoolResults(device.device(),
+        statistics_pool,
+        current,
+        1,
+        sizeof(results),
+        &results,
+        sizeof(results),
+        VK_QUERY_RESULT_64_BIT);
+    stats_.pipeline_statistics_valid = result == VK_SUCCESS;
+    if (stats_.pipeline_statistics_valid) {
+        stats_.pipeline = results;
+    }
+}
+
+void bt_gpu_telemetry::sample_memory_budget()
+{
+    device.memory_heaps(stats_.heaps);
+    if (!stats_.memory_budget_valid) {
+        return;
+    }
+
+    over_budget_warning.resize(stats_.heaps.size(), false);
+    stats_.heaps_over_budget_warning = 0;
+    for (size_t i = 0; i < stats_.heaps.size(); i++) {
+        const auto& heap = stats_.heaps[i];
+        auto warning_level = config_.budget_warning_fraction * static_cast<double>(heap.budget);
+        bool over = static_cast<double>(heap.usage) > warning_level;
+        if (over) {
+            stats_.heaps_over_budget_warning++;
+        }
+        if (over && !over_budget_warning[i]) {
+            stats_.budget_warnings++;
+            SPDLOG_WARN("memory heap {}{}: {} MiB used of a {} MiB budget ({} MiB heap), past the {:.0f}% warning "
+                        "level",
+                i,
+                heap.device_local ? " (device local)" : "",
+                heap.usage / (1024 * 1024),
+                heap.budget / (1024 * 1024),
+                heap.size / (1024 * 1024),
+                100.0f * config_.budget_warning_fraction);
+        }
+        over_budget_warning[i] = over;
+    }
+}
+} // namespace bt
@@ -0,0 +1,90 @@
+#ifndef BT_GPU_TELEMETRY_HPP
+#define BT_GPU_TELEMETRY_HPP
+
+#include "bt_device.hpp"
+
+#include <glad/vulkan.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace bt {
+struct bt_gpu_telemetry_config {
+    // A warning is logged when a heap's usage rises past this fraction of its budget, and again only after it has
+    // dropped back below.
+    float budget_warning_fraction = 0.9f;
+};
+
+// Results of a pipeline statistics query with the statistics bt_gpu_telemetry enables, in the order Vulkan writes
+// them.
+struct bt_pipeline_statistics {
+    uint64_t input_assembly_vertices = 0;
+    uint64_t input_assembly_primitives = 0;
+    uint64_t vertex_shader_invocations = 0;
+    // Primitives that reached clipping, and that came out of it; fewer out than in means primitives were culled or
+    // clipped away entirely.
+    uint64_t clipping_invocations = 0;
+    uint64_t clipping_primitives = 0;
+    uint64_t fragment_shader_invocations = 0;
+    uint64_t compute_shader_invocations = 0;
+};
+
+static_assert(sizeof(bt_pipeline_statistics) == 7 * sizeof(uint64_t),
+    "bt_pipeline_statistics must match the query's results");
+
+struct bt_gpu_telemetry_stats {
+    // Of the previous time the frame index being begun was used, read back once it completed. Only valid when the
+    // device supports pipeline statistics queries.
+    bool pipeline_statistics_valid = false;
+    bt_pipeline_statistics pipeline;
+    // Sampled when the frame was begun; budgets and usage are only known with VK_EXT_memory_budget.
+    bool memory_budget_valid = false;
+    std::vector<bt_memory_heap> heaps;
+    // Heaps currently past the warning fraction of their budget, and warnings logged so far.
+    uint32_t heaps_over_budget_warning = 0;
+    uint32_t budget_warnings = 0;
+};
+
+// Counts what the GPU did in each frame with a pipeline statistics query around its command buffer, and samples the
+// memory heaps' budgets and usage, to tell vertex-bound from fragment-bound frames and how close the process is to
+// running out of video memory. Query results are read back when a frame index is begun again, after its fence, so
+// nothing waits for the GPU.
+//
+// Pipeline statistics queries of the same type cannot nest, so nothing recorded between begin_frame() and end_frame()
+// may begin its own.
+class bt_gpu_telemetry {
+  public:
+    bt_gpu_telemetry(bt_device& device,
+        uint32_t frame_count,
+        const bt_gpu_telemetry_config& config = bt_gpu_telemetry_config {});
+    bt_gpu_telemetry(const bt_gpu_telemetry&) = delete;
+    ~bt_gpu_telemetry();
+
+    bt_gpu_telemetry& operator=(const bt_gpu_telemetry&) = delete;
+
+    // Call first in a frame's command buffer, outside render passes, once the previous use of frame_index has
+    // completed.
+    void begin_frame(VkCommandBuffer command_buffer, uint32_t frame_index);
+    // Call last in the frame's command buffer, outside render passes.
+    void end_frame(VkCommandBuffer command_buffer);
+
+    const bt_gpu_telemetry_config& config() const { return config_; }
+    const bt_gpu_telemetry_stats& stats() const { return stats_; }
+
+  private:
+    void read_statistics();
+    void sample_memory_budget();
+
+    bt_device& device;
+    bt_gpu_telemetry_config config_;
+    VkQueryPool statistics_pool = VK_NULL_HANDLE;
+    // Whether the query of each frame index was written and not yet read.
+    std::vector<bool> pending;
+    // Per heap, whether it was past the warning fraction when last sampled.
+    std::vector<bool> over_budget_warning;
+    uint32_t current = 0;
+    bt_gpu_telemetry_stats stats_;
+};
+} // namespace bt
+
+#endif // BT_GPU_TELEMETRY_HPP
@@ -0,0 +1,267 @@
+#include "bt_host_allocator.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <new>
+#include <vector>
+
+namespace bt {
+namespace {
+constexpr uint8_t NOT_POOLED = UINT8_MAX;
+constexpr size_t LARGEST_POOL_BLOCK = bt_host_allocator::SMALLEST_POOL_BLOCK << (bt_host_allocator::POOL_CLASSES - 1);
+
+// Precedes every allocation handed to the driver, which only gives back the pointer when freeing.
+struct block_header {
+    size_t size;
+    // From the start of the block to the allocation.
+    uint32_t offset;
+    uint32_t alignment;
+    uint8_t scope;
+    uint8_t size_class;
+};
+
+constexpr size_t HEADER_SIZE = sizeof(block_header);
+static_assert(HEADER_SIZE % alignof(block_header) == 0);
+
+// Free pooled blocks of each size class. Blocks come from the heap one at a time, so any thread's lists can take a
+// block another thread allocated.
+struct thread_pool {
+    thread_pool() = default;
+    thread_pool(const thread_pool&) = delete;
+
+    ~thread_pool()
+    {
+        for (auto& blocks : free_blocks) {
+            for (auto* block : blocks) {
+                ::operator delete(block, std::align_val_t { bt_host_allocator::POOL_ALIGNMENT });
+            }
+        }
+    }
+
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    std::array<std::vector<std::byte*>, bt_host_allocator::POOL_CLASSES> free_blocks;
+};
+thread_local thread_pool pool;
+
+block_header* header_of(void* memory)
+{
+    return reinterpret_cast<block_header*>(static_cast<std::byte*>(memory) - HEADER_SIZE);
+}
+
+uint8_t size_class_of(size_t bytes)
+{
+    uint8_t size_class = 0;
+    while ((bt_host_allocator::SMALLEST_POOL_BLOCK << size_class) < bytes) {
+        size_class++;
+    }
+    return size_class;
+}
+} // namespace
+
+bt_host_allocator::bt_host_allocator()
+{
+    callbacks_.pUserData = this;
+    callbacks_.pfnAllocation = allocate;
+    callbacks_.pfnReallocation = reallocate;
+    callbacks_.pfnFree = free;
+    callbacks_.pfnInternalAllocation = internal_allocate;
+    callbacks_.pfnInternalFree = internal_free;
+}
+
+void bt_host_allocator::end_frame()
+{
+    for (auto& counters : scopes) {
+        uint64_t total = counters.allocations.load(std::memory_order_relaxed)
+            + counters.reallocations.load(std::memory_order_relaxed);
+        counters.frame_allocations = total - counters.frame_start;
+        counters.frame_start = total;
+    }
+}
+
+bt_host_allocator_stats bt_host_allocator::stats() const
+{
+    bt_host_allocator_stats result;
+    for (size_t i = 0; i < scopes.size(); i++) {
+        const auto& counters = scopes[i];
+        auto& scope = result.scopes[i];
+        scope.allocations = counters.allocations.load(std::memory_order_relaxed);
+        scope.reallocations = counters.reallocations.load(std::memory_order_relaxed);
+        scope.frees = counters.frees.load(std::memory_order_relaxed);
+        scope.frame_allocations = counters.frame_allocations;
+        scope.bytes = counters.bytes.load(std::memory_order_relaxed);
+        scope.peak_bytes = counters.peak_bytes.load(std::memory_order_relaxed);
+        scope.internal_bytes = counters.internal_bytes.load(std::memory_order_relaxed);
+    }
+    result.pool_hits = pool_hits.load(std::memory_order_relaxed);
+    result.pool_misses = pool_misses.load(std::memory_order_relaxed);
+    return result;
+}
+
+const char* bt_host_allocator::scope_name(VkSystemAllocationScope scope)
+{
+    switch (scope) {
+    case VK_SYSTEM_ALLOCATION_SCOPE_COMMAND:
+        return "command";
+    case VK_SYSTEM_ALLOCATION_SCOPE_OBJECT:
+        return "object";
+    case VK_SYSTEM_ALLOCATION_SCOPE_CACHE:
+        return "cache";
+    case VK_SYSTEM_ALLOCATION_SCOPE_DEVICE:
+        return "device";
+    case VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE:
+        return "instance";
+    default:
+        return "unknown";
+    }
+}
+
+void* VKAPI_PTR bt_host_allocator::allocate(void* user_data,
+    size_t size,
+    size_t alignment,
+    VkSystemAllocationScope scope)
+{
+    auto& self = *static_cast<bt_host_allocator*>(user_data);
+    void* memory = self.allocate_block(size, alignment, scope);
+    if (memory != nullptr) {
+        self.scopes[scope].allocations.fetch_add(1, std::memory_order_relaxed);
+        self.add_bytes(scope, size);
+    }
+    return memory;
+}
+
+void* VKAPI_PTR bt_host_allocator::reallocate(void* user_data,
+    void* original,
+    size_t size,
+    size_t alignment,
+    VkSystemAllocationScope scope)
+{
+    if (original == nullptr) {
+        return allocate(user_data, size, alignment, scope);
+    }
+    if (size == 0) {
+        free(user_data, original);
+        return nullptr;
+    }
+
+    auto& self = *static_cast<bt_host_allocator*>(user_data);
+    // On failure the original must stay valid.
+    void* memory = self.allocate_block(size, alignment, scope);
+    if (memory == nullptr) {
+        return nullptr;
+    }
+
+    const auto* header = header_of(original);
+    size_t original_size = header->size;
+    auto original_scope = header->scope;
+    std::memcpy(memory, original, std::min(original_size, size));
+    self.free_block(original);
+
+    self.scopes[original_scope].bytes.fetch_sub(original_size, std::memory_order_relaxed);
+    self.scopes[scope].reallocations.fetch_add(1, std::memory_order_relaxed);
+    self.add_bytes(scope, size);
+    return memory;
+}
+
+void VKAPI_PTR bt_host_allocator::free(void* user_data, void* memory)
+{
+    if (memory == nullptr) {
+        return;
+    }
+
+    auto& self = *static_cast<bt_host_allocator*>(user_data);
+    const auto* header = header_of(memory);
+    auto& counters = self.scopes[header->scope];
+    counters.frees.fetch_add(1, std::memory_order_relaxed);
+    counters.bytes.fetch_sub(header->size, std::memory_order_relaxed);
+    self.free_block(memory);
+}
+
+void VKAPI_PTR bt_host_allocator::internal_allocate(void* user_data,
+    size_t size,
+    VkInternalAllocationType,
+    VkSystemAllocationScope scope)
+{
+    auto& self = *static_cast<bt_host_allocator*>(user_data);
+    self.scopes[scope].internal_bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+void VKAPI_PTR bt_host_allocator::internal_free(void* user_data,
+    size_t size,
+    VkInternalAllocationType,
+    VkSystemAllocationScope scope)
+{
+    auto& self = *static_cast<bt_host_allocator*>(user_data);
+    self.scopes[scope].internal_bytes.fetch_sub(size, std::memory_order_relaxed);
+}
+
+void* bt_host_allocator::allocate_block(size_t size, size_t alignment, VkSystemAllocationScope scope)
+{
+    assert(scope < scopes.size() && "allocation scope out of range");
+
+    alignment = std::max(alignment, alignof(std::max_align_t));
+    size_t offset = (HEADER_SIZE + alignment - 1) & ~(alignment - 1);
+    size_t total = offset + size;
+
+    std::byte* block = nullptr;
+    uint8_t size_class = NOT_POOLED;
+    if (scope == VK_SYSTEM_ALLOCATION_SCOPE_COMMAND && alignment <= POOL_ALIGNMENT && total <= LARGEST_POOL_BLOCK) {
+        size_class = size_class_of(total);
+        auto& blocks = pool.free_blocks[size_class];
+        if (!blocks.empty()) {
+            block = blocks.back();
+            blocks.pop_back();
+            pool_hits.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            block = static_cast<std::byte*>(::operator new(
+                SMALLEST_POOL_BLOCK << size_class, std::align_val_t { POOL_ALIGNMENT }, std::nothrow));
+            pool_misses.fetch_add(1, std::memory_order_relaxed);
+        }
+    } else {
+        block = static_cast<std::byte*>(::operator new(total, std::align_val_t { alignment }, std::nothrow));
+        if (scope == VK_SYSTEM_ALLOCATION_SCOPE_COMMAND) {
+            pool_misses.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    if (block == nullptr) {
+        return nullptr;
+    }
+
+    auto* memory = block + offset;
+    auto* header = header_of(memory);
+    header->size = size;
+    header->offset = static_cast<uint32_t>(offset);
+    header->alignment = static_cast<uint32_t>(alignment);
+    header->scope = static_cast<uint8_t>(scope);
+    header->size_class = size_class;
+    return memory;
+}
+
+void bt_host_allocator::free_block(void* memory)
+{
+    const auto* header = header_of(memory);
+    auto* block = static_cast<std::byte*>(memory) - header->offset;
+
+    if (header->size_class == NOT_POOLED) {
+        ::operator delete(block, std::align_val_t { header->alignment });
+        return;
+    }
+
+    auto& blocks = pool.free_blocks[header->size_class];
+    if (blocks.size() < MAX_CACHED_BYTES / (SMALLEST_POOL_BLOCK << header->size_class)) {
+        blocks.push_back(block);
+    } else {
+        ::operator delete(block, std::align_val_t { POOL_ALIGNMENT });
+    }
+}
+
+void bt_host_allocator::add_bytes(VkSystemAllocationScope scope, size_t bytes)
+{
+    auto& counters = scopes[scope];
+    size_t now = counters.bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    size_t peak = counters.peak_bytes.load(std::memory_order_relaxed);
+    while (now > peak && !counters.peak_bytes.compare_exchange_weak(peak, now, std::memory_order_relaxed)) { }
+}
+} // namespace bt
@@ -0,0 +1,106 @@
+#ifndef BT_HOST_ALLOCATOR_HPP
+#define BT_HOST_ALLOCATOR_HPP
+
+#include <glad/vulkan.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace bt {
+struct bt_host_scope_stats {
+    uint64_t allocations = 0;
+    uint64_t reallocations = 0;
+    uint64_t frees = 0;
+    // Allocations and reallocations between the last two calls to end_frame().
+    uint64_t frame_allocations = 0;
+    // Live bytes requested by the driver, and the most there have been at once.
+    size_t bytes = 0;
+    size_t peak_bytes = 0;
+    // Memory the driver allocated itself, such as executable code, and reported through notifications.
+    size_t internal_bytes = 0;
+};
+
+struct bt_host_allocator_stats {
+    // Indexed by VkSystemAllocationScope.
+    std::array<bt_host_scope_stats, VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE + 1> scopes;
+    // Command-scope allocations served from a thread's pool, and those that had to go to the heap.
+    uint64_t pool_hits = 0;
+    uint64_t pool_misses = 0;
+};
+
+// VkAllocationCallbacks that track the driver's host allocations by scope, to find allocation churn on the hot path.
+// Command-scope allocations, which drivers make while recording command buffers, are served from per-thread free lists
+// of a few block sizes so recording does not go through the global heap; everything else does.
+//
+// The driver may call back from any thread. Pooled blocks freed on another thread than the one that allocated them
+// join that thread's free lists.
+class bt_host_allocator {
+  public:
+    static constexpr size_t POOL_ALIGNMENT = 64;
+    static constexpr size_t SMALLEST_POOL_BLOCK = 64;
+    static constexpr size_t POOL_CLASSES = 7;
+    // Bytes of free blocks each thread keeps per size class; blocks freed beyond it go back to the heap.
+    static constexpr size_t MAX_CACHED_BYTES = 1024 * 1024;
+
+    bt_host_allocator();
+    bt_host_allocator(const bt_host_allocator&) = delete;
+    ~bt_host_allocator() = default;
+
+    bt_host_allocator& operator=(const bt_host_allocator&) = delete;
+
+    // Passed as pAllocator to every Vulkan call; must outlive every object created with it.
+    VkAllocationCallbacks* callbacks() { return &callbacks_; }
+
+    // Closes a frame's allocation counts. Call from one thread, the same one that reads stats().
+    void end_frame();
+
+    bt_host_allocator_stats stats() const;
+
+    static const char* scope_name(VkSystemAllocationScope scope);
+
+  private:
+    struct scope_counters {
+        std::atomic<uint64_t> allocations = 0;
+        std::atomic<uint64_t> reallocations = 0;
+        std::atomic<uint64_t> frees = 0;
+        std::atomic<size_t> bytes = 0;
+        std::atomic<size_t> peak_bytes = 0;
+        std::atomic<size_t> internal_bytes = 0;
+        // Owned by the thread calling end_frame().
+        uint64_t frame_start = 0;
+        uint64_t frame_allocations = 0;
+    };
+
+    static void* VKAPI_PTR allocate(void* user_data,
+        size_t size,
+        size_t alignment,
+        VkSystemAllocationScope scope);
+    static void* VKAPI_PTR reallocate(void* user_data,
+        void* original,
+        size_t size,
+        size_t alignment,
+        VkSystemAllocationScope scope);
+    static void VKAPI_PTR free(void* user_data, void* memory);
+    static void VKAPI_PTR internal_allocate(void* user_data,
+        size_t size,
+        VkInternalAllocationType type,
+        VkSystemAllocationScope scope);
+    static void VKAPI_PTR internal_free(void* user_data,
+        size_t size,
+        VkInternalAllocationType type,
+        VkSystemAllocationScope scope);
+
+    void* allocate_block(size_t size, size_t alignment, VkSystemAllocationScope scope);
+    void free_block(void* memory);
+    void add_bytes(VkSystemAllocationScope scope, size_t bytes);
+
+    VkAllocationCallbacks callbacks_ {};
+    std::array<scope_counters, VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE + 1> scopes;
+    std::atomic<uint64_t> pool_hits = 0;
+    std::atomic<uint64_t> pool_misses = 0;
+};
+} // namespace bt
+
+#endif // BT_HOST_ALLOCATOR_HPP
@@ -0,0 +1,63 @@
+#ifndef BT_LOD_HPP
+#define BT_LOD_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace bt {
+struct bt_lod {
+    uint32_t first_index = 0;
+    uint32_t index_count = 0;
+    // Approximate object space distance between this level and the base mesh.
+    float error = 0.0f;
+};
+
+struct bt_lod_settings {
+    bool enabled = true;
+    // Largest acceptable projected error, in pixels.
+    float max_pixel_error = 1.0f;
+    // A coarser level is only chosen once its error drops this fraction below the threshold, so objects hovering
+    // around a switch distance don't flicker between levels.
+    float hysteresis = 0.25f;
+};
+
+class bt_lod_selector {
+  public:
+    // `pixels_per_unit` converts object space error at `distance` into pixels; for a perspective projection it is
+    // viewport_height / (2 * tan(fov_y / 2)) and the error shrinks with distance. Pass a distance of 1 for
+    // orthographic views.
+    static uint32_t select(const std::vector<bt_lod>& lods,
+        uint32_t current,
+        float distance,
+        float pixels_per_unit,
+        const bt_lod_settings& settings)
+    {
+        if (!settings.enabled || lods.size() <= 1) {
+            return 0;
+        }
+
+        float scale = pixels_per_unit / std::max(distance, 1e-4f);
+        auto coarsest_within = [&](float threshold) {
+            uint32_t level = 0;
+            for (uint32_t i = 1; i < lods.size(); i++) {
+                if (lods[i].error * scale <= threshold) {
+                    level = i;
+                }
+            }
+            return level;
+        };
+
+        current = std::min(current, static_cast<uint32_t>(lods.size() - 1));
+        if (lods[current].error * scale > settings.max_pixel_error) {
+            return coarsest_within(settings.max_pixel_error);
+        }
+
+        return std::max(current, coarsest_within(settings.max_pixel_error * (1.0f - settings.hysteresis)));
+    }
+
+    bt_lod_selector() = delete;
+};
+} // namespace bt
+
+#endif // BT_LOD_HPP
@@ -8,9 +8,18 @@ bt_logger::bt_logger(spdlog::level::level_enum max_level) :
     logger_name("BT")
 {
     init_logger();
+
+#ifdef BT_ASYNC_LOGGING
+    async_logger = std::make_unique<bt_async_logger>(spdlog::default_logger());
+#endif
 }
 
-bt_logger::~bt_logger() { spdlog::get(logger_name)->flush(); }
+bt_logger::~bt_logger()
+{
+    // Drains the queued records before the final flush.
+    async_logger.reset();
+    spdlog::get(logger_name)->flush();
+}
 
 void bt_logger::init_logger()
 {
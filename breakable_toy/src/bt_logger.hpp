@@ -1,10 +1,63 @@
 #ifndef BT_LOGGER_HPP
 #define BT_LOGGER_HPP
 
+// Set from the BT_LOG_LEVEL CMake cache variable; levels below it compile to nothing.
+#ifndef SPDLOG_ACTIVE_LEVEL
 #define SPDLOG_ACTIVE_LEVEL SPDLOG_LEVEL_TRACE
+#endif
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/spdlog.h>
 
+#include "bt_async_log.hpp"
+
+#include <memory>
+
+// With BT_ASYNC_LOGGING the SPDLOG_* macros enqueue binary records instead of formatting and writing on the caller.
+#ifdef BT_ASYNC_LOGGING
+#undef SPDLOG_TRACE
+#undef SPDLOG_DEBUG
+#undef SPDLOG_INFO
+#undef SPDLOG_WARN
+#undef SPDLOG_ERROR
+#undef SPDLOG_CRITICAL
+
+#if SPDLOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_TRACE
+#define SPDLOG_TRACE(...) BT_LOG_ASYNC(spdlog::level::trace, __VA_ARGS__)
+#else
+#define SPDLOG_TRACE(...) (void)0
+#endif
+
+#if SPDLOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_DEBUG
+#define SPDLOG_DEBUG(...) BT_LOG_ASYNC(spdlog::level::debug, __VA_ARGS__)
+#else
+#define SPDLOG_DEBUG(...) (void)0
+#endif
+
+#if SPDLOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_INFO
+#define SPDLOG_INFO(...) BT_LOG_ASYNC(spdlog::level::info, __VA_ARGS__)
+#else
+#define SPDLOG_INFO(...) (void)0
+#endif
+
+#if SPDLOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_WARN
+#define SPDLOG_WARN(...) BT_LOG_ASYNC(spdlog::level::warn, __VA_ARGS__)
+#else
+#define SPDLOG_WARN(...) (void)0
+#endif
+
+#if SPDLOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_ERROR
+#define SPDLOG_ERROR(...) BT_LOG_ASYNC(spdlog::level::err, __VA_ARGS__)
+#else
+#define SPDLOG_ERROR(...) (void)0
+#endif
+
+#if SPDLOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_CRITICAL
+#define SPDLOG_CRITICAL(...) BT_LOG_ASYNC(spdlog::level::critical, __VA_ARGS__)
+#else
+#define SPDLOG_CRITICAL(...) (void)0
+#endif
+#endif // BT_ASYNC_LOGGING
+
 namespace bt {
 class bt_logger {
   public:
@@ -21,6 +74,7 @@ class bt_logger {
 
     spdlog::level::level_enum max_level;
     const char* logger_name;
+    std::unique_ptr<bt_async_logger> async_logger;
 };
 } // namespace bt
 
@@ -0,0 +1,515 @@
+#include "bt_mip_generator.hpp"
+
+#include "bt_logger.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <stdexcept>
+
+namespace bt {
+namespace {
+constexpr uint32_t TILE_SIZE = 64;
+constexpr uint32_t LEVEL_BINDINGS = bt_mip_generator::MAX_COMPUTE_MIPS - 1;
+constexpr uint32_t QUERIES_PER_FRAME = 2 * bt_mip_generator::MAX_DISPATCHES_PER_FRAME;
+
+constexpr VkPipelineStageFlags SAMPLED_STAGES =
+    VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+struct push_constants {
+    uint32_t width;
+    uint32_t height;
+    uint32_t mip_count;
+    uint32_t srgb;
+    uint32_t group_count;
+};
+
+VkImageMemoryBarrier level_barrier(VkImage image,
+    uint32_t first_level,
+    uint32_t level_count,
+    VkImageLayout old_layout,
+    VkImageLayout new_layout,
+    VkAccessFlags src_access,
+    VkAccessFlags dst_access)
+{
+    VkImageMemoryBarrier barrier { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+    barrier.srcAccessMask = src_access;
+    barrier.dstAccessMask = dst_access;
+    barrier.oldLayout = old_layout;
+    barrier.newLayout = new_layout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, first_level, level_count, 0, 1 };
+    return barrier;
+}
+
+void pipeline_barrier(VkCommandBuffer command_buffer,
+    VkPipelineStageFlags src_stages,
+    VkPipelineStageFlags dst_stages,
+    const VkImageMemoryBarrier* barriers,
+    uint32_t barrier_count)
+{
+    vkCmdPipelineBarrier(command_buffer, src_stages, dst_stages, 0, 0, nullptr, 0, nullptr, barrier_count, barriers);
+}
+
+bool is_rgba8(VkFormat format)
+{
+    return format == VK_FORMAT_R8G8B8A8_UNORM || format == VK_FORMAT_R8G8B8A8_SRGB;
+}
+} // namespace
+
+bt_mip_generator::bt_mip_generator(bt_device& device, bt_resources& resources, uint32_t frame_count) :
+    device { device },
+    resources { resources },
+    frames(frame_count)
+{
+    assert(frame_count > 0 && "mip generator needs at least one frame");
+
+    create_set_layout();
+    create_pipeline();
+    create_counter_buffer(frame_count);
+
+    std::array<VkDescriptorPoolSize, 2> pool_sizes {};
+    pool_sizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    pool_sizes[0].descriptorCount = MAX_DISPATCHES_PER_FRAME * MAX_COMPUTE_MIPS;
+    pool_sizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    pool_sizes[1].descriptorCount = MAX_DISPATCHES_PER_FRAME;
+
+    VkDescriptorPoolCreateInfo pool_info { VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+    pool_info.maxSets = MAX_DISPATCHES_PER_FRAME;
+    pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+    pool_info.pPoolSizes = pool_sizes.data();
+
+    for (auto& f : frames) {
+        if (vkCreateDescriptorPool(device.device(), &pool_info, device.allocator(), &f.descriptor_pool)
+            != VK_SUCCESS) {
+            throw std::runtime_error("failed to create mip generator descriptor pool");
+        }
+    }
+
+    if (device.timestamp_valid_bits() > 0) {
+        VkQueryPoolCreateInfo query_info { VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO };
+        query_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        query_info.queryCount = QUERIES_PER_FRAME * frame_count;
+
+        if (vkCreateQueryPool(device.device(), &query_info, device.allocator(), &timestamp_pool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create mip generator query pool");
+        }
+    }
+}
+
+bt_mip_generator::~bt_mip_generator()
+{
+    for (auto& f : frames) {
+        for (auto view : f.views) {
+            vkDestroyImageView(device.device(), view, device.allocator());
+        }
+        vkDestroyDescriptorPool(device.device(), f.descriptor_pool, device.allocator());
+    }
+    if (timestamp_pool != VK_NULL_HANDLE) {
+        vkDestroyQueryPool(device.device(), timestamp_pool, device.allocator());
+    }
+    vkDestroyBuffer(device.device(), counter_buffer, device.allocator());
+    vkFreeMemory(device.device(), counter_memory, device.allocator());
+    resources.destroy(pipeline);
+    vkDestroyPipelineLayout(device.device(), pipeline_layout, device.allocator());
+    vkDestroyDescriptorSetLayout(device.device(), set_layout, device.allocator());
+}
+
+VkImageUsageFlags bt_mip_generator::image_usage(VkFormat format) const
+{
+    VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    if (is_rgba8(format)) {
+        usage |= VK_IMAGE_USAGE_STORAGE_BIT;
+    }
+    return usage;
+}
+
+VkImageCreateFlags bt_mip_generator::image_flags(VkFormat format) const
+{
+    // sRGB formats cannot be storage images; the shader writes through a UNORM view and encodes sRGB itself.
+    if (format == VK_FORMAT_R8G8B8A8_SRGB) {
+        return VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT | VK_IMAGE_CREATE_EXTENDED_USAGE_BIT;
+    }
+    return 0;
+}
+
+void bt_mip_generator::begin_frame(uint32_t frame_index)
+{
+    assert(frame_index < frames.size() && "frame index out of range");
+
+    current = frame_index;
+    auto& f = frames[current];
+
+    // The frame's fence has signalled, so the dispatches recorded with these are done.
+    vkResetDescriptorPool(device.device(), f.descriptor_pool, 0);
+    for (auto view : f.views) {
+        vkDestroyImageView(device.device(), view, device.allocator());
+    }
+    f.views.clear();
+    f.dispatches = 0;
+
+    stats_ = {};
+    read_timestamps(f);
+}
+
+void bt_mip_generator::generate(VkCommandBuffer command_buffer,
+    VkImage image,
+    VkFormat format,
+    uint32_t width,
+    uint32_t height,
+    uint32_t mip_count)
+{
+    if (mip_count <= 1) {
+        auto barrier = level_barrier(image,
+            0,
+            1,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_ACCESS_SHADER_READ_BIT);
+        pipeline_barrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, SAMPLED_STAGES, &barrier, 1);
+        return;
+    }
+
+    auto& f = frames[current];
+    bool timed = timestamp_pool != VK_NULL_HANDLE && f.timed_images < MAX_DISPATCHES_PER_FRAME;
+    uint32_t first_query = current * QUERIES_PER_FRAME + 2 * f.timed_images;
+    if (timed) {
+        if (f.timed_images == 0) {
+            vkCmdResetQueryPool(command_buffer, timestamp_pool, current * QUERIES_PER_FRAME, QUERIES_PER_FRAME);
+        }
+        vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestamp_pool, first_query);
+        f.timed_images++;
+    }
+
+    if (can_use_compute(format, width, height, mip_count)) {
+        generate_compute(command_buffer, image, format, width, height, mip_count);
+    } else {
+        // Throws if the format cannot be blitted with linear filtering either.
+        device.find_supported_format({ format },
+            VK_IMAGE_TILING_OPTIMAL,
+            VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT
+                | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT);
+        generate_blit(command_buffer, image, width, height, mip_count);
+    }
+
+    if (timed) {
+        vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestamp_pool, first_query + 1);
+    }
+}
+
+bool bt_mip_generator::can_use_compute(VkFormat format, uint32_t width, uint32_t height, uint32_t mip_count) const
+{
+    // The last workgroup reduces level 6 on its own, so it must fit in one 64x64 tile.
+    return is_rgba8(format) && mip_count <= MAX_COMPUTE_MIPS
+        && std::max(width, height) <= TILE_SIZE << (MAX_COMPUTE_MIPS - 7)
+        && frames[current].dispatches < MAX_DISPATCHES_PER_FRAME;
+}
+
+void bt_mip_generator::generate_compute(VkCommandBuffer command_buffer,
+    VkImage image,
+    VkFormat format,
+    uint32_t width,
+    uint32_t height,
+    uint32_t mip_count)
+{
+    auto& f = frames[current];
+    if (!counters_cleared) {
+        clear_counters(command_buffer);
+    }
+    uint32_t slot = current * MAX_DISPATCHES_PER_FRAME + f.dispatches++;
+
+    std::array<VkImageMemoryBarrier, 2> to_general {
+        level_barrier(image,
+            0,
+            1,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_IMAGE_LAYOUT_GENERAL,
+            VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_ACCESS_SHADER_READ_BIT),
+        level_barrier(image,
+            1,
+            mip_count - 1,
+            VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_IMAGE_LAYOUT_GENERAL,
+            0,
+            VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT),
+    };
+    pipeline_barrier(command_buffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        to_general.data(),
+        static_cast<uint32_t>(to_general.size()));
+
+    VkDescriptorSetAllocateInfo alloc_info { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+    alloc_info.descriptorPool = f.descriptor_pool;
+    alloc_info.descriptorSetCount = 1;
+    alloc_info.pSetLayouts = &set_layout;
+
+    VkDescriptorSet descriptor_set;
+    if (vkAllocateDescriptorSets(device.device(), &alloc_info, &descriptor_set) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate mip generator descriptor set");
+    }
+
+    // Every level binding is statically used, so levels past the end of the chain repeat the last view. The shader
+    // never writes them.
+    std::array<VkDescriptorImageInfo, MAX_COMPUTE_MIPS> image_infos {};
+    for (uint32_t level = 0; level < MAX_COMPUTE_MIPS; level++) {
+        if (level < mip_count) {
+            f.views.push_back(create_view(image, VK_FORMAT_R8G8B8A8_UNORM, level));
+        }
+        image_infos[level].imageView = f.views.back();
+        image_infos[level].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+    }
+
+    VkDescriptorBufferInfo buffer_info { counter_buffer, slot * counter_stride, sizeof(uint32_t) };
+
+    std::array<VkWriteDescriptorSet, 3> writes {};
+    for (auto& write : writes) {
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = descriptor_set;
+    }
+    writes[0].dstBinding = 0;
+    writes[0].descriptorCount = 1;
+    writes[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    writes[0].pImageInfo = &image_infos[0];
+    writes[1].dstBinding = 1;
+    writes[1].descriptorCount = LEVEL_BINDINGS;
+    writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    writes[1].pImageInfo = &image_infos[1];
+    writes[2].dstBinding = 2;
+    writes[2].descriptorCount = 1;
+    writes[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    writes[2].pBufferInfo = &buffer_info;
+    vkUpdateDescriptorSets(device.device(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+    uint32_t groups_x = (width + TILE_SIZE - 1) / TILE_SIZE;
+    uint32_t groups_y = (height + TILE_SIZE - 1) / TILE_SIZE;
+    push_constants push { width,
+        height,
+        mip_count,
+        format == VK_FORMAT_R8G8B8A8_SRGB ? 1u : 0u,
+        groups_x * groups_y };
+
+    vkCmdBindDescriptorSets(command_buffer,
+        VK_PIPELINE_BIND_POINT_COMPUTE,
+        pipeline_layout,
+        0,
+        1,
+        &descriptor_set,
+        0,
+        nullptr);
+    vkCmdPushConstants(command_buffer, pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push), &push);
+    resources.pipeline(pipeline).dispatch(command_buffer, groups_x, groups_y);
+
+    auto to_sampled = level_barrier(image,
+        0,
+        mip_count,
+        VK_IMAGE_LAYOUT_GENERAL,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        VK_ACCESS_SHADER_WRITE_BIT,
+        VK_ACCESS_SHADER_READ_BIT);
+    pipeline_barrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, SAMPLED_STAGES, &to_sampled, 1);
+
+    stats_.compute_dispatches++;
+}
+
+void bt_mip_generator::generate_blit(VkCommandBuffer command_buffer,
+    VkImage image,
+    uint32_t width,
+    uint32_t height,
+    uint32_t mip_count)
+{
+    std::array<VkImageMemoryBarrier, 2> prepare {
+        level_barrier(image,
+            0,
+            1,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_ACCESS_TRANSFER_READ_BIT),
+        level_barrier(image,
+            1,
+            mip_count - 1,
+            VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            0,
+            VK_ACCESS_TRANSFER_WRITE_BIT),
+    };
+    pipeline_barrier(command_buffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        prepare.data(),
+        static_cast<uint32_t>(prepare.size()));
+
+    for (uint32_t level = 1; level < mip_count; level++) {
+        VkImageBlit blit {};
+        blit.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, 1 };
+        blit.srcOffsets[1] = { static_cast<int32_t>(std::max(width >> (level - 1), 1u)),
+            static_cast<int32_t>(std::max(height >> (level - 1), 1u)),
+            1 };
+        blit.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1 };
+        blit.dstOffsets[1] = { static_cast<int32_t>(std::max(width >> level, 1u)),
+            static_cast<int32_t>(std::max(height >> level, 1u)),
+            1 };
+        vkCmdBlitImage(command_buffer,
+            image,
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            image,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            1,
+            &blit,
+            VK_FILTER_LINEAR);
+
+        auto to_source = level_barrier(image,
+            level,
+            1,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_ACCESS_TRANSFER_READ_BIT);
+        pipeline_barrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, &to_source, 1);
+    }
+
+    auto to_sampled = level_barrier(image,
+        0,
+        mip_count,
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        VK_ACCESS_TRANSFER_READ_BIT,
+        VK_ACCESS_SHADER_READ_BIT);
+    pipeline_barrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, SAMPLED_STAGES, &to_sampled, 1);
+
+    stats_.blit_chains++;
+}
+
+void bt_mip_generator::create_set_layout()
+{
+    std::array<VkDescriptorSetLayoutBinding, 3> bindings {};
+    bindings[0].binding = 0;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    bindings[0].descriptorCount = 1;
+    bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    bindings[1].binding = 1;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    bindings[1].descriptorCount = LEVEL_BINDINGS;
+    bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    bindings[2].binding = 2;
+    bindings[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[2].descriptorCount = 1;
+    bindings[2].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    VkDescriptorSetLayoutCreateInfo layout_info { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+    layout_info.bindingCount = static_cast<uint32_t>(bindings.size());
+    layout_info.pBindings = bindings.data();
+
+    if (vkCreateDescriptorSetLayout(device.device(), &layout_info, device.allocator(), &set_layout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create mip generator descriptor set layout");
+    }
+}
+
+void bt_mip_generator::create_pipeline()
+{
+    VkPushConstantRange push_range { VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push_constants) };
+
+    VkPipelineLayoutCreateInfo layout_info { VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+    layout_info.setLayoutCount = 1;
+    layout_info.pSetLayouts = &set_layout;
+    layout_info.pushConstantRangeCount = 1;
+    layout_info.pPushConstantRanges = &push_range;
+
+    if (vkCreatePipelineLayout(device.device(), &layout_info, device.allocator(), &pipeline_layout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create mip generator pipeline layout");
+    }
+
+    pipeline = resources.create_compute_pipeline("shaders/mip_downsample.comp.spv", pipeline_layout);
+}
+
+void bt_mip_generator::create_counter_buffer(uint32_t frame_count)
+{
+    // One counter per dispatch a frame can record, each at its own descriptor offset. Only the GPU touches them, so
+    // they live in device-local memory; clear_counters() zeroes them once and the shader returns a counter to zero
+    // when its dispatch finishes.
+    counter_stride = std::max<VkDeviceSize>(device.properties.limits.minStorageBufferOffsetAlignment, sizeof(uint32_t));
+    VkDeviceSize size = counter_stride * MAX_DISPATCHES_PER_FRAME * frame_count;
+
+    device.create_buffer(size,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        counter_buffer,
+        counter_memory);
+}
+
+void bt_mip_generator::clear_counters(VkCommandBuffer command_buffer)
+{
+    vkCmdFillBuffer(command_buffer, counter_buffer, 0, VK_WHOLE_SIZE, 0);
+
+    VkBufferMemoryBarrier barrier { VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER };
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = counter_buffer;
+    barrier.size = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(command_buffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        0,
+        nullptr,
+        1,
+        &barrier,
+        0,
+        nullptr);
+    counters_cleared = true;
+}
+
+void bt_mip_generator::read_timestamps(frame& f)
+{
+    if (f.timed_images == 0) {
+        return;
+    }
+
+    std::vector<uint64_t> timestamps(2 * f.timed_images);
+    VkResult result = vkGetQueryPoolResults(device.device(),
+        timestamp_pool,
+        current * QUERIES_PER_FRAME,
+        static_cast<uint32_t>(timestamps.size()),
+        timestamps.size() * sizeof(uint64_t),
+        timestamps.data(),
+        sizeof(uint64_t),
+        VK_QUERY_RESULT_64_BIT);
+
+    if (result == VK_SUCCESS) {
+        double gpu_ms = 0.0;
+        for (uint32_t i = 0; i < f.timed_images; i++) {
+            gpu_ms += device.timestamp_ms(timestamps[2 * i], timestamps[2 * i + 1]);
+        }
+        stats_.timed_images = f.timed_images;
+        stats_.gpu_ms = gpu_ms;
+
+        SPDLOG_DEBUG("mip generator: {} images in {:.3f} ms on the GPU ({:.3f} ms each)",
+            stats_.timed_images,
+            stats_.gpu_ms,
+            stats_.gpu_ms / stats_.timed_images);
+    }
+    f.timed_images = 0;
+}
+
+VkImageView bt_mip_generator::create_view(VkImage image, VkFormat format, uint32_t level)
+{
+    VkImageViewCreateInfo view_info { VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
+    view_info.image = image;
+    view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    view_info.format = format;
+    view_info.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, level, 1, 0, 1 };
+
+    VkImageView view;
+    if (vkCreateImageView(device.device(), &view_info, device.allocator(), &view) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create mip generator image view");
+    }
+    return view;
+}
+} // namespace bt
@@ -0,0 +1,105 @@
+#ifndef BT_MIP_GENERATOR_HPP
+#define BT_MIP_GENERATOR_HPP
+
+#include "bt_device.hpp"
+#include "bt_resources.hpp"
+
+#include <glad/vulkan.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace bt {
+struct bt_mip_generator_stats {
+    // Since the current frame was begun.
+    uint32_t compute_dispatches = 0;
+    uint32_t blit_chains = 0;
+    // GPU time of the images generated the previous time this frame index was used, read back once it completed.
+    // Zero when the graphics queue does not write timestamps.
+    uint32_t timed_images = 0;
+    double gpu_ms = 0.0;
+};
+
+// Generates mip chains on the GPU, recorded into the caller's command buffer so it runs in the same batch as the
+// upload of level 0. RGBA8 images up to 4096 texels across are reduced by a single compute dispatch of
+// shaders/mip_downsample.comp.spv, which keeps the intermediate levels in shared memory; other formats and sizes fall
+// back to one vkCmdBlitImage per level.
+//
+// Views and descriptor sets made for a dispatch belong to the frame that recorded it and are released when that frame
+// index is begun again. The compute pipeline is created in, and returned to, the given bt_resources.
+class bt_mip_generator {
+  public:
+    // Level 0 plus the 12 levels one dispatch can write.
+    static constexpr uint32_t MAX_COMPUTE_MIPS = 13;
+    // Further images in the same frame use blits.
+    static constexpr uint32_t MAX_DISPATCHES_PER_FRAME = 64;
+
+    bt_mip_generator(bt_device& device, bt_resources& resources, uint32_t frame_count);
+    bt_mip_generator(const bt_mip_generator&) = delete;
+    ~bt_mip_generator();
+
+    bt_mip_generator& operator=(const bt_mip_generator&) = delete;
+
+    // Usage and create flags images of this format need for generate(); includes what the compute path needs when
+    // the format can take it.
+    VkImageUsageFlags image_usage(VkFormat format) const;
+    VkImageCreateFlags image_flags(VkFormat format) const;
+
+    void begin_frame(uint32_t frame_index);
+
+    // Fills levels 1 to mip_count - 1 of image from level 0. Level 0 must be in TRANSFER_DST_OPTIMAL, written by a
+    // transfer; other levels are discarded. Leaves every level in SHADER_READ_ONLY_OPTIMAL, visible to shader reads.
+    void generate(VkCommandBuffer command_buffer,
+        VkImage image,
+        VkFormat format,
+        uint32_t width,
+        uint32_t height,
+        uint32_t mip_count);
+
+    const bt_mip_generator_stats& stats() const { return stats_; }
+
+  private:
+    struct frame {
+        VkDescriptorPool descriptor_pool = VK_NULL_HANDLE;
+        std::vector<VkImageView> views;
+        uint32_t dispatches = 0;
+        // Images timed this frame, two timestamps each.
+        uint32_t timed_images = 0;
+    };
+
+    bool can_use_compute(VkFormat format, uint32_t width, uint32_t height, uint32_t mip_count) const;
+    void create_set_layout();
+    void create_pipeline();
+    void create_counter_buffer(uint32_t frame_count);
+    void clear_counters(VkCommandBuffer command_buffer);
+    void read_timestamps(frame& f);
+    VkImageView create_view(VkImage image, VkFormat format, uint32_t level);
+    void generate_compute(VkCommandBuffer command_buffer,
+        VkImage image,
+        VkFormat format,
+        uint32_t width,
+        uint32_t height,
+        uint32_t mip_count);
+    void generate_blit(VkCommandBuffer command_buffer,
+        VkImage image,
+        uint32_t width,
+        uint32_t height,
+        uint32_t mip_count);
+
+    bt_device& device;
+    bt_resources& resources;
+    VkDescriptorSetLayout set_layout = VK_NULL_HANDLE;
+    VkPipelineLayout pipeline_layout = VK_NULL_HANDLE;
+    bt_compute_pipeline_handle pipeline;
+    VkBuffer counter_buffer = VK_NULL_HANDLE;
+    VkDeviceMemory counter_memory = VK_NULL_HANDLE;
+    VkDeviceSize counter_stride = 0;
+    bool counters_cleared = false;
+    VkQueryPool timestamp_pool = VK_NULL_HANDLE;
+    std::vector<frame> frames;
+    uint32_t current = 0;
+    bt_mip_generator_stats stats_;
+};
+} // namespace bt
+
+#endif // BT_MIP_GENERATOR_HPP
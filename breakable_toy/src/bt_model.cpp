@@ -1,5 +1,8 @@
 #include "bt_model.hpp"
 
+#include "bt_simplify.hpp"
+
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 
@@ -32,16 +35,53 @@ std::vector<VkVertexInputAttributeDescription> bt_model::vertex::attribute_descr
     return descriptions;
 }
 
+void bt_model::builder::generate_lods(size_t max_lods)
+{
+    if (indices.empty()) {
+        indices.resize(vertices.size());
+        for (uint32_t i = 0; i < indices.size(); i++) {
+            indices[i] = i;
+        }
+    }
+
+    std::vector<glm::vec3> positions(vertices.size());
+    for (size_t i = 0; i < vertices.size(); i++) {
+        positions[i] = glm::vec3(vertices[i].position, 0.0f);
+    }
+
+    lods = bt_mesh_simplifier::generate_lods(positions, indices, max_lods);
+}
+
 bt_model::bt_model(bt_device& device, const std::vector<vertex>& vertices) :
     device_(device)
 {
     create_vertex_buffers(vertices);
+    compute_bounds(vertices);
+    lods_.push_back({ 0, vertex_count_, 0.0f });
+}
+
+bt_model::bt_model(bt_device& device, const builder& builder) :
+    device_(device)
+{
+    create_vertex_buffers(builder.vertices);
+    create_index_buffers(builder.indices);
+    compute_bounds(builder.vertices);
+
+    lods_ = builder.lods;
+    if (lods_.empty()) {
+        lods_.push_back({ 0, has_index_buffer_ ? index_count_ : vertex_count_, 0.0f });
+    }
 }
 
 bt_model::~bt_model()
 {
-    vkDestroyBuffer(device_.device(), vertex_buffer_, device_.allocator());
-    vkFreeMemory(device_.device(), vertex_buffer_memory_, device_.allocator());
+    device_.destroy_later(vertex_buffer_);
+    device_.destroy_later(vertex_buffer_memory_);
+
+    if (has_index_buffer_) {
+        device_.destroy_later(index_buffer_);
+        device_.destroy_later(index_buffer_memory_);
+    }
 }
 
 void bt_model::bind(VkCommandBuffer command_buffer)
@@ -49,9 +89,44 @@ void bt_model::bind(VkCommandBuffer command_buffer)
     VkBuffer buffers[] = { vertex_buffer_ };
     VkDeviceSize offsets[] = { 0 };
     vkCmdBindVertexBuffers(command_buffer, 0, 1, buffers, offsets);
+
+    if (has_index_buffer_) {
+        vkCmdBindIndexBuffer(command_buffer, index_buffer_, 0, VK_INDEX_TYPE_UINT32);
+    }
+}
+
+void bt_model::draw(VkCommandBuffer command_buffer, uint32_t lod)
+{
+    const auto& level = lods_[std::min(lod, static_cast<uint32_t>(lods_.size() - 1))];
+    if (has_index_buffer_) {
+        vkCmdDrawIndexed(command_buffer, level.index_count, 1, level.first_index, 0, 0);
+    } else {
+        vkCmdDraw(command_buffer, vertex_count_, 1, 0, 0);
+    }
+}
+
+VkDrawIndexedIndirectCommand bt_model::indirect_command(uint32_t lod) const
+{
+    const auto& level = lods_[std::min(lod, static_cast<uint32_t>(lods_.size() - 1))];
+    if (has_index_buffer_) {
+        return { level.index_count, 1, level.first_index, 0, 0 };
+    }
+    return { vertex_count_, 1, 0, 0, 0 };
 }
 
-void bt_model::draw(VkCommandBuffer command_buffer) { vkCmdDraw(command_buffer, vertex_count_, 1, 0, 0); }
+void bt_model::draw_indirect(VkCommandBuffer command_buffer, VkBuffer buffer, VkDeviceSize offset)
+{
+    if (has_index_buffer_) {
+        vkCmdDrawIndexedIndirect(command_buffer, buffer, offset, 1, sizeof(VkDrawIndexedIndirectCommand));
+    } else {
+        vkCmdDrawIndirect(command_buffer, buffer, offset, 1, sizeof(VkDrawIndirectCommand));
+    }
+}
+
+uint32_t bt_model::triangle_count(uint32_t lod) const
+{
+    return lods_[std::min(lod, static_cast<uint32_t>(lods_.size() - 1))].index_count / 3;
+}
 
 void bt_model::create_vertex_buffers(const std::vector<vertex>& vertices)
 {
@@ -69,4 +144,41 @@ void bt_model::create_vertex_buffers(const std::vector<vertex>& vertices)
     memcpy(data, vertices.data(), static_cast<size_t>(buffer_size));
     vkUnmapMemory(device_.device(), vertex_buffer_memory_);
 }
+
+void bt_model::create_index_buffers(const std::vector<uint32_t>& indices)
+{
+    index_count_ = static_cast<uint32_t>(indices.size());
+    has_index_buffer_ = index_count_ > 0;
+    if (!has_index_buffer_) {
+        return;
+    }
+
+    VkDeviceSize buffer_size = sizeof(indices[0]) * index_count_;
+    device_.create_buffer(buffer_size,
+        VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        index_buffer_,
+        index_buffer_memory_);
+
+    void* data;
+    vkMapMemory(device_.device(), index_buffer_memory_, 0, buffer_size, 0, &data);
+    memcpy(data, indices.data(), static_cast<size_t>(buffer_size));
+    vkUnmapMemory(device_.device(), index_buffer_memory_);
+}
+
+void bt_model::compute_bounds(const std::vector<vertex>& vertices)
+{
+    bounding_box_ = {};
+    for (const auto& v : vertices) {
+        bounding_box_.expand(glm::vec3(v.position, 0.0f));
+    }
+
+    // The sphere is centred on the box rather than being minimal; it is only used for coarse tests.
+    bounding_sphere_.center = bounding_box_.center();
+    bounding_sphere_.radius = 0.0f;
+    for (const auto& v : vertices) {
+        bounding_sphere_.radius
+            = std::max(bounding_sphere_.radius, glm::length(glm::vec3(v.position, 0.0f) - bounding_sphere_.center));
+    }
+}
 } // namespace bt
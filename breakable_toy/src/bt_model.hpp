@@ -1,7 +1,9 @@
 #ifndef BT_MODEL_HPP
 #define BT_MODEL_HPP
 
+#include "bt_bounds.hpp"
 #include "bt_device.hpp"
+#include "bt_lod.hpp"
 #include "bt_maths.hpp"
 
 #include <glad/vulkan.h>
@@ -19,22 +21,52 @@ class bt_model {
         static std::vector<VkVertexInputAttributeDescription> attribute_descriptions();
     };
 
+    struct builder {
+        std::vector<vertex> vertices;
+        std::vector<uint32_t> indices;
+        std::vector<bt_lod> lods;
+
+        // Appends simplified index ranges for up to `max_lods` levels (including the base mesh) to `indices`.
+        void generate_lods(size_t max_lods);
+    };
+
     bt_model(bt_device& device, const std::vector<vertex>& vertices);
+    bt_model(bt_device& device, const builder& builder);
     bt_model(const bt_model&) = delete;
     ~bt_model();
 
     bt_model& operator=(const bt_model&) = delete;
 
     void bind(VkCommandBuffer command_buffer);
-    void draw(VkCommandBuffer command_buffer);
+    void draw(VkCommandBuffer command_buffer, uint32_t lod = 0);
+    // The arguments draw() would use for lod, one instance. Without an index buffer they are those of a
+    // VkDrawIndirectCommand, which has the same layout up to its end.
+    VkDrawIndexedIndirectCommand indirect_command(uint32_t lod = 0) const;
+    // Draws with the arguments at offset in buffer, as written from indirect_command() and changed since.
+    void draw_indirect(VkCommandBuffer command_buffer, VkBuffer buffer, VkDeviceSize offset);
+
+    const std::vector<bt_lod>& lods() const { return lods_; }
+    uint32_t triangle_count(uint32_t lod = 0) const;
+
+    const bt_aabb& bounding_box() const { return bounding_box_; }
+    const bt_sphere& bounding_sphere() const { return bounding_sphere_; }
 
   private:
     void create_vertex_buffers(const std::vector<vertex>& vertices);
+    void create_index_buffers(const std::vector<uint32_t>& indices);
+    void compute_bounds(const std::vector<vertex>& vertices);
 
     bt_device& device_;
     VkBuffer vertex_buffer_;
     VkDeviceMemory vertex_buffer_memory_;
     uint32_t vertex_count_;
+    bool has_index_buffer_ = false;
+    VkBuffer index_buffer_;
+    VkDeviceMemory index_buffer_memory_;
+    uint32_t index_count_ = 0;
+    std::vector<bt_lod> lods_;
+    bt_aabb bounding_box_;
+    bt_sphere bounding_sphere_;
 };
 } // namespace bt
 
@@ -0,0 +1,626 @@
+#include "bt_occlusion.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+namespace bt {
+namespace {
+constexpr uint32_t STAGE_PREPARE = 0;
+constexpr uint32_t STAGE_CULL = 1;
+
+// Timestamps per frame, in the order they are written.
+constexpr uint32_t TIMESTAMP_SCENE_START = 0;
+constexpr uint32_t TIMESTAMP_CULL_START = 1;
+constexpr uint32_t TIMESTAMP_CULL_END = 2;
+constexpr uint32_t TIMESTAMP_SCENE_END = 3;
+constexpr uint32_t TIMESTAMPS = 4;
+
+// Weight of the newest frame in the smoothed statistics.
+constexpr double SMOOTHING = 0.1;
+
+VkDeviceSize align_up(VkDeviceSize size, VkDeviceSize alignment)
+{
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+void* map_memory(bt_device& device, VkDeviceMemory memory, VkDeviceSize size)
+{
+    void* mapped;
+    if (vkMapMemory(device.device(), memory, 0, size, 0, &mapped) != VK_SUCCESS) {
+        throw std::runtime_error("failed to map occlusion culling buffer");
+    }
+    return mapped;
+}
+
+void memory_barrier(VkCommandBuffer command_buffer,
+    VkPipelineStageFlags src_stages,
+    VkAccessFlags src_access,
+    VkPipelineStageFlags dst_stages,
+    VkAccessFlags dst_access)
+{
+    VkMemoryBarrier barrier { VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+    barrier.srcAccessMask = src_access;
+    barrier.dstAccessMask = dst_access;
+    vkCmdPipelineBarrier(command_buffer, src_stages, dst_stages, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+void smooth(double& average, double sample)
+{
+    average = average == 0.0 ? sample : average + SMOOTHING * (sample - average);
+}
+} // namespace
+
+bt_occlusion_culler::bt_occlusion_culler(bt_device& device,
+    bt_resources& resources,
+    uint32_t frame_count,
+    const bt_occlusion_config& config) :
+    device { device },
+    resources { resources },
+    config_ { config },
+    frames(frame_count)
+{
+    assert(frame_count > 0 && "occlusion culler needs at least one frame");
+    assert(config.max_draws > 0 && config.max_objects > 0 && "occlusion culler needs room for at least one draw");
+
+    create_buffers(frame_count);
+    create_descriptors(frame_count);
+    create_pipelines();
+    create_query_pool(frame_count);
+}
+
+bt_occlusion_culler::~bt_occlusion_culler()
+{
+    // Frames in flight may still be culling or drawing.
+    resources.destroy(cull_pipeline);
+    resources.destroy(prepare_pipeline);
+    resources.destroy(pyramid_pipeline);
+    destroy_pyramid();
+    device.destroy_later(cull_layout);
+    device.destroy_later(pyramid_layout);
+    device.destroy_later(descriptor_pool);
+    device.destroy_later(cull_set_layout);
+    device.destroy_later(pyramid_set_layout);
+    device.destroy_later(sampler);
+    device.destroy_later(timestamp_pool);
+    device.destroy_later(candidate_buffer);
+    device.destroy_later(candidate_memory);
+    device.destroy_later(indirect_buffer);
+    device.destroy_later(indirect_memory);
+    device.destroy_later(counter_buffer);
+    device.destroy_later(counter_memory);
+    device.destroy_later(visibility_buffer);
+    device.destroy_later(visibility_memory);
+}
+
+void bt_occlusion_culler::resize(VkExtent2D extent)
+{
+    // Level 0 is the largest power of two no larger than the depth attachment, so every level halves exactly.
+    VkExtent2D size { std::bit_floor(std::max(extent.width, 1u)), std::bit_floor(std::max(extent.height, 1u)) };
+    if (pyramid != VK_NULL_HANDLE && size.width == pyramid_extent.width && size.height == pyramid_extent.height) {
+        return;
+    }
+
+    destroy_pyramid();
+    pyramid_extent = size;
+    auto levels = std::min(static_cast<uint32_t>(std::bit_width(std::max(size.width, size.height))), MAX_LEVELS);
+
+    VkImageCreateInfo image_info { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
+    image_info.imageType = VK_IMAGE_TYPE_2D;
+    image_info.format = VK_FORMAT_R32_SFLOAT;
+    image_info.extent = { size.width, size.height, 1 };
+    image_info.mipLevels = levels;
+    image_info.arrayLayers = 1;
+    image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+    image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    image_info.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    device.create_image_with_info(image_info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, pyramid, pyramid_memory);
+
+    auto create_view = [&](uint32_t base_level, uint32_t level_count) {
+        VkImageViewCreateInfo view_info { VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
+        view_info.image = pyramid;
+        view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        view_info.format = VK_FORMAT_R32_SFLOAT;
+        view_info.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, base_level, level_count, 0, 1 };
+
+        VkImageView view;
+        if (vkCreateImageView(device.device(), &view_info, device.allocator(), &view) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create depth pyramid view");
+        }
+        return view;
+    };
+
+    pyramid_view = create_view(0, levels);
+    for (uint32_t level = 0; level < levels; level++) {
+        level_views.push_back(create_view(level, 1));
+    }
+    // Moved to GENERAL by the next frame that builds it rather than here, so resizing does not wait for the GPU.
+    pyramid_initialized = false;
+}
+
+void bt_occlusion_culler::begin_frame(uint32_t frame_index, uint64_t fragment_invocations)
+{
+    assert(frame_index < frames.size() && "frame index out of range");
+
+    current = frame_index;
+    read_back(fragment_invocations);
+
+    auto& f = frames[current];
+    f.reference = config_.reference_interval > 0 && frames_begun++ % config_.reference_interval == 0;
+    f.count = 0;
+    draw_count_ = 0;
+}
+
+uint32_t bt_occlusion_culler::add(uint32_t object, const bt_aabb& box, const bt_model& mesh, uint32_t lod)
+{
+    if (draw_count_ >= config_.max_draws || object >= config_.max_objects) {
+        return NO_SLOT;
+    }
+
+    auto& f = frames[current];
+    uint32_t slot = draw_count_++;
+    f.candidates[slot] = { glm::vec4(box.min, 1.0f), glm::vec4(box.max, 1.0f), object, {} };
+
+    // Instance counts are written by prepare and cull.
+    auto command = mesh.indirect_command(lod);
+    command.instanceCount = 0;
+    f.commands[slot] = command;
+    f.commands[config_.max_draws + slot] = command;
+    return slot;
+}
+
+void bt_occlusion_culler::prepare(VkCommandBuffer command_buffer)
+{
+    auto& f = frames[current];
+    f.count = draw_count_;
+    std::memset(f.counters, 0, sizeof(counter_block));
+
+    if (timestamp_pool != VK_NULL_HANDLE) {
+        vkCmdResetQueryPool(command_buffer, timestamp_pool, TIMESTAMPS * current, TIMESTAMPS);
+        vkCmdWriteTimestamp(command_buffer,
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+            timestamp_pool,
+            TIMESTAMPS * current + TIMESTAMP_SCENE_START);
+    }
+    f.recorded = true;
+
+    if (f.count == 0) {
+        return;
+    }
+
+    // The previous frame's cull wrote the visibility read here.
+    memory_barrier(command_buffer,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_ACCESS_SHADER_WRITE_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+    cull_push_constants push {};
+    push.count = f.count;
+    push.capacity = config_.max_draws;
+    vkCmdBindDescriptorSets(command_buffer,
+        VK_PIPELINE_BIND_POINT_COMPUTE,
+        cull_layout,
+        0,
+        1,
+        &f.cull_set,
+        0,
+        nullptr);
+    vkCmdPushConstants(command_buffer, cull_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push), &push);
+    resources.pipeline(prepare_pipeline)
+        .dispatch(command_buffer, bt_compute_pipeline::group_count(f.count, GROUP_SIZE));
+
+    bt_compute_pipeline::barrier(command_buffer,
+        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+        VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+}
+
+void bt_occlusion_culler::end_phase(VkCommandBuffer command_buffer, uint32_t phase)
+{
+    if (phase == 1 && timestamp_pool != VK_NULL_HANDLE) {
+        vkCmdWriteTimestamp(command_buffer,
+            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            timestamp_pool,
+            TIMESTAMPS * current + TIMESTAMP_SCENE_END);
+    }
+}
+
+void bt_occlusion_culler::build_and_cull(VkCommandBuffer command_buffer,
+    const glm::mat4& view_projection,
+    VkImageView depth_view,
+    VkExtent2D depth_extent)
+{
+    assert(pyramid != VK_NULL_HANDLE && "cannot cull before resize");
+
+    auto& f = frames[current];
+    if (timestamp_pool != VK_NULL_HANDLE) {
+        vkCmdWriteTimestamp(command_buffer,
+            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            timestamp_pool,
+            TIMESTAMPS * current + TIMESTAMP_CULL_START);
+    }
+
+    // The frame index's fence has been waited for, so its sets are no longer in use.
+    write_descriptors(f, depth_view);
+    build_pyramid(command_buffer, f, depth_extent);
+
+    if (f.count > 0) {
+        cull_push_constants push {};
+        push.view_projection = view_projection;
+        push.pyramid_size = { std::min(std::bit_floor(std::max(depth_extent.width, 1u)), pyramid_extent.width),
+            std::min(std::bit_floor(std::max(depth_extent.height, 1u)), pyramid_extent.height) };
+        push.level_count = static_cast<uint32_t>(level_views.size());
+        push.count = f.count;
+        push.capacity = config_.max_draws;
+        push.reference = f.reference ? 1 : 0;
+        vkCmdBindDescriptorSets(command_buffer,
+            VK_PIPELINE_BIND_POINT_COMPUTE,
+            cull_layout,
+            0,
+            1,
+            &f.cull_set,
+            0,
+            nullptr);
+        vkCmdPushConstants(command_buffer, cull_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push), &push);
+        resources.pipeline(cull_pipeline)
+            .dispatch(command_buffer, bt_compute_pipeline::group_count(f.count, GROUP_SIZE));
+
+        bt_compute_pipeline::barrier(command_buffer,
+            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+            VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+    }
+
+    if (timestamp_pool != VK_NULL_HANDLE) {
+        vkCmdWriteTimestamp(command_buffer,
+            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            timestamp_pool,
+            TIMESTAMPS * current + TIMESTAMP_CULL_END);
+    }
+}
+
+void bt_occlusion_culler::draw(VkCommandBuffer command_buffer, bt_model& mesh, uint32_t slot, uint32_t phase)
+{
+    assert(slot < draw_count_ && phase < 2 && "occlusion culled draw out of range");
+
+    VkDeviceSize index = static_cast<VkDeviceSize>(phase) * config_.max_draws + slot;
+    mesh.draw_indirect(command_buffer,
+        indirect_buffer,
+        command_stride * current + index * sizeof(VkDrawIndexedIndirectCommand));
+}
+
+void bt_occlusion_culler::create_buffers(uint32_t frame_count)
+{
+    auto alignment = device.properties.limits.minStorageBufferOffsetAlignment;
+    candidate_stride = align_up(sizeof(candidate) * config_.max_draws, alignment);
+    command_stride = align_up(2 * sizeof(VkDrawIndexedIndirectCommand) * config_.max_draws, alignment);
+    counter_stride = align_up(sizeof(counter_block), alignment);
+
+    // Written by the CPU for each frame, and the commands' instance counts by the GPU in place; frames in flight each
+    // have their own part.
+    auto host_visible = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    device.create_buffer(candidate_stride * frame_count,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        host_visible,
+        candidate_buffer,
+        candidate_memory);
+    device.create_buffer(command_stride * frame_count,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+        host_visible,
+        indirect_buffer,
+        indirect_memory);
+    device.create_buffer(counter_stride * frame_count,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        host_visible,
+        counter_buffer,
+        counter_memory);
+
+    auto* candidates = static_cast<std::byte*>(map_memory(device, candidate_memory, candidate_stride * frame_count));
+    auto* commands = static_cast<std::byte*>(map_memory(device, indirect_memory, command_stride * frame_count));
+    auto* counters = static_cast<std::byte*>(map_memory(device, counter_memory, counter_stride * frame_count));
+    for (uint32_t i = 0; i < frame_count; i++) {
+        frames[i].candidates = reinterpret_cast<candidate*>(candidates + candidate_stride * i);
+        frames[i].commands = reinterpret_cast<VkDrawIndexedIndirectCommand*>(commands + command_stride * i);
+        frames[i].counters = reinterpret_cast<counter_block*>(counters + counter_stride * i);
+    }
+
+    device.create_buffer(sizeof(uint32_t) * config_.max_objects,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        visibility_buffer,
+        visibility_memory);
+
+    // Nothing was visible before the first frame, so everything is drawn in its second phase.
+    VkCommandBuffer command_buffer = device.begin_single_time_commands();
+    vkCmdFillBuffer(command_buffer, visibility_buffer, 0, VK_WHOLE_SIZE, 0);
+    device.end_single_time_commands(command_buffer);
+}
+
+void bt_occlusion_culler::create_descriptors(uint32_t frame_count)
+{
+    std::array<VkDescriptorSetLayoutBinding, 5> cull_bindings {};
+    for (uint32_t i = 0; i < cull_bindings.size(); i++) {
+        cull_bindings[i].binding = i;
+        cull_bindings[i].descriptorType =
+            i < 4 ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        cull_bindings[i].descriptorCount = 1;
+        cull_bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    std::array<VkDescriptorSetLayoutBinding, 2> pyramid_bindings {};
+    pyramid_bindings[0] = { 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr };
+    pyramid_bindings[1] = { 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr };
+
+    VkDescriptorSetLayoutCreateInfo layout_info { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+    layout_info.bindingCount = static_cast<uint32_t>(cull_bindings.size());
+    layout_info.pBindings = cull_bindings.data();
+    if (vkCreateDescriptorSetLayout(device.device(), &layout_info, device.allocator(), &cull_set_layout)
+        != VK_SUCCESS) {
+        throw std::runtime_error("failed to create occlusion culling descriptor set layout");
+    }
+
+    layout_info.bindingCount = static_cast<uint32_t>(pyramid_bindings.size());
+    layout_info.pBindings = pyramid_bindings.data();
+    if (vkCreateDescriptorSetLayout(device.device(), &layout_info, device.allocator(), &pyramid_set_layout)
+        != VK_SUCCESS) {
+        throw std::runtime_error("failed to create depth pyramid descriptor set layout");
+    }
+
+    std::array<VkDescriptorPoolSize, 3> pool_sizes { {
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4 * frame_count },
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, (1 + MAX_LEVELS) * frame_count },
+        { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, MAX_LEVELS * frame_count },
+    } };
+
+    VkDescriptorPoolCreateInfo pool_info { VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+    pool_info.maxSets = (1 + MAX_LEVELS) * frame_count;
+    pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+    pool_info.pPoolSizes = pool_sizes.data();
+    if (vkCreateDescriptorPool(device.device(), &pool_info, device.allocator(), &descriptor_pool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create occlusion culling descriptor pool");
+    }
+
+    for (uint32_t i = 0; i < frame_count; i++) {
+        auto& f = frames[i];
+        std::vector<VkDescriptorSetLayout> set_layouts(1 + MAX_LEVELS, pyramid_set_layout);
+        set_layouts[0] = cull_set_layout;
+        std::vector<VkDescriptorSet> sets(set_layouts.size());
+
+        VkDescriptorSetAllocateInfo alloc_info { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+        alloc_info.descriptorPool = descriptor_pool;
+        alloc_info.descriptorSetCount = static_cast<uint32_t>(set_layouts.size());
+        alloc_info.pSetLayouts = set_layouts.data();
+        if (vkAllocateDescriptorSets(device.device(), &alloc_info, sets.data()) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate occlusion culling descriptor sets");
+        }
+        f.cull_set = sets[0];
+        f.pyramid_sets.assign(sets.begin() + 1, sets.end());
+
+        // The buffers never change; the pyramid is written each frame.
+        std::array<VkDescriptorBufferInfo, 4> buffer_infos { {
+            { candidate_buffer, candidate_stride * i, sizeof(candidate) * config_.max_draws },
+            { indirect_buffer, command_stride * i, 2 * sizeof(VkDrawIndexedIndirectCommand) * config_.max_draws },
+            { visibility_buffer, 0, VK_WHOLE_SIZE },
+            { counter_buffer, counter_stride * i, sizeof(counter_block) },
+        } };
+
+        std::array<VkWriteDescriptorSet, 4> writes {};
+        for (uint32_t binding = 0; binding < writes.size(); binding++) {
+            writes[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[binding].dstSet = f.cull_set;
+            writes[binding].dstBinding = binding;
+            writes[binding].descriptorCount = 1;
+            writes[binding].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            writes[binding].pBufferInfo = &buffer_infos[binding];
+        }
+        vkUpdateDescriptorSets(device.device(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    }
+
+    // Only texelFetch is used, but combined image samplers need one.
+    VkSamplerCreateInfo sampler_info { VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+    sampler_info.magFilter = VK_FILTER_NEAREST;
+    sampler_info.minFilter = VK_FILTER_NEAREST;
+    sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_info.maxLod = VK_LOD_CLAMP_NONE;
+    if (vkCreateSampler(device.device(), &sampler_info, device.allocator(), &sampler) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create depth pyramid sampler");
+    }
+
+    auto create_layout = [&](VkDescriptorSetLayout set_layout, uint32_t push_size, VkPipelineLayout& layout) {
+        VkPushConstantRange push_range { VK_SHADER_STAGE_COMPUTE_BIT, 0, push_size };
+
+        VkPipelineLayoutCreateInfo pipeline_layout_info { VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+        pipeline_layout_info.setLayoutCount = 1;
+        pipeline_layout_info.pSetLayouts = &set_layout;
+        pipeline_layout_info.pushConstantRangeCount = 1;
+        pipeline_layout_info.pPushConstantRanges = &push_range;
+        if (vkCreatePipelineLayout(device.device(), &pipeline_layout_info, device.allocator(), &layout)
+            != VK_SUCCESS) {
+            throw std::runtime_error("failed to create occlusion culling pipeline layout");
+        }
+    };
+    create_layout(cull_set_layout, sizeof(cull_push_constants), cull_layout);
+    create_layout(pyramid_set_layout, sizeof(pyramid_push_constants), pyramid_layout);
+}
+
+void bt_occlusion_culler::create_pipelines()
+{
+    VkSpecializationMapEntry stage_entry { 0, 0, sizeof(uint32_t) };
+    auto create = [&](uint32_t stage) {
+        VkSpecializationInfo specialization {};
+        specialization.mapEntryCount = 1;
+        specialization.pMapEntries = &stage_entry;
+        specialization.dataSize = sizeof(stage);
+        specialization.pData = &stage;
+        return resources.create_compute_pipeline("shaders/occlusion_cull.comp.spv", cull_layout, &specialization);
+    };
+
+    prepare_pipeline = create(STAGE_PREPARE);
+    cull_pipeline = create(STAGE_CULL);
+    pyramid_pipeline = resources.create_compute_pipeline("shaders/hiz_build.comp.spv", pyramid_layout);
+}
+
+void bt_occlusion_culler::create_query_pool(uint32_t frame_count)
+{
+    if (device.timestamp_valid_bits() == 0) {
+        return;
+    }
+
+    VkQueryPoolCreateInfo query_info { VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO };
+    query_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    query_info.queryCount = TIMESTAMPS * frame_count;
+    if (vkCreateQueryPool(device.device(), &query_info, device.allocator(), &timestamp_pool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create occlusion culling timestamp pool");
+    }
+}
+
+void bt_occlusion_culler::destroy_pyramid()
+{
+    for (auto view : level_views) {
+        device.destroy_later(view);
+    }
+    level_views.clear();
+    device.destroy_later(pyramid_view);
+    device.destroy_later(pyramid);
+    device.destroy_later(pyramid_memory);
+    pyramid_view = VK_NULL_HANDLE;
+    pyramid = VK_NULL_HANDLE;
+    pyramid_memory = VK_NULL_HANDLE;
+}
+
+void bt_occlusion_culler::write_descriptors(frame& f, VkImageView depth_view)
+{
+    auto level_count = static_cast<uint32_t>(level_views.size());
+    std::vector<VkDescriptorImageInfo> image_infos;
+    image_infos.reserve(1 + 2 * level_count);
+    std::vector<VkWriteDescriptorSet> writes;
+    writes.reserve(1 + 2 * level_count);
+
+    auto write = [&](VkDescriptorSet set, uint32_t binding, VkDescriptorType type, VkDescriptorImageInfo info) {
+        image_infos.push_back(info);
+        VkWriteDescriptorSet w { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+        w.dstSet = set;
+        w.dstBinding = binding;
+        w.descriptorCount = 1;
+        w.descriptorType = type;
+        w.pImageInfo = &image_infos.back();
+        writes.push_back(w);
+    };
+
+    write(f.cull_set,
+        4,
+        VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        { sampler, pyramid_view, VK_IMAGE_LAYOUT_GENERAL });
+    for (uint32_t level = 0; level < level_count; level++) {
+        // Level 0 is reduced from the depth attachment, the others from the level above.
+        VkDescriptorImageInfo source = level == 0
+            ? VkDescriptorImageInfo { sampler, depth_view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL }
+            : VkDescriptorImageInfo { sampler, level_views[level - 1], VK_IMAGE_LAYOUT_GENERAL };
+        write(f.pyramid_sets[level], 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, source);
+        write(f.pyramid_sets[level],
+            1,
+            VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+            { VK_NULL_HANDLE, level_views[level], VK_IMAGE_LAYOUT_GENERAL });
+    }
+
+    vkUpdateDescriptorSets(device.device(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+}
+
+void bt_occlusion_culler::build_pyramid(VkCommandBuffer command_buffer, frame& f, VkExtent2D depth_extent)
+{
+    // Whatever read the pyramid last, in an earlier frame, is done before it is overwritten. It is built and read in
+    // compute shaders only, so it stays in GENERAL.
+    VkImageMemoryBarrier barrier { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+    barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.oldLayout = pyramid_initialized ? VK_IMAGE_LAYOUT_GENERAL : VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = pyramid;
+    barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, static_cast<uint32_t>(level_views.size()), 0, 1 };
+    vkCmdPipelineBarrier(command_buffer,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        0,
+        nullptr,
+        0,
+        nullptr,
+        1,
+        &barrier);
+    pyramid_initialized = true;
+
+    pyramid_push_constants push {};
+    push.source_size = { depth_extent.width, depth_extent.height };
+    push.destination_size = { std::min(std::bit_floor(std::max(depth_extent.width, 1u)), pyramid_extent.width),
+        std::min(std::bit_floor(std::max(depth_extent.height, 1u)), pyramid_extent.height) };
+
+    resources.pipeline(pyramid_pipeline).bind(command_buffer);
+    for (uint32_t level = 0; level < level_views.size(); level++) {
+        vkCmdBindDescriptorSets(command_buffer,
+            VK_PIPELINE_BIND_POINT_COMPUTE,
+            pyramid_layout,
+            0,
+            1,
+            &f.pyramid_sets[level],
+            0,
+            nullptr);
+        vkCmdPushConstants(command_buffer, pyramid_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push), &push);
+        vkCmdDispatch(command_buffer,
+            bt_compute_pipeline::group_count(push.destination_size.x, PYRAMID_GROUP_SIZE),
+            bt_compute_pipeline::group_count(push.destination_size.y, PYRAMID_GROUP_SIZE),
+            1);
+        bt_compute_pipeline::barrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+
+        push.source_size = push.destination_size;
+        push.destination_size = glm::max(push.destination_size / 2u, glm::uvec2 { 1 });
+    }
+}
+
+void bt_occlusion_culler::read_back(uint64_t fragment_invocations)
+{
+    auto& f = frames[current];
+    if (!f.recorded) {
+        return;
+    }
+    f.recorded = false;
+
+    stats_.candidates = f.count;
+    stats_.first_phase_draws = f.counters->first_phase;
+    stats_.second_phase_draws = f.counters->second_phase;
+    stats_.occluded = f.counters->occluded;
+    if (f.reference) {
+        stats_.reference_frames++;
+    }
+
+    if (fragment_invocations > 0) {
+        smooth(f.reference ? stats_.reference_fragment_invocations : stats_.fragment_invocations,
+            static_cast<double>(fragment_invocations));
+    }
+
+    uint64_t timestamps[TIMESTAMPS];
+    if (timestamp_pool != VK_NULL_HANDLE
+        && vkGetQueryPoolResults(device.device(),
+               timestamp_pool,
+               TIMESTAMPS * current,
+               TIMESTAMPS,
+               sizeof(timestamps),
+               timestamps,
+               sizeof(uint64_t),
+               VK_QUERY_RESULT_64_BIT)
+            == VK_SUCCESS) {
+        auto ms = [&](uint32_t from, uint32_t to) { return device.timestamp_ms(timestamps[from], timestamps[to]); };
+        smooth(stats_.cull_ms, ms(TIMESTAMP_CULL_START, TIMESTAMP_CULL_END));
+        smooth(f.reference ? stats_.reference_scene_ms : stats_.scene_ms,
+            ms(TIMESTAMP_SCENE_START, TIMESTAMP_SCENE_END));
+    }
+}
+} // namespace bt
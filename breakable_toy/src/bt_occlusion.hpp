@@ -0,0 +1,196 @@
+#ifndef BT_OCCLUSION_HPP
+#define BT_OCCLUSION_HPP
+
+#include "bt_bounds.hpp"
+#include "bt_device.hpp"
+#include "bt_maths.hpp"
+#include "bt_model.hpp"
+#include "bt_resources.hpp"
+
+#include <glad/vulkan.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace bt {
+struct bt_occlusion_config {
+    // Draws tested per frame; draws added beyond it are drawn unconditionally in the first phase.
+    uint32_t max_draws = 4096;
+    // Objects ids range below this; their visibility persists from frame to frame.
+    uint32_t max_objects = 65536;
+    // Every this many frames, draws found occluded are drawn anyway, to measure what culling saves.
+    uint32_t reference_interval = 60;
+};
+
+struct bt_occlusion_stats {
+    // Of the previous time the frame index being begun was used, read back once it completed.
+    uint32_t candidates = 0;
+    uint32_t first_phase_draws = 0;
+    uint32_t second_phase_draws = 0;
+    uint32_t occluded = 0;
+    // Smoothed over recent frames. Fragment shader invocations of whole frames, in culled frames and in reference
+    // frames that also draw what was found occluded, as passed to begin_frame().
+    double fragment_invocations = 0.0;
+    double reference_fragment_invocations = 0.0;
+    // GPU time of building the depth pyramid and culling, and of everything from the first phase to the end of the
+    // second in culled and in reference frames. Zero without timestamps on graphics queues.
+    double cull_ms = 0.0;
+    double scene_ms = 0.0;
+    double reference_scene_ms = 0.0;
+    uint32_t reference_frames = 0;
+
+    double fragment_invocations_saved() const { return reference_fragment_invocations - fragment_invocations; }
+    // Scene time without any occlusion culling, as estimated from reference frames, less scene time with it.
+    double net_ms_saved() const { return reference_scene_ms - cull_ms - scene_ms; }
+};
+
+// Two-phase occlusion culling against a hierarchical depth buffer. Each frame:
+//
+//  1. prepare(), outside render passes, turns on the first-phase draws of objects that were visible last frame.
+//  2. A render pass draws them with draw(..., 0).
+//  3. build_and_cull(), outside render passes, reduces the depth that pass left into a pyramid of farthest depths,
+//     tests every draw's bounds against it, turns on the second-phase draws of those that became visible and records
+//     which objects are visible for the next frame.
+//  4. A render pass that loads the first one's attachments draws them with draw(..., 1), then calls end_phase().
+//
+// Draws are added on the CPU each frame with add(), and issued as indirect draws whose instance counts the GPU
+// writes, so nothing is read back before drawing. Objects that move out from behind an occluder are drawn in the
+// second phase of the same frame; only what moves into view of an object drawn in the first phase for the first time
+// can be a frame late, as in any two-phase scheme. The compute pipelines are created in, and returned to, the given
+// bt_resources.
+class bt_occlusion_culler {
+  public:
+    static constexpr uint32_t NO_SLOT = UINT32_MAX;
+    static constexpr uint32_t MAX_LEVELS = 16;
+    static constexpr uint32_t GROUP_SIZE = 64;
+    static constexpr uint32_t PYRAMID_GROUP_SIZE = 8;
+
+    bt_occlusion_culler(bt_device& device,
+        bt_resources& resources,
+        uint32_t frame_count,
+        const bt_occlusion_config& config = {});
+    bt_occlusion_culler(const bt_occlusion_culler&) = delete;
+    ~bt_occlusion_culler();
+
+    bt_occlusion_culler& operator=(const bt_occlusion_culler&) = delete;
+
+    const bt_occlusion_config& config() const { return config_; }
+
+    // Sizes the depth pyramid for depth attachments of extent; keeps it if already sized for it.
+    void resize(VkExtent2D extent);
+
+    // fragment_invocations counts the fragment shader invocations of the whole frame that last used frame_index, e.g.
+    // from bt_gpu_telemetry, or is 0 if unknown.
+    void begin_frame(uint32_t frame_index, uint64_t fragment_invocations);
+    // Adds a draw of lod of mesh for object, whose bounds are box. Returns the draw's slot, or NO_SLOT when the frame
+    // is full. Draws are slotted in the order they are added.
+    uint32_t add(uint32_t object, const bt_aabb& box, const bt_model& mesh, uint32_t lod);
+    uint32_t draw_count() const { return draw_count_; }
+
+    void prepare(VkCommandBuffer command_buffer);
+    void end_phase(VkCommandBuffer command_buffer, uint32_t phase);
+    // depth_view is the first phase's depth attachment, in SHADER_READ_ONLY_OPTIMAL, drawn over depth_extent from its
+    // top-left corner; view_projection maps object space to clip space.
+    void build_and_cull(VkCommandBuffer command_buffer,
+        const glm::mat4& view_projection,
+        VkImageView depth_view,
+        VkExtent2D depth_extent);
+    // Records the phase's draw of slot with mesh already bound.
+    void draw(VkCommandBuffer command_buffer, bt_model& mesh, uint32_t slot, uint32_t phase);
+
+    const bt_occlusion_stats& stats() const { return stats_; }
+
+  private:
+    // Laid out as in shaders/occlusion_cull.comp.glsl.
+    struct candidate {
+        glm::vec4 box_min;
+        glm::vec4 box_max;
+        uint32_t object;
+        uint32_t padding[3];
+    };
+
+    struct counter_block {
+        uint32_t candidates;
+        uint32_t first_phase;
+        uint32_t occluded;
+        uint32_t second_phase;
+    };
+
+    struct cull_push_constants {
+        glm::mat4 view_projection;
+        glm::uvec2 pyramid_size;
+        uint32_t level_count;
+        uint32_t count;
+        uint32_t capacity;
+        uint32_t reference;
+    };
+
+    struct pyramid_push_constants {
+        glm::uvec2 source_size;
+        glm::uvec2 destination_size;
+    };
+
+    struct frame {
+        // Mapped per-frame parts of the candidate, command and counter buffers.
+        candidate* candidates = nullptr;
+        VkDrawIndexedIndirectCommand* commands = nullptr;
+        counter_block* counters = nullptr;
+        VkDescriptorSet cull_set = VK_NULL_HANDLE;
+        std::vector<VkDescriptorSet> pyramid_sets;
+        bool recorded = false;
+        bool reference = false;
+        uint32_t count = 0;
+    };
+
+    void create_buffers(uint32_t frame_count);
+    void create_descriptors(uint32_t frame_count);
+    void create_pipelines();
+    void create_query_pool(uint32_t frame_count);
+    void destroy_pyramid();
+    void write_descriptors(frame& f, VkImageView depth_view);
+    void build_pyramid(VkCommandBuffer command_buffer, frame& f, VkExtent2D depth_extent);
+    void read_back(uint64_t fragment_invocations);
+
+    bt_device& device;
+    bt_resources& resources;
+    bt_occlusion_config config_;
+    VkDeviceSize candidate_stride = 0;
+    VkDeviceSize command_stride = 0;
+    VkDeviceSize counter_stride = 0;
+    VkBuffer candidate_buffer = VK_NULL_HANDLE;
+    VkDeviceMemory candidate_memory = VK_NULL_HANDLE;
+    // Both phases' commands of every frame; the GPU writes their instance counts.
+    VkBuffer indirect_buffer = VK_NULL_HANDLE;
+    VkDeviceMemory indirect_memory = VK_NULL_HANDLE;
+    VkBuffer counter_buffer = VK_NULL_HANDLE;
+    VkDeviceMemory counter_memory = VK_NULL_HANDLE;
+    // One flag per object, shared by every frame in flight.
+    VkBuffer visibility_buffer = VK_NULL_HANDLE;
+    VkDeviceMemory visibility_memory = VK_NULL_HANDLE;
+    VkImage pyramid = VK_NULL_HANDLE;
+    VkDeviceMemory pyramid_memory = VK_NULL_HANDLE;
+    VkImageView pyramid_view = VK_NULL_HANDLE;
+    std::vector<VkImageView> level_views;
+    VkExtent2D pyramid_extent {};
+    bool pyramid_initialized = false;
+    VkSampler sampler = VK_NULL_HANDLE;
+    VkDescriptorSetLayout cull_set_layout = VK_NULL_HANDLE;
+    VkDescriptorSetLayout pyramid_set_layout = VK_NULL_HANDLE;
+    VkDescriptorPool descriptor_pool = VK_NULL_HANDLE;
+    VkPipelineLayout cull_layout = VK_NULL_HANDLE;
+    VkPipelineLayout pyramid_layout = VK_NULL_HANDLE;
+    bt_compute_pipeline_handle prepare_pipeline;
+    bt_compute_pipeline_handle cull_pipeline;
+    bt_compute_pipeline_handle pyramid_pipeline;
+    // Per frame: the start of the first phase, the start and end of pyramid building and culling, and the end of the
+    // second phase.
+    VkQueryPool timestamp_pool = VK_NULL_HANDLE;
+    std::vector<frame> frames;
+    uint32_t current = 0;
+    uint32_t draw_count_ = 0;
+    uint32_t frames_begun = 0;
+    bt_occlusion_stats stats_;
+};
+} // namespace bt
+
+#endif // BT_OCCLUSION_HPP
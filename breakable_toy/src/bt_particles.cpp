@@ -0,0 +1,390 @@
+#include "bt_particles.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+namespace bt {
+namespace {
+// Particle in shaders/particles.comp.glsl: position, packed half-precision velocity and remaining life.
+constexpr VkDeviceSize PARTICLE_SIZE = 16;
+
+constexpr uint32_t STAGE_SIMULATE = 0;
+constexpr uint32_t STAGE_EMIT = 1;
+constexpr uint32_t STAGE_FINALIZE = 2;
+
+constexpr VkShaderStageFlags SHADER_STAGES = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT;
+
+void memory_barrier(VkCommandBuffer command_buffer,
+    VkPipelineStageFlags src_stages,
+    VkAccessFlags src_access,
+    VkPipelineStageFlags dst_stages,
+    VkAccessFlags dst_access)
+{
+    VkMemoryBarrier barrier { VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+    barrier.srcAccessMask = src_access;
+    barrier.dstAccessMask = dst_access;
+    vkCmdPipelineBarrier(command_buffer, src_stages, dst_stages, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+} // namespace
+
+bt_particle_system::bt_particle_system(bt_device& device,
+    bt_resources& resources,
+    uint32_t frame_count,
+    const bt_particle_config& config) :
+    device { device },
+    resources { resources },
+    config_ { config },
+    frames(frame_count)
+{
+    assert(frame_count > 0 && "particle system needs at least one frame");
+    assert(config.capacity > 0 && "particle system needs room for at least one particle");
+
+    if (PARTICLE_SIZE * config.capacity > device.properties.limits.maxStorageBufferRange) {
+        throw std::runtime_error("failed to create particle system: capacity exceeds the storage buffer range");
+    }
+
+    create_buffers(frame_count);
+    create_descriptors();
+    create_compute_pipelines();
+
+    if (device.timestamp_valid_bits() > 0) {
+        VkQueryPoolCreateInfo query_info { VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO };
+        query_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        query_info.queryCount = 2 * frame_count;
+
+        if (vkCreateQueryPool(device.device(), &query_info, device.allocator(), &timestamp_pool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create particle query pool");
+        }
+    }
+
+    stats_.capacity = config.capacity;
+}
+
+bt_particle_system::~bt_particle_system()
+{
+    // Frames in flight may still be simulating or drawing.
+    if (!draw_pipeline.is_null()) {
+        resources.destroy(draw_pipeline);
+    }
+    resources.destroy(finalize_pipeline);
+    resources.destroy(emit_pipeline);
+    resources.destroy(simulate_pipeline);
+    device.destroy_later(pipeline_layout);
+    device.destroy_later(descriptor_pool);
+    device.destroy_later(set_layout);
+    device.destroy_later(timestamp_pool);
+    for (size_t i = 0; i < particle_buffers.size(); i++) {
+        device.destroy_later(particle_buffers[i]);
+        device.destroy_later(particle_memory[i]);
+    }
+    device.destroy_later(state_buffer);
+    device.destroy_later(state_memory);
+    device.destroy_later(readback_buffer);
+    device.destroy_later(readback_memory);
+}
+
+void bt_particle_system::create_draw_pipeline(VkRenderPass render_pass)
+{
+    bt_pipeline_config_info config {};
+    bt_pipeline::default_pipeline_config_info(config);
+    // Quads are built in the vertex shader from the particle buffer.
+    config.binding_descriptions.clear();
+    config.attribute_descriptions.clear();
+    // Additive, drawn over the scene without touching its depth.
+    config.color_blend_attachment.blendEnable = VK_TRUE;
+    config.color_blend_attachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+    config.color_blend_attachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE;
+    config.depth_stencil_info.depthTestEnable = VK_FALSE;
+    config.depth_stencil_info.depthWriteEnable = VK_FALSE;
+    config.pipeline_layout = pipeline_layout;
+    config.render_pass = render_pass;
+
+    if (!draw_pipeline.is_null()) {
+        resources.destroy(draw_pipeline);
+    }
+    draw_pipeline = resources.create_pipeline("shaders/particles.vert.spv", "shaders/particles.frag.spv", config);
+}
+
+void bt_particle_system::begin_frame(uint32_t frame_index)
+{
+    assert(frame_index < frames.size() && "frame index out of range");
+
+    current = frame_index;
+    read_back();
+}
+
+void bt_particle_system::simulate(VkCommandBuffer command_buffer, float dt)
+{
+    auto& f = frames[current];
+
+    float emission = config_.emit_rate * dt + emit_remainder;
+    auto emit_count = static_cast<uint32_t>(emission);
+    emit_remainder = emission - static_cast<float>(emit_count);
+    // More than fit would only be dropped.
+    emit_count = std::min(emit_count + pending_burst, config_.capacity);
+    pending_burst = 0;
+
+    uint32_t first_query = 2 * current;
+    if (timestamp_pool != VK_NULL_HANDLE) {
+        vkCmdResetQueryPool(command_buffer, timestamp_pool, first_query, 2);
+        vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestamp_pool, first_query);
+    }
+
+    // The previous frame's finalize wrote the counters and the dispatch read here, and its draw and read-back may
+    // still be reading what this frame overwrites.
+    memory_barrier(command_buffer,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_ACCESS_SHADER_WRITE_BIT,
+        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+    auto push = make_push_constants(dt, emit_count);
+    vkCmdBindDescriptorSets(command_buffer,
+        VK_PIPELINE_BIND_POINT_COMPUTE,
+        pipeline_layout,
+        0,
+        1,
+        &descriptor_sets[src],
+        0,
+        nullptr);
+    vkCmdPushConstants(command_buffer, pipeline_layout, SHADER_STAGES, 0, sizeof(push), &push);
+
+    // Both only append to the destination buffer, so they need no barrier between them.
+    resources.pipeline(simulate_pipeline)
+        .dispatch_indirect(command_buffer, state_buffer, offsetof(bt_particle_state, dispatch));
+    if (emit_count > 0) {
+        resources.pipeline(emit_pipeline)
+            .dispatch(command_buffer, bt_compute_pipeline::group_count(emit_count, GROUP_SIZE));
+    }
+
+    bt_compute_pipeline::barrier(command_buffer,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+    resources.pipeline(finalize_pipeline).dispatch(command_buffer, 1);
+
+    bt_compute_pipeline::barrier(command_buffer,
+        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT);
+
+    if (timestamp_pool != VK_NULL_HANDLE) {
+        vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestamp_pool, first_query + 1);
+    }
+
+    // Read when this frame index is begun again, after its fence has signalled.
+    VkBufferCopy copy { 0, current * sizeof(bt_particle_state), sizeof(bt_particle_state) };
+    vkCmdCopyBuffer(command_buffer, state_buffer, readback_buffer, 1, &copy);
+    memory_barrier(command_buffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_ACCESS_TRANSFER_WRITE_BIT,
+        VK_PIPELINE_STAGE_HOST_BIT,
+        VK_ACCESS_HOST_READ_BIT);
+
+    f.simulated = true;
+    f.emitted = emit_count;
+    src = 1 - src;
+    seed++;
+}
+
+void bt_particle_system::draw(VkCommandBuffer command_buffer)
+{
+    assert(!draw_pipeline.is_null() && "cannot draw particles before create_draw_pipeline");
+
+    auto push = make_push_constants(0.0f, 0);
+    resources.pipeline(draw_pipeline).bind(command_buffer);
+    // The set whose destination is the buffer the last simulate() wrote.
+    vkCmdBindDescriptorSets(command_buffer,
+        VK_PIPELINE_BIND_POINT_GRAPHICS,
+        pipeline_layout,
+        0,
+        1,
+        &descriptor_sets[1 - src],
+        0,
+        nullptr);
+    vkCmdPushConstants(command_buffer, pipeline_layout, SHADER_STAGES, 0, sizeof(push), &push);
+    vkCmdDrawIndirect(command_buffer,
+        state_buffer,
+        offsetof(bt_particle_state, draw),
+        1,
+        sizeof(VkDrawIndirectCommand));
+}
+
+void bt_particle_system::create_buffers(uint32_t frame_count)
+{
+    for (size_t i = 0; i < particle_buffers.size(); i++) {
+        device.create_buffer(PARTICLE_SIZE * config_.capacity,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            particle_buffers[i],
+            particle_memory[i]);
+    }
+
+    device.create_buffer(sizeof(bt_particle_state),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+            | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        state_buffer,
+        state_memory);
+
+    // No particles, and a simulate dispatch of zero groups.
+    VkCommandBuffer command_buffer = device.begin_single_time_commands();
+    vkCmdFillBuffer(command_buffer, state_buffer, 0, VK_WHOLE_SIZE, 0);
+    device.end_single_time_commands(command_buffer);
+
+    VkDeviceSize readback_size = sizeof(bt_particle_state) * frame_count;
+    device.create_buffer(readback_size,
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        readback_buffer,
+        readback_memory);
+
+    void* mapped;
+    if (vkMapMemory(device.device(), readback_memory, 0, readback_size, 0, &mapped) != VK_SUCCESS) {
+        throw std::runtime_error("failed to map particle read-back buffer");
+    }
+    std::memset(mapped, 0, static_cast<size_t>(readback_size));
+    readback = static_cast<const bt_particle_state*>(mapped);
+}
+
+void bt_particle_system::create_descriptors()
+{
+    std::array<VkDescriptorSetLayoutBinding, 3> bindings {};
+    for (uint32_t i = 0; i < bindings.size(); i++) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = SHADER_STAGES;
+    }
+
+    VkDescriptorSetLayoutCreateInfo layout_info { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+    layout_info.bindingCount = static_cast<uint32_t>(bindings.size());
+    layout_info.pBindings = bindings.data();
+
+    if (vkCreateDescriptorSetLayout(device.device(), &layout_info, device.allocator(), &set_layout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create particle descriptor set layout");
+    }
+
+    VkDescriptorPoolSize pool_size { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        static_cast<uint32_t>(bindings.size() * descriptor_sets.size()) };
+
+    VkDescriptorPoolCreateInfo pool_info { VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+    pool_info.maxSets = static_cast<uint32_t>(descriptor_sets.size());
+    pool_info.poolSizeCount = 1;
+    pool_info.pPoolSizes = &pool_size;
+
+    if (vkCreateDescriptorPool(device.device(), &pool_info, device.allocator(), &descriptor_pool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create particle descriptor pool");
+    }
+
+    std::array<VkDescriptorSetLayout, 2> set_layouts { set_layout, set_layout };
+    VkDescriptorSetAllocateInfo alloc_info { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+    alloc_info.descriptorPool = descriptor_pool;
+    alloc_info.descriptorSetCount = static_cast<uint32_t>(set_layouts.size());
+    alloc_info.pSetLayouts = set_layouts.data();
+
+    if (vkAllocateDescriptorSets(device.device(), &alloc_info, descriptor_sets.data()) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate particle descriptor sets");
+    }
+
+    for (uint32_t i = 0; i < descriptor_sets.size(); i++) {
+        std::array<VkDescriptorBufferInfo, 3> buffer_infos { {
+            { particle_buffers[i], 0, VK_WHOLE_SIZE },
+            { particle_buffers[1 - i], 0, VK_WHOLE_SIZE },
+            { state_buffer, 0, VK_WHOLE_SIZE },
+        } };
+
+        std::array<VkWriteDescriptorSet, 3> writes {};
+        for (uint32_t binding = 0; binding < writes.size(); binding++) {
+            writes[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[binding].dstSet = descriptor_sets[i];
+            writes[binding].dstBinding = binding;
+            writes[binding].descriptorCount = 1;
+            writes[binding].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            writes[binding].pBufferInfo = &buffer_infos[binding];
+        }
+        vkUpdateDescriptorSets(device.device(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    }
+
+    VkPushConstantRange push_range { SHADER_STAGES, 0, sizeof(push_constants) };
+
+    VkPipelineLayoutCreateInfo pipeline_layout_info { VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+    pipeline_layout_info.setLayoutCount = 1;
+    pipeline_layout_info.pSetLayouts = &set_layout;
+    pipeline_layout_info.pushConstantRangeCount = 1;
+    pipeline_layout_info.pPushConstantRanges = &push_range;
+
+    if (vkCreatePipelineLayout(device.device(), &pipeline_layout_info, device.allocator(), &pipeline_layout)
+        != VK_SUCCESS) {
+        throw std::runtime_error("failed to create particle pipeline layout");
+    }
+}
+
+void bt_particle_system::create_compute_pipelines()
+{
+    VkSpecializationMapEntry stage_entry { 0, 0, sizeof(uint32_t) };
+    auto create = [&](uint32_t stage) {
+        VkSpecializationInfo specialization {};
+        specialization.mapEntryCount = 1;
+        specialization.pMapEntries = &stage_entry;
+        specialization.dataSize = sizeof(stage);
+        specialization.pData = &stage;
+        return resources.create_compute_pipeline("shaders/particles.comp.spv", pipeline_layout, &specialization);
+    };
+
+    simulate_pipeline = create(STAGE_SIMULATE);
+    emit_pipeline = create(STAGE_EMIT);
+    finalize_pipeline = create(STAGE_FINALIZE);
+}
+
+bt_particle_system::push_constants bt_particle_system::make_push_constants(float dt, uint32_t emit_count) const
+{
+    push_constants push {};
+    push.emitter = config_.emitter;
+    push.velocity = config_.velocity;
+    push.gravity = config_.gravity;
+    push.spread = config_.spread;
+    push.lifetime = config_.lifetime;
+    push.dt = dt;
+    push.size = config_.size;
+    push.src = src;
+    push.emit_count = emit_count;
+    push.capacity = config_.capacity;
+    push.seed = seed;
+    return push;
+}
+
+void bt_particle_system::read_back()
+{
+    auto& f = frames[current];
+    if (!f.simulated) {
+        return;
+    }
+
+    const auto& state = readback[current];
+    stats_.simulated = state.simulated;
+    stats_.alive = state.draw.instanceCount;
+    stats_.dropped = state.dropped;
+    stats_.emitted = f.emitted - std::min(f.emitted, state.dropped);
+    stats_.gpu_ms = 0.0;
+    stats_.particles_per_ms = 0.0;
+
+    uint64_t timestamps[2];
+    if (timestamp_pool != VK_NULL_HANDLE
+        && vkGetQueryPoolResults(device.device(),
+               timestamp_pool,
+               2 * current,
+               2,
+               sizeof(timestamps),
+               timestamps,
+               sizeof(uint64_t),
+               VK_QUERY_RESULT_64_BIT)
+            == VK_SUCCESS) {
+        stats_.gpu_ms = device.timestamp_ms(timestamps[0], timestamps[1]);
+        if (stats_.gpu_ms > 0.0) {
+            stats_.particles_per_ms = stats_.simulated / stats_.gpu_ms;
+        }
+    }
+    f.simulated = false;
+}
+} // namespace bt
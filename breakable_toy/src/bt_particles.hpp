@@ -0,0 +1,155 @@
+#ifndef BT_PARTICLES_HPP
+#define BT_PARTICLES_HPP
+
+#include "bt_device.hpp"
+#include "bt_maths.hpp"
+#include "bt_resources.hpp"
+
+#include <glad/vulkan.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace bt {
+// GPU-side counters of the particle system, laid out as the State block of shaders/particles.comp.glsl. The draw and
+// dispatch commands are read straight from here by vkCmdDrawIndirect and vkCmdDispatchIndirect.
+struct bt_particle_state {
+    // Particles in each of the two particle buffers.
+    uint32_t alive[2];
+    // Particles the last simulate pass read, and emissions it had no room for.
+    uint32_t simulated;
+    uint32_t dropped;
+    VkDrawIndirectCommand draw;
+    VkDispatchIndirectCommand dispatch;
+    uint32_t padding;
+};
+
+static_assert(offsetof(bt_particle_state, draw) == 16 && offsetof(bt_particle_state, dispatch) == 32,
+    "bt_particle_state must match the State block in particles.comp.glsl");
+
+struct bt_particle_config {
+    // Particles that can be alive at once; fixes the size of the particle buffers.
+    uint32_t capacity = 65536;
+    // Continuous emission, in particles per second, on top of any burst().
+    float emit_rate = 8192.0f;
+    // Particles live for between half and all of this, in seconds.
+    float lifetime = 2.0f;
+    // Clip-space emitter position, initial velocity and the angle in radians it is spread over.
+    glm::vec2 emitter { 0.0f, 0.6f };
+    glm::vec2 velocity { 0.0f, -1.4f };
+    float spread = 0.8f;
+    glm::vec2 gravity { 0.0f, 1.5f };
+    // Half the side of a particle's quad, in clip space.
+    float size = 0.004f;
+};
+
+struct bt_particle_stats {
+    // Of the previous time the frame index being begun was used, read back once it completed.
+    uint32_t capacity = 0;
+    uint32_t simulated = 0;
+    uint32_t alive = 0;
+    uint32_t emitted = 0;
+    uint32_t dropped = 0;
+    // GPU time of emission, simulation and compaction. Zero when the graphics queue does not write timestamps.
+    double gpu_ms = 0.0;
+    double particles_per_ms = 0.0;
+};
+
+// Emits, integrates and compacts particles entirely in compute shaders and draws the survivors with an indirect draw
+// whose instance count the GPU wrote; the CPU only supplies the frame's time step and emission count, and never reads
+// the particles or their count back before drawing. simulate() is recorded outside render passes, draw() inside one
+// whose pipeline was created with create_draw_pipeline().
+//
+// The particle buffers and counters are shared by every frame in flight; frames are ordered by the barriers at the
+// start of simulate(), so frames submitted to the same queue may overlap freely. Pipelines are created in, and
+// returned to, the given bt_resources.
+class bt_particle_system {
+  public:
+    static constexpr uint32_t GROUP_SIZE = 256;
+
+    bt_particle_system(bt_device& device,
+        bt_resources& resources,
+        uint32_t frame_count,
+        const bt_particle_config& config = {});
+    bt_particle_system(const bt_particle_system&) = delete;
+    ~bt_particle_system();
+
+    bt_particle_system& operator=(const bt_particle_system&) = delete;
+
+    const bt_particle_config& config() const { return config_; }
+
+    // Builds the pipeline that draws the particles in subpass 0 of render_pass, replacing the previous one.
+    void create_draw_pipeline(VkRenderPass render_pass);
+
+    // Emits count particles in the next simulate(), on top of the continuous emission.
+    void burst(uint32_t count) { pending_burst += count; }
+
+    void begin_frame(uint32_t frame_index);
+    // Records one step of dt seconds.
+    void simulate(VkCommandBuffer command_buffer, float dt);
+    // Records a draw of the particles alive after the last simulate(), with the viewport and scissor already set.
+    void draw(VkCommandBuffer command_buffer);
+
+    const bt_particle_stats& stats() const { return stats_; }
+
+  private:
+    struct push_constants {
+        glm::vec2 emitter;
+        glm::vec2 velocity;
+        glm::vec2 gravity;
+        float spread;
+        float lifetime;
+        float dt;
+        float size;
+        uint32_t src;
+        uint32_t emit_count;
+        uint32_t capacity;
+        uint32_t seed;
+    };
+
+    struct frame {
+        bool simulated = false;
+        uint32_t emitted = 0;
+    };
+
+    void create_buffers(uint32_t frame_count);
+    void create_descriptors();
+    void create_compute_pipelines();
+    push_constants make_push_constants(float dt, uint32_t emit_count) const;
+    void read_back();
+
+    bt_device& device;
+    bt_resources& resources;
+    bt_particle_config config_;
+    std::array<VkBuffer, 2> particle_buffers {};
+    std::array<VkDeviceMemory, 2> particle_memory {};
+    VkBuffer state_buffer = VK_NULL_HANDLE;
+    VkDeviceMemory state_memory = VK_NULL_HANDLE;
+    // One bt_particle_state per frame in flight, copied after the frame's finalize.
+    VkBuffer readback_buffer = VK_NULL_HANDLE;
+    VkDeviceMemory readback_memory = VK_NULL_HANDLE;
+    const bt_particle_state* readback = nullptr;
+    VkQueryPool timestamp_pool = VK_NULL_HANDLE;
+    VkDescriptorSetLayout set_layout = VK_NULL_HANDLE;
+    VkDescriptorPool descriptor_pool = VK_NULL_HANDLE;
+    // Set i reads particle buffer i and writes the other.
+    std::array<VkDescriptorSet, 2> descriptor_sets {};
+    VkPipelineLayout pipeline_layout = VK_NULL_HANDLE;
+    bt_compute_pipeline_handle simulate_pipeline;
+    bt_compute_pipeline_handle emit_pipeline;
+    bt_compute_pipeline_handle finalize_pipeline;
+    bt_pipeline_handle draw_pipeline;
+    std::vector<frame> frames;
+    uint32_t current = 0;
+    // Buffer the next simulate() reads from; the other holds the particles to draw.
+    uint32_t src = 0;
+    uint32_t seed = 0;
+    float emit_remainder = 0.0f;
+    uint32_t pending_burst = 0;
+    bt_particle_stats stats_;
+};
+} // namespace bt
+
+#endif // BT_PARTICLES_HPP
@@ -8,6 +8,26 @@
 #include <stdexcept>
 
 namespace bt {
+namespace {
+VkShaderModule create_shader_module(bt_device& device, const std::vector<char>& code)
+{
+    VkShaderModuleCreateInfo create_info { VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO };
+    create_info.codeSize = code.size();
+    create_info.pCode = reinterpret_cast<const uint32_t*>(code.data());
+
+    VkShaderModule shader_module;
+    if (vkCreateShaderModule(device.device(), &create_info, device.allocator(), &shader_module) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create shader module");
+    }
+    return shader_module;
+}
+
+VkShaderModule load_shader_module(bt_device& device, std::string_view filepath)
+{
+    return create_shader_module(device, bt_filesystem::read_file(filepath));
+}
+} // namespace
+
 void bt_pipeline::default_pipeline_config_info(bt_pipeline_config_info& config_info)
 {
     config_info.viewport_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
@@ -76,22 +96,81 @@ void bt_pipeline::default_pipeline_config_info(bt_pipeline_config_info& config_i
     config_info.dynamic_state_info.pDynamicStates = config_info.dynamic_state_enables.data();
     config_info.dynamic_state_info.dynamicStateCount = static_cast<uint32_t>(config_info.dynamic_state_enables.size());
     config_info.dynamic_state_info.flags = 0;
+
+    config_info.binding_descriptions = bt_model::vertex::binding_descriptions();
+    config_info.attribute_descriptions = bt_model::vertex::attribute_descriptions();
+}
+
+void bt_pipeline::apply_draw_state(bt_pipeline_config_info& config_info, const bt_draw_state& state)
+{
+    config_info.rasterisation_info.cullMode = state.cull_mode;
+    config_info.rasterisation_info.frontFace = state.front_face;
+    config_info.rasterisation_info.depthBiasEnable = state.depth_bias ? VK_TRUE : VK_FALSE;
+    config_info.input_assembly_info.topology = state.topology;
+    config_info.input_assembly_info.primitiveRestartEnable = state.primitive_restart ? VK_TRUE : VK_FALSE;
+    config_info.depth_stencil_info.depthTestEnable = state.depth_test ? VK_TRUE : VK_FALSE;
+    config_info.depth_stencil_info.depthWriteEnable = state.depth_write ? VK_TRUE : VK_FALSE;
+    config_info.depth_stencil_info.depthCompareOp = state.depth_compare;
+}
+
+void bt_pipeline::make_draw_state_dynamic(bt_pipeline_config_info& config_info, bool extended_dynamic_state2)
+{
+    config_info.dynamic_state_enables.insert(config_info.dynamic_state_enables.end(),
+        { VK_DYNAMIC_STATE_CULL_MODE_EXT,
+            VK_DYNAMIC_STATE_FRONT_FACE_EXT,
+            VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY_EXT,
+            VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE_EXT,
+            VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE_EXT,
+            VK_DYNAMIC_STATE_DEPTH_COMPARE_OP_EXT });
+    if (extended_dynamic_state2) {
+        config_info.dynamic_state_enables.insert(config_info.dynamic_state_enables.end(),
+            { VK_DYNAMIC_STATE_PRIMITIVE_RESTART_ENABLE_EXT, VK_DYNAMIC_STATE_DEPTH_BIAS_ENABLE_EXT });
+    }
+    config_info.dynamic_state_info.pDynamicStates = config_info.dynamic_state_enables.data();
+    config_info.dynamic_state_info.dynamicStateCount = static_cast<uint32_t>(config_info.dynamic_state_enables.size());
+}
+
+void bt_pipeline::set_draw_state(VkCommandBuffer command_buffer,
+    const bt_draw_state& state,
+    bool extended_dynamic_state2)
+{
+    vkCmdSetCullModeEXT(command_buffer, state.cull_mode);
+    vkCmdSetFrontFaceEXT(command_buffer, state.front_face);
+    vkCmdSetPrimitiveTopologyEXT(command_buffer, state.topology);
+    vkCmdSetDepthTestEnableEXT(command_buffer, state.depth_test ? VK_TRUE : VK_FALSE);
+    vkCmdSetDepthWriteEnableEXT(command_buffer, state.depth_write ? VK_TRUE : VK_FALSE);
+    vkCmdSetDepthCompareOpEXT(command_buffer, state.depth_compare);
+    if (extended_dynamic_state2) {
+        vkCmdSetPrimitiveRestartEnableEXT(command_buffer, state.primitive_restart ? VK_TRUE : VK_FALSE);
+        vkCmdSetDepthBiasEnableEXT(command_buffer, state.depth_bias ? VK_TRUE : VK_FALSE);
+    }
 }
 
 bt_pipeline::bt_pipeline(bt_device& device,
     std::string_view vert_filepath,
     std::string_view frag_filepath,
     const bt_pipeline_config_info& config_info) :
+    bt_pipeline {
+        device, bt_filesystem::read_file(vert_filepath), bt_filesystem::read_file(frag_filepath), config_info
+    }
+{
+}
+
+bt_pipeline::bt_pipeline(bt_device& device,
+    const std::vector<char>& vert_code,
+    const std::vector<char>& frag_code,
+    const bt_pipeline_config_info& config_info) :
     device { device }
 {
-    create_graphics_pipeline(vert_filepath, frag_filepath, config_info);
+    create_graphics_pipeline(vert_code, frag_code, config_info);
 }
 
 bt_pipeline::~bt_pipeline()
 {
+    // Shader modules are only needed to create the pipeline; the pipeline may still be bound in frames in flight.
     vkDestroyShaderModule(device.device(), vert_shader_module, device.allocator());
     vkDestroyShaderModule(device.device(), frag_shader_module, device.allocator());
-    vkDestroyPipeline(device.device(), graphics_pipeline, device.allocator());
+    device.destroy_later(graphics_pipeline);
 }
 
 void bt_pipeline::bind(VkCommandBuffer command_buffer)
@@ -100,18 +179,15 @@ void bt_pipeline::bind(VkCommandBuffer command_buffer)
 }
 
 void bt_pipeline::create_graphics_pipeline(
-    std::string_view vert_filepath, std::string_view frag_filepath, const bt_pipeline_config_info& config_info)
+    const std::vector<char>& vert_code, const std::vector<char>& frag_code, const bt_pipeline_config_info& config_info)
 {
     assert(config_info.pipeline_layout != VK_NULL_HANDLE
         && "cannot create graphics pipeline - no pipeline_layout provided in config_info");
     assert(config_info.render_pass != VK_NULL_HANDLE
         && "cannot create graphics pipeline - no render_pass provided in config_info");
 
-    auto vert_code = bt_filesystem::read_file(vert_filepath);
-    auto frag_code = bt_filesystem::read_file(frag_filepath);
-
-    create_shader_module(vert_code, &vert_shader_module);
-    create_shader_module(frag_code, &frag_shader_module);
+    vert_shader_module = create_shader_module(device, vert_code);
+    frag_shader_module = create_shader_module(device, frag_code);
 
     VkPipelineShaderStageCreateInfo shader_stages[2];
     shader_stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -130,8 +206,8 @@ void bt_pipeline::create_graphics_pipeline(
     shader_stages[1].pNext = nullptr;
     shader_stages[1].pSpecializationInfo = nullptr;
 
-    auto binding_descriptions = bt_model::vertex::binding_descriptions();
-    auto attribute_descriptions = bt_model::vertex::attribute_descriptions();
+    const auto& binding_descriptions = config_info.binding_descriptions;
+    const auto& attribute_descriptions = config_info.attribute_descriptions;
     VkPipelineVertexInputStateCreateInfo vertex_input_info {
         VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO
     };
@@ -163,14 +239,66 @@ void bt_pipeline::create_graphics_pipeline(
     }
 }
 
-void bt_pipeline::create_shader_module(const std::vector<char>& code, VkShaderModule* shader_module)
+void bt_compute_pipeline::barrier(
+    VkCommandBuffer command_buffer, VkPipelineStageFlags dst_stages, VkAccessFlags dst_access)
 {
-    VkShaderModuleCreateInfo create_info { VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO };
-    create_info.codeSize = code.size();
-    create_info.pCode = reinterpret_cast<const uint32_t*>(code.data());
+    VkMemoryBarrier barrier { VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = dst_access;
+    vkCmdPipelineBarrier(
+        command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, dst_stages, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
 
-    if (vkCreateShaderModule(device.device(), &create_info, device.allocator(), shader_module) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create shader module");
+bt_compute_pipeline::bt_compute_pipeline(bt_device& device,
+    std::string_view comp_filepath,
+    VkPipelineLayout pipeline_layout,
+    const VkSpecializationInfo* specialization) :
+    device { device }
+{
+    assert(pipeline_layout != VK_NULL_HANDLE && "cannot create compute pipeline - no pipeline_layout provided");
+
+    VkShaderModule shader_module = load_shader_module(device, comp_filepath);
+
+    VkComputePipelineCreateInfo pipeline_info { VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO };
+    pipeline_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipeline_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipeline_info.stage.module = shader_module;
+    pipeline_info.stage.pName = "main";
+    pipeline_info.stage.pSpecializationInfo = specialization;
+    pipeline_info.layout = pipeline_layout;
+    pipeline_info.basePipelineIndex = -1;
+    pipeline_info.basePipelineHandle = VK_NULL_HANDLE;
+
+    VkResult result = vkCreateComputePipelines(device.device(),
+        VK_NULL_HANDLE,
+        1,
+        &pipeline_info,
+        device.allocator(),
+        &compute_pipeline);
+    vkDestroyShaderModule(device.device(), shader_module, device.allocator());
+
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create compute pipeline");
     }
 }
+
+bt_compute_pipeline::~bt_compute_pipeline() { device.destroy_later(compute_pipeline); }
+
+void bt_compute_pipeline::bind(VkCommandBuffer command_buffer)
+{
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, compute_pipeline);
+}
+
+void bt_compute_pipeline::dispatch(
+    VkCommandBuffer command_buffer, uint32_t groups_x, uint32_t groups_y, uint32_t groups_z)
+{
+    bind(command_buffer);
+    vkCmdDispatch(command_buffer, groups_x, groups_y, groups_z);
+}
+
+void bt_compute_pipeline::dispatch_indirect(VkCommandBuffer command_buffer, VkBuffer buffer, VkDeviceSize offset)
+{
+    bind(command_buffer);
+    vkCmdDispatchIndirect(command_buffer, buffer, offset);
+}
 } // namespace bt
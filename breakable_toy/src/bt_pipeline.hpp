@@ -7,6 +7,22 @@
 #include <vector>
 
 namespace bt {
+// Pipeline state that VK_EXT_extended_dynamic_state can set per draw instead of baking it into pipelines. Defaults
+// match default_pipeline_config_info().
+struct bt_draw_state {
+    VkCullModeFlags cull_mode = VK_CULL_MODE_NONE;
+    VkFrontFace front_face = VK_FRONT_FACE_CLOCKWISE;
+    VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    bool depth_test = true;
+    bool depth_write = true;
+    VkCompareOp depth_compare = VK_COMPARE_OP_LESS;
+    // Only dynamic with VK_EXT_extended_dynamic_state2.
+    bool primitive_restart = false;
+    bool depth_bias = false;
+
+    bool operator==(const bt_draw_state&) const = default;
+};
+
 struct bt_pipeline_config_info {
     bt_pipeline_config_info() = default;
     bt_pipeline_config_info(const bt_pipeline_config_info&) = delete;
@@ -20,6 +36,9 @@ struct bt_pipeline_config_info {
     VkPipelineColorBlendStateCreateInfo color_blend_info;
     VkPipelineDepthStencilStateCreateInfo depth_stencil_info;
     std::vector<VkDynamicState> dynamic_state_enables;
+    // Empty for pipelines that fetch their vertices from buffers themselves.
+    std::vector<VkVertexInputBindingDescription> binding_descriptions;
+    std::vector<VkVertexInputAttributeDescription> attribute_descriptions;
     VkPipelineDynamicStateCreateInfo dynamic_state_info;
     VkPipelineLayout pipeline_layout = nullptr;
     VkRenderPass render_pass = nullptr;
@@ -29,11 +48,24 @@ struct bt_pipeline_config_info {
 class bt_pipeline {
   public:
     static void default_pipeline_config_info(bt_pipeline_config_info& config_info);
+    // Bakes state into the config; with dynamic draw state only the topology class of state.topology matters.
+    static void apply_draw_state(bt_pipeline_config_info& config_info, const bt_draw_state& state);
+    // Leaves bt_draw_state to be set per command buffer with set_draw_state(), all of it with extended_dynamic_state2
+    // and all but primitive restart and depth bias without. The device must support the extensions used.
+    static void make_draw_state_dynamic(bt_pipeline_config_info& config_info, bool extended_dynamic_state2);
+    static void set_draw_state(VkCommandBuffer command_buffer,
+        const bt_draw_state& state,
+        bool extended_dynamic_state2);
 
     bt_pipeline(bt_device& device,
         std::string_view vert_filepath,
         std::string_view frag_filepath,
         const bt_pipeline_config_info& config_info);
+    // From SPIR-V already read, e.g. on another thread.
+    bt_pipeline(bt_device& device,
+        const std::vector<char>& vert_code,
+        const std::vector<char>& frag_code,
+        const bt_pipeline_config_info& config_info);
     bt_pipeline(const bt_pipeline&) = delete;
     ~bt_pipeline();
 
@@ -42,16 +74,49 @@ class bt_pipeline {
     void bind(VkCommandBuffer command_buffer);
 
   private:
-    void create_graphics_pipeline(
-        std::string_view vert_filepath, std::string_view frag_filepath, const bt_pipeline_config_info& config_info);
-
-    void create_shader_module(const std::vector<char>& code, VkShaderModule* shader_module);
+    void create_graphics_pipeline(const std::vector<char>& vert_code,
+        const std::vector<char>& frag_code,
+        const bt_pipeline_config_info& config_info);
 
     bt_device& device;
     VkPipeline graphics_pipeline;
     VkShaderModule vert_shader_module;
     VkShaderModule frag_shader_module;
 };
+
+// A compute shader and the layout it is dispatched with. Several pipelines can be built from one shader by passing
+// different specialisation constants.
+class bt_compute_pipeline {
+  public:
+    // Workgroups of group_size invocations needed to cover invocations.
+    static uint32_t group_count(uint32_t invocations, uint32_t group_size)
+    {
+        return (invocations + group_size - 1) / group_size;
+    }
+
+    // Makes shader writes of earlier dispatches visible to dst_access in dst_stages.
+    static void barrier(VkCommandBuffer command_buffer, VkPipelineStageFlags dst_stages, VkAccessFlags dst_access);
+
+    bt_compute_pipeline(bt_device& device,
+        std::string_view comp_filepath,
+        VkPipelineLayout pipeline_layout,
+        const VkSpecializationInfo* specialization = nullptr);
+    bt_compute_pipeline(const bt_compute_pipeline&) = delete;
+    ~bt_compute_pipeline();
+
+    bt_compute_pipeline& operator=(const bt_compute_pipeline&) = delete;
+
+    void bind(VkCommandBuffer command_buffer);
+    // Binds the pipeline, then dispatches.
+    void dispatch(VkCommandBuffer command_buffer, uint32_t groups_x, uint32_t groups_y = 1, uint32_t groups_z = 1);
+    // The group counts are read from a VkDispatchIndirectCommand in buffer when the dispatch executes, so they can be
+    // written by earlier dispatches without a round trip through the CPU.
+    void dispatch_indirect(VkCommandBuffer command_buffer, VkBuffer buffer, VkDeviceSize offset);
+
+  private:
+    bt_device& device;
+    VkPipeline compute_pipeline;
+};
 } // namespace bt
 
 #endif // BT_PIPELINE_HPP
@@ -0,0 +1,154 @@
+#include "bt_pipeline_registry.hpp"
+
+#include "bt_filesystem.hpp"
+#include "bt_logger.hpp"
+
+#include <chrono>
+#include <functional>
+
+namespace bt {
+namespace {
+void hash_combine(size_t& seed, size_t value) { seed ^= value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2); }
+
+// Without VK_EXT_extended_dynamic_state3 a dynamic topology must be of the class the pipeline was created with. A
+// strip stands for its class when primitive restart is baked in, as lists only restart with an extra feature.
+VkPrimitiveTopology topology_class(VkPrimitiveTopology topology, bool primitive_restart)
+{
+    switch (topology) {
+    case VK_PRIMITIVE_TOPOLOGY_POINT_LIST:
+        return VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
+    case VK_PRIMITIVE_TOPOLOGY_LINE_LIST:
+    case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP:
+    case VK_PRIMITIVE_TOPOLOGY_LINE_LIST_WITH_ADJACENCY:
+    case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP_WITH_ADJACENCY:
+        return primitive_restart ? VK_PRIMITIVE_TOPOLOGY_LINE_STRIP : VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
+    case VK_PRIMITIVE_TOPOLOGY_PATCH_LIST:
+        return VK_PRIMITIVE_TOPOLOGY_PATCH_LIST;
+    default:
+        return primitive_restart ? VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP : VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    }
+}
+} // namespace
+
+size_t bt_pipeline_desc_hash::operator()(const bt_pipeline_desc& desc) const
+{
+    const auto& state = desc.draw_state;
+    size_t seed = std::hash<std::string> {}(desc.vert_shader);
+    hash_combine(seed, std::hash<std::string> {}(desc.frag_shader));
+    hash_combine(seed, std::hash<VkPipelineLayout> {}(desc.pipeline_layout));
+    hash_combine(seed, std::hash<VkRenderPass> {}(desc.render_pass));
+    hash_combine(seed, desc.blend);
+    hash_combine(seed, state.cull_mode);
+    hash_combine(seed, state.front_face);
+    hash_combine(seed, state.topology);
+    hash_combine(seed, state.depth_test);
+    hash_combine(seed, state.depth_write);
+    hash_combine(seed, state.depth_compare);
+    hash_combine(seed, state.primitive_restart);
+    hash_combine(seed, state.depth_bias);
+    return seed;
+}
+
+bt_pipeline_registry::bt_pipeline_registry(bt_device& device, bt_resources& resources, bool dynamic_draw_state) :
+    resources { resources },
+    dynamic_draw_state_ { dynamic_draw_state && device.extended_dynamic_state_supported() },
+    dynamic_draw_state2_ { dynamic_draw_state_ && device.extended_dynamic_state2_supported() }
+{
+    if (dynamic_draw_state && !dynamic_draw_state_) {
+        SPDLOG_WARN("VK_EXT_extended_dynamic_state not supported, draw state is baked into pipelines");
+    }
+}
+
+bt_pipeline_registry::~bt_pipeline_registry() { clear(); }
+
+void bt_pipeline_registry::add_shader(std::string path, std::vector<char> code)
+{
+    shaders.insert_or_assign(std::move(path), std::move(code));
+}
+
+bt_pipeline_handle bt_pipeline_registry::get(const bt_pipeline_desc& desc)
+{
+    stats_.lookups++;
+    auto key = static_part(desc, dynamic_draw_state_, dynamic_draw_state2_);
+    if (auto found = pipelines.find(key); found != pipelines.end()) {
+        return found->second;
+    }
+
+    const auto& vert_code = shader(key.vert_shader);
+    const auto& frag_code = shader(key.frag_shader);
+
+    bt_pipeline_config_info config {};
+    bt_pipeline::default_pipeline_config_info(config);
+    config.pipeline_layout = key.pipeline_layout;
+    config.render_pass = key.render_pass;
+    bt_pipeline::apply_draw_state(config, key.draw_state);
+    if (key.blend) {
+        auto& attachment = config.color_blend_attachment;
+        attachment.blendEnable = VK_TRUE;
+        attachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+        attachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+        attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+        attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    }
+    if (dynamic_draw_state_) {
+        bt_pipeline::make_draw_state_dynamic(config, dynamic_draw_state2_);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto handle = resources.create_pipeline(vert_code, frag_code, config);
+    stats_.compile_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    stats_.pipelines++;
+
+    pipelines.emplace(std::move(key), handle);
+    return handle;
+}
+
+void bt_pipeline_registry::set_draw_state(VkCommandBuffer command_buffer, const bt_draw_state& state)
+{
+    if (dynamic_draw_state_) {
+        bt_pipeline::set_draw_state(command_buffer, state, dynamic_draw_state2_);
+    }
+}
+
+void bt_pipeline_registry::clear()
+{
+    for (const auto& [desc, handle] : pipelines) {
+        resources.destroy(handle);
+    }
+    pipelines.clear();
+    stats_.pipelines = 0;
+}
+
+bt_pipeline_desc bt_pipeline_registry::static_part(const bt_pipeline_desc& desc,
+    bool dynamic_draw_state,
+    bool dynamic_draw_state2)
+{
+    if (!dynamic_draw_state) {
+        return desc;
+    }
+
+    auto key = desc;
+    const bt_draw_state defaults {};
+    auto& state = key.draw_state;
+    state.cull_mode = defaults.cull_mode;
+    state.front_face = defaults.front_face;
+    state.depth_test = defaults.depth_test;
+    state.depth_write = defaults.depth_write;
+    state.depth_compare = defaults.depth_compare;
+    if (dynamic_draw_state2) {
+        state.primitive_restart = defaults.primitive_restart;
+        state.depth_bias = defaults.depth_bias;
+    }
+    state.topology = topology_class(state.topology, state.primitive_restart);
+    return key;
+}
+
+const std::vector<char>& bt_pipeline_registry::shader(const std::string& path)
+{
+    auto found = shaders.find(path);
+    if (found == shaders.end()) {
+        found = shaders.emplace(path, bt_filesystem::read_file(path)).first;
+    }
+    return found->second;
+}
+} // namespace bt
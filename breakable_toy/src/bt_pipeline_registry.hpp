@@ -0,0 +1,84 @@
+#ifndef BT_PIPELINE_REGISTRY_HPP
+#define BT_PIPELINE_REGISTRY_HPP
+
+#include "bt_device.hpp"
+#include "bt_pipeline.hpp"
+#include "bt_resources.hpp"
+
+#include <glad/vulkan.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace bt {
+// What a graphics pipeline is made from. Shaders are named by path.
+struct bt_pipeline_desc {
+    std::string vert_shader;
+    std::string frag_shader;
+    VkPipelineLayout pipeline_layout = VK_NULL_HANDLE;
+    VkRenderPass render_pass = VK_NULL_HANDLE;
+    bool blend = false;
+    bt_draw_state draw_state;
+
+    bool operator==(const bt_pipeline_desc&) const = default;
+};
+
+struct bt_pipeline_desc_hash {
+    size_t operator()(const bt_pipeline_desc& desc) const;
+};
+
+struct bt_pipeline_registry_stats {
+    uint32_t pipelines = 0;
+    uint64_t lookups = 0;
+    // Spent in vkCreateGraphicsPipelines and shader module creation.
+    double compile_ms = 0.0;
+};
+
+// Creates each distinct pipeline once and hands out its handle for every later request. With dynamic draw state the
+// pipelines only bake what bt_draw_state does not cover plus the topology class, and leave the rest to
+// set_draw_state(), so materials that differ only in cull mode, depth state or topology share one pipeline.
+class bt_pipeline_registry {
+  public:
+    // Dynamic draw state is only used when requested and the device supports VK_EXT_extended_dynamic_state.
+    bt_pipeline_registry(bt_device& device, bt_resources& resources, bool dynamic_draw_state = true);
+    bt_pipeline_registry(const bt_pipeline_registry&) = delete;
+    ~bt_pipeline_registry();
+
+    bt_pipeline_registry& operator=(const bt_pipeline_registry&) = delete;
+
+    // Supplies the SPIR-V for path, e.g. read ahead on another thread; otherwise it is read on first use.
+    void add_shader(std::string path, std::vector<char> code);
+
+    bt_pipeline_handle get(const bt_pipeline_desc& desc);
+    // Sets the draw state the registry's pipelines leave dynamic; does nothing when they bake it. Call after binding
+    // the first of them in a command buffer, or before, as long as no pipeline baking that state is bound in between.
+    void set_draw_state(VkCommandBuffer command_buffer, const bt_draw_state& state);
+
+    // Destroys every pipeline, e.g. when the render passes they were created for go away.
+    void clear();
+
+    bool dynamic_draw_state() const { return dynamic_draw_state_; }
+    bool dynamic_draw_state2() const { return dynamic_draw_state2_; }
+    const bt_pipeline_registry_stats& stats() const { return stats_; }
+
+    // The part of desc a pipeline is keyed on: desc itself, or without what dynamic state sets.
+    static bt_pipeline_desc static_part(const bt_pipeline_desc& desc,
+        bool dynamic_draw_state,
+        bool dynamic_draw_state2);
+
+  private:
+    const std::vector<char>& shader(const std::string& path);
+
+    bt_resources& resources;
+    bool dynamic_draw_state_ = false;
+    bool dynamic_draw_state2_ = false;
+    std::unordered_map<std::string, std::vector<char>> shaders;
+    std::unordered_map<bt_pipeline_desc, bt_pipeline_handle, bt_pipeline_desc_hash> pipelines;
+    bt_pipeline_registry_stats stats_;
+};
+} // namespace bt
+
+#endif // BT_PIPELINE_REGISTRY_HPP
@@ -0,0 +1,129 @@
+#include "bt_presenter.hpp"
+
+#include <cassert>
+#include <limits>
+#include <stdexcept>
+
+namespace bt {
+bt_presenter::bt_presenter(bt_device& device) :
+    device { device }
+{
+    create_sync_objects();
+}
+
+bt_presenter::~bt_presenter()
+{
+    for (auto semaphore : render_finished_semaphores) {
+        device.destroy_later(semaphore);
+    }
+    for (auto fence : in_flight_fences) {
+        device.destroy_later(fence);
+    }
+}
+
+uint32_t bt_presenter::begin_frame()
+{
+    vkWaitForFences(device.device(),
+        1,
+        &in_flight_fences[current_frame],
+        VK_TRUE,
+        std::numeric_limits<uint64_t>::max());
+    device.complete_frames(fence_frames[current_frame]);
+
+    acquired.clear();
+    return current_frame;
+}
+
+VkResult bt_presenter::acquire(bt_swapchain& swapchain, uint32_t* image_index)
+{
+    VkResult result = swapchain.acquire_next_image(current_frame, image_index);
+    if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+        return result;
+    }
+
+    // With more images than frames in flight an image can come back while the frame that last rendered to it, under
+    // another frame index, is still executing.
+    VkFence& image_fence = swapchain.image_fence(*image_index);
+    if (image_fence != VK_NULL_HANDLE && image_fence != in_flight_fences[current_frame]) {
+        vkWaitForFences(device.device(), 1, &image_fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+    }
+    image_fence = in_flight_fences[current_frame];
+
+    acquired.push_back({ &swapchain, *image_index });
+    return result;
+}
+
+void bt_presenter::submit_and_present(const VkCommandBuffer* buffers, uint32_t count, std::vector<VkResult>& results)
+{
+    assert(!acquired.empty() && "cannot present a frame without acquired images");
+
+    wait_semaphores.clear();
+    wait_stages.clear();
+    swapchains.clear();
+    image_indices.clear();
+    for (const auto& image : acquired) {
+        wait_semaphores.push_back(image.swapchain->image_available(current_frame));
+        wait_stages.push_back(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+        swapchains.push_back(image.swapchain->handle());
+        image_indices.push_back(image.image_index);
+    }
+
+    VkSubmitInfo submit_info = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+    submit_info.waitSemaphoreCount = static_cast<uint32_t>(wait_semaphores.size());
+    submit_info.pWaitSemaphores = wait_semaphores.data();
+    submit_info.pWaitDstStageMask = wait_stages.data();
+    submit_info.commandBufferCount = count;
+    submit_info.pCommandBuffers = buffers;
+    submit_info.signalSemaphoreCount = 1;
+    submit_info.pSignalSemaphores = &render_finished_semaphores[current_frame];
+
+    vkResetFences(device.device(), 1, &in_flight_fences[current_frame]);
+    fence_frames[current_frame] = device.submit_frame();
+    if (vkQueueSubmit(device.graphics_queue(), 1, &submit_info, in_flight_fences[current_frame]) != VK_SUCCESS) {
+        throw std::runtime_error("failed to submit draw command buffer");
+    }
+
+    results.assign(acquired.size(), VK_SUCCESS);
+
+    VkPresentInfoKHR present_info = { VK_STRUCTURE_TYPE_PRESENT_INFO_KHR };
+    present_info.waitSemaphoreCount = 1;
+    present_info.pWaitSemaphores = &render_finished_semaphores[current_frame];
+    present_info.swapchainCount = static_cast<uint32_t>(swapchains.size());
+    present_info.pSwapchains = swapchains.data();
+    present_info.pImageIndices = image_indices.data();
+    present_info.pResults = results.data();
+
+    // Out of date and suboptimal swapchains are reported through results, for their viewports to recreate.
+    VkResult result = vkQueuePresentKHR(device.present_queue(), &present_info);
+    if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR && result != VK_ERROR_OUT_OF_DATE_KHR) {
+        throw std::runtime_error("failed to present swapchain images");
+    }
+
+    stats_.swapchains = static_cast<uint32_t>(acquired.size());
+    stats_.submits = 1;
+    stats_.presents = 1;
+
+    acquired.clear();
+    current_frame = (current_frame + 1) % bt_swapchain::MAX_FRAMES_IN_FLIGHT;
+}
+
+void bt_presenter::create_sync_objects()
+{
+    render_finished_semaphores.resize(bt_swapchain::MAX_FRAMES_IN_FLIGHT);
+    in_flight_fences.resize(bt_swapchain::MAX_FRAMES_IN_FLIGHT);
+    fence_frames.resize(bt_swapchain::MAX_FRAMES_IN_FLIGHT, 0);
+
+    VkSemaphoreCreateInfo semaphore_info = { VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
+
+    VkFenceCreateInfo fence_info = { VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+    fence_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+    for (size_t i = 0; i < bt_swapchain::MAX_FRAMES_IN_FLIGHT; i++) {
+        if (vkCreateSemaphore(device.device(), &semaphore_info, device.allocator(), &render_finished_semaphores[i])
+                != VK_SUCCESS
+            || vkCreateFence(device.device(), &fence_info, device.allocator(), &in_flight_fences[i]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create synchronization objects for a frame");
+        }
+    }
+}
+} // namespace bt
@@ -0,0 +1,69 @@
+#ifndef BT_PRESENTER_HPP
+#define BT_PRESENTER_HPP
+
+#include "bt_device.hpp"
+#include "bt_swapchain.hpp"
+
+#include <glad/vulkan.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace bt {
+struct bt_presenter_stats {
+    uint32_t swapchains = 0;
+    uint32_t submits = 0;
+    uint32_t presents = 0;
+};
+
+// Paces frames in flight and presents any number of swapchains per frame. A frame acquires an image from each
+// swapchain it renders to, records everything into the same command buffers, then submit_and_present() submits them
+// once, waiting on every acquire, and presents all images with a single vkQueuePresentKHR.
+class bt_presenter {
+  public:
+    explicit bt_presenter(bt_device& device);
+    bt_presenter(const bt_presenter&) = delete;
+    ~bt_presenter();
+
+    bt_presenter& operator=(const bt_presenter&) = delete;
+
+    // Waits until the frame in flight about to be recorded has completed and returns its index, in
+    // [0, MAX_FRAMES_IN_FLIGHT). Its command buffers and per-frame resources are free again afterwards.
+    uint32_t begin_frame();
+    uint32_t current_frame_index() const { return current_frame; }
+
+    // Acquires an image to present this frame. Images are only presented if acquiring them succeeded.
+    VkResult acquire(bt_swapchain& swapchain, uint32_t* image_index);
+
+    // Submits the frame's command buffers and presents every acquired image. results receives the present result of
+    // each successful acquire, in acquisition order. Must be called with at least one image acquired.
+    void submit_and_present(const VkCommandBuffer* buffers, uint32_t count, std::vector<VkResult>& results);
+
+    // Of the last frame.
+    const bt_presenter_stats& stats() const { return stats_; }
+
+  private:
+    struct acquired_image {
+        bt_swapchain* swapchain;
+        uint32_t image_index;
+    };
+
+    void create_sync_objects();
+
+    bt_device& device;
+    std::vector<VkSemaphore> render_finished_semaphores;
+    std::vector<VkFence> in_flight_fences;
+    // Device frame number last submitted with each fence.
+    std::vector<uint64_t> fence_frames;
+    uint32_t current_frame = 0;
+    std::vector<acquired_image> acquired;
+    // Scratch for building the submit and present.
+    std::vector<VkSemaphore> wait_semaphores;
+    std::vector<VkPipelineStageFlags> wait_stages;
+    std::vector<VkSwapchainKHR> swapchains;
+    std::vector<uint32_t> image_indices;
+    bt_presenter_stats stats_;
+};
+} // namespace bt
+
+#endif // BT_PRESENTER_HPP
@@ -0,0 +1,903 @@
+#include "bt_render_graph.hpp"
+
+#include "bt_logger.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace bt {
+namespace {
+struct usage_info {
+    VkImageLayout layout;
+    VkPipelineStageFlags stages;
+    VkAccessFlags read_access;
+    // Zero for usages that cannot write.
+    VkAccessFlags write_access;
+    VkImageUsageFlags image_usage;
+};
+
+constexpr VkPipelineStageFlags DEPTH_STAGES =
+    VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+constexpr VkPipelineStageFlags SHADER_STAGES = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT
+    | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+usage_info info(bt_rg_usage usage)
+{
+    switch (usage) {
+    case bt_rg_usage::color_attachment:
+        return { VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+            VK_ACCESS_COLOR_ATTACHMENT_READ_BIT,
+            VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+            VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT };
+    case bt_rg_usage::depth_attachment:
+        return { VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+            DEPTH_STAGES,
+            VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
+            VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+            VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT };
+    case bt_rg_usage::depth_read:
+        return { VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+            DEPTH_STAGES,
+            VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
+            0,
+            VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT };
+    case bt_rg_usage::sampled:
+        return { VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            SHADER_STAGES,
+            VK_ACCESS_SHADER_READ_BIT,
+            0,
+            VK_IMAGE_USAGE_SAMPLED_BIT };
+    case bt_rg_usage::storage:
+        return { VK_IMAGE_LAYOUT_GENERAL,
+            SHADER_STAGES,
+            VK_ACCESS_SHADER_READ_BIT,
+            VK_ACCESS_SHADER_WRITE_BIT,
+            VK_IMAGE_USAGE_STORAGE_BIT };
+    case bt_rg_usage::transfer_src:
+        return { VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_ACCESS_TRANSFER_READ_BIT,
+            0,
+            VK_IMAGE_USAGE_TRANSFER_SRC_BIT };
+    case bt_rg_usage::transfer_dst:
+        return { VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_IMAGE_USAGE_TRANSFER_DST_BIT };
+    }
+    throw std::runtime_error("failed to describe render graph usage");
+}
+
+bool is_depth_format(VkFormat format)
+{
+    switch (format) {
+    case VK_FORMAT_D16_UNORM:
+    case VK_FORMAT_X8_D24_UNORM_PACK32:
+    case VK_FORMAT_D32_SFLOAT:
+    case VK_FORMAT_D16_UNORM_S8_UINT:
+    case VK_FORMAT_D24_UNORM_S8_UINT:
+    case VK_FORMAT_D32_SFLOAT_S8_UINT:
+        return true;
+    default:
+        return false;
+    }
+}
+
+VkImageAspectFlags barrier_aspect(VkFormat format)
+{
+    switch (format) {
+    case VK_FORMAT_D16_UNORM_S8_UINT:
+    case VK_FORMAT_D24_UNORM_S8_UINT:
+    case VK_FORMAT_D32_SFLOAT_S8_UINT:
+        return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+    default:
+        return is_depth_format(format) ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+    }
+}
+
+VkDeviceSize align_up(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+bool overlaps(VkDeviceSize a_offset, VkDeviceSize a_size, VkDeviceSize b_offset, VkDeviceSize b_size)
+{
+    return a_offset < b_offset + b_size && b_offset < a_offset + a_size;
+}
+} // namespace
+
+void bt_render_graph::pass_builder::read(bt_rg_resource resource, bt_rg_usage usage)
+{
+    graph.add_access(pass, resource, usage, true, false);
+}
+
+void bt_render_graph::pass_builder::write(bt_rg_resource resource, bt_rg_usage usage)
+{
+    if (info(usage).write_access == 0) {
+        throw std::runtime_error(fmt::format("failed to add render pass {}: {} cannot be written with this usage",
+            graph.passes[pass].name,
+            graph.resources[resource].name));
+    }
+    graph.add_access(pass, resource, usage, false, true);
+}
+
+void bt_render_graph::pass_builder::color_attachment(bt_rg_resource resource, std::optional<VkClearColorValue> clear)
+{
+    auto& p = graph.passes[pass];
+    if (p.colors.size() == MAX_COLOR_ATTACHMENTS) {
+        throw std::runtime_error(
+            fmt::format("failed to add render pass {}: more than {} color attachments", p.name, MAX_COLOR_ATTACHMENTS));
+    }
+
+    VkClearValue clear_value {};
+    if (clear) {
+        clear_value.color = *clear;
+    }
+    p.colors.push_back({ resource, clear.has_value(), clear_value });
+    graph.add_access(pass, resource, bt_rg_usage::color_attachment, !clear, true);
+}
+
+void bt_render_graph::pass_builder::depth_attachment(bt_rg_resource resource,
+    std::optional<VkClearDepthStencilValue> clear,
+    bool write)
+{
+    auto& p = graph.passes[pass];
+    if (p.depth) {
+        throw std::runtime_error(fmt::format("failed to add render pass {}: more than one depth attachment", p.name));
+    }
+
+    VkClearValue clear_value {};
+    if (clear) {
+        clear_value.depthStencil = *clear;
+    }
+    p.depth = attachment { resource, clear.has_value(), clear_value };
+    p.depth_write = write || clear;
+    graph.add_access(pass,
+        resource,
+        p.depth_write ? bt_rg_usage::depth_attachment : bt_rg_usage::depth_read,
+        !clear,
+        p.depth_write);
+}
+
+void bt_render_graph::pass_builder::side_effect()
+{
+    graph.passes[pass].side_effect = true;
+}
+
+bt_rg_memory_pool::bt_rg_memory_pool(bt_device& device) :
+    device { device }
+{
+}
+
+bt_rg_memory_pool::~bt_rg_memory_pool()
+{
+    for (auto& b : blocks) {
+        device.destroy_later(b.memory);
+    }
+}
+
+VkDeviceMemory bt_rg_memory_pool::acquire(uint32_t memory_type, uint32_t slot, VkDeviceSize size)
+{
+    auto it = std::find_if(blocks.begin(), blocks.end(), [&](const block& b) {
+        return b.memory_type == memory_type && b.slot == slot;
+    });
+    if (it != blocks.end() && it->size >= size) {
+        return it->memory;
+    }
+
+    if (it == blocks.end()) {
+        blocks.push_back({ memory_type, slot, 0, VK_NULL_HANDLE });
+        it = blocks.end() - 1;
+    } else {
+        device.destroy_later(it->memory);
+        it->memory = VK_NULL_HANDLE;
+    }
+
+    VkMemoryAllocateInfo alloc_info { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+    alloc_info.allocationSize = size;
+    alloc_info.memoryTypeIndex = memory_type;
+    if (vkAllocateMemory(device.device(), &alloc_info, device.allocator(), &it->memory) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate render graph memory");
+    }
+    it->size = size;
+    allocations_++;
+    return it->memory;
+}
+
+VkDeviceSize bt_rg_memory_pool::allocated_bytes() const
+{
+    VkDeviceSize total = 0;
+    for (const auto& b : blocks) {
+        total += b.size;
+    }
+    return total;
+}
+
+bt_render_graph::bt_render_graph(bt_device& device, bt_rg_memory_pool& memory_pool, uint32_t frame_count) :
+    device { &device },
+    memory_pool { &memory_pool },
+    frame_count { frame_count }
+{
+}
+
+bt_render_graph::~bt_render_graph()
+{
+    destroy();
+}
+
+bt_rg_resource bt_render_graph::create_image(std::string_view name, const bt_rg_image_desc& desc)
+{
+    assert(!planned && "cannot add resources to a planned render graph");
+
+    resource r;
+    r.name = name;
+    r.desc = desc;
+    resources.push_back(std::move(r));
+    return static_cast<bt_rg_resource>(resources.size() - 1);
+}
+
+bt_rg_resource bt_render_graph::import_image(std::string_view name,
+    const bt_rg_image_desc& desc,
+    VkImageLayout initial_layout,
+    VkImageLayout final_layout,
+    VkPipelineStageFlags initial_stages)
+{
+    bt_rg_resource id = create_image(name, desc);
+    auto& r = resources[id];
+    r.imported = true;
+    r.initial_layout = initial_layout;
+    r.final_layout = final_layout;
+    r.initial_stages = initial_stages;
+    r.images.resize(1, VK_NULL_HANDLE);
+    r.views.resize(1, VK_NULL_HANDLE);
+    r.recent_views.reserve(MAX_IMPORTED_VIEWS);
+    return id;
+}
+
+bt_rg_pass bt_render_graph::add_pass(std::string_view name, const setup_fn& setup, execute_fn execute)
+{
+    assert(!planned && "cannot add passes to a planned render graph");
+
+    pass p;
+    p.name = name;
+    p.execute = std::move(execute);
+    passes.push_back(std::move(p));
+
+    auto id = static_cast<bt_rg_pass>(passes.size() - 1);
+    pass_builder builder { *this, id };
+    setup(builder);
+    return id;
+}
+
+void bt_render_graph::add_access(bt_rg_pass pass, bt_rg_resource resource, bt_rg_usage usage, bool read, bool write)
+{
+    auto& p = passes[pass];
+    for (auto& a : p.accesses) {
+        if (a.resource != resource) {
+            continue;
+        }
+        // A pass sees one layout per image, so it can only combine usages that share it (e.g. storage reads and
+        // writes).
+        if (info(a.usage).layout != info(usage).layout) {
+            throw std::runtime_error(fmt::format("failed to add render pass {}: {} is used in two layouts",
+                p.name,
+                resources[resource].name));
+        }
+        a.read |= read;
+        a.write |= write;
+        return;
+    }
+    p.accesses.push_back({ resource, usage, read, write });
+}
+
+void bt_render_graph::plan(const requirements_fn& requirements)
+{
+    plan_passes();
+    place_memory(requirements);
+    place_barriers();
+}
+
+void bt_render_graph::compile()
+{
+    assert(device != nullptr && "a render graph without a device can only be planned");
+
+    plan_passes();
+    create_images();
+    place_memory([this](bt_rg_resource id) {
+        VkMemoryRequirements requirements;
+        vkGetImageMemoryRequirements(device->device(), resources[id].images[0], &requirements);
+        return requirements;
+    });
+    place_barriers();
+    allocate_memory();
+    create_views();
+    for (uint32_t i : order) {
+        if (!passes[i].colors.empty() || passes[i].depth) {
+            create_render_pass(passes[i]);
+        }
+    }
+
+    SPDLOG_DEBUG("render graph: {} passes, {} culled, {} barriers, {} transient images in {} KiB ({} KiB unaliased, "
+                 "{} KiB lazy) x {} frames; pool holds {} KiB after {} allocations",
+        stats_.passes,
+        stats_.culled_passes,
+        stats_.barriers,
+        stats_.transient_images,
+        stats_.transient_bytes / 1024,
+        stats_.unaliased_bytes / 1024,
+        stats_.lazy_bytes / 1024,
+        stats_.frame_count,
+        memory_pool->allocated_bytes() / 1024,
+        memory_pool->allocations());
+}
+
+void bt_render_graph::plan_passes()
+{
+    assert(!planned && "render graph already planned");
+    planned = true;
+
+    cull_passes();
+    compute_lifetimes();
+}
+
+void bt_render_graph::cull_passes()
+{
+    // Walking backwards, a pass is live if it writes something a later live pass or the outside world reads. Imported
+    // images are read by whoever owns them once the graph is done.
+    std::vector<bool> needed(resources.size());
+    for (size_t i = 0; i < resources.size(); i++) {
+        needed[i] = resources[i].imported;
+    }
+
+    for (size_t i = passes.size(); i-- > 0;) {
+        auto& p = passes[i];
+        p.alive = p.side_effect;
+        for (const auto& a : p.accesses) {
+            p.alive |= a.write && needed[a.resource];
+        }
+        if (!p.alive) {
+            continue;
+        }
+
+        // Writes that don't read the old contents end the need for whatever produced them.
+        for (const auto& a : p.accesses) {
+            if (a.write && !a.read) {
+                needed[a.resource] = false;
+            }
+        }
+        for (const auto& a : p.accesses) {
+            if (a.read) {
+                needed[a.resource] = true;
+            }
+        }
+    }
+
+    order.clear();
+    for (uint32_t i = 0; i < passes.size(); i++) {
+        if (passes[i].alive) {
+            passes[i].position = static_cast<uint32_t>(order.size());
+            order.push_back(i);
+        }
+    }
+
+    stats_.passes = static_cast<uint32_t>(order.size());
+    stats_.culled_passes = static_cast<uint32_t>(passes.size() - order.size());
+    stats_.frame_count = frame_count;
+}
+
+void bt_render_graph::compute_lifetimes()
+{
+    for (uint32_t position = 0; position < order.size(); position++) {
+        for (const auto& a : passes[order[position]].accesses) {
+            auto& r = resources[a.resource];
+            r.usage |= info(a.usage).image_usage;
+            r.first_use = std::min(r.first_use, position);
+            r.last_use = std::max(r.last_use, position);
+            if (a.read) {
+                r.last_read = std::max(r.last_read, position);
+                r.read = true;
+            }
+        }
+    }
+
+    // Contents that live and die inside one render pass never need to reach memory.
+    constexpr VkImageUsageFlags attachment_usage =
+        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    for (auto& r : resources) {
+        r.lazy = !r.imported && r.first_use != UINT32_MAX && r.first_use == r.last_use
+            && (r.usage & ~attachment_usage) == 0;
+        if (r.lazy) {
+            r.usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+        }
+    }
+}
+
+void bt_render_graph::place_memory(const requirements_fn& requirements)
+{
+    std::vector<bt_rg_resource> transients;
+    for (bt_rg_resource id = 0; id < resources.size(); id++) {
+        auto& r = resources[id];
+        if (!r.imported && r.first_use != UINT32_MAX) {
+            r.requirements = requirements(id);
+            transients.push_back(id);
+        }
+    }
+
+    // Largest first, each at the lowest offset that doesn't collide with an image live at the same time. Images only
+    // share memory with images of the same memory types.
+    std::sort(transients.begin(), transients.end(), [this](bt_rg_resource a, bt_rg_resource b) {
+        return resources[a].requirements.size > resources[b].requirements.size;
+    });
+
+    heaps.clear();
+    std::vector<bt_rg_resource> placed;
+    stats_.transient_images = static_cast<uint32_t>(transients.size());
+    stats_.transient_bytes = 0;
+    stats_.unaliased_bytes = 0;
+    for (bt_rg_resource id : transients) {
+        auto& r = resources[id];
+        auto heap_it = std::find_if(heaps.begin(), heaps.end(), [&](const heap& h) {
+            return h.memory_type_bits == r.requirements.memoryTypeBits && h.lazy == r.lazy;
+        });
+        if (heap_it == heaps.end()) {
+            heap h;
+            h.memory_type_bits = r.requirements.memoryTypeBits;
+            h.lazy = r.lazy;
+            heaps.push_back(std::move(h));
+            heap_it = heaps.end() - 1;
+        }
+        r.heap = static_cast<uint32_t>(heap_it - heaps.begin());
+
+        VkDeviceSize offset = 0;
+        for (bool moved = true; moved;) {
+            moved = false;
+            for (bt_rg_resource other_id : placed) {
+                const auto& other = resources[other_id];
+                bool live_together = r.first_use <= other.last_use && other.first_use <= r.last_use;
+                if (other.heap == r.heap && live_together
+                    && overlaps(offset, r.requirements.size, other.offset, other.requirements.size)) {
+                    offset = align_up(other.offset + other.requirements.size, r.requirements.alignment);
+                    moved = true;
+                }
+            }
+        }
+        r.offset = offset;
+        heap_it->size = std::max(heap_it->size, offset + r.requirements.size);
+        placed.push_back(id);
+        stats_.unaliased_bytes += r.requirements.size;
+    }
+
+    // The later of two images sharing memory starts from whatever the earlier one left there.
+    for (bt_rg_resource id : transients) {
+        for (bt_rg_resource other_id : transients) {
+            resources[id].aliased |= shares_memory(other_id, id);
+        }
+    }
+
+    stats_.lazy_bytes = 0;
+    for (const auto& h : heaps) {
+        stats_.transient_bytes += h.size;
+        stats_.lazy_bytes += h.lazy ? h.size : 0;
+    }
+}
+
+bool bt_render_graph::shares_memory(bt_rg_resource earlier, bt_rg_resource later) const
+{
+    const auto& e = resources[earlier];
+    const auto& l = resources[later];
+    return !e.imported && !l.imported && e.first_use != UINT32_MAX && l.first_use != UINT32_MAX && e.heap == l.heap
+        && e.last_use < l.first_use && overlaps(e.offset, e.requirements.size, l.offset, l.requirements.size);
+}
+
+void bt_render_graph::place_barriers()
+{
+    struct state {
+        VkImageLayout layout;
+        VkPipelineStageFlags stages = 0;
+        // Writes not yet made available, or zero if the last access was a read.
+        VkAccessFlags pending_writes = 0;
+        bool touched = false;
+    };
+
+    std::vector<state> states(resources.size());
+    for (size_t i = 0; i < resources.size(); i++) {
+        states[i].layout = resources[i].imported ? resources[i].initial_layout : VK_IMAGE_LAYOUT_UNDEFINED;
+    }
+
+    stats_.barriers = 0;
+    for (uint32_t i : order) {
+        auto& p = passes[i];
+        p.before = {};
+        for (const auto& a : p.accesses) {
+            const auto& r = resources[a.resource];
+            auto& s = states[a.resource];
+            usage_info u = info(a.usage);
+
+            // Reads after reads in the same layout need nothing; everything else waits for the previous accesses.
+            bool needed = s.layout != u.layout || s.pending_writes != 0 || a.write;
+            if (!s.touched) {
+                // First use in the frame. Transient images are discarded; memory shared with an earlier image must
+                // wait for all of its work and make its writes available. Imported images are synchronised by
+                // whoever hands them over, so only a layout change is needed, chained to the stages their owner
+                // waited at.
+                needed = r.imported ? s.layout != u.layout : true;
+                s.stages = r.aliased ? VK_PIPELINE_STAGE_ALL_COMMANDS_BIT
+                    : r.imported     ? r.initial_stages
+                                     : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+                if (r.aliased) {
+                    for (bt_rg_resource other_id = 0; other_id < resources.size(); other_id++) {
+                        if (shares_memory(other_id, a.resource)) {
+                            s.pending_writes |= states[other_id].pending_writes;
+                        }
+                    }
+                }
+                s.touched = true;
+            }
+
+            if (needed) {
+                p.before.barriers.push_back({ a.resource,
+                    s.layout,
+                    u.layout,
+                    s.pending_writes,
+                    (a.read ? u.read_access : 0) | (a.write ? u.write_access : 0) });
+                p.before.src_stages |= s.stages;
+                p.before.dst_stages |= u.stages;
+                s.layout = u.layout;
+                s.stages = u.stages;
+            } else {
+                s.stages |= u.stages;
+            }
+            s.pending_writes = a.write ? u.write_access : 0;
+        }
+        stats_.barriers += static_cast<uint32_t>(p.before.barriers.size());
+    }
+
+    after = {};
+    for (bt_rg_resource id = 0; id < resources.size(); id++) {
+        const auto& r = resources[id];
+        const auto& s = states[id];
+        if (!r.imported || !s.touched || r.final_layout == VK_IMAGE_LAYOUT_UNDEFINED) {
+            continue;
+        }
+        if (s.layout != r.final_layout || s.pending_writes != 0) {
+            after.barriers.push_back({ id, s.layout, r.final_layout, s.pending_writes, 0 });
+            after.src_stages |= s.stages;
+            after.dst_stages |= VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+        }
+    }
+    stats_.barriers += static_cast<uint32_t>(after.barriers.size());
+}
+
+void bt_render_graph::create_images()
+{
+    for (auto& r : resources) {
+        if (r.imported || r.first_use == UINT32_MAX) {
+            continue;
+        }
+
+        VkImageCreateInfo image_info { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
+        image_info.imageType = VK_IMAGE_TYPE_2D;
+        image_info.extent = { r.desc.extent.width, r.desc.extent.height, 1 };
+        image_info.mipLevels = 1;
+        image_info.arrayLayers = 1;
+        image_info.format = r.desc.format;
+        image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+        image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        image_info.usage = r.usage;
+        image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+        image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        r.images.resize(frame_count, VK_NULL_HANDLE);
+        for (auto& image : r.images) {
+            if (vkCreateImage(device->device(), &image_info, device->allocator(), &image) != VK_SUCCESS) {
+                throw std::runtime_error(fmt::format("failed to create render graph image {}", r.name));
+            }
+        }
+    }
+}
+
+void bt_render_graph::allocate_memory()
+{
+    // Pool slots are numbered per memory type, so heaps that end up in the same type don't share memory.
+    std::map<uint32_t, uint32_t> heaps_per_type;
+    for (auto& h : heaps) {
+        constexpr VkMemoryPropertyFlags lazy_properties =
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+        if (h.lazy && !device->has_memory_type(h.memory_type_bits, lazy_properties)) {
+            h.lazy = false;
+            stats_.lazy_bytes -= h.size;
+        }
+        uint32_t memory_type = device->find_memory_type(h.memory_type_bits,
+            h.lazy ? lazy_properties : VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        uint32_t first_slot = heaps_per_type[memory_type]++ * frame_count;
+        h.memory.resize(frame_count, VK_NULL_HANDLE);
+        for (uint32_t frame = 0; frame < frame_count; frame++) {
+            h.memory[frame] = memory_pool->acquire(memory_type, first_slot + frame, h.size);
+        }
+    }
+
+    for (auto& r : resources) {
+        for (uint32_t frame = 0; frame < r.images.size() && !r.imported; frame++) {
+            if (vkBindImageMemory(device->device(), r.images[frame], heaps[r.heap].memory[frame], r.offset)
+                != VK_SUCCESS) {
+                throw std::runtime_error(fmt::format("failed to bind render graph image {}", r.name));
+            }
+        }
+    }
+}
+
+void bt_render_graph::create_views()
+{
+    for (auto& r : resources) {
+        if (r.imported) {
+            continue;
+        }
+
+        r.views.resize(r.images.size(), VK_NULL_HANDLE);
+        for (size_t frame = 0; frame < r.images.size(); frame++) {
+            VkImageViewCreateInfo view_info { VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
+            view_info.image = r.images[frame];
+            view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+            view_info.format = r.desc.format;
+            view_info.subresourceRange.aspectMask =
+                is_depth_format(r.desc.format) ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+            view_info.subresourceRange.levelCount = 1;
+            view_info.subresourceRange.layerCount = 1;
+
+            if (vkCreateImageView(device->device(), &view_info, device->allocator(), &r.views[frame]) != VK_SUCCESS) {
+                throw std::runtime_error(fmt::format("failed to create render graph image view {}", r.name));
+            }
+        }
+    }
+}
+
+void bt_render_graph::create_render_pass(pass& p)
+{
+    std::vector<VkAttachmentDescription> descriptions;
+    std::vector<VkAttachmentReference> color_refs;
+    VkAttachmentReference depth_ref {};
+
+    auto describe = [&](const attachment& a, VkImageLayout layout) {
+        const auto& r = resources[a.resource];
+        if (descriptions.empty()) {
+            p.extent = r.desc.extent;
+        } else if (r.desc.extent.width != p.extent.width || r.desc.extent.height != p.extent.height) {
+            throw std::runtime_error(fmt::format("failed to create render pass {}: attachment extents differ", p.name));
+        }
+
+        // Nothing useful is in an image on its first use unless it came in with contents, and nothing needs its
+        // contents afterwards unless a later pass or the image's owner reads them.
+        bool undefined = r.first_use == p.position && (!r.imported || r.initial_layout == VK_IMAGE_LAYOUT_UNDEFINED);
+        bool stored = r.imported || (r.read && r.last_read > p.position);
+
+        VkAttachmentDescription description {};
+        description.format = r.desc.format;
+        description.samples = VK_SAMPLE_COUNT_1_BIT;
+        description.loadOp = a.clear ? VK_ATTACHMENT_LOAD_OP_CLEAR
+            : undefined              ? VK_ATTACHMENT_LOAD_OP_DONT_CARE
+                                     : VK_ATTACHMENT_LOAD_OP_LOAD;
+        description.storeOp = stored ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        description.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        description.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        // The graph's barriers move images into and out of the pass layout.
+        description.initialLayout = layout;
+        description.finalLayout = layout;
+        descriptions.push_back(description);
+        return VkAttachmentReference { static_cast<uint32_t>(descriptions.size() - 1), layout };
+    };
+
+    for (const auto& color : p.colors) {
+        color_refs.push_back(describe(color, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL));
+    }
+    if (p.depth) {
+        depth_ref = describe(*p.depth,
+            p.depth_write ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
+                          : VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL);
+    }
+    if (p.render_area.width == 0) {
+        p.render_area = p.extent;
+    }
+
+    VkSubpassDescription subpass {};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = static_cast<uint32_t>(color_refs.size());
+    subpass.pColorAttachments = color_refs.data();
+    subpass.pDepthStencilAttachment = p.depth ? &depth_ref : nullptr;
+
+    VkRenderPassCreateInfo render_pass_info { VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO };
+    render_pass_info.attachmentCount = static_cast<uint32_t>(descriptions.size());
+    render_pass_info.pAttachments = descriptions.data();
+    render_pass_info.subpassCount = 1;
+    render_pass_info.pSubpasses = &subpass;
+
+    if (vkCreateRenderPass(device->device(), &render_pass_info, device->allocator(), &p.render_pass) != VK_SUCCESS) {
+        throw std::runtime_error(fmt::format("failed to create render pass {}", p.name));
+    }
+}
+
+VkFramebuffer bt_render_graph::framebuffer(pass& p)
+{
+    std::array<VkImageView, MAX_COLOR_ATTACHMENTS + 1> views {};
+    uint32_t count = 0;
+    for (const auto& color : p.colors) {
+        views[count++] = view(color.resource);
+    }
+    if (p.depth) {
+        views[count++] = view(p.depth->resource);
+    }
+
+    auto it = p.framebuffers.find(views);
+    if (it != p.framebuffers.end()) {
+        return it->second;
+    }
+
+    VkFramebufferCreateInfo framebuffer_info { VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO };
+    framebuffer_info.renderPass = p.render_pass;
+    framebuffer_info.attachmentCount = count;
+    framebuffer_info.pAttachments = views.data();
+    framebuffer_info.width = p.extent.width;
+    framebuffer_info.height = p.extent.height;
+    framebuffer_info.layers = 1;
+
+    VkFramebuffer framebuffer;
+    if (vkCreateFramebuffer(device->device(), &framebuffer_info, device->allocator(), &framebuffer) != VK_SUCCESS) {
+        throw std::runtime_error(fmt::format("failed to create framebuffer for render pass {}", p.name));
+    }
+    p.framebuffers.emplace(views, framebuffer);
+    return framebuffer;
+}
+
+void bt_render_graph::set_render_area(bt_rg_pass pass, VkExtent2D extent)
+{
+    auto& p = passes[pass];
+    p.render_area = p.extent.width == 0
+        ? extent
+        : VkExtent2D { std::min(extent.width, p.extent.width), std::min(extent.height, p.extent.height) };
+}
+
+void bt_render_graph::set_imported(bt_rg_resource resource, VkImage image, VkImageView view)
+{
+    auto& r = resources[resource];
+    assert(r.imported && "only imported images can be rebound");
+    r.images[0] = image;
+    r.views[0] = view;
+
+    // Framebuffers are built on the views; once a view falls out of the recent ones, so do they.
+    auto recent = std::find(r.recent_views.begin(), r.recent_views.end(), view);
+    if (recent == r.recent_views.end()) {
+        if (r.recent_views.size() == MAX_IMPORTED_VIEWS) {
+            VkImageView oldest = r.recent_views.back();
+            r.recent_views.pop_back();
+            forget_view(oldest);
+        }
+        recent = r.recent_views.insert(r.recent_views.end(), view);
+    }
+    std::rotate(r.recent_views.begin(), recent, recent + 1);
+}
+
+void bt_render_graph::forget_view(VkImageView view)
+{
+    for (auto& p : passes) {
+        std::erase_if(p.framebuffers, [&](const auto& entry) {
+            const auto& [views, framebuffer] = entry;
+            if (std::find(views.begin(), views.end(), view) == views.end()) {
+                return false;
+            }
+            device->destroy_later(framebuffer);
+            return true;
+        });
+    }
+}
+
+VkImage bt_render_graph::image(bt_rg_resource resource) const
+{
+    const auto& r = resources[resource];
+    return r.imported ? r.images[0] : r.images[current_frame];
+}
+
+VkImageView bt_render_graph::view(bt_rg_resource resource) const
+{
+    const auto& r = resources[resource];
+    return r.imported ? r.views[0] : r.views[current_frame];
+}
+
+void bt_render_graph::execute(VkCommandBuffer command_buffer, uint32_t frame_index)
+{
+    assert(frame_index < frame_count);
+    current_frame = frame_index;
+
+    for (uint32_t i : order) {
+        auto& p = passes[i];
+        record_barriers(command_buffer, p.before);
+
+        if (p.render_pass == VK_NULL_HANDLE) {
+            p.execute(command_buffer);
+            continue;
+        }
+
+        clear_values.clear();
+        for (const auto& color : p.colors) {
+            clear_values.push_back(color.clear_value);
+        }
+        if (p.depth) {
+            clear_values.push_back(p.depth->clear_value);
+        }
+
+        VkRenderPassBeginInfo render_pass_info { VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
+        render_pass_info.renderPass = p.render_pass;
+        render_pass_info.framebuffer = framebuffer(p);
+        render_pass_info.renderArea.offset = { 0, 0 };
+        render_pass_info.renderArea.extent = p.render_area;
+        render_pass_info.clearValueCount = static_cast<uint32_t>(clear_values.size());
+        render_pass_info.pClearValues = clear_values.data();
+
+        vkCmdBeginRenderPass(command_buffer, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
+        p.execute(command_buffer);
+        vkCmdEndRenderPass(command_buffer);
+    }
+
+    record_barriers(command_buffer, after);
+}
+
+void bt_render_graph::record_barriers(VkCommandBuffer command_buffer, const barrier_batch& batch)
+{
+    if (batch.barriers.empty()) {
+        return;
+    }
+
+    image_barriers.clear();
+    for (const auto& b : batch.barriers) {
+        VkImageMemoryBarrier barrier { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+        barrier.srcAccessMask = b.src_access;
+        barrier.dstAccessMask = b.dst_access;
+        barrier.oldLayout = b.old_layout;
+        barrier.newLayout = b.new_layout;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image(b.resource);
+        barrier.subresourceRange = { barrier_aspect(resources[b.resource].desc.format), 0, 1, 0, 1 };
+        image_barriers.push_back(barrier);
+    }
+
+    vkCmdPipelineBarrier(command_buffer,
+        batch.src_stages,
+        batch.dst_stages,
+        0,
+        0,
+        nullptr,
+        0,
+        nullptr,
+        static_cast<uint32_t>(image_barriers.size()),
+        image_barriers.data());
+}
+
+void bt_render_graph::destroy()
+{
+    if (device == nullptr) {
+        return;
+    }
+
+    // Frames in flight may still be executing the graph, e.g. when it is rebuilt for a new swapchain.
+    for (auto& p : passes) {
+        for (auto& [views, framebuffer] : p.framebuffers) {
+            device->destroy_later(framebuffer);
+        }
+        device->destroy_later(p.render_pass);
+    }
+    for (auto& r : resources) {
+        if (r.imported) {
+            continue;
+        }
+        for (auto view : r.views) {
+            device->destroy_later(view);
+        }
+        for (auto image : r.images) {
+            device->destroy_later(image);
+        }
+    }
+}
+} // namespace bt
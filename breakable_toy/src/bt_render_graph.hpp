@@ -0,0 +1,289 @@
+#ifndef BT_RENDER_GRAPH_HPP
+#define BT_RENDER_GRAPH_HPP
+
+#include "bt_device.hpp"
+
+#include <glad/vulkan.h>
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace bt {
+using bt_rg_resource = uint32_t;
+using bt_rg_pass = uint32_t;
+
+// How a pass touches an image. Determines the layout the image is in during the pass and the stages and accesses
+// barriers around it synchronise with.
+enum class bt_rg_usage {
+    color_attachment,
+    depth_attachment,
+    depth_read,
+    sampled,
+    storage,
+    transfer_src,
+    transfer_dst,
+};
+
+struct bt_rg_image_desc {
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    VkExtent2D extent {};
+};
+
+struct bt_rg_stats {
+    uint32_t passes = 0;
+    uint32_t culled_passes = 0;
+    // Image barriers recorded per execution, including the final transitions of imported images.
+    uint32_t barriers = 0;
+    uint32_t transient_images = 0;
+    // Per frame in flight; every frame owns a copy of the transient images.
+    VkDeviceSize transient_bytes = 0;
+    VkDeviceSize unaliased_bytes = 0;
+    // Part of transient_bytes that is lazily allocated: attachments whose contents never leave their pass, which
+    // tile-based GPUs keep in tile memory without committing backing pages.
+    VkDeviceSize lazy_bytes = 0;
+    uint32_t frame_count = 0;
+};
+
+// Device memory for render graph transients that outlives the graphs placed in it, so a graph rebuilt after a resize
+// reuses the previous allocations unless it needs more. Serves one graph at a time.
+class bt_rg_memory_pool {
+  public:
+    explicit bt_rg_memory_pool(bt_device& device);
+    bt_rg_memory_pool(const bt_rg_memory_pool&) = delete;
+    ~bt_rg_memory_pool();
+
+    bt_rg_memory_pool& operator=(const bt_rg_memory_pool&) = delete;
+
+    // At least size bytes of memory_type for the given slot. The slot's previous memory, if too small, is replaced
+    // and freed through the device's deletion queue, as images in flight may still be bound to it.
+    VkDeviceMemory acquire(uint32_t memory_type, uint32_t slot, VkDeviceSize size);
+
+    VkDeviceSize allocated_bytes() const;
+    // vkAllocateMemory calls made so far.
+    uint32_t allocations() const { return allocations_; }
+
+  private:
+    struct block {
+        uint32_t memory_type;
+        uint32_t slot;
+        VkDeviceSize size;
+        VkDeviceMemory memory;
+    };
+
+    bt_device& device;
+    std::vector<block> blocks;
+    uint32_t allocations_ = 0;
+};
+
+// Describes a frame as passes that read and write named images, then records it with the barriers and layout
+// transitions the declared accesses need.
+//
+// Usage: create_image() and import_image() declare resources, add_pass() declares passes in submission order, and
+// compile() turns the description into Vulkan objects. Passes whose writes never reach an imported image or a pass
+// marked side_effect() are culled. Transient images are created by the graph, one copy per frame in flight, in memory
+// from a bt_rg_memory_pool; images whose lifetimes don't overlap share memory, and attachments used by a single pass
+// get lazily allocated memory where the device has it. Imported images (e.g. the swapchain image) are owned elsewhere
+// and rebound with set_imported() before each execute().
+//
+// Passes with attachments run inside a single-subpass render pass the graph creates; their load and store ops follow
+// from the graph (clear if asked, don't care for contents nothing produced or nothing reads). Other passes record
+// compute or transfer work directly.
+class bt_render_graph {
+  public:
+    using execute_fn = std::function<void(VkCommandBuffer)>;
+    // Size, alignment and memory types of a transient image, for plan() without a device.
+    using requirements_fn = std::function<VkMemoryRequirements(bt_rg_resource)>;
+
+    class pass_builder {
+      public:
+        void read(bt_rg_resource resource, bt_rg_usage usage);
+        void write(bt_rg_resource resource, bt_rg_usage usage);
+        // Attachments are bound in the order they are declared. Without a clear value the previous contents are
+        // loaded.
+        void color_attachment(bt_rg_resource resource, std::optional<VkClearColorValue> clear = std::nullopt);
+        void depth_attachment(bt_rg_resource resource,
+            std::optional<VkClearDepthStencilValue> clear = std::nullopt,
+            bool write = true);
+        // Keeps the pass even if nothing reads what it writes.
+        void side_effect();
+
+      private:
+        friend class bt_render_graph;
+
+        pass_builder(bt_render_graph& graph, bt_rg_pass pass) :
+            graph { graph },
+            pass { pass }
+        {
+        }
+
+        bt_render_graph& graph;
+        bt_rg_pass pass;
+    };
+
+    using setup_fn = std::function<void(pass_builder&)>;
+
+    static constexpr uint32_t MAX_COLOR_ATTACHMENTS = 8;
+    // Framebuffers are kept for this many recently bound views of each imported image, e.g. every swapchain image.
+    static constexpr uint32_t MAX_IMPORTED_VIEWS = 8;
+
+    // A graph without a device can only be planned; used to size frames offline.
+    bt_render_graph() = default;
+    bt_render_graph(bt_device& device, bt_rg_memory_pool& memory_pool, uint32_t frame_count);
+    bt_render_graph(const bt_render_graph&) = delete;
+    ~bt_render_graph();
+
+    bt_render_graph& operator=(const bt_render_graph&) = delete;
+
+    bt_rg_resource create_image(std::string_view name, const bt_rg_image_desc& desc);
+    // initial_layout is the layout the image is in when execute() starts (UNDEFINED discards its contents), and the
+    // graph leaves it in final_layout. initial_stages are the stages its owner already synchronised with whoever used
+    // it before, e.g. the stage a swapchain acquire semaphore is waited at; the first barrier chains from them.
+    bt_rg_resource import_image(std::string_view name,
+        const bt_rg_image_desc& desc,
+        VkImageLayout initial_layout,
+        VkImageLayout final_layout,
+        VkPipelineStageFlags initial_stages);
+    bt_rg_pass add_pass(std::string_view name, const setup_fn& setup, execute_fn execute);
+
+    // Culls passes, places barriers and lays out transient memory using the given requirements. compile() does this
+    // with the requirements of real images.
+    void plan(const requirements_fn& requirements);
+    void compile();
+
+    void set_imported(bt_rg_resource resource, VkImage image, VkImageView view);
+    // Limits a pass with attachments to the top-left part of them until changed; defaults to their full extent.
+    void set_render_area(bt_rg_pass pass, VkExtent2D extent);
+    void execute(VkCommandBuffer command_buffer, uint32_t frame_index);
+
+    // Valid after compile(); the render pass of a pass with attachments, for creating pipelines against.
+    VkRenderPass render_pass(bt_rg_pass pass) const { return passes[pass].render_pass; }
+    // The image of a resource in the frame being executed; for pass callbacks.
+    VkImage image(bt_rg_resource resource) const;
+    VkImageView view(bt_rg_resource resource) const;
+    bool culled(bt_rg_pass pass) const { return !passes[pass].alive; }
+    const bt_rg_stats& stats() const { return stats_; }
+
+  private:
+    struct resource {
+        std::string name;
+        bt_rg_image_desc desc;
+        bool imported = false;
+        VkImageLayout initial_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkImageLayout final_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkPipelineStageFlags initial_stages = 0;
+        VkImageUsageFlags usage = 0;
+        // Positions of live passes, in submission order, that access the resource.
+        uint32_t first_use = UINT32_MAX;
+        uint32_t last_use = 0;
+        bool read = false;
+        uint32_t last_read = 0;
+        // Transient memory placement, the same in every frame's allocation.
+        VkMemoryRequirements requirements {};
+        uint32_t heap = 0;
+        VkDeviceSize offset = 0;
+        // Its memory was used by another image earlier in the frame.
+        bool aliased = false;
+        // Only ever an attachment of a single pass.
+        bool lazy = false;
+        // Transient images have one per frame in flight, imported ones the currently bound image.
+        std::vector<VkImage> images;
+        std::vector<VkImageView> views;
+        // Imported only; views passed to set_imported(), most recent first.
+        std::vector<VkImageView> recent_views;
+    };
+
+    struct access {
+        bt_rg_resource resource;
+        bt_rg_usage usage;
+        // Whether the pass depends on the previous contents and whether it changes them.
+        bool read;
+        bool write;
+    };
+
+    struct attachment {
+        bt_rg_resource resource;
+        bool clear;
+        VkClearValue clear_value;
+    };
+
+    struct barrier {
+        bt_rg_resource resource;
+        VkImageLayout old_layout;
+        VkImageLayout new_layout;
+        VkAccessFlags src_access;
+        VkAccessFlags dst_access;
+    };
+
+    struct barrier_batch {
+        std::vector<barrier> barriers;
+        VkPipelineStageFlags src_stages = 0;
+        VkPipelineStageFlags dst_stages = 0;
+    };
+
+    struct pass {
+        std::string name;
+        std::vector<access> accesses;
+        std::vector<attachment> colors;
+        std::optional<attachment> depth;
+        bool depth_write = false;
+        bool side_effect = false;
+        execute_fn execute;
+        bool alive = false;
+        uint32_t position = 0;
+        barrier_batch before;
+        VkRenderPass render_pass = VK_NULL_HANDLE;
+        VkExtent2D extent {};
+        VkExtent2D render_area {};
+        // Keyed by attachment views in binding order, the rest null; they differ per frame and per imported image.
+        std::map<std::array<VkImageView, MAX_COLOR_ATTACHMENTS + 1>, VkFramebuffer> framebuffers;
+    };
+
+    // Memory shared by the transient images of one set of compatible memory types; one allocation per frame.
+    struct heap {
+        uint32_t memory_type_bits = 0;
+        bool lazy = false;
+        VkDeviceSize size = 0;
+        std::vector<VkDeviceMemory> memory;
+    };
+
+    void add_access(bt_rg_pass pass, bt_rg_resource resource, bt_rg_usage usage, bool read, bool write);
+    void plan_passes();
+    void cull_passes();
+    void compute_lifetimes();
+    // Whether two transient images use overlapping memory, the earlier one finishing before the later one starts.
+    bool shares_memory(bt_rg_resource earlier, bt_rg_resource later) const;
+    void place_barriers();
+    void place_memory(const requirements_fn& requirements);
+    void create_images();
+    void allocate_memory();
+    void create_views();
+    void create_render_pass(pass& p);
+    VkFramebuffer framebuffer(pass& p);
+    void record_barriers(VkCommandBuffer command_buffer, const barrier_batch& batch);
+    void forget_view(VkImageView view);
+    void destroy();
+
+    bt_device* device = nullptr;
+    bt_rg_memory_pool* memory_pool = nullptr;
+    uint32_t frame_count = 1;
+    uint32_t current_frame = 0;
+    std::vector<resource> resources;
+    std::vector<pass> passes;
+    std::vector<uint32_t> order;
+    std::vector<heap> heaps;
+    barrier_batch after;
+    // Scratch for execute(), kept to avoid allocating every frame.
+    std::vector<VkClearValue> clear_values;
+    std::vector<VkImageMemoryBarrier> image_barriers;
+    bool planned = false;
+    bt_rg_stats stats_;
+};
+} // namespace bt
+
+#endif // BT_RENDER_GRAPH_HPP
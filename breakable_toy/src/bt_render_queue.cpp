@@ -0,0 +1,64 @@
+#include "bt_render_queue.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+
+namespace bt {
+uint64_t bt_draw_key::encode(uint32_t pass, uint32_t pipeline, uint32_t descriptor_set, uint32_t mesh, float depth)
+{
+    assert(pass < (1u << PASS_BITS) && "pass id out of range for draw key");
+    assert(pipeline < (1u << PIPELINE_BITS) && "pipeline id out of range for draw key");
+    assert(descriptor_set < (1u << DESCRIPTOR_SET_BITS) && "descriptor set id out of range for draw key");
+    assert(mesh < (1u << MESH_BITS) && "mesh id out of range for draw key");
+
+    constexpr uint32_t max_depth = (1u << DEPTH_BITS) - 1;
+    auto quantised_depth = static_cast<uint32_t>(std::clamp(depth, 0.0f, 1.0f) * static_cast<float>(max_depth));
+
+    uint64_t key = pass;
+    key = (key << PIPELINE_BITS) | pipeline;
+    key = (key << DESCRIPTOR_SET_BITS) | descriptor_set;
+    key = (key << MESH_BITS) | mesh;
+    key = (key << DEPTH_BITS) | quantised_depth;
+    return key;
+}
+
+bt_render_queue::bt_render_queue(unsigned sort_threads) :
+    sorter { sort_threads }
+{
+}
+
+void bt_render_queue::clear()
+{
+    entries.clear();
+    push_data.clear();
+    items.clear();
+    stats_ = {};
+}
+
+void bt_render_queue::push(const bt_draw& draw, const void* data, uint32_t push_size)
+{
+    auto offset = static_cast<uint32_t>(push_data.size());
+    if (push_size > 0) {
+        push_data.resize(push_data.size() + push_size);
+        memcpy(push_data.data() + offset, data, push_size);
+    }
+
+    // Pipeline and mesh ids may be resource handles, whose low bits are the pool slot index; grouping by those is
+    // enough, and replay compares the full ids before eliding a bind.
+    constexpr uint32_t pipeline_mask = (1u << bt_draw_key::PIPELINE_BITS) - 1;
+    constexpr uint32_t mesh_mask = (1u << bt_draw_key::MESH_BITS) - 1;
+    auto key = bt_draw_key::encode(
+        draw.pass, draw.pipeline & pipeline_mask, draw.descriptor_set, draw.mesh & mesh_mask, draw.depth);
+    items.push_back({ key, static_cast<uint32_t>(entries.size()) });
+    entries.push_back({ draw, offset, push_size });
+}
+
+void bt_render_queue::sort()
+{
+    auto start = std::chrono::steady_clock::now();
+    sorter.sort(items);
+    stats_.sort_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+} // namespace bt
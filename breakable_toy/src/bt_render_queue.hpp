@@ -0,0 +1,143 @@
+#ifndef BT_RENDER_QUEUE_HPP
+#define BT_RENDER_QUEUE_HPP
+
+#include "bt_sort.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace bt {
+// Draw sort key, most significant field first: pass | pipeline | descriptor set | mesh | depth. Sorting by it groups
+// draws by state so that consecutive draws can share binds, and orders them front to back within a group.
+struct bt_draw_key {
+    static constexpr int PASS_BITS = 4;
+    static constexpr int PIPELINE_BITS = 12;
+    static constexpr int DESCRIPTOR_SET_BITS = 12;
+    static constexpr int MESH_BITS = 16;
+    static constexpr int DEPTH_BITS = 20;
+
+    static uint64_t encode(uint32_t pass, uint32_t pipeline, uint32_t descriptor_set, uint32_t mesh, float depth);
+};
+
+struct bt_draw {
+    uint32_t pass = 0;
+    // Pipeline and mesh may be bt_handle values; see bt_render_queue::push.
+    uint32_t pipeline = 0;
+    uint32_t descriptor_set = 0;
+    uint32_t mesh = 0;
+    uint32_t lod = 0;
+    // Normalised view depth in [0, 1].
+    float depth = 0.0f;
+    // Not used by the queue; passed through to the recorder, e.g. to find per-draw data on the GPU.
+    uint32_t slot = UINT32_MAX;
+};
+
+// Bind counts are of the last replay: replays of the same sorted draws bind alike, so summing them over a frame's
+// phases and viewports would only multiply them.
+struct bt_render_queue_stats {
+    uint32_t replays = 0;
+    uint32_t draws = 0;
+    uint32_t pipeline_binds = 0;
+    uint32_t pipeline_binds_elided = 0;
+    uint32_t descriptor_set_binds = 0;
+    uint32_t descriptor_set_binds_elided = 0;
+    uint32_t mesh_binds = 0;
+    uint32_t mesh_binds_elided = 0;
+    double sort_ms = 0.0;
+};
+
+// Collects a frame's draws, sorts them by bt_draw_key and replays them through a recorder, skipping binds of state
+// that is already bound. The recorder provides:
+//
+//     void bind_pipeline(uint32_t pipeline);
+//     void bind_descriptor_set(uint32_t descriptor_set);
+//     void bind_mesh(uint32_t mesh);
+//     void draw(const bt_draw& draw, const void* push_data, uint32_t push_size);
+class bt_render_queue {
+  public:
+    explicit bt_render_queue(unsigned sort_threads = std::thread::hardware_concurrency());
+    bt_render_queue(const bt_render_queue&) = delete;
+    ~bt_render_queue() = default;
+
+    bt_render_queue& operator=(const bt_render_queue&) = delete;
+
+    void clear();
+    void push(const bt_draw& draw, const void* push_data = nullptr, uint32_t push_size = 0);
+    void sort();
+
+    template <typename Recorder>
+    void replay(Recorder& recorder);
+
+    size_t size() const { return entries.size(); }
+    const bt_render_queue_stats& stats() const { return stats_; }
+
+  private:
+    struct entry {
+        bt_draw draw;
+        uint32_t push_offset;
+        uint32_t push_size;
+    };
+
+    static constexpr uint32_t UNBOUND = UINT32_MAX;
+
+    bt_radix_sorter sorter;
+    std::vector<entry> entries;
+    std::vector<std::byte> push_data;
+    std::vector<bt_sort_item> items;
+    bt_render_queue_stats stats_;
+};
+
+template <typename Recorder>
+void bt_render_queue::replay(Recorder& recorder)
+{
+    uint32_t bound_pipeline = UNBOUND;
+    uint32_t bound_descriptor_set = UNBOUND;
+    uint32_t bound_mesh = UNBOUND;
+
+    stats_.replays++;
+    stats_.draws = 0;
+    stats_.pipeline_binds = 0;
+    stats_.pipeline_binds_elided = 0;
+    stats_.descriptor_set_binds = 0;
+    stats_.descriptor_set_binds_elided = 0;
+    stats_.mesh_binds = 0;
+    stats_.mesh_binds_elided = 0;
+
+    for (const auto& item : items) {
+        const auto& e = entries[item.index];
+
+        if (e.draw.pipeline != bound_pipeline) {
+            recorder.bind_pipeline(e.draw.pipeline);
+            bound_pipeline = e.draw.pipeline;
+            // A new pipeline may use a different layout, which invalidates the bound descriptor sets.
+            bound_descriptor_set = UNBOUND;
+            stats_.pipeline_binds++;
+        } else {
+            stats_.pipeline_binds_elided++;
+        }
+
+        if (e.draw.descriptor_set != bound_descriptor_set) {
+            recorder.bind_descriptor_set(e.draw.descriptor_set);
+            bound_descriptor_set = e.draw.descriptor_set;
+            stats_.descriptor_set_binds++;
+        } else {
+            stats_.descriptor_set_binds_elided++;
+        }
+
+        if (e.draw.mesh != bound_mesh) {
+            recorder.bind_mesh(e.draw.mesh);
+            bound_mesh = e.draw.mesh;
+            stats_.mesh_binds++;
+        } else {
+            stats_.mesh_binds_elided++;
+        }
+
+        recorder.draw(e.draw, e.push_size > 0 ? push_data.data() + e.push_offset : nullptr, e.push_size);
+        stats_.draws++;
+    }
+}
+} // namespace bt
+
+#endif // BT_RENDER_QUEUE_HPP
@@ -0,0 +1,185 @@
+#ifndef BT_RESOURCE_POOL_HPP
+#define BT_RESOURCE_POOL_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+namespace bt {
+// 32-bit reference to an object in a bt_resource_pool<T>: a slot index and the generation the slot had when the
+// object was created. Freeing a slot bumps its generation, so handles to the old object are detectably stale instead of
+// silently resolving to whatever reuses the slot. Generations start at 1, so the zero handle is never valid.
+template <typename T>
+class bt_handle {
+  public:
+    static constexpr uint32_t INDEX_BITS = 20;
+    static constexpr uint32_t GENERATION_BITS = 32 - INDEX_BITS;
+    static constexpr uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
+    static constexpr uint32_t GENERATION_MASK = (1u << GENERATION_BITS) - 1;
+
+    constexpr bt_handle() = default;
+    constexpr explicit bt_handle(uint32_t value) :
+        value_ { value }
+    {
+    }
+    constexpr bt_handle(uint32_t index, uint32_t generation) :
+        value_ { (generation & GENERATION_MASK) << INDEX_BITS | (index & INDEX_MASK) }
+    {
+    }
+
+    constexpr uint32_t index() const { return value_ & INDEX_MASK; }
+    constexpr uint32_t generation() const { return value_ >> INDEX_BITS; }
+    constexpr uint32_t value() const { return value_; }
+    constexpr bool is_null() const { return value_ == 0; }
+
+    constexpr bool operator==(const bt_handle&) const = default;
+
+  private:
+    uint32_t value_ = 0;
+};
+
+// Fixed-capacity pool of T in one contiguous slot array. Creating and destroying are O(1) through a free list of
+// slots, objects never move, and iterating walks the array in order. Resolving a stale or null handle asserts, so
+// debug builds catch use after destroy; valid() checks without asserting. Not synchronised: handles can be passed
+// between threads, but the pool must only be accessed by one at a time.
+template <typename T>
+class bt_resource_pool {
+  public:
+    using handle = bt_handle<T>;
+
+    static constexpr uint32_t MAX_CAPACITY = handle::INDEX_MASK + 1;
+
+    explicit bt_resource_pool(uint32_t capacity) :
+        slots { std::make_unique<slot[]>(capacity) },
+        capacity_ { capacity }
+    {
+        if (capacity > MAX_CAPACITY) {
+            throw std::runtime_error("failed to create resource pool: capacity exceeds handle index range");
+        }
+    }
+
+    bt_resource_pool(const bt_resource_pool&) = delete;
+    bt_resource_pool& operator=(const bt_resource_pool&) = delete;
+
+    ~bt_resource_pool() { clear(); }
+
+    template <typename... Args>
+    handle create(Args&&... args)
+    {
+        uint32_t index = free_head;
+        if (index != NONE) {
+            free_head = slots[index].next_free;
+        } else if (used < capacity_) {
+            index = used++;
+        } else {
+            throw std::runtime_error("failed to create resource: pool is full");
+        }
+
+        slot& s = slots[index];
+        try {
+            ::new (static_cast<void*>(s.storage)) T(std::forward<Args>(args)...);
+        } catch (...) {
+            s.next_free = free_head;
+            free_head = index;
+            throw;
+        }
+        s.alive = true;
+        size_++;
+        return handle { index, s.generation };
+    }
+
+    void destroy(handle h)
+    {
+        assert(valid(h) && "destroying a stale or null resource handle");
+        slot& s = slots[h.index()];
+        s.object()->~T();
+        s.alive = false;
+        s.generation = next_generation(s.generation);
+        s.next_free = free_head;
+        free_head = h.index();
+        size_--;
+    }
+
+    // Destroys every object; all outstanding handles become stale.
+    void clear()
+    {
+        for (uint32_t i = 0; i < used; i++) {
+            if (slots[i].alive) {
+                destroy(handle { i, slots[i].generation });
+            }
+        }
+    }
+
+    bool valid(handle h) const
+    {
+        if (h.is_null() || h.index() >= used) {
+            return false;
+        }
+        const slot& s = slots[h.index()];
+        return s.alive && s.generation == h.generation();
+    }
+
+    T& get(handle h)
+    {
+        assert(valid(h) && "resolving a stale or null resource handle");
+        return *slots[h.index()].object();
+    }
+
+    const T& get(handle h) const
+    {
+        assert(valid(h) && "resolving a stale or null resource handle");
+        return *slots[h.index()].object();
+    }
+
+    // For handles that may legitimately have gone stale, e.g. ones held by another system.
+    T* try_get(handle h) { return valid(h) ? slots[h.index()].object() : nullptr; }
+
+    // Calls f(handle, T&) for every live object in slot order.
+    template <typename F>
+    void for_each(F&& f)
+    {
+        for (uint32_t i = 0; i < used; i++) {
+            slot& s = slots[i];
+            if (s.alive) {
+                f(handle { i, s.generation }, *s.object());
+            }
+        }
+    }
+
+    uint32_t size() const { return size_; }
+    uint32_t capacity() const { return capacity_; }
+
+  private:
+    static constexpr uint32_t NONE = ~0u;
+
+    struct slot {
+        alignas(T) std::byte storage[sizeof(T)];
+        uint32_t generation = 1;
+        uint32_t next_free = NONE;
+        bool alive = false;
+
+        T* object() { return std::launder(reinterpret_cast<T*>(storage)); }
+        const T* object() const { return std::launder(reinterpret_cast<const T*>(storage)); }
+    };
+
+    static uint32_t next_generation(uint32_t generation)
+    {
+        // Skip 0 when wrapping so no live handle is ever null.
+        uint32_t next = (generation + 1) & handle::GENERATION_MASK;
+        return next == 0 ? 1 : next;
+    }
+
+    std::unique_ptr<slot[]> slots;
+    uint32_t capacity_;
+    // Slots below this have been handed out at least once; the rest have never been touched.
+    uint32_t used = 0;
+    uint32_t free_head = NONE;
+    uint32_t size_ = 0;
+};
+} // namespace bt
+
+#endif // BT_RESOURCE_POOL_HPP
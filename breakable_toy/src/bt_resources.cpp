@@ -0,0 +1,86 @@
+#include "bt_resources.hpp"
+
+namespace bt {
+bt_resources::bt_resources(bt_device& device, const bt_resource_capacities& capacities) :
+    device { device },
+    meshes { capacities.meshes },
+    pipelines { capacities.pipelines },
+    compute_pipelines { capacities.compute_pipelines },
+    buffers { capacities.buffers },
+    images { capacities.images }
+{
+}
+
+bt_resources::~bt_resources()
+{
+    // Meshes and pipelines queue their own Vulkan objects when destroyed; buffers and images are plain handles.
+    buffers.for_each([&](bt_buffer_handle, bt_buffer& buffer) {
+        device.destroy_later(buffer.buffer);
+        device.destroy_later(buffer.memory);
+    });
+    images.for_each([&](bt_image_handle, bt_image& image) {
+        device.destroy_later(image.image);
+        device.destroy_later(image.memory);
+    });
+}
+
+bt_mesh_handle bt_resources::create_mesh(const bt_model::builder& builder)
+{
+    return meshes.create(device, builder);
+}
+
+bt_pipeline_handle bt_resources::create_pipeline(std::string_view vert_filepath,
+    std::string_view frag_filepath,
+    const bt_pipeline_config_info& config_info)
+{
+    return pipelines.create(device, vert_filepath, frag_filepath, config_info);
+}
+
+bt_pipeline_handle bt_resources::create_pipeline(const std::vector<char>& vert_code,
+    const std::vector<char>& frag_code,
+    const bt_pipeline_config_info& config_info)
+{
+    return pipelines.create(device, vert_code, frag_code, config_info);
+}
+
+bt_compute_pipeline_handle bt_resources::create_compute_pipeline(std::string_view comp_filepath,
+    VkPipelineLayout pipeline_layout,
+    const VkSpecializationInfo* specialization)
+{
+    return compute_pipelines.create(device, comp_filepath, pipeline_layout, specialization);
+}
+
+bt_buffer_handle bt_resources::create_buffer(
+    VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties)
+{
+    bt_buffer buffer {};
+    buffer.size = size;
+    device.create_buffer(size, usage, properties, buffer.buffer, buffer.memory);
+    return buffers.create(buffer);
+}
+
+bt_image_handle bt_resources::create_image(const VkImageCreateInfo& image_info, VkMemoryPropertyFlags properties)
+{
+    bt_image image {};
+    image.format = image_info.format;
+    image.extent = image_info.extent;
+    device.create_image_with_info(image_info, properties, image.image, image.memory);
+    return images.create(image);
+}
+
+void bt_resources::destroy(bt_buffer_handle handle)
+{
+    const auto& buffer = buffers.get(handle);
+    device.destroy_later(buffer.buffer);
+    device.destroy_later(buffer.memory);
+    buffers.destroy(handle);
+}
+
+void bt_resources::destroy(bt_image_handle handle)
+{
+    const auto& image = images.get(handle);
+    device.destroy_later(image.image);
+    device.destroy_later(image.memory);
+    images.destroy(handle);
+}
+} // namespace bt
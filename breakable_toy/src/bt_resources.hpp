@@ -0,0 +1,95 @@
+#ifndef BT_RESOURCES_HPP
+#define BT_RESOURCES_HPP
+
+#include "bt_device.hpp"
+#include "bt_model.hpp"
+#include "bt_pipeline.hpp"
+#include "bt_resource_pool.hpp"
+
+#include <glad/vulkan.h>
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace bt {
+struct bt_buffer {
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize size = 0;
+};
+
+struct bt_image {
+    VkImage image = VK_NULL_HANDLE;
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    VkExtent3D extent {};
+};
+
+using bt_mesh_handle = bt_handle<bt_model>;
+using bt_pipeline_handle = bt_handle<bt_pipeline>;
+using bt_compute_pipeline_handle = bt_handle<bt_compute_pipeline>;
+using bt_buffer_handle = bt_handle<bt_buffer>;
+using bt_image_handle = bt_handle<bt_image>;
+
+struct bt_resource_capacities {
+    uint32_t meshes = 1024;
+    uint32_t pipelines = 256;
+    uint32_t compute_pipelines = 64;
+    uint32_t buffers = 4096;
+    uint32_t images = 4096;
+};
+
+// Owns the renderer's meshes, pipelines, buffers and images in one pool per type. Everything else refers to them by
+// handle, so a system that outlives a resource finds a stale handle rather than a dangling pointer. Destroyed
+// resources' Vulkan objects go through the device's deletion queue, as frames in flight may still use them.
+class bt_resources {
+  public:
+    explicit bt_resources(bt_device& device, const bt_resource_capacities& capacities = {});
+    bt_resources(const bt_resources&) = delete;
+    ~bt_resources();
+
+    bt_resources& operator=(const bt_resources&) = delete;
+
+    bt_mesh_handle create_mesh(const bt_model::builder& builder);
+    bt_pipeline_handle create_pipeline(std::string_view vert_filepath,
+        std::string_view frag_filepath,
+        const bt_pipeline_config_info& config_info);
+    bt_pipeline_handle create_pipeline(const std::vector<char>& vert_code,
+        const std::vector<char>& frag_code,
+        const bt_pipeline_config_info& config_info);
+    bt_compute_pipeline_handle create_compute_pipeline(std::string_view comp_filepath,
+        VkPipelineLayout pipeline_layout,
+        const VkSpecializationInfo* specialization = nullptr);
+    bt_buffer_handle create_buffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties);
+    bt_image_handle create_image(const VkImageCreateInfo& image_info, VkMemoryPropertyFlags properties);
+
+    void destroy(bt_mesh_handle mesh) { meshes.destroy(mesh); }
+    void destroy(bt_pipeline_handle pipeline) { pipelines.destroy(pipeline); }
+    void destroy(bt_compute_pipeline_handle pipeline) { compute_pipelines.destroy(pipeline); }
+    void destroy(bt_buffer_handle buffer);
+    void destroy(bt_image_handle image);
+
+    bt_model& mesh(bt_mesh_handle mesh) { return meshes.get(mesh); }
+    bt_pipeline& pipeline(bt_pipeline_handle pipeline) { return pipelines.get(pipeline); }
+    bt_compute_pipeline& pipeline(bt_compute_pipeline_handle pipeline) { return compute_pipelines.get(pipeline); }
+    const bt_buffer& buffer(bt_buffer_handle buffer) const { return buffers.get(buffer); }
+    const bt_image& image(bt_image_handle image) const { return images.get(image); }
+
+    bool valid(bt_mesh_handle mesh) const { return meshes.valid(mesh); }
+    bool valid(bt_pipeline_handle pipeline) const { return pipelines.valid(pipeline); }
+    bool valid(bt_compute_pipeline_handle pipeline) const { return compute_pipelines.valid(pipeline); }
+    bool valid(bt_buffer_handle buffer) const { return buffers.valid(buffer); }
+    bool valid(bt_image_handle image) const { return images.valid(image); }
+
+  private:
+    bt_device& device;
+    bt_resource_pool<bt_model> meshes;
+    bt_resource_pool<bt_pipeline> pipelines;
+    bt_resource_pool<bt_compute_pipeline> compute_pipelines;
+    bt_resource_pool<bt_buffer> buffers;
+    bt_resource_pool<bt_image> images;
+};
+} // namespace bt
+
+#endif // BT_RESOURCES_HPP
@@ -0,0 +1,284 @@
+#include "bt_simplify.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <queue>
+#include <unordered_map>
+
+namespace bt {
+namespace {
+// Boundary edges get a constraint plane perpendicular to the surface so open borders keep their outline.
+constexpr double BOUNDARY_WEIGHT = 10.0;
+
+struct quadric {
+    double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+    double a11 = 0, a12 = 0, a13 = 0;
+    double a22 = 0, a23 = 0;
+    double a33 = 0;
+
+    void add_plane(double a, double b, double c, double d, double weight)
+    {
+        a00 += weight * a * a;
+        a01 += weight * a * b;
+        a02 += weight * a * c;
+        a03 += weight * a * d;
+        a11 += weight * b * b;
+        a12 += weight * b * c;
+        a13 += weight * b * d;
+        a22 += weight * c * c;
+        a23 += weight * c * d;
+        a33 += weight * d * d;
+    }
+
+    quadric& operator+=(const quadric& q)
+    {
+        a00 += q.a00;
+        a01 += q.a01;
+        a02 += q.a02;
+        a03 += q.a03;
+        a11 += q.a11;
+        a12 += q.a12;
+        a13 += q.a13;
+        a22 += q.a22;
+        a23 += q.a23;
+        a33 += q.a33;
+        return *this;
+    }
+
+    double evaluate(const glm::vec3& p) const
+    {
+        double x = p.x, y = p.y, z = p.z;
+        double error = a00 * x * x + 2 * a01 * x * y + 2 * a02 * x * z + 2 * a03 * x + a11 * y * y + 2 * a12 * y * z
+            + 2 * a13 * y + a22 * z * z + 2 * a23 * z + a33;
+        return std::max(error, 0.0);
+    }
+};
+
+struct collapse {
+    double cost;
+    uint32_t from;
+    uint32_t to;
+    uint32_t from_version;
+    uint32_t to_version;
+
+    bool operator>(const collapse& other) const { return cost > other.cost; }
+};
+
+uint64_t edge_key(uint32_t a, uint32_t b)
+{
+    return a < b ? (static_cast<uint64_t>(a) << 32) | b : (static_cast<uint64_t>(b) << 32) | a;
+}
+
+glm::vec3 triangle_normal(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+{
+    return glm::cross(b - a, c - a);
+}
+} // namespace
+
+bt_mesh_simplifier::result bt_mesh_simplifier::simplify(
+    const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, size_t target_index_count)
+{
+    assert(indices.size() % 3 == 0 && "index count must be a multiple of 3");
+
+    size_t vertex_count = positions.size();
+    size_t triangle_count = indices.size() / 3;
+
+    std::vector<uint32_t> triangles = indices;
+    std::vector<bool> triangle_alive(triangle_count, true);
+    std::vector<std::vector<uint32_t>> vertex_triangles(vertex_count);
+    std::vector<quadric> quadrics(vertex_count);
+    std::unordered_map<uint64_t, uint32_t> edge_use;
+
+    for (uint32_t t = 0; t < triangle_count; t++) {
+        uint32_t i0 = triangles[t * 3 + 0], i1 = triangles[t * 3 + 1], i2 = triangles[t * 3 + 2];
+        glm::vec3 normal = triangle_normal(positions[i0], positions[i1], positions[i2]);
+        float length = glm::length(normal);
+        if (length > 0.0f) {
+            normal = normal / length;
+            double d = -glm::dot(normal, positions[i0]);
+            for (uint32_t v : { i0, i1, i2 }) {
+                quadrics[v].add_plane(normal.x, normal.y, normal.z, d, 1.0);
+            }
+        }
+
+        for (uint32_t v : { i0, i1, i2 }) {
+            vertex_triangles[v].push_back(t);
+        }
+
+        edge_use[edge_key(i0, i1)]++;
+        edge_use[edge_key(i1, i2)]++;
+        edge_use[edge_key(i2, i0)]++;
+    }
+
+    for (uint32_t t = 0; t < triangle_count; t++) {
+        const uint32_t* tri = &triangles[t * 3];
+        glm::vec3 normal = triangle_normal(positions[tri[0]], positions[tri[1]], positions[tri[2]]);
+        for (int e = 0; e < 3; e++) {
+            uint32_t a = tri[e], b = tri[(e + 1) % 3];
+            if (edge_use[edge_key(a, b)] != 1) {
+                continue;
+            }
+
+            glm::vec3 edge = positions[b] - positions[a];
+            glm::vec3 plane_normal = glm::cross(edge, normal);
+            float length = glm::length(plane_normal);
+            if (length == 0.0f) {
+                continue;
+            }
+
+            plane_normal = plane_normal / length;
+            double d = -glm::dot(plane_normal, positions[a]);
+            quadrics[a].add_plane(plane_normal.x, plane_normal.y, plane_normal.z, d, BOUNDARY_WEIGHT);
+            quadrics[b].add_plane(plane_normal.x, plane_normal.y, plane_normal.z, d, BOUNDARY_WEIGHT);
+        }
+    }
+
+    std::vector<uint32_t> version(vertex_count, 0);
+    std::vector<bool> removed(vertex_count, false);
+    std::priority_queue<collapse, std::vector<collapse>, std::greater<>> queue;
+
+    auto push_candidate = [&](uint32_t from, uint32_t to) {
+        quadric q = quadrics[from];
+        q += quadrics[to];
+        queue.push({ q.evaluate(positions[to]), from, to, version[from], version[to] });
+    };
+
+    for (const auto& [key, uses] : edge_use) {
+        auto a = static_cast<uint32_t>(key >> 32);
+        auto b = static_cast<uint32_t>(key & 0xffffffffu);
+        push_candidate(a, b);
+        push_candidate(b, a);
+    }
+
+    size_t alive_count = triangle_count;
+    double max_cost = 0.0;
+    std::vector<uint32_t> neighbours;
+
+    while (alive_count * 3 > target_index_count && !queue.empty()) {
+        collapse c = queue.top();
+        queue.pop();
+
+        if (removed[c.from] || removed[c.to] || version[c.from] != c.from_version || version[c.to] != c.to_version) {
+            continue;
+        }
+
+        // Reject collapses that would flip a surviving triangle.
+        bool flips = false;
+        for (uint32_t t : vertex_triangles[c.from]) {
+            if (!triangle_alive[t]) {
+                continue;
+            }
+
+            const uint32_t* tri = &triangles[t * 3];
+            if (tri[0] == c.to || tri[1] == c.to || tri[2] == c.to) {
+                continue;
+            }
+
+            glm::vec3 before = triangle_normal(positions[tri[0]], positions[tri[1]], positions[tri[2]]);
+            glm::vec3 corners[3] = { positions[tri[0]], positions[tri[1]], positions[tri[2]] };
+            for (int k = 0; k < 3; k++) {
+                if (tri[k] == c.from) {
+                    corners[k] = positions[c.to];
+                }
+            }
+            glm::vec3 after = triangle_normal(corners[0], corners[1], corners[2]);
+            if (glm::dot(before, after) <= 0.0f) {
+                flips = true;
+                break;
+            }
+        }
+
+        if (flips) {
+            continue;
+        }
+
+        for (uint32_t t : vertex_triangles[c.from]) {
+            if (!triangle_alive[t]) {
+                continue;
+            }
+
+            uint32_t* tri = &triangles[t * 3];
+            if (tri[0] == c.to || tri[1] == c.to || tri[2] == c.to) {
+                triangle_alive[t] = false;
+                alive_count--;
+                continue;
+            }
+
+            for (int k = 0; k < 3; k++) {
+                if (tri[k] == c.from) {
+                    tri[k] = c.to;
+                }
+            }
+            vertex_triangles[c.to].push_back(t);
+        }
+
+        removed[c.from] = true;
+        vertex_triangles[c.from].clear();
+        quadrics[c.to] += quadrics[c.from];
+        version[c.to]++;
+        max_cost = std::max(max_cost, c.cost);
+
+        neighbours.clear();
+        std::erase_if(vertex_triangles[c.to], [&](uint32_t t) { return !triangle_alive[t]; });
+        for (uint32_t t : vertex_triangles[c.to]) {
+            for (int k = 0; k < 3; k++) {
+                uint32_t v = triangles[t * 3 + k];
+                if (v != c.to) {
+                    neighbours.push_back(v);
+                }
+            }
+        }
+        std::sort(neighbours.begin(), neighbours.end());
+        neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+
+        for (uint32_t n : neighbours) {
+            push_candidate(n, c.to);
+            push_candidate(c.to, n);
+        }
+    }
+
+    result simplified;
+    simplified.indices.reserve(alive_count * 3);
+    for (uint32_t t = 0; t < triangle_count; t++) {
+        if (triangle_alive[t]) {
+            simplified.indices.insert(simplified.indices.end(), &triangles[t * 3], &triangles[t * 3] + 3);
+        }
+    }
+    simplified.error = static_cast<float>(std::sqrt(max_cost));
+
+    return simplified;
+}
+
+std::vector<bt_lod> bt_mesh_simplifier::generate_lods(
+    const std::vector<glm::vec3>& positions, std::vector<uint32_t>& indices, size_t max_lods, float reduction)
+{
+    std::vector<bt_lod> lods;
+    lods.push_back({ 0, static_cast<uint32_t>(indices.size()), 0.0f });
+
+    std::vector<uint32_t> base(indices);
+    while (lods.size() < max_lods) {
+        size_t previous_count = lods.back().index_count;
+        size_t target = static_cast<size_t>(static_cast<float>(previous_count / 3) * reduction) * 3;
+        if (target < 3) {
+            break;
+        }
+
+        auto simplified = simplify(positions, base, target);
+
+        // Stop once collapses are mostly being rejected; further levels would be near duplicates.
+        if (simplified.indices.empty() || simplified.indices.size() * 20 > previous_count * 19) {
+            break;
+        }
+
+        bt_lod lod;
+        lod.first_index = static_cast<uint32_t>(indices.size());
+        lod.index_count = static_cast<uint32_t>(simplified.indices.size());
+        lod.error = std::max(simplified.error, lods.back().error);
+        indices.insert(indices.end(), simplified.indices.begin(), simplified.indices.end());
+        lods.push_back(lod);
+    }
+
+    return lods;
+}
+} // namespace bt
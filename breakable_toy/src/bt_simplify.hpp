@@ -0,0 +1,35 @@
+#ifndef BT_SIMPLIFY_HPP
+#define BT_SIMPLIFY_HPP
+
+#include "bt_lod.hpp"
+#include "bt_maths.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace bt {
+// Quadric error metric (Garland & Heckbert) mesh simplification. Edges are collapsed onto one of their end points
+// rather than an optimal position so that every level of detail indexes into the base mesh's vertex buffer.
+class bt_mesh_simplifier {
+  public:
+    struct result {
+        std::vector<uint32_t> indices;
+        float error = 0.0f;
+    };
+
+    static result simplify(
+        const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, size_t target_index_count);
+
+    // Builds a chain of levels of detail, each with roughly `reduction` times the triangles of the previous level,
+    // stopping after `max_lods` levels or when simplification stalls. The base mesh is level 0. The index data for
+    // every level is appended to `indices` and described by the returned levels.
+    static std::vector<bt_lod> generate_lods(const std::vector<glm::vec3>& positions,
+        std::vector<uint32_t>& indices,
+        size_t max_lods,
+        float reduction = 0.5f);
+
+    bt_mesh_simplifier() = delete;
+};
+} // namespace bt
+
+#endif // BT_SIMPLIFY_HPP
@@ -0,0 +1,132 @@
+#include "bt_simulation.hpp"
+
+#include "bt_logger.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace bt {
+void bt_jitter_tracker::tick(std::chrono::steady_clock::time_point now)
+{
+    if (started) {
+        add(std::chrono::duration<double, std::milli>(now - last).count());
+    }
+    started = true;
+    last = now;
+}
+
+void bt_jitter_tracker::add(double interval_ms)
+{
+    samples++;
+    double delta = interval_ms - mean;
+    mean += delta / static_cast<double>(samples);
+    m2 += delta * (interval_ms - mean);
+    min = samples == 1 ? interval_ms : std::min(min, interval_ms);
+    max = samples == 1 ? interval_ms : std::max(max, interval_ms);
+}
+
+void bt_jitter_tracker::reset()
+{
+    // Keep the last tick so the next interval is still measured.
+    samples = 0;
+    mean = 0.0;
+    m2 = 0.0;
+    min = 0.0;
+    max = 0.0;
+}
+
+bt_jitter_stats bt_jitter_tracker::stats() const
+{
+    bt_jitter_stats stats;
+    stats.samples = samples;
+    stats.mean_ms = mean;
+    stats.stddev_ms = samples > 1 ? std::sqrt(m2 / static_cast<double>(samples - 1)) : 0.0;
+    stats.min_ms = min;
+    stats.max_ms = max;
+    return stats;
+}
+
+bt_fixed_step_loop::bt_fixed_step_loop(step_fn step, const bt_fixed_step_config& config) :
+    step { std::move(step) },
+    config { config },
+    dt_ { 1.0 / config.rate_hz },
+    start { std::chrono::steady_clock::now() }
+{
+    worker = std::thread { &bt_fixed_step_loop::run, this };
+}
+
+bt_fixed_step_loop::~bt_fixed_step_loop()
+{
+    stopping.store(true);
+    worker.join();
+}
+
+double bt_fixed_step_loop::now() const
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+bt_fixed_step_stats bt_fixed_step_loop::stats() const
+{
+    std::lock_guard lock { stats_mutex };
+    auto stats = stats_;
+    stats.interval = intervals.stats();
+    return stats;
+}
+
+void bt_fixed_step_loop::reset_stats()
+{
+    std::lock_guard lock { stats_mutex };
+    intervals.reset();
+    stats_.max_late_ms = 0.0;
+}
+
+void bt_fixed_step_loop::run()
+{
+    using clock = std::chrono::steady_clock;
+    auto period = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(dt_));
+    auto spin = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double, std::milli>(config.spin_ms));
+
+    uint64_t next_step = 0;
+    while (!stopping.load()) {
+        auto scheduled = start + period * static_cast<int64_t>(next_step);
+        if (clock::now() < scheduled - spin) {
+            std::this_thread::sleep_until(scheduled - spin);
+        }
+        while (clock::now() < scheduled) {
+            std::this_thread::yield();
+        }
+
+        auto now = clock::now();
+        auto behind = static_cast<uint64_t>((now - scheduled) / period);
+        uint64_t dropped = 0;
+        if (behind > config.max_catch_up) {
+            dropped = behind;
+            SPDLOG_TRACE("fixed step loop: {} steps behind, dropping them", behind);
+        }
+
+        {
+            std::lock_guard lock { stats_mutex };
+            intervals.tick(now);
+            stats_.max_late_ms =
+                std::max(stats_.max_late_ms, std::chrono::duration<double, std::milli>(now - scheduled).count());
+            stats_.steps++;
+            stats_.dropped_steps += dropped;
+        }
+
+        // Dropped steps are never run, so the simulation's state pauses while its clock stays in step with now().
+        next_step += dropped;
+        step(next_step, static_cast<double>(next_step) * dt_, dt_);
+        next_step++;
+    }
+}
+
+float bt_interpolation_alpha(double previous, double current, double time)
+{
+    if (current <= previous) {
+        return 1.0f;
+    }
+
+    return static_cast<float>(std::clamp((time - previous) / (current - previous), 0.0, 1.0));
+}
+} // namespace bt
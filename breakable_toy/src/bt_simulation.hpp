@@ -0,0 +1,101 @@
+#ifndef BT_SIMULATION_HPP
+#define BT_SIMULATION_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace bt {
+struct bt_jitter_stats {
+    uint64_t samples = 0;
+    double mean_ms = 0.0;
+    // Standard deviation of the interval; the jitter.
+    double stddev_ms = 0.0;
+    double min_ms = 0.0;
+    double max_ms = 0.0;
+};
+
+// Accumulates the intervals between successive ticks of a loop.
+class bt_jitter_tracker {
+  public:
+    void tick(std::chrono::steady_clock::time_point now);
+    // Adds an interval directly, for loops that are not timed by the wall clock.
+    void add(double interval_ms);
+    void reset();
+
+    bt_jitter_stats stats() const;
+
+  private:
+    std::chrono::steady_clock::time_point last {};
+    bool started = false;
+    uint64_t samples = 0;
+    // Running mean and sum of squared deviations (Welford).
+    double mean = 0.0;
+    double m2 = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+};
+
+struct bt_fixed_step_config {
+    double rate_hz = 120.0;
+    // Once the loop is further behind than this many steps it drops them instead of running them back to back, so a
+    // long stall (a breakpoint, a suspended laptop) is not followed by a burst of catch-up steps.
+    uint32_t max_catch_up = 5;
+    // The last part of each wait is spent yielding instead of sleeping, as sleeps overshoot by up to a scheduler
+    // quantum.
+    double spin_ms = 0.5;
+};
+
+struct bt_fixed_step_stats {
+    uint64_t steps = 0;
+    uint64_t dropped_steps = 0;
+    // Intervals between steps; ideally all 1000 / rate_hz.
+    bt_jitter_stats interval;
+    // How late the worst step started since the last reset, relative to its schedule.
+    double max_late_ms = 0.0;
+};
+
+// Runs `step` at a fixed rate on its own thread, starting on construction and stopping on destruction. Step n is
+// scheduled at n * dt seconds after start and receives n and that time, so results don't depend on when the thread
+// actually got to run; indices of dropped steps are skipped.
+class bt_fixed_step_loop {
+  public:
+    using step_fn = std::function<void(uint64_t step, double time, double dt)>;
+
+    bt_fixed_step_loop(step_fn step, const bt_fixed_step_config& config = bt_fixed_step_config {});
+    bt_fixed_step_loop(const bt_fixed_step_loop&) = delete;
+    ~bt_fixed_step_loop();
+
+    bt_fixed_step_loop& operator=(const bt_fixed_step_loop&) = delete;
+
+    double dt() const { return dt_; }
+    // Seconds since the loop started, on the same timeline as the steps' times.
+    double now() const;
+
+    // Safe to call from any thread. Reset clears the interval and lateness measurements.
+    bt_fixed_step_stats stats() const;
+    void reset_stats();
+
+  private:
+    void run();
+
+    step_fn step;
+    bt_fixed_step_config config;
+    double dt_;
+    std::chrono::steady_clock::time_point start;
+    mutable std::mutex stats_mutex;
+    bt_fixed_step_stats stats_;
+    bt_jitter_tracker intervals;
+    std::atomic<bool> stopping = false;
+    std::thread worker;
+};
+
+// Where `time` lies between two snapshots taken at `previous` and `current`, clamped to [0, 1]. Renderers draw one
+// step behind the simulation's clock so they always have a later snapshot to interpolate towards.
+float bt_interpolation_alpha(double previous, double current, double time);
+} // namespace bt
+
+#endif // BT_SIMULATION_HPP
@@ -0,0 +1,161 @@
+#include "bt_sort.hpp"
+
+#include <algorithm>
+
+namespace bt {
+namespace {
+// Below this many items per thread handing chunks to the workers costs more than it saves.
+constexpr size_t MIN_ITEMS_PER_THREAD = 16 * 1024;
+
+inline uint32_t digit(uint64_t key, int pass)
+{
+    return static_cast<uint32_t>(key >> (pass * bt_radix_sorter::RADIX_BITS)) & (bt_radix_sorter::BUCKETS - 1);
+}
+
+std::array<bool, bt_radix_sorter::PASSES> find_passes(const std::vector<bt_sort_item>& items)
+{
+    // A byte only needs sorting if it differs between items.
+    uint64_t differing = 0;
+    uint64_t first = items.front().key;
+    for (const auto& item : items) {
+        differing |= item.key ^ first;
+    }
+
+    std::array<bool, bt_radix_sorter::PASSES> needed {};
+    for (int pass = 0; pass < bt_radix_sorter::PASSES; pass++) {
+        needed[pass] = digit(differing, pass) != 0;
+    }
+    return needed;
+}
+} // namespace
+
+bt_radix_sorter::bt_radix_sorter(unsigned thread_count) :
+    histograms(std::max(thread_count, 1u))
+{
+    workers.reserve(histograms.size() - 1);
+    for (size_t thread = 1; thread < histograms.size(); thread++) {
+        workers.emplace_back([this, thread] { run_worker(thread); });
+    }
+}
+
+bt_radix_sorter::~bt_radix_sorter()
+{
+    {
+        std::lock_guard lock { mutex };
+        stopping = true;
+    }
+    wake.notify_all();
+}
+
+void bt_radix_sorter::sort(std::vector<bt_sort_item>& items)
+{
+    count = items.size();
+    if (count < 2) {
+        return;
+    }
+
+    scratch.resize(count);
+    passes = find_passes(items);
+    threads = std::clamp<size_t>(count / MIN_ITEMS_PER_THREAD, 1, histograms.size());
+    source = items.data();
+    destination = scratch.data();
+
+    if (threads == 1) {
+        sort_chunk(0);
+    } else {
+        {
+            std::lock_guard lock { mutex };
+            finished = 0;
+            sorts++;
+        }
+        wake.notify_all();
+        sort_chunk(0);
+
+        std::unique_lock lock { mutex };
+        done.wait(lock, [&] { return finished == workers.size(); });
+    }
+
+    if (source != items.data()) {
+        items.swap(scratch);
+    }
+}
+
+void bt_radix_sorter::run_worker(size_t thread)
+{
+    uint64_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock lock { mutex };
+            wake.wait(lock, [&] { return stopping || sorts != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = sorts;
+        }
+
+        if (thread < threads) {
+            sort_chunk(thread);
+        }
+
+        {
+            std::lock_guard lock { mutex };
+            finished++;
+        }
+        done.notify_one();
+    }
+}
+
+template <typename Complete>
+void bt_radix_sorter::sync(Complete&& complete)
+{
+    if (threads == 1) {
+        complete();
+        return;
+    }
+
+    uint32_t phase = generation.load(std::memory_order_acquire);
+    if (arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == threads) {
+        complete();
+        arrived.store(0, std::memory_order_relaxed);
+        generation.fetch_add(1, std::memory_order_release);
+        generation.notify_all();
+    } else {
+        generation.wait(phase, std::memory_order_acquire);
+    }
+}
+
+void bt_radix_sorter::sort_chunk(size_t thread)
+{
+    size_t begin = count * thread / threads;
+    size_t end = count * (thread + 1) / threads;
+    auto& h = histograms[thread];
+
+    for (int pass = 0; pass < PASSES; pass++) {
+        if (!passes[pass]) {
+            continue;
+        }
+
+        h.fill(0);
+        for (size_t i = begin; i < end; i++) {
+            h[digit(source[i].key, pass)]++;
+        }
+        sync([&] {
+            // Exclusive prefix sum over (bucket, thread) so each thread scatters into its own slice of every bucket,
+            // which keeps the sort stable.
+            size_t offset = 0;
+            for (int bucket = 0; bucket < BUCKETS; bucket++) {
+                for (size_t t = 0; t < threads; t++) {
+                    size_t bucket_count = histograms[t][bucket];
+                    histograms[t][bucket] = offset;
+                    offset += bucket_count;
+                }
+            }
+        });
+
+        for (size_t i = begin; i < end; i++) {
+            destination[h[digit(source[i].key, pass)]++] = source[i];
+        }
+        sync([&] { std::swap(source, destination); });
+    }
+}
+} // namespace bt
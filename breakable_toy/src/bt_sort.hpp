@@ -0,0 +1,67 @@
+#ifndef BT_SORT_HPP
+#define BT_SORT_HPP
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace bt {
+struct bt_sort_item {
+    uint64_t key;
+    uint32_t index;
+};
+
+// Stable LSD radix sort on the 64-bit key, one byte per pass. Passes whose byte is identical for every item are
+// skipped, so keys that only use a few fields cost proportionally less. Large inputs are split across up to
+// `thread_count` threads, which are started once and wait between sorts; the histograms and scratch buffer are kept
+// too, so sorting allocates only when the input outgrows every earlier one. One sort at a time.
+class bt_radix_sorter {
+  public:
+    static constexpr int RADIX_BITS = 8;
+    static constexpr int BUCKETS = 1 << RADIX_BITS;
+    static constexpr int PASSES = 64 / RADIX_BITS;
+
+    explicit bt_radix_sorter(unsigned thread_count = 1);
+    bt_radix_sorter(const bt_radix_sorter&) = delete;
+    ~bt_radix_sorter();
+
+    bt_radix_sorter& operator=(const bt_radix_sorter&) = delete;
+
+    void sort(std::vector<bt_sort_item>& items);
+
+  private:
+    void run_worker(size_t thread);
+    void sort_chunk(size_t thread);
+    // Waits for every thread of the sort; the last to arrive runs complete() before releasing the others.
+    template <typename Complete>
+    void sync(Complete&& complete);
+
+    std::vector<bt_sort_item> scratch;
+    std::vector<std::array<size_t, BUCKETS>> histograms;
+
+    // The sort in progress; written before workers are woken.
+    bt_sort_item* source = nullptr;
+    bt_sort_item* destination = nullptr;
+    size_t count = 0;
+    size_t threads = 1;
+    std::array<bool, PASSES> passes {};
+
+    std::atomic<uint32_t> arrived = 0;
+    std::atomic<uint32_t> generation = 0;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    uint64_t sorts = 0;
+    size_t finished = 0;
+    bool stopping = false;
+    std::vector<std::jthread> workers;
+};
+} // namespace bt
+
+#endif // BT_SORT_HPP
@@ -0,0 +1,63 @@
+#ifndef BT_SPSC_QUEUE_HPP
+#define BT_SPSC_QUEUE_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace bt {
+// Bounded single producer, single consumer queue of trivially copyable values. Neither side locks or waits: push
+// fails when the queue is full and pop fails when it is empty. Each side caches the other's position and only reloads
+// it when the cached one says there is no room or nothing to read, so the shared cache lines are rarely touched.
+template <typename T, size_t Capacity>
+class bt_spsc_queue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+  public:
+    bt_spsc_queue() = default;
+    bt_spsc_queue(const bt_spsc_queue&) = delete;
+    bt_spsc_queue& operator=(const bt_spsc_queue&) = delete;
+
+    // Producer side.
+    bool push(const T& value)
+    {
+        uint64_t write = write_pos.load(std::memory_order_relaxed);
+        if (write - cached_read_pos == Capacity) {
+            cached_read_pos = read_pos.load(std::memory_order_acquire);
+            if (write - cached_read_pos == Capacity) {
+                return false;
+            }
+        }
+
+        slots[write & (Capacity - 1)] = value;
+        write_pos.store(write + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side.
+    bool pop(T& value)
+    {
+        uint64_t read = read_pos.load(std::memory_order_relaxed);
+        if (read == cached_write_pos) {
+            cached_write_pos = write_pos.load(std::memory_order_acquire);
+            if (read == cached_write_pos) {
+                return false;
+            }
+        }
+
+        value = slots[read & (Capacity - 1)];
+        read_pos.store(read + 1, std::memory_order_release);
+        return true;
+    }
+
+  private:
+    std::array<T, Capacity> slots {};
+    alignas(64) std::atomic<uint64_t> write_pos = 0;
+    uint64_t cached_read_pos = 0;
+    alignas(64) std::atomic<uint64_t> read_pos = 0;
+    uint64_t cached_write_pos = 0;
+};
+} // namespace bt
+
+#endif // BT_SPSC_QUEUE_HPP
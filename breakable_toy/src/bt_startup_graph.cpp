@@ -0,0 +1,153 @@
+#include "bt_startup_graph.hpp"
+
+#include "bt_logger.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+
+namespace bt {
+bt_startup_graph::step_id bt_startup_graph::add(std::string name,
+    std::vector<step_id> dependencies,
+    std::function<void()> work)
+{
+    auto id = static_cast<step_id>(steps.size());
+    for (auto dependency : dependencies) {
+        assert(dependency < id && "startup step depends on a step not added yet");
+        steps[dependency].dependents.push_back(id);
+    }
+    steps.push_back({ std::move(name), std::move(dependencies), {}, std::move(work) });
+    return id;
+}
+
+void bt_startup_graph::run(uint32_t thread_count)
+{
+    using clock = std::chrono::steady_clock;
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<step_id> ready;
+    std::vector<size_t> waiting_on(steps.size());
+    uint32_t running = 0;
+    std::exception_ptr error;
+
+    for (step_id id = 0; id < steps.size(); id++) {
+        waiting_on[id] = steps[id].dependencies.size();
+        if (waiting_on[id] == 0) {
+            ready.push_back(id);
+        }
+    }
+
+    trace_.clear();
+    auto start = clock::now();
+    auto ms_since_start = [&](clock::time_point time) {
+        return std::chrono::duration<double, std::milli>(time - start).count();
+    };
+
+    // Each thread takes ready steps until none are ready and none are running, when no more can become ready.
+    auto work = [&](uint32_t thread) {
+        std::unique_lock lock { mutex };
+        while (true) {
+            changed.wait(lock, [&] { return !ready.empty() || running == 0; });
+            if (ready.empty()) {
+                changed.notify_all();
+                return;
+            }
+
+            auto id = ready.front();
+            ready.pop_front();
+            running++;
+            lock.unlock();
+
+            auto step_start = clock::now();
+            std::exception_ptr step_error;
+            try {
+                steps[id].work();
+            } catch (...) {
+                step_error = std::current_exception();
+            }
+            auto step_end = clock::now();
+
+            lock.lock();
+            running--;
+            steps[id].duration_ms = std::chrono::duration<double, std::milli>(step_end - step_start).count();
+            trace_.push_back({ steps[id].name, ms_since_start(step_start), steps[id].duration_ms, thread });
+            if (step_error && !error) {
+                error = step_error;
+            }
+            if (error) {
+                ready.clear();
+            } else {
+                for (auto dependent : steps[id].dependents) {
+                    if (--waiting_on[dependent] == 0) {
+                        ready.push_back(dependent);
+                    }
+                }
+            }
+            changed.notify_all();
+        }
+    };
+
+    threads_used_ = std::clamp(thread_count, 1u, std::max(static_cast<uint32_t>(steps.size()), 1u));
+    std::vector<std::thread> threads;
+    for (uint32_t thread = 1; thread < threads_used_; thread++) {
+        threads.emplace_back(work, thread);
+    }
+    work(0);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    wall_ms_ = ms_since_start(clock::now());
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+double bt_startup_graph::serial_ms() const
+{
+    double total = 0.0;
+    for (const auto& s : steps) {
+        total += s.duration_ms;
+    }
+    return total;
+}
+
+double bt_startup_graph::critical_path_ms() const
+{
+    // Dependencies always come first, so one pass in order finds when each step could finish at the earliest.
+    std::vector<double> finish(steps.size());
+    double longest = 0.0;
+    for (size_t id = 0; id < steps.size(); id++) {
+        double ready = 0.0;
+        for (auto dependency : steps[id].dependencies) {
+            ready = std::max(ready, finish[dependency]);
+        }
+        finish[id] = ready + steps[id].duration_ms;
+        longest = std::max(longest, finish[id]);
+    }
+    return longest;
+}
+
+void bt_startup_graph::log_trace() const
+{
+    auto by_start = trace_;
+    std::sort(by_start.begin(), by_start.end(), [](const auto& a, const auto& b) { return a.start_ms < b.start_ms; });
+    for (const auto& s : by_start) {
+        SPDLOG_INFO("startup: {:<20} {:8.2f} ms, from {:8.2f} ms on thread {}",
+            s.name,
+            s.duration_ms,
+            s.start_ms,
+            s.thread);
+    }
+    SPDLOG_INFO("startup: {:.2f} ms on {} threads; steps take {:.2f} ms one after another, critical path {:.2f} ms",
+        wall_ms_,
+        threads_used_,
+        serial_ms(),
+        critical_path_ms());
+}
+} // namespace bt
@@ -0,0 +1,71 @@
+#ifndef BT_STARTUP_GRAPH_HPP
+#define BT_STARTUP_GRAPH_HPP
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace bt {
+struct bt_startup_step {
+    std::string name;
+    // Relative to the start of run().
+    double start_ms = 0.0;
+    double duration_ms = 0.0;
+    // 0 is the thread that called run().
+    uint32_t thread = 0;
+};
+
+// Initialisation steps and what each needs done first. run() starts every step as soon as its dependencies have
+// finished, on a few threads, so independent work such as reading shaders, building meshes and creating swapchains
+// overlaps. Each step's wall time is traced, to see what startup waits on.
+//
+// Steps that run concurrently must not touch the same state unless it is thread safe: separate resource pools,
+// separate viewports, and Vulkan calls that create objects are fine; recording through the device's command pool or
+// submitting to its queues is not.
+class bt_startup_graph {
+  public:
+    using step_id = uint32_t;
+
+    bt_startup_graph() = default;
+    bt_startup_graph(const bt_startup_graph&) = delete;
+    ~bt_startup_graph() = default;
+
+    bt_startup_graph& operator=(const bt_startup_graph&) = delete;
+
+    // Dependencies must have been added before, so the graph cannot have cycles.
+    step_id add(std::string name, std::vector<step_id> dependencies, std::function<void()> work);
+
+    // Runs every step on up to thread_count threads, including the calling one. If a step throws, steps not started
+    // yet are skipped and the exception is rethrown once those running have finished.
+    void run(uint32_t thread_count = std::thread::hardware_concurrency());
+
+    // Steps in the order they finished.
+    const std::vector<bt_startup_step>& trace() const { return trace_; }
+    double wall_ms() const { return wall_ms_; }
+    // What running the steps one after another would take.
+    double serial_ms() const;
+    // The longest chain of dependent steps, which no number of threads gets startup below.
+    double critical_path_ms() const;
+    uint32_t threads_used() const { return threads_used_; }
+
+    void log_trace() const;
+
+  private:
+    struct step {
+        std::string name;
+        std::vector<step_id> dependencies;
+        std::vector<step_id> dependents;
+        std::function<void()> work;
+        double duration_ms = 0.0;
+    };
+
+    std::vector<step> steps;
+    std::vector<bt_startup_step> trace_;
+    double wall_ms_ = 0.0;
+    uint32_t threads_used_ = 0;
+};
+} // namespace bt
+
+#endif // BT_STARTUP_GRAPH_HPP
@@ -10,25 +10,35 @@
 #include <vector>
 
 namespace bt {
+// Images of one window surface. Frame pacing and submission live in bt_presenter, which can drive several swapchains
+// at once; a swapchain only has a semaphore per frame in flight for its acquires.
 class bt_swapchain {
   public:
     static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
 
-    bt_swapchain(bt_device& device, VkExtent2D window_extent);
-    bt_swapchain(bt_device& device, VkExtent2D window_extent, std::shared_ptr<bt_swapchain> previous);
+    bt_swapchain(bt_device& device, VkSurfaceKHR surface, VkExtent2D window_extent);
+    // Replaces previous without waiting for frames in flight, which keep presenting from it until it is retired.
+    // previous hands its objects to the device's deletion queue when destroyed.
+    bt_swapchain(
+        bt_device& device, VkSurfaceKHR surface, VkExtent2D window_extent, std::shared_ptr<bt_swapchain> previous);
     ~bt_swapchain();
 
     bt_swapchain(const bt_swapchain&) = delete;
     bt_swapchain& operator=(const bt_swapchain&) = delete;
 
-    VkFramebuffer framebuffer(int index) { return swapchain_framebuffers[index]; }
-    VkRenderPass render_pass() { return render_pass_; }
+    VkImage image(int index) { return swapchain_images[index]; }
     VkImageView image_view(int index) { return swapchain_image_views[index]; }
     size_t image_count() { return swapchain_images.size(); }
     VkFormat swapchain_image_format() { return swapchain_image_format_; }
+    VkImageUsageFlags image_usage() { return image_usage_; }
     VkExtent2D swapchain_extent() { return swapchain_extent_; }
     uint32_t width() { return swapchain_extent_.width; }
     uint32_t height() { return swapchain_extent_.height; }
+    VkSwapchainKHR handle() { return swapchain; }
+    // Signalled by the acquire made for frame in flight frame_index.
+    VkSemaphore image_available(uint32_t frame_index) { return image_available_semaphores[frame_index]; }
+    // Fence of the frame that last rendered to the image, or VK_NULL_HANDLE; maintained by bt_presenter.
+    VkFence& image_fence(uint32_t image_index) { return images_in_flight[image_index]; }
 
     float extent_aspect_ratio()
     {
@@ -36,16 +46,12 @@ class bt_swapchain {
     }
 
     VkFormat find_depth_format();
-    VkResult acquire_next_image(uint32_t* imageIndex);
-    VkResult submit_command_buffers(const VkCommandBuffer* buffers, uint32_t* image_index);
+    VkResult acquire_next_image(uint32_t frame_index, uint32_t* image_index);
 
   private:
     void init();
     void create_swapchain();
     void create_image_views();
-    void create_depth_resources();
-    void create_render_pass();
-    void create_framebuffers();
     void create_sync_objects();
 
     VkSurfaceFormatKHR choose_swap_surface_format(const std::vector<VkSurfaceFormatKHR>& available_formats);
@@ -54,22 +60,16 @@ class bt_swapchain {
 
     VkFormat swapchain_image_format_;
     VkExtent2D swapchain_extent_;
-    std::vector<VkFramebuffer> swapchain_framebuffers;
-    VkRenderPass render_pass_;
-    std::vector<VkImage> depth_images;
-    std::vector<VkDeviceMemory> depth_image_memorys;
-    std::vector<VkImageView> depth_image_views;
+    VkImageUsageFlags image_usage_;
     std::vector<VkImage> swapchain_images;
     std::vector<VkImageView> swapchain_image_views;
     bt_device& device;
+    VkSurfaceKHR surface;
     VkExtent2D window_extent;
     VkSwapchainKHR swapchain;
     std::shared_ptr<bt_swapchain> old_swapchain;
     std::vector<VkSemaphore> image_available_semaphores;
-    std::vector<VkSemaphore> render_finished_semaphores;
-    std::vector<VkFence> in_flight_fences;
     std::vector<VkFence> images_in_flight;
-    size_t current_frame = 0;
 };
 } // namespace bt
 
@@ -0,0 +1,253 @@
+#include "bt_texture_file.hpp"
+
+#include "bt_logger.hpp"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace bt {
+namespace {
+constexpr std::array<char, 4> MAGIC = { 'B', 'T', 'T', 'X' };
+constexpr uint32_t VERSION = 1;
+constexpr uint64_t DATA_ALIGNMENT = 16;
+
+struct file_header {
+    std::array<char, 4> magic;
+    uint32_t version;
+    uint32_t format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t mip_count;
+};
+
+struct mip_entry {
+    uint64_t offset;
+    uint64_t size;
+};
+
+uint64_t align_up(uint64_t value)
+{
+    return (value + DATA_ALIGNMENT - 1) & ~(DATA_ALIGNMENT - 1);
+}
+
+template <typename T>
+T read_value(const std::vector<char>& data, size_t offset, const fs::path& path)
+{
+    if (offset + sizeof(T) > data.size()) {
+        throw std::runtime_error(fmt::format("failed to read texture file {}: truncated", path.string()));
+    }
+    T value;
+    std::memcpy(&value, data.data() + offset, sizeof(T));
+    return value;
+}
+
+// What level `level` of a width x height texture in `format` occupies, or 0 for formats the cooker never writes.
+uint64_t expected_mip_size(VkFormat format, uint32_t width, uint32_t height, uint32_t level)
+{
+    uint32_t level_width = std::max(width >> level, 1u);
+    uint32_t level_height = std::max(height >> level, 1u);
+    if (format == VK_FORMAT_R8G8B8A8_UNORM || format == VK_FORMAT_R8G8B8A8_SRGB) {
+        return static_cast<uint64_t>(level_width) * level_height * 4;
+    }
+    if (auto block_format = bt_block_format_from_vk(format)) {
+        return bt_compressed_size(*block_format, level_width, level_height);
+    }
+    return 0;
+}
+
+VkFormat rgba8_format(VkFormat format)
+{
+    auto block_format = bt_block_format_from_vk(format);
+    bool srgb = block_format.has_value() && bt_block_info(*block_format).srgb == format
+        && bt_block_info(*block_format).unorm != format;
+    return srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+}
+} // namespace
+
+bt_texture_file bt_texture_file::read(const fs::path& path)
+{
+    std::ifstream stream(path, std::ios::ate | std::ios::binary);
+    if (!stream.is_open()) {
+        throw std::runtime_error(fmt::format("failed to open texture file {}", path.string()));
+    }
+    std::vector<char> data(static_cast<size_t>(stream.tellg()));
+    stream.seekg(0);
+    stream.read(data.data(), static_cast<std::streamsize>(data.size()));
+
+    auto header = read_value<file_header>(data, 0, path);
+    if (header.magic != MAGIC || header.version != VERSION) {
+        throw std::runtime_error(fmt::format("failed to read texture file {}: not a version {} texture",
+            path.string(),
+            VERSION));
+    }
+
+    // Everything the header says is checked before it sizes anything, as the file comes from disk at runtime.
+    auto format = static_cast<VkFormat>(header.format);
+    if (header.width == 0 || header.height == 0 || expected_mip_size(format, header.width, header.height, 0) == 0) {
+        throw std::runtime_error(fmt::format("failed to read texture file {}: unsupported {}x{} texture of format {}",
+            path.string(),
+            header.width,
+            header.height,
+            header.format));
+    }
+    if (header.mip_count == 0 || header.mip_count > bt_mip_count(header.width, header.height)) {
+        throw std::runtime_error(fmt::format("failed to read texture file {}: {} mips for a {}x{} texture",
+            path.string(),
+            header.mip_count,
+            header.width,
+            header.height));
+    }
+
+    bt_texture_file file;
+    file.format = format;
+    file.width = header.width;
+    file.height = header.height;
+    file.mips.reserve(header.mip_count);
+    for (uint32_t level = 0; level < header.mip_count; level++) {
+        auto entry = read_value<mip_entry>(data, sizeof(file_header) + level * sizeof(mip_entry), path);
+        if (entry.offset > data.size() || entry.size > data.size() - entry.offset) {
+            throw std::runtime_error(fmt::format("failed to read texture file {}: mip {} out of bounds",
+                path.string(),
+                level));
+        }
+        // A short level would have the upload read past the end of its staging data.
+        if (entry.size != expected_mip_size(format, file.width, file.height, level)) {
+            throw std::runtime_error(fmt::format("failed to read texture file {}: mip {} is {} bytes, expected {}",
+                path.string(),
+                level,
+                entry.size,
+                expected_mip_size(format, file.width, file.height, level)));
+        }
+        auto begin = reinterpret_cast<const std::byte*>(data.data()) + entry.offset;
+        file.mips.emplace_back(begin, begin + entry.size);
+    }
+    return file;
+}
+
+void bt_texture_file::write(const fs::path& path) const
+{
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    if (!stream.is_open()) {
+        throw std::runtime_error(fmt::format("failed to create texture file {}", path.string()));
+    }
+
+    file_header header { MAGIC,
+        VERSION,
+        static_cast<uint32_t>(format),
+        width,
+        height,
+        static_cast<uint32_t>(mips.size()) };
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    uint64_t offset = align_up(sizeof(file_header) + mips.size() * sizeof(mip_entry));
+    for (const auto& mip : mips) {
+        mip_entry entry { offset, mip.size() };
+        stream.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+        offset = align_up(offset + mip.size());
+    }
+
+    constexpr std::array<char, DATA_ALIGNMENT> padding {};
+    for (const auto& mip : mips) {
+        auto position = static_cast<uint64_t>(stream.tellp());
+        stream.write(padding.data(), static_cast<std::streamsize>(align_up(position) - position));
+        stream.write(reinterpret_cast<const char*>(mip.data()), static_cast<std::streamsize>(mip.size()));
+    }
+
+    if (!stream) {
+        throw std::runtime_error(fmt::format("failed to write texture file {}", path.string()));
+    }
+}
+
+VkDeviceSize bt_texture_file::size() const
+{
+    VkDeviceSize total = 0;
+    for (const auto& mip : mips) {
+        total += mip.size();
+    }
+    return total;
+}
+
+bt_texture_file bt_cook_texture(const std::vector<std::byte>& pixels,
+    uint32_t width,
+    uint32_t height,
+    bt_block_format format,
+    bool srgb,
+    unsigned thread_count)
+{
+    const auto& info = bt_block_info(format);
+
+    bt_texture_file file;
+    file.format = srgb ? info.srgb : info.unorm;
+    file.width = width;
+    file.height = height;
+
+    uint32_t mip_count = bt_mip_count(width, height);
+    file.mips.reserve(mip_count);
+
+    std::vector<std::byte> level_pixels = pixels;
+    for (uint32_t level = 0; level < mip_count; level++) {
+        uint32_t level_width = std::max(width >> level, 1u);
+        uint32_t level_height = std::max(height >> level, 1u);
+        file.mips.push_back(bt_compress_blocks(format, level_pixels.data(), level_width, level_height, thread_count));
+        if (level + 1 < mip_count) {
+            level_pixels = bt_downsample_rgba8(level_pixels, level_width, level_height);
+        }
+    }
+    return file;
+}
+
+std::unique_ptr<bt_texture_source> bt_make_texture_source(bt_device& device, bt_texture_file file)
+{
+    auto block_format = bt_block_format_from_vk(file.format);
+    if (!block_format) {
+        return std::make_unique<bt_memory_texture_source>(file.format, file.width, file.height, std::move(file.mips));
+    }
+
+    // Vulkan 1.0 devices never report the transfer bits (they came with VK_KHR_maintenance1), and any format they can
+    // sample can be copied to.
+    VkFormatFeatureFlags features = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+    if (device.properties.apiVersion >= VK_API_VERSION_1_1) {
+        features |= VK_FORMAT_FEATURE_TRANSFER_SRC_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT;
+    }
+    VkFormat fallback = rgba8_format(file.format);
+    VkFormat format = device.find_supported_format({ file.format, fallback }, VK_IMAGE_TILING_OPTIMAL, features);
+
+    VkDeviceSize uncompressed_size = 0;
+    for (uint32_t level = 0; level < file.mips.size(); level++) {
+        uncompressed_size += static_cast<VkDeviceSize>(std::max(file.width >> level, 1u))
+            * std::max(file.height >> level, 1u) * 4;
+    }
+
+    if (format == fallback) {
+        SPDLOG_WARN("{} not supported, decoding {}x{} texture to RGBA8",
+            bt_block_info(*block_format).name,
+            file.width,
+            file.height);
+        for (uint32_t level = 0; level < file.mips.size(); level++) {
+            file.mips[level] = bt_decompress_blocks(*block_format,
+                file.mips[level].data(),
+                std::max(file.width >> level, 1u),
+                std::max(file.height >> level, 1u));
+        }
+    } else {
+        SPDLOG_DEBUG("{}x{} {} texture uses {} KiB, {:.1f}x less than RGBA8",
+            file.width,
+            file.height,
+            bt_block_info(*block_format).name,
+            file.size() / 1024,
+            static_cast<double>(uncompressed_size) / static_cast<double>(file.size()));
+    }
+
+    return std::make_unique<bt_memory_texture_source>(format, file.width, file.height, std::move(file.mips));
+}
+
+std::unique_ptr<bt_texture_source> bt_load_texture(bt_device& device, const fs::path& path)
+{
+    return bt_make_texture_source(device, bt_texture_file::read(path));
+}
+} // namespace bt
@@ -0,0 +1,50 @@
+#ifndef BT_TEXTURE_FILE_HPP
+#define BT_TEXTURE_FILE_HPP
+
+#include "bt_block_compression.hpp"
+#include "bt_device.hpp"
+#include "bt_texture_source.hpp"
+
+#include <glad/vulkan.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace bt {
+// Cooked mip chain as stored on disk. A file is a header (magic "BTTX", version, VkFormat, width, height, mip count),
+// a table of (offset, size) pairs, one per level, then the levels at 16-byte aligned offsets. Each level holds exactly
+// what vkCmdCopyBufferToImage reads for it with a zero row length: tightly packed texels, or rows of 4x4 blocks for
+// block-compressed formats. Values are little-endian.
+struct bt_texture_file {
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<std::vector<std::byte>> mips;
+
+    static bt_texture_file read(const fs::path& path);
+    void write(const fs::path& path) const;
+
+    VkDeviceSize size() const;
+};
+
+// Builds the full mip chain of an RGBA8 image with a 2x2 box filter and block-compresses every level.
+bt_texture_file bt_cook_texture(const std::vector<std::byte>& pixels,
+    uint32_t width,
+    uint32_t height,
+    bt_block_format format,
+    bool srgb,
+    unsigned thread_count = std::thread::hardware_concurrency());
+
+// Makes a streamable source of a cooked texture in the best format the device samples: the file's own format when
+// supported, otherwise RGBA8 decoded on the CPU.
+std::unique_ptr<bt_texture_source> bt_make_texture_source(bt_device& device, bt_texture_file file);
+std::unique_ptr<bt_texture_source> bt_load_texture(bt_device& device, const fs::path& path);
+} // namespace bt
+
+#endif // BT_TEXTURE_FILE_HPP
@@ -0,0 +1,103 @@
+#include "bt_texture_source.hpp"
+
+#include <bit>
+#include <cassert>
+#include <cstring>
+
+namespace bt {
+uint32_t bt_mip_count(uint32_t width, uint32_t height)
+{
+    return static_cast<uint32_t>(std::bit_width(std::max(width, height)));
+}
+
+std::vector<std::byte> bt_downsample_rgba8(const std::vector<std::byte>& pixels, uint32_t width, uint32_t height)
+{
+    uint32_t half_width = std::max(width / 2, 1u);
+    uint32_t half_height = std::max(height / 2, 1u);
+    std::vector<std::byte> result(static_cast<size_t>(half_width) * half_height * 4);
+
+    auto texel = [&](uint32_t x, uint32_t y, uint32_t channel) {
+        x = std::min(x, width - 1);
+        y = std::min(y, height - 1);
+        return static_cast<uint32_t>(pixels[(static_cast<size_t>(y) * width + x) * 4 + channel]);
+    };
+
+    for (uint32_t y = 0; y < half_height; y++) {
+        for (uint32_t x = 0; x < half_width; x++) {
+            for (uint32_t channel = 0; channel < 4; channel++) {
+                uint32_t sum = texel(2 * x, 2 * y, channel) + texel(2 * x + 1, 2 * y, channel)
+                    + texel(2 * x, 2 * y + 1, channel) + texel(2 * x + 1, 2 * y + 1, channel);
+                result[(static_cast<size_t>(y) * half_width + x) * 4 + channel] = static_cast<std::byte>((sum + 2) / 4);
+            }
+        }
+    }
+    return result;
+}
+
+bt_memory_texture_source::bt_memory_texture_source(VkFormat format,
+    uint32_t width,
+    uint32_t height,
+    std::vector<std::vector<std::byte>> mips) :
+    format_ { format },
+    width_ { width },
+    height_ { height },
+    mips { std::move(mips) }
+{
+    assert(!this->mips.empty() && "texture source needs at least one mip");
+}
+
+std::unique_ptr<bt_memory_texture_source> bt_memory_texture_source::from_rgba8(uint32_t width,
+    uint32_t height,
+    std::vector<std::byte> pixels,
+    VkFormat format)
+{
+    assert(pixels.size() == static_cast<size_t>(width) * height * 4 && "pixel data does not match extent");
+
+    uint32_t mip_count = bt_mip_count(width, height);
+    std::vector<std::vector<std::byte>> mips;
+    mips.reserve(mip_count);
+    mips.push_back(std::move(pixels));
+
+    for (uint32_t level = 1; level < mip_count; level++) {
+        mips.push_back(bt_downsample_rgba8(mips.back(),
+            std::max(width >> (level - 1), 1u),
+            std::max(height >> (level - 1), 1u)));
+    }
+
+    return std::make_unique<bt_memory_texture_source>(format, width, height, std::move(mips));
+}
+
+std::unique_ptr<bt_memory_texture_source> bt_memory_texture_source::with_generated_mips(uint32_t width,
+    uint32_t height,
+    std::vector<std::byte> pixels,
+    VkFormat format)
+{
+    assert(pixels.size() == static_cast<size_t>(width) * height * 4 && "pixel data does not match extent");
+
+    std::vector<std::vector<std::byte>> mips;
+    mips.push_back(std::move(pixels));
+
+    auto source = std::make_unique<bt_memory_texture_source>(format, width, height, std::move(mips));
+    source->generates_mips_ = true;
+    return source;
+}
+
+uint32_t bt_memory_texture_source::mip_count() const
+{
+    return generates_mips_ ? bt_mip_count(width_, height_) : static_cast<uint32_t>(mips.size());
+}
+
+VkDeviceSize bt_memory_texture_source::mip_size(uint32_t level) const
+{
+    if (generates_mips_) {
+        return static_cast<VkDeviceSize>(mip_width(level)) * mip_height(level) * 4;
+    }
+    return mips[level].size();
+}
+
+void bt_memory_texture_source::read_mip(uint32_t level, std::byte* destination) const
+{
+    assert(level < mips.size() && "generated mips have no data to read");
+    memcpy(destination, mips[level].data(), mips[level].size());
+}
+} // namespace bt
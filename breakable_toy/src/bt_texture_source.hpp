@@ -0,0 +1,76 @@
+#ifndef BT_TEXTURE_SOURCE_HPP
+#define BT_TEXTURE_SOURCE_HPP
+
+#include <glad/vulkan.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace bt {
+// CPU-side mip chain a texture is streamed from. Level 0 is the most detailed; mip data is tightly packed in the
+// texture's format, so it can be copied straight into a staging buffer.
+class bt_texture_source {
+  public:
+    virtual ~bt_texture_source() = default;
+
+    virtual VkFormat format() const = 0;
+    virtual uint32_t width() const = 0;
+    virtual uint32_t height() const = 0;
+    virtual uint32_t mip_count() const = 0;
+    virtual VkDeviceSize mip_size(uint32_t level) const = 0;
+    virtual void read_mip(uint32_t level, std::byte* destination) const = 0;
+    // True when only level 0 holds data and the rest of the chain is generated on the GPU once it is uploaded;
+    // mip_size still reports each level's size in device memory.
+    virtual bool generates_mips() const { return false; }
+
+    uint32_t mip_width(uint32_t level) const { return std::max(width() >> level, 1u); }
+    uint32_t mip_height(uint32_t level) const { return std::max(height() >> level, 1u); }
+};
+
+// Mip chain held in memory.
+class bt_memory_texture_source : public bt_texture_source {
+  public:
+    bt_memory_texture_source(VkFormat format,
+        uint32_t width,
+        uint32_t height,
+        std::vector<std::vector<std::byte>> mips);
+
+    // Builds the full chain from RGBA8 pixels with a 2x2 box filter.
+    static std::unique_ptr<bt_memory_texture_source> from_rgba8(uint32_t width,
+        uint32_t height,
+        std::vector<std::byte> pixels,
+        VkFormat format = VK_FORMAT_R8G8B8A8_SRGB);
+
+    // Keeps only the RGBA8 level 0; the streamer generates the other levels on the GPU.
+    static std::unique_ptr<bt_memory_texture_source> with_generated_mips(uint32_t width,
+        uint32_t height,
+        std::vector<std::byte> pixels,
+        VkFormat format = VK_FORMAT_R8G8B8A8_SRGB);
+
+    VkFormat format() const override { return format_; }
+    uint32_t width() const override { return width_; }
+    uint32_t height() const override { return height_; }
+    uint32_t mip_count() const override;
+    VkDeviceSize mip_size(uint32_t level) const override;
+    void read_mip(uint32_t level, std::byte* destination) const override;
+    bool generates_mips() const override { return generates_mips_; }
+
+  private:
+    VkFormat format_;
+    uint32_t width_;
+    uint32_t height_;
+    std::vector<std::vector<std::byte>> mips;
+    bool generates_mips_ = false;
+};
+
+// Number of levels in a full chain down to 1x1.
+uint32_t bt_mip_count(uint32_t width, uint32_t height);
+
+// Halves an RGBA8 image with a 2x2 box filter; odd edges repeat their last texel.
+std::vector<std::byte> bt_downsample_rgba8(const std::vector<std::byte>& pixels, uint32_t width, uint32_t height);
+} // namespace bt
+
+#endif // BT_TEXTURE_SOURCE_HPP
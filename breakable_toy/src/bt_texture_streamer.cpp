@@ -0,0 +1,461 @@
+#include "bt_texture_streamer.hpp"
+
+#include "bt_logger.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
+
+namespace bt {
+namespace {
+constexpr VkPipelineStageFlags SAMPLED_STAGES =
+    VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+// Satisfies the buffer offset alignment of every uncompressed and block-compressed format.
+constexpr VkDeviceSize STAGING_ALIGNMENT = 16;
+
+VkImageMemoryBarrier image_barrier(VkImage image,
+    uint32_t mip_count,
+    VkImageLayout old_layout,
+    VkImageLayout new_layout,
+    VkAccessFlags src_access,
+    VkAccessFlags dst_access)
+{
+    VkImageMemoryBarrier barrier { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+    barrier.srcAccessMask = src_access;
+    barrier.dstAccessMask = dst_access;
+    barrier.oldLayout = old_layout;
+    barrier.newLayout = new_layout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, mip_count, 0, 1 };
+    return barrier;
+}
+} // namespace
+
+bt_texture_streamer::bt_texture_streamer(bt_device& device,
+    bt_resources& resources,
+    bt_bindless_table* bindless,
+    const bt_texture_streamer_config& config) :
+    device { device },
+    bindless { bindless },
+    config { config },
+    mip_generator { device, resources, bt_swapchain::MAX_FRAMES_IN_FLIGHT },
+    last_update { std::chrono::steady_clock::now() }
+{
+    for (auto& s : staging) {
+        device.create_buffer(config.upload_bytes_per_frame,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            s.buffer,
+            s.memory);
+
+        void* mapped;
+        if (vkMapMemory(device.device(), s.memory, 0, config.upload_bytes_per_frame, 0, &mapped) != VK_SUCCESS) {
+            throw std::runtime_error("failed to map texture staging buffer");
+        }
+        s.mapped = static_cast<std::byte*>(mapped);
+    }
+
+    stats_.budget = config.budget;
+}
+
+bt_texture_streamer::~bt_texture_streamer()
+{
+    for (auto& t : textures) {
+        if (t.source != nullptr) {
+            retire(t);
+        }
+    }
+    release_retired(true);
+
+    for (auto& s : staging) {
+        vkUnmapMemory(device.device(), s.memory);
+        vkDestroyBuffer(device.device(), s.buffer, device.allocator());
+        vkFreeMemory(device.device(), s.memory, device.allocator());
+    }
+}
+
+bt_texture_id bt_texture_streamer::add(std::unique_ptr<bt_texture_source> source)
+{
+    bt_texture_id id;
+    if (!free_ids.empty()) {
+        id = free_ids.back();
+        free_ids.pop_back();
+    } else {
+        id = static_cast<bt_texture_id>(textures.size());
+        textures.emplace_back();
+    }
+
+    auto& t = textures[id];
+    uint32_t mip_count = source->mip_count();
+
+    if (source->generates_mips()) {
+        if (source->mip_size(0) > config.upload_bytes_per_frame) {
+            throw std::runtime_error("failed to add texture: level 0 exceeds the per-frame upload size");
+        }
+        t.tail_mip = 0;
+    } else {
+        t.tail_mip = mip_count - 1;
+    }
+    while (t.tail_mip > 0 && std::max(source->mip_width(t.tail_mip - 1), source->mip_height(t.tail_mip - 1))
+               <= config.tail_size) {
+        t.tail_mip--;
+    }
+
+    while (t.first_streamable_mip < t.tail_mip
+        && source->mip_size(t.first_streamable_mip) > config.upload_bytes_per_frame) {
+        t.first_streamable_mip++;
+    }
+    if (t.first_streamable_mip > 0) {
+        SPDLOG_WARN("texture {}: mips above {}x{} exceed the per-frame upload size and will not be streamed",
+            id,
+            source->mip_width(t.first_streamable_mip),
+            source->mip_height(t.first_streamable_mip));
+    }
+
+    t.source = std::move(source);
+    t.resident_mip = mip_count;
+    t.wanted_mip = mip_count;
+    t.last_requested = frame;
+    stats_.textures++;
+    return id;
+}
+
+void bt_texture_streamer::remove(bt_texture_id id)
+{
+    auto& t = textures[id];
+    assert(t.source != nullptr && "removing a texture that does not exist");
+
+    stats_.resident_bytes -= resident_size(t, t.resident_mip);
+    retire(t);
+    t = {};
+    free_ids.push_back(id);
+    stats_.textures--;
+}
+
+bool bt_texture_streamer::request(bt_texture_id id, float screen_size)
+{
+    auto& t = textures[id];
+
+    uint32_t wanted = t.tail_mip;
+    if (screen_size > 0.0f) {
+        float texels = static_cast<float>(std::max(t.source->width(), t.source->height()));
+        auto level = static_cast<int>(std::floor(std::log2(texels / screen_size)));
+        wanted = static_cast<uint32_t>(
+            std::clamp(level, static_cast<int>(t.first_streamable_mip), static_cast<int>(t.tail_mip)));
+    }
+
+    t.wanted_mip = std::min(t.wanted_mip, wanted);
+    t.last_requested = frame;
+
+    if (t.resident_mip > wanted) {
+        pending_non_resident_draws++;
+        return false;
+    }
+    return true;
+}
+
+void bt_texture_streamer::update(VkCommandBuffer command_buffer,
+    uint32_t frame_index,
+    std::pmr::memory_resource* scratch)
+{
+    release_retired(false);
+
+    mip_generator.begin_frame(frame_index);
+
+    current_staging = &staging[frame_index];
+    current_staging->head = 0;
+    current_scratch = scratch;
+    stats_.uploaded_bytes = 0;
+    stats_.mips_streamed_in = 0;
+    stats_.mips_evicted = 0;
+
+    // Tails first: they are small and every texture needs one before it can be drawn at all.
+    for (bt_texture_id id = 0; id < textures.size(); id++) {
+        auto& t = textures[id];
+        if (t.source != nullptr && t.resident_mip > t.tail_mip) {
+            if (!set_resident_mip(command_buffer, id, t.tail_mip)) {
+                break;
+            }
+        }
+    }
+
+    std::pmr::vector<bt_texture_id> wanted { current_scratch };
+    for (bt_texture_id id = 0; id < textures.size(); id++) {
+        const auto& t = textures[id];
+        if (t.source != nullptr && t.wanted_mip < t.resident_mip) {
+            wanted.push_back(id);
+        }
+    }
+
+    // Most starved first, so a texture far below the detail it needs catches up before others gain a refinement.
+    std::sort(wanted.begin(), wanted.end(), [&](bt_texture_id a, bt_texture_id b) {
+        return textures[a].resident_mip - textures[a].wanted_mip > textures[b].resident_mip - textures[b].wanted_mip;
+    });
+
+    for (auto id : wanted) {
+        auto& t = textures[id];
+        uint32_t next_mip = t.resident_mip - 1;
+
+        if (!make_room(command_buffer, t.source->mip_size(next_mip), id)) {
+            continue;
+        }
+        if (!set_resident_mip(command_buffer, id, next_mip)) {
+            break;
+        }
+    }
+
+    for (auto& t : textures) {
+        if (t.source != nullptr) {
+            t.wanted_mip = t.source->mip_count();
+        }
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(now - last_update).count();
+    last_update = now;
+    if (seconds > 0.0) {
+        double rate = static_cast<double>(stats_.uploaded_bytes) / (1024.0 * 1024.0) / seconds;
+        stats_.upload_mb_per_second = 0.9 * stats_.upload_mb_per_second + 0.1 * rate;
+    }
+
+    stats_.non_resident_draws = pending_non_resident_draws;
+    pending_non_resident_draws = 0;
+    frame++;
+}
+
+VkDeviceSize bt_texture_streamer::resident_size(const texture& t, uint32_t first_mip) const
+{
+    VkDeviceSize size = 0;
+    for (uint32_t level = first_mip; level < t.source->mip_count(); level++) {
+        size += t.source->mip_size(level);
+    }
+    return size;
+}
+
+bool bt_texture_streamer::make_room(VkCommandBuffer command_buffer, VkDeviceSize bytes, bt_texture_id keep)
+{
+    while (stats_.resident_bytes + bytes > config.budget) {
+        // Least recently requested texture with a mip above its tail. Textures requested this frame only give up
+        // mips they have more of than they asked for.
+        bt_texture_id victim = UINT32_MAX;
+        for (bt_texture_id id = 0; id < textures.size(); id++) {
+            const auto& t = textures[id];
+            if (id == keep || t.source == nullptr || t.resident_mip >= t.tail_mip) {
+                continue;
+            }
+            if (t.last_requested == frame && t.wanted_mip <= t.resident_mip) {
+                continue;
+            }
+            if (victim == UINT32_MAX || t.last_requested < textures[victim].last_requested) {
+                victim = id;
+            }
+        }
+
+        if (victim == UINT32_MAX) {
+            return false;
+        }
+
+        set_resident_mip(command_buffer, victim, textures[victim].resident_mip + 1);
+        stats_.mips_evicted++;
+    }
+    return true;
+}
+
+bool bt_texture_streamer::set_resident_mip(VkCommandBuffer command_buffer, bt_texture_id id, uint32_t first_mip)
+{
+    auto& t = textures[id];
+    const auto& source = *t.source;
+    uint32_t mip_count = source.mip_count();
+    uint32_t old_first_mip = t.resident_mip;
+    uint32_t old_level_count = mip_count - std::min(old_first_mip, mip_count);
+
+    // Levels that are not in the old image come from the source through this frame's staging buffer, apart from
+    // generated ones, which are made from level 0 after it lands.
+    bool generate = source.generates_mips();
+    uint32_t upload_end = generate ? 1 : std::min(old_first_mip, mip_count);
+    std::pmr::vector<VkBufferImageCopy> uploads { current_scratch };
+    VkDeviceSize head = current_staging->head;
+    for (uint32_t level = first_mip; level < upload_end; level++) {
+        head = (head + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1);
+        if (head + source.mip_size(level) > config.upload_bytes_per_frame) {
+            return false;
+        }
+
+        VkBufferImageCopy region {};
+        region.bufferOffset = head;
+        region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - first_mip, 0, 1 };
+        region.imageExtent = { source.mip_width(level), source.mip_height(level), 1 };
+        uploads.push_back(region);
+
+        source.read_mip(level, current_staging->mapped + head);
+        head += source.mip_size(level);
+    }
+    stats_.uploaded_bytes += head - current_staging->head;
+    current_staging->head = head;
+
+    uint32_t level_count = mip_count - first_mip;
+
+    VkImageCreateInfo image_info { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
+    image_info.imageType = VK_IMAGE_TYPE_2D;
+    image_info.format = source.format();
+    image_info.extent = { source.mip_width(first_mip), source.mip_height(first_mip), 1 };
+    image_info.mipLevels = level_count;
+    image_info.arrayLayers = 1;
+    image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+    image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    image_info.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    if (generate) {
+        image_info.flags = mip_generator.image_flags(source.format());
+        image_info.usage |= mip_generator.image_usage(source.format());
+    }
+    image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    VkImage image;
+    VkDeviceMemory memory;
+    device.create_image_with_info(image_info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, memory);
+
+    std::pmr::vector<VkImageMemoryBarrier> barriers { current_scratch };
+    barriers.push_back(image_barrier(image,
+        level_count,
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        0,
+        VK_ACCESS_TRANSFER_WRITE_BIT));
+    if (t.image != VK_NULL_HANDLE) {
+        barriers.push_back(image_barrier(t.image,
+            old_level_count,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            VK_ACCESS_SHADER_READ_BIT,
+            VK_ACCESS_TRANSFER_READ_BIT));
+    }
+    vkCmdPipelineBarrier(command_buffer,
+        SAMPLED_STAGES | VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0,
+        0,
+        nullptr,
+        0,
+        nullptr,
+        static_cast<uint32_t>(barriers.size()),
+        barriers.data());
+
+    // Levels both images hold are copied on the GPU instead of being uploaded again.
+    std::pmr::vector<VkImageCopy> copies { current_scratch };
+    for (uint32_t level = std::max(first_mip, old_first_mip); level < mip_count; level++) {
+        VkImageCopy copy {};
+        copy.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - old_first_mip, 0, 1 };
+        copy.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - first_mip, 0, 1 };
+        copy.extent = { source.mip_width(level), source.mip_height(level), 1 };
+        copies.push_back(copy);
+    }
+    if (!copies.empty()) {
+        vkCmdCopyImage(command_buffer,
+            t.image,
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            image,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            static_cast<uint32_t>(copies.size()),
+            copies.data());
+    }
+    if (!uploads.empty()) {
+        vkCmdCopyBufferToImage(command_buffer,
+            current_staging->buffer,
+            image,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            static_cast<uint32_t>(uploads.size()),
+            uploads.data());
+    }
+
+    if (generate) {
+        mip_generator.generate(command_buffer,
+            image,
+            source.format(),
+            source.mip_width(first_mip),
+            source.mip_height(first_mip),
+            level_count);
+    } else {
+        auto to_sampled = image_barrier(image,
+            level_count,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_ACCESS_SHADER_READ_BIT);
+        vkCmdPipelineBarrier(command_buffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            SAMPLED_STAGES,
+            0,
+            0,
+            nullptr,
+            0,
+            nullptr,
+            1,
+            &to_sampled);
+    }
+
+    VkImageViewCreateInfo view_info { VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
+    view_info.image = image;
+    view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    view_info.format = source.format();
+    view_info.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, level_count, 0, 1 };
+
+    VkImageView view;
+    if (vkCreateImageView(device.device(), &view_info, device.allocator(), &view) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create streamed texture image view");
+    }
+
+    // Earlier frames may still sample the old image through the old slot, so the new view gets a slot of its own.
+    if (t.image != VK_NULL_HANDLE) {
+        retire(t);
+    }
+
+    stats_.resident_bytes += resident_size(t, first_mip);
+    stats_.resident_bytes -= resident_size(t, old_first_mip);
+    if (first_mip < old_first_mip) {
+        stats_.mips_streamed_in += std::min(old_first_mip, mip_count) - first_mip;
+    }
+
+    t.image = image;
+    t.memory = memory;
+    t.view = view;
+    t.bindless_index = bindless != nullptr ? bindless->add_sampled_image(view) : INVALID_INDEX;
+    t.resident_mip = first_mip;
+    return true;
+}
+
+void bt_texture_streamer::retire(texture& t)
+{
+    if (t.image != VK_NULL_HANDLE) {
+        retired.push_back({ frame, t.image, t.memory, t.view, t.bindless_index });
+    }
+
+    t.image = VK_NULL_HANDLE;
+    t.memory = VK_NULL_HANDLE;
+    t.view = VK_NULL_HANDLE;
+    t.bindless_index = INVALID_INDEX;
+}
+
+void bt_texture_streamer::release_retired(bool all)
+{
+    // Work recorded in update N has completed once frame N + MAX_FRAMES_IN_FLIGHT has waited on its fence.
+    auto released = std::remove_if(retired.begin(), retired.end(), [&](const retired_resources& r) {
+        if (!all && r.frame + bt_swapchain::MAX_FRAMES_IN_FLIGHT > frame) {
+            return false;
+        }
+
+        vkDestroyImageView(device.device(), r.view, device.allocator());
+        vkDestroyImage(device.device(), r.image, device.allocator());
+        vkFreeMemory(device.device(), r.memory, device.allocator());
+        if (bindless != nullptr && r.bindless_index != INVALID_INDEX) {
+            bindless->remove(bt_bindless_type::sampled_image, r.bindless_index);
+        }
+        return true;
+    });
+    retired.erase(released, retired.end());
+}
+} // namespace bt
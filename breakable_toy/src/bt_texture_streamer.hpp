@@ -0,0 +1,148 @@
+#ifndef BT_TEXTURE_STREAMER_HPP
+#define BT_TEXTURE_STREAMER_HPP
+
+#include "bt_bindless.hpp"
+#include "bt_device.hpp"
+#include "bt_mip_generator.hpp"
+#include "bt_resources.hpp"
+#include "bt_swapchain.hpp"
+#include "bt_texture_source.hpp"
+
+#include <glad/vulkan.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+namespace bt {
+using bt_texture_id = uint32_t;
+
+struct bt_texture_streamer_config {
+    // Device memory all resident mips together may use. The mip tail is always resident, even over budget.
+    VkDeviceSize budget = 256 * 1024 * 1024;
+    // Staging space per frame, which caps how much is uploaded each frame. Mips larger than this are never streamed.
+    VkDeviceSize upload_bytes_per_frame = 16 * 1024 * 1024;
+    // Mips no larger than this in either dimension form the tail, which is loaded first and never evicted.
+    uint32_t tail_size = 64;
+};
+
+struct bt_texture_streamer_stats {
+    uint32_t textures = 0;
+    VkDeviceSize resident_bytes = 0;
+    VkDeviceSize budget = 0;
+    // This frame.
+    VkDeviceSize uploaded_bytes = 0;
+    uint32_t mips_streamed_in = 0;
+    uint32_t mips_evicted = 0;
+    // Requests this frame for a mip more detailed than what is resident.
+    uint32_t non_resident_draws = 0;
+    // Upload rate, smoothed over recent frames.
+    double upload_mb_per_second = 0.0;
+};
+
+// Keeps each texture's resident mip range within a memory budget. A texture owns one image holding its levels from
+// the most detailed resident mip down to 1x1; streaming a mip in or out replaces the image with one that has a level
+// more or less, copying the levels they share on the GPU.
+//
+// Textures start with only their mip tail, which the first update() after add() uploads. Every frame, draws report
+// how large a texture appears on screen through request(); update() then streams in the mips those requests need, one
+// level per texture per frame and most starved texture first, and when that would exceed the budget evicts the top
+// mip of the least recently requested textures. Replaced images, views and bindless slots are released once the
+// frames using them have completed.
+//
+// Sources that generate their mips are not streamed: their whole chain is the tail, made resident by uploading level 0
+// and generating the rest on the GPU in the same command buffer.
+class bt_texture_streamer {
+  public:
+    static constexpr uint32_t INVALID_INDEX = bt_index_allocator::INVALID_INDEX;
+
+    bt_texture_streamer(bt_device& device,
+        bt_resources& resources,
+        bt_bindless_table* bindless,
+        const bt_texture_streamer_config& config = {});
+    bt_texture_streamer(const bt_texture_streamer&) = delete;
+    ~bt_texture_streamer();
+
+    bt_texture_streamer& operator=(const bt_texture_streamer&) = delete;
+
+    bt_texture_id add(std::unique_ptr<bt_texture_source> source);
+    void remove(bt_texture_id id);
+
+    // Feedback from a draw sampling the texture across roughly screen_size pixels. Returns false if the mip it needs
+    // is not resident yet.
+    bool request(bt_texture_id id, float screen_size);
+
+    // Records this frame's uploads and copies; call outside a render pass. Must be called once per frame, after the
+    // frame's fence has been waited on. The frame's transient lists are allocated from scratch, such as the frame
+    // arena.
+    void update(VkCommandBuffer command_buffer,
+        uint32_t frame_index,
+        std::pmr::memory_resource* scratch = std::pmr::get_default_resource());
+
+    // Empty until the texture's tail has been uploaded.
+    VkImageView image_view(bt_texture_id id) const { return textures[id].view; }
+    uint32_t bindless_index(bt_texture_id id) const { return textures[id].bindless_index; }
+    uint32_t resident_mip(bt_texture_id id) const { return textures[id].resident_mip; }
+
+    const bt_texture_streamer_stats& stats() const { return stats_; }
+    const bt_mip_generator_stats& mip_generator_stats() const { return mip_generator.stats(); }
+
+  private:
+    struct texture {
+        std::unique_ptr<bt_texture_source> source;
+        VkImage image = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        uint32_t bindless_index = INVALID_INDEX;
+        // Most detailed level resident; mip_count when nothing is.
+        uint32_t resident_mip = 0;
+        uint32_t tail_mip = 0;
+        // Most detailed level that fits in a frame's staging buffer.
+        uint32_t first_streamable_mip = 0;
+        // Most detailed level requested this frame; mip_count when not requested.
+        uint32_t wanted_mip = 0;
+        uint64_t last_requested = 0;
+    };
+
+    struct retired_resources {
+        uint64_t frame;
+        VkImage image;
+        VkDeviceMemory memory;
+        VkImageView view;
+        uint32_t bindless_index;
+    };
+
+    struct staging_buffer {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        std::byte* mapped = nullptr;
+        VkDeviceSize head = 0;
+    };
+
+    VkDeviceSize resident_size(const texture& t, uint32_t first_mip) const;
+    bool make_room(VkCommandBuffer command_buffer, VkDeviceSize bytes, bt_texture_id keep);
+    bool set_resident_mip(VkCommandBuffer command_buffer, bt_texture_id id, uint32_t first_mip);
+    void retire(texture& t);
+    void release_retired(bool all);
+
+    bt_device& device;
+    bt_bindless_table* bindless;
+    bt_texture_streamer_config config;
+    bt_mip_generator mip_generator;
+    std::vector<texture> textures;
+    std::vector<bt_texture_id> free_ids;
+    std::vector<retired_resources> retired;
+    std::array<staging_buffer, bt_swapchain::MAX_FRAMES_IN_FLIGHT> staging;
+    staging_buffer* current_staging = nullptr;
+    std::pmr::memory_resource* current_scratch = std::pmr::get_default_resource();
+    uint64_t frame = 0;
+    uint32_t pending_non_resident_draws = 0;
+    std::chrono::steady_clock::time_point last_update;
+    bt_texture_streamer_stats stats_;
+};
+} // namespace bt
+
+#endif // BT_TEXTURE_STREAMER_HPP
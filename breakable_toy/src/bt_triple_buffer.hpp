@@ -0,0 +1,57 @@
+#ifndef BT_TRIPLE_BUFFER_HPP
+#define BT_TRIPLE_BUFFER_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace bt {
+// Hands the latest value from one writer thread to one reader thread without locking or waiting. The writer fills its
+// own slot and publishes it by swapping it with a shared middle slot; the reader swaps its slot with the middle one
+// when something new was published. Neither side ever touches the slot the other owns, so a published value stays
+// immutable until the reader lets go of it, and values the reader never picked up are simply overwritten.
+//
+// The writer's slot holds whatever was published two swaps ago, so every publish has to overwrite the whole value.
+template <typename T>
+class bt_triple_buffer {
+  public:
+    bt_triple_buffer() = default;
+    explicit bt_triple_buffer(const T& initial) :
+        slots { initial, initial, initial }
+    {
+    }
+
+    bt_triple_buffer(const bt_triple_buffer&) = delete;
+    bt_triple_buffer& operator=(const bt_triple_buffer&) = delete;
+
+    // Writer side.
+    T& write_slot() { return slots[back]; }
+
+    void publish() { back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX_MASK; }
+
+    // Reader side. Takes the most recently published value, if there is one the reader has not seen yet.
+    bool update()
+    {
+        if ((middle.load(std::memory_order_relaxed) & FRESH) == 0) {
+            return false;
+        }
+
+        front = middle.exchange(front, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+
+    const T& read() const { return slots[front]; }
+
+  private:
+    static constexpr uint8_t INDEX_MASK = 3;
+    static constexpr uint8_t FRESH = 4;
+
+    std::array<T, 3> slots {};
+    // Index of the shared slot, with FRESH set while it holds a value the reader has not taken.
+    alignas(64) std::atomic<uint8_t> middle = 1;
+    alignas(64) uint8_t back = 0;
+    alignas(64) uint8_t front = 2;
+};
+} // namespace bt
+
+#endif // BT_TRIPLE_BUFFER_HPP
@@ -5,52 +5,101 @@
 #include <stdexcept>
 
 namespace bt {
-bt_window::bt_window(uint32_t width, uint32_t height, std::string name) :
-    width { width },
-    height { height },
-    window_name { std::move(name) }
-{
-    init_window();
-}
+namespace {
+uint64_t pack_extent(uint32_t width, uint32_t height) { return static_cast<uint64_t>(width) << 32 | height; }
 
-bt_window::~bt_window()
-{
-    gladLoaderUnloadVulkan();
-
-    glfwDestroyWindow(handle);
-    glfwTerminate();
-}
+bt_window& window_of(GLFWwindow* handle) { return *reinterpret_cast<bt_window*>(glfwGetWindowUserPointer(handle)); }
+} // namespace
 
-void bt_window::init_window()
+bt_glfw_context::bt_glfw_context()
 {
+    if (users++ > 0) {
+        return;
+    }
+
     glfwSetErrorCallback(
         [](int code, const char* description) { SPDLOG_ERROR("GLFW error (code {}): {}", code, description); });
 
     glfwInitVulkanLoader(vkGetInstanceProcAddr);
 
     if (!glfwInit()) {
+        users--;
         throw std::runtime_error("unable to initialise GLFW");
     }
 
     if (!glfwVulkanSupported()) {
+        glfwTerminate();
+        users--;
         throw std::runtime_error("no Vulkan loader or installable client driver found");
     }
+}
+
+bt_glfw_context::~bt_glfw_context()
+{
+    if (--users == 0) {
+        glfwTerminate();
+    }
+}
+
+bt_window::bt_window(uint32_t width, uint32_t height, std::string name) :
+    extent_ { pack_extent(width, height) },
+    window_name { std::move(name) }
+{
+    init_window();
+}
 
+bt_window::~bt_window() { glfwDestroyWindow(handle); }
+
+void bt_window::init_window()
+{
     glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
     glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
-    handle = glfwCreateWindow(width, height, window_name.c_str(), nullptr, nullptr);
+    auto initial = extent();
+    handle = glfwCreateWindow(static_cast<int>(initial.width),
+        static_cast<int>(initial.height),
+        window_name.c_str(),
+        nullptr,
+        nullptr);
     if (!handle) {
         throw std::runtime_error("unable to create GLFW window");
     }
 
+    // The requested size is in screen coordinates; on high-DPI displays the framebuffer is larger, and the resize
+    // callback only reports later changes.
+    int width = 0;
+    int height = 0;
+    glfwGetFramebufferSize(handle, &width, &height);
+    extent_.store(pack_extent(static_cast<uint32_t>(width), static_cast<uint32_t>(height)), std::memory_order_release);
+
     glfwSetWindowUserPointer(handle, this);
 
     glfwSetFramebufferSizeCallback(handle, [](GLFWwindow* handle, int width, int height) {
-        auto window = reinterpret_cast<bt_window*>(glfwGetWindowUserPointer(handle));
-        window->framebuffer_resized = true;
-        window->width = static_cast<uint32_t>(width);
-        window->height = static_cast<uint32_t>(height);
+        auto& window = window_of(handle);
+        window.extent_.store(pack_extent(static_cast<uint32_t>(width), static_cast<uint32_t>(height)),
+            std::memory_order_release);
+        window.framebuffer_resized.store(true, std::memory_order_release);
+        window.push_event(
+            { bt_window_event_type::resize, 0, 0, 0, static_cast<double>(width), static_cast<double>(height) });
     });
+    glfwSetKeyCallback(handle, [](GLFWwindow* handle, int key, int, int action, int mods) {
+        window_of(handle).push_event({ bt_window_event_type::key, key, action, mods, 0.0, 0.0 });
+    });
+    glfwSetMouseButtonCallback(handle, [](GLFWwindow* handle, int button, int action, int mods) {
+        window_of(handle).push_event({ bt_window_event_type::mouse_button, button, action, mods, 0.0, 0.0 });
+    });
+    glfwSetCursorPosCallback(handle, [](GLFWwindow* handle, double x, double y) {
+        window_of(handle).push_event({ bt_window_event_type::cursor, 0, 0, 0, x, y });
+    });
+    glfwSetScrollCallback(handle, [](GLFWwindow* handle, double x, double y) {
+        window_of(handle).push_event({ bt_window_event_type::scroll, 0, 0, 0, x, y });
+    });
+}
+
+void bt_window::push_event(const bt_window_event& event)
+{
+    if (!events.push(event)) {
+        dropped_events_.fetch_add(1, std::memory_order_relaxed);
+    }
 }
 
 void bt_window::create_window_surface(VkInstance instance, VkSurfaceKHR* surface, VkAllocationCallbacks* allocator)
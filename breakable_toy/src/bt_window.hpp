@@ -1,15 +1,50 @@
 #ifndef BT_WINDOW_HPP
 #define BT_WINDOW_HPP
 
+#include "bt_spsc_queue.hpp"
+
 #include <glad/vulkan.h>
 #define GLFW_INCLUDE_NONE
 #include <GLFW/glfw3.h>
 
+#include <atomic>
+#include <cstdint>
 #include <string>
 
 namespace bt {
+enum class bt_window_event_type { resize, key, mouse_button, cursor, scroll };
+
+struct bt_window_event {
+    bt_window_event_type type;
+    // GLFW key or mouse button, action and modifier bits.
+    int32_t code;
+    int32_t action;
+    int32_t mods;
+    // Cursor position, scroll offset or new framebuffer size.
+    double x;
+    double y;
+};
+
+// Keeps GLFW initialised while any instance exists. GLFW is global and must be initialised and terminated on the main
+// thread, so instances must only be created and destroyed there.
+class bt_glfw_context {
+  public:
+    bt_glfw_context();
+    bt_glfw_context(const bt_glfw_context&) = delete;
+    ~bt_glfw_context();
+
+    bt_glfw_context& operator=(const bt_glfw_context&) = delete;
+
+  private:
+    static inline int users = 0;
+};
+
+// Owns the GLFW window. Events are pumped on the thread that created it, which queues them for a single consumer
+// thread; extent() and the resize flag can be read from any thread.
 class bt_window {
   public:
+    static constexpr size_t EVENT_QUEUE_CAPACITY = 1024;
+
     bt_window(uint32_t width, uint32_t height, std::string name);
     bt_window(const bt_window&) = delete;
     bt_window(bt_window&&) = delete;
@@ -18,18 +53,31 @@ class bt_window {
     bt_window& operator=(const bt_window&) = delete;
 
     bool should_close() { return glfwWindowShouldClose(handle); }
-    VkExtent2D extent() { return { width, height }; }
-    bool was_resized() { return framebuffer_resized; }
-    void reset_resized_flag() { framebuffer_resized = false; }
+    VkExtent2D extent()
+    {
+        uint64_t packed = extent_.load(std::memory_order_acquire);
+        return { static_cast<uint32_t>(packed >> 32), static_cast<uint32_t>(packed) };
+    }
+    bool was_resized() { return framebuffer_resized.load(std::memory_order_acquire); }
+    void reset_resized_flag() { framebuffer_resized.store(false, std::memory_order_release); }
+
+    // Consumer side of the event queue. Events that arrive while it is full are dropped and counted; resizes are
+    // still reflected in extent() and the resize flag.
+    bool poll_event(bt_window_event& event) { return events.pop(event); }
+    uint64_t dropped_events() { return dropped_events_.load(std::memory_order_relaxed); }
 
     void create_window_surface(VkInstance instance, VkSurfaceKHR* surface, VkAllocationCallbacks* allocator);
 
   private:
     void init_window();
+    void push_event(const bt_window_event& event);
 
-    uint32_t width;
-    uint32_t height;
-    bool framebuffer_resized = false;
+    bt_glfw_context glfw;
+    // Width in the high and height in the low 32 bits, so both change together.
+    std::atomic<uint64_t> extent_;
+    std::atomic<bool> framebuffer_resized = false;
+    bt_spsc_queue<bt_window_event, EVENT_QUEUE_CAPACITY> events;
+    std::atomic<uint64_t> dropped_events_ = 0;
     std::string window_name;
     GLFWwindow* handle;
 };
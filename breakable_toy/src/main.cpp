@@ -2,20 +2,49 @@
 #include "bt_filesystem.hpp"
 #include "bt_logger.hpp"
 
+#include <algorithm>
 #include <cstdlib>
 #include <stdexcept>
+#include <string_view>
 
 int main(int argc, char* argv[])
 {
     bt::bt_logger logger { spdlog::level::trace };
     bt::bt_filesystem::init(argv[0]);
 
-    bt::app app {};
+    bt::app_options options;
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg { argv[i] };
+        // --viewports N opens N windows rendered and presented together by one device.
+        if (arg == "--viewports" && i + 1 < argc) {
+            options.viewports = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+        }
+        // --track-host-allocations routes the driver's host allocations through bt_host_allocator and logs them per
+        // frame.
+        if (arg == "--track-host-allocations") {
+            options.track_host_allocations = true;
+        }
+        // --startup-profile logs each startup step's wall time and the time to the first frame; add --serial-startup
+        // to run the steps one after another for comparison.
+        if (arg == "--startup-profile") {
+            options.startup_profile = true;
+        }
+        if (arg == "--serial-startup") {
+            options.serial_startup = true;
+        }
+        // --static-pipeline-state bakes cull mode, depth state and topology into pipelines even where the device could
+        // set them per draw.
+        if (arg == "--static-pipeline-state") {
+            options.dynamic_draw_state = false;
+        }
+    }
+
+    bt::app app { options };
 
     try {
         app.run();
     } catch (const std::exception& e) {
-        SPDLOG_CRITICAL(e.what());
+        SPDLOG_CRITICAL("{}", e.what());
         return EXIT_FAILURE;
     }
 
@@ -0,0 +1,203 @@
+#include "bt_block_compression.hpp"
+#include "bt_texture_file.hpp"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Offline texture cooker: reads a binary PPM (P6) or PAM (P7, RGB or RGB_ALPHA) image, builds its mip chain,
+// block-compresses every level and writes a .bttx file the engine can stream without further processing.
+//
+//   texture_cooker <input.ppm|input.pam> <output.bttx> [--format bc1|bc3|bc5|bc7] [--linear] [--threads N]
+
+namespace {
+struct image {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<std::byte> pixels; // RGBA8
+};
+
+std::string next_token(std::istream& stream)
+{
+    std::string token;
+    while (stream >> token) {
+        if (token[0] != '#') {
+            return token;
+        }
+        std::getline(stream, token);
+    }
+    throw std::runtime_error("failed to parse image header");
+}
+
+image read_image(const std::string& path)
+{
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream.is_open()) {
+        throw std::runtime_error(fmt::format("failed to open image {}", path));
+    }
+
+    image result;
+    uint32_t channels = 3;
+    uint32_t max_value = 255;
+    std::string magic = next_token(stream);
+    if (magic == "P6") {
+        result.width = std::stoul(next_token(stream));
+        result.height = std::stoul(next_token(stream));
+        max_value = std::stoul(next_token(stream));
+    } else if (magic == "P7") {
+        for (std::string key = next_token(stream); key != "ENDHDR"; key = next_token(stream)) {
+            std::string value = next_token(stream);
+            if (key == "WIDTH") {
+                result.width = std::stoul(value);
+            } else if (key == "HEIGHT") {
+                result.height = std::stoul(value);
+            } else if (key == "DEPTH") {
+                channels = std::stoul(value);
+            } else if (key == "MAXVAL") {
+                max_value = std::stoul(value);
+            }
+        }
+    } else {
+        throw std::runtime_error(fmt::format("failed to read image {}: only binary PPM and PAM are supported", path));
+    }
+    if (max_value != 255 || (channels != 3 && channels != 4) || result.width == 0 || result.height == 0) {
+        throw std::runtime_error(fmt::format("failed to read image {}: expected 8-bit RGB or RGBA", path));
+    }
+    stream.get(); // the single whitespace character ending the header
+
+    size_t pixel_count = static_cast<size_t>(result.width) * result.height;
+    std::vector<std::byte> packed(pixel_count * channels);
+    stream.read(reinterpret_cast<char*>(packed.data()), static_cast<std::streamsize>(packed.size()));
+    if (!stream) {
+        throw std::runtime_error(fmt::format("failed to read image {}: truncated", path));
+    }
+
+    result.pixels.resize(pixel_count * 4);
+    for (size_t i = 0; i < pixel_count; i++) {
+        for (uint32_t c = 0; c < 4; c++) {
+            result.pixels[i * 4 + c] = c < channels ? packed[i * channels + c] : std::byte { 255 };
+        }
+    }
+    return result;
+}
+
+std::optional<bt::bt_block_format> parse_format(std::string_view name)
+{
+    using bt::bt_block_format;
+    for (auto format : { bt_block_format::bc1, bt_block_format::bc3, bt_block_format::bc5, bt_block_format::bc7 }) {
+        std::string_view info_name = bt::bt_block_info(format).name;
+        if (name.size() == info_name.size()
+            && std::equal(name.begin(), name.end(), info_name.begin(), [](char a, char b) {
+                   return std::toupper(static_cast<unsigned char>(a)) == b;
+               })) {
+            return format;
+        }
+    }
+    return std::nullopt;
+}
+
+int usage()
+{
+    fmt::print(stderr,
+        "usage: texture_cooker <input.ppm|input.pam> <output.bttx> [--format bc1|bc3|bc5|bc7] [--linear] "
+        "[--threads N]\n");
+    return EXIT_FAILURE;
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3) {
+        return usage();
+    }
+
+    std::string input = argv[1];
+    std::string output = argv[2];
+    auto format = bt::bt_block_format::bc7;
+    bool srgb = true;
+    unsigned threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    for (int i = 3; i < argc; i++) {
+        std::string_view arg = argv[i];
+        if (arg == "--format" && i + 1 < argc) {
+            auto parsed = parse_format(argv[++i]);
+            if (!parsed) {
+                return usage();
+            }
+            format = *parsed;
+        } else if (arg == "--linear") {
+            srgb = false;
+        } else if (arg == "--threads" && i + 1 < argc) {
+            try {
+                threads = std::max(static_cast<unsigned>(std::stoul(argv[++i])), 1u);
+            } catch (const std::exception&) {
+                return usage();
+            }
+        } else {
+            return usage();
+        }
+    }
+
+    try {
+        image source = read_image(input);
+
+        auto start = std::chrono::steady_clock::now();
+        bt::bt_texture_file file = bt::bt_cook_texture(source.pixels,
+            source.width,
+            source.height,
+            format,
+            srgb,
+            threads);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        file.write(output);
+
+        uint64_t pixel_count = 0;
+        uint64_t uncompressed_size = 0;
+        for (uint32_t level = 0; level < file.mips.size(); level++) {
+            uint64_t level_pixels = static_cast<uint64_t>(std::max(file.width >> level, 1u))
+                * std::max(file.height >> level, 1u);
+            pixel_count += level_pixels;
+            uncompressed_size += level_pixels * 4;
+        }
+
+        const auto& info = bt::bt_block_info(format);
+        std::vector<std::byte> decoded = bt::bt_decompress_blocks(format, file.mips[0].data(), file.width, file.height);
+        double psnr = bt::bt_psnr(source.pixels.data(),
+            decoded.data(),
+            static_cast<size_t>(file.width) * file.height,
+            info.channels);
+
+        fmt::print("{} -> {}: {}x{} {}{}, {} mips\n",
+            input,
+            output,
+            file.width,
+            file.height,
+            info.name,
+            srgb && info.srgb != info.unorm ? " sRGB" : "",
+            file.mips.size());
+        fmt::print("  encode  {:.1f} MPix/s ({:.1f} ms, {} thread(s))\n",
+            static_cast<double>(pixel_count) / seconds / 1e6,
+            seconds * 1000.0,
+            threads);
+        fmt::print("  PSNR    {:.2f} dB (level 0, {} channel(s))\n", psnr, info.channels);
+        fmt::print("  memory  {} KiB vs {} KiB as RGBA8 ({:.1f}x smaller)\n",
+            file.size() / 1024,
+            uncompressed_size / 1024,
+            static_cast<double>(uncompressed_size) / static_cast<double>(file.size()));
+    } catch (const std::exception& e) {
+        fmt::print(stderr, "{}\n", e.what());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}